@@ -0,0 +1,445 @@
+/* libunbind.c
+* (C) 2025 - George McGinn - MIT License
+* Reentrant physics core for unbindEnergy and unbindDose (see libunbind.h).
+* Build: gcc -O2 -c libunbind.c -o libunbind.o   (or link directly with the programs)
+*
+* Notes:
+*  - All functions are pure: inputs in, results out, no I/O and no global mutable state.
+*  - The solver arithmetic is kept expression-for-expression identical to the original
+*    main() code so the command-line output does not change.
+*/
+
+#include <math.h>
+#include <string.h>
+#include <strings.h>
+#include "libunbind.h"
+
+// Names indexed by PLANET_* / MATERIAL_*
+static const char* const planet_names[PLANET_COUNT] = {
+    "earth", "mars", "venus", "jupiter", "saturn",
+    "uranus", "neptune", "pluto", "moon", "vacuum"
+};
+static const char* const material_names[MATERIAL_COUNT] = { "stony", "iron", "cometary" };
+
+// Function to get gravitational binding energy based on planet type
+double get_planetary_binding_energy(int planet_type) {
+    switch(planet_type) {
+        case PLANET_EARTH:   return 2.49e32;  // J - Original value from code comments
+        case PLANET_MARS:    return 4.87e30;  // J - Calculated from NASA data
+        case PLANET_VENUS:   return 1.57e32;  // J - Calculated from NASA data
+        case PLANET_JUPITER: return 2.06e36;  // J - Calculated from NASA data
+        case PLANET_SATURN:  return 2.22e35;  // J - Calculated from NASA data
+        case PLANET_URANUS:  return 1.19e34;  // J - Calculated from NASA data
+        case PLANET_NEPTUNE: return 1.69e34;  // J - Calculated from NASA data
+        case PLANET_PLUTO:   return 2.85e27;  // J - Calculated from NASA data
+        case PLANET_MOON:    return 1.23e29;  // J - Moon binding energy
+        case PLANET_VACUUM:  
+        default:             return 2.49e32;  // J - Default to Earth
+    }
+}
+
+/* Atmospheric retention tables.
+ * Fraction of kinetic energy that reaches the surface, by impactor diameter. Each
+ * (planet, material) row lists ascending breakpoints (km) and the retention of each band:
+ * value[0] below breakpoint[0], value[i] for breakpoint[i-1] <= D < breakpoint[i], and
+ * value[n] above the last breakpoint. Unused breakpoint slots are +Inf so a whole row can
+ * be compared against a SIMD register at once. To add a planet or material, add a row.
+ */
+#define NO_BP INFINITY
+static const unbind_retention_table retention_tables[PLANET_COUNT][MATERIAL_COUNT] = {
+    // Earth
+    [PLANET_EARTH] = {
+        // Stony: <10m 1%, 10-30m 10%, 30-200m 50%, >200m 90%
+        [MATERIAL_STONY]    = { 3, { 0.01, 0.03, 0.20, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP },
+                                   { 0.01, 0.10, 0.50, 0.90 } },
+        // Iron - higher survival rate: <10m 0%, 10-30m 20%, 30-50m 50%, 50-100m 80%, 100-200m 90%, >200m 95%
+        [MATERIAL_IRON]     = { 5, { 0.01, 0.03, 0.05, 0.10, 0.20, NO_BP, NO_BP, NO_BP },
+                                   { 0.00, 0.20, 0.50, 0.80, 0.90, 0.95 } },
+        // Cometary - very low survival: <50m 0%, 50-200m 5%, >200m 80%
+        [MATERIAL_COMETARY] = { 2, { 0.05, 0.20, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP },
+                                   { 0.00, 0.05, 0.80 } },
+    },
+    // Mars: minimal atmospheric protection (1.3% of Earth's density)
+    [PLANET_MARS] = {
+        [MATERIAL_STONY]    = { 1, { 0.005, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.85, 0.95 } },
+        [MATERIAL_IRON]     = { 1, { 0.001, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.80, 0.95 } },
+        [MATERIAL_COMETARY] = { 1, { 0.01,  NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.70, 0.90 } },
+    },
+    // Venus: extreme atmospheric protection (53x denser than Earth)
+    [PLANET_VENUS] = {
+        [MATERIAL_STONY]    = { 2, { 0.20, 1.00, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.05, 0.60 } },
+        [MATERIAL_IRON]     = { 3, { 0.10, 0.50, 1.00, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.10, 0.50, 0.80 } },
+        [MATERIAL_COMETARY] = { 1, { 1.00, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.30 } },
+    },
+    // Jupiter: massive atmospheric protection, crushing pressures
+    [PLANET_JUPITER] = {
+        [MATERIAL_STONY]    = { 1, { 10.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.10 } },
+        [MATERIAL_IRON]     = { 2, { 1.00, 10.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.01, 0.20 } },
+        [MATERIAL_COMETARY] = { 1, { 10.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.10 } },
+    },
+    // Saturn: similar to Jupiter but larger scale height allows deeper penetration
+    [PLANET_SATURN] = {
+        [MATERIAL_STONY]    = { 1, { 5.00, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.15 } },
+        [MATERIAL_IRON]     = { 2, { 0.50, 5.00, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.05, 0.30 } },
+        [MATERIAL_COMETARY] = { 1, { 5.00, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.15 } },
+    },
+    // Uranus: ice giant with thick hydrogen/helium atmosphere + ices
+    [PLANET_URANUS] = {
+        [MATERIAL_STONY]    = { 1, { 10.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.15 } },
+        [MATERIAL_IRON]     = { 2, { 2.00, 10.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.02, 0.25 } },
+        [MATERIAL_COMETARY] = { 1, { 10.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.15 } },
+    },
+    // Neptune: densest ice giant, even more protective than Uranus
+    [PLANET_NEPTUNE] = {
+        [MATERIAL_STONY]    = { 1, { 15.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.10 } },
+        [MATERIAL_IRON]     = { 2, { 3.00, 15.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.01, 0.20 } },
+        [MATERIAL_COMETARY] = { 1, { 15.0, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.00, 0.10 } },
+    },
+    // Pluto: extremely thin nitrogen atmosphere (1 Pa vs Earth's 101,325 Pa)
+    [PLANET_PLUTO] = {
+        [MATERIAL_STONY]    = { 1, { 0.005, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.92, 0.98 } },
+        [MATERIAL_IRON]     = { 1, { 0.001, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.95, 0.99 } },
+        [MATERIAL_COMETARY] = { 1, { 0.01,  NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.90, 0.98 } },
+    },
+    // Moon: essentially no atmosphere (3*10^-15 Pa); the exosphere provides virtually no protection
+    [PLANET_MOON] = {
+        [MATERIAL_STONY]    = { 1, { 0.001, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.99, 1.00 } },
+        [MATERIAL_IRON]     = { 1, { 0.001, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.99, 1.00 } },
+        [MATERIAL_COMETARY] = { 1, { 0.001, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 0.98, 0.99 } },
+    },
+    // Vacuum: no atmospheric losses
+    [PLANET_VACUUM] = {
+        [MATERIAL_STONY]    = { 0, { NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 1.00 } },
+        [MATERIAL_IRON]     = { 0, { NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 1.00 } },
+        [MATERIAL_COMETARY] = { 0, { NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP, NO_BP }, { 1.00 } },
+    },
+};
+#undef NO_BP
+
+// Table for a planet/material pair. Unknown planets behave as vacuum and
+// unknown materials as stony, as the original switch did.
+const unbind_retention_table* unbind_retention_table_for(int planet_type, int material_type) {
+    if (planet_type < 0 || planet_type >= PLANET_COUNT) planet_type = PLANET_VACUUM;
+    if (material_type < 0 || material_type >= MATERIAL_COUNT) material_type = MATERIAL_STONY;
+    return &retention_tables[planet_type][material_type];
+}
+
+// Band index = number of breakpoints <= D. The loop has a uniform trip count per
+// table, and the comparisons are summed rather than branched on.
+double unbind_retention_lookup(const unbind_retention_table* t, double diameter_km) {
+    int idx = 0;
+    for (int i = 0; i < t->n_breakpoints; i++)
+        idx += diameter_km >= t->breakpoint_km[i];
+    return t->value[idx];
+}
+
+// Start the 'v' solver: D_vac_km has g <= 0 and the top-band size has g >= 0 once it is
+// also past the last breakpoint.
+void unbind_v_init(unbind_v_state* s, const unbind_retention_table* t, double D_vac_km, double D_top_km) {
+    double last_bp = t->n_breakpoints > 0 ? t->breakpoint_km[t->n_breakpoints-1] : 0.0;
+    s->lo = D_vac_km;
+    s->hi = D_top_km > last_bp ? D_top_km : last_bp;
+    s->D = D_vac_km;
+    s->iterations = 0;
+    s->state = UNBIND_V_RUNNING;
+}
+
+// One solver step. ret = retention(s->D), D_next_km = f(s->D), ret_next = retention(D_next_km).
+// Every lo is an evaluated iterate, so once no breakpoint lies strictly inside (lo, hi)
+// the band of lo has no fixed point and the answer is the breakpoint at hi. The next
+// iterate is the fixed-point update when it lies inside the bracket, else the middle
+// breakpoint inside it, else the geometric midpoint (sizes span decades).
+int unbind_v_step(unbind_v_state* s, const unbind_retention_table* t, double ret, double D_next_km,
+                  double ret_next) {
+    s->iterations++;
+    if (ret_next == ret) {
+        // f is constant within a band, so D_next is an exact fixed point
+        s->D = D_next_km;
+        return s->state = UNBIND_V_FIXED_POINT;
+    }
+    if (s->D < D_next_km) { if (s->D > s->lo) s->lo = s->D; }
+    else if (s->D < s->hi) s->hi = s->D;
+
+    int first = -1, inside = 0, hi_on_edge = 0;
+    for (int i = 0; i < t->n_breakpoints; i++) {
+        double bp = t->breakpoint_km[i];
+        if (bp > s->lo && bp < s->hi) { if (first < 0) first = i; inside++; }
+        hi_on_edge |= bp == s->hi;
+    }
+    if ((inside == 0 && hi_on_edge) || s->hi - s->lo <= UNBIND_V_RTOL * s->hi) {
+        s->D = s->hi;
+        return s->state = UNBIND_V_BAND_EDGE;
+    }
+    if (s->iterations >= UNBIND_V_ITER_CAP) {
+        s->D = s->hi;
+        return s->state = UNBIND_V_MAX_ITER;
+    }
+    if (D_next_km > s->lo && D_next_km < s->hi) s->D = D_next_km;
+    else if (inside > 0) s->D = t->breakpoint_km[first + inside/2];
+    else s->D = sqrt(s->lo * s->hi);
+    return s->state = UNBIND_V_RUNNING;
+}
+
+// Atmospheric retention function
+double atmospheric_retention(double diameter_km, int planet_type, int material_type) {
+    // Returns fraction of kinetic energy that reaches surface
+    return unbind_retention_lookup(unbind_retention_table_for(planet_type, material_type), diameter_km);
+}
+
+// Helper function to get planet type from string (other bodies: unbind_registry.h)
+int get_planet_type(const char* planet_name) {
+    int planet = unbind_lookup_planet(planet_name);
+    return planet >= 0 ? planet : PLANET_EARTH; // default to Earth if unknown
+}
+
+// Helper function to get material type from string
+int get_material_type(const char* material_name) {
+    if (!material_name) return MATERIAL_STONY; // default to stony
+    if (strcasecmp(material_name, "iron") == 0) return MATERIAL_IRON;
+    if (strcasecmp(material_name, "cometary") == 0) return MATERIAL_COMETARY;
+    if (strcasecmp(material_name, "stony") == 0) return MATERIAL_STONY;
+    return MATERIAL_STONY; // default to stony
+}
+
+// Strict lookups: unknown names return -1 instead of a default
+int unbind_lookup_planet(const char* planet_name) {
+    if (!planet_name) return -1;
+    for (int i = 0; i < PLANET_COUNT; i++)
+        if (strcasecmp(planet_name, planet_names[i]) == 0) return i;
+    return -1;
+}
+
+int unbind_lookup_material(const char* material_name) {
+    if (!material_name) return -1;
+    for (int i = 0; i < MATERIAL_COUNT; i++)
+        if (strcasecmp(material_name, material_names[i]) == 0) return i;
+    return -1;
+}
+
+const char* unbind_planet_name(int planet_type) {
+    return (planet_type >= 0 && planet_type < PLANET_COUNT) ? planet_names[planet_type] : "unknown";
+}
+
+const char* unbind_material_name(int material_type) {
+    return (material_type >= 0 && material_type < MATERIAL_COUNT) ? material_names[material_type] : "unknown";
+}
+
+// Shared by the planet and material list parsers
+static int parse_list(const char* list, int (*lookup)(const char*), int count, int* out, int max) {
+    char name[64];
+    int n = 0;
+    if (!list) return -1;
+    if (strcasecmp(list, "all") == 0) {
+        if (count > max) return -1;
+        for (int i = 0; i < count; i++) out[n++] = i;
+        return n;
+    }
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        if (len == 0 || len >= sizeof(name) || n >= max) return -1;
+        memcpy(name, list, len);
+        name[len] = '\0';
+        int idx = lookup(name);
+        if (idx < 0) return -1;
+        out[n++] = idx;
+        list += len;
+        if (*list == ',') list++;
+    }
+    return n > 0 ? n : -1;
+}
+
+// "all" or comma-separated names. Returns the number of entries written to out,
+// or -1 for an unknown name, an empty list, or more than max entries.
+int unbind_parse_planet_list(const char* list, int* out, int max) {
+    return parse_list(list, unbind_lookup_planet, PLANET_COUNT, out, max);
+}
+
+int unbind_parse_material_list(const char* list, int* out, int max) {
+    return parse_list(list, unbind_lookup_material, MATERIAL_COUNT, out, max);
+}
+
+// Defaults match the command line: 3000 kg/m^3, epsilon 1.0, Earth, stony
+void unbind_input_defaults(unbind_input* in) {
+    in->mode = UNBIND_MODE_DIAMETER;
+    in->value = 0.0;
+    in->rho = UNBIND_DEFAULT_DENSITY;
+    in->epsilon = 1.0;
+    in->planet = PLANET_EARTH;
+    in->material = MATERIAL_STONY;
+}
+
+// Mass -> required speed. Diameter (for retention) is estimated at 3000 kg/m^3.
+void unbind_mass_to_speed(double m, double eps, double U, int planet_type, int material_type,
+                          unbind_result* r) {
+    const double c = UNBIND_SPEED_OF_LIGHT;
+    double volume = m / UNBIND_DEFAULT_DENSITY;
+    double D_km = 2.0 * cbrt((3.0*volume)/(4.0*UNBIND_PI)) / 1000.0;
+    r->retention = atmospheric_retention(D_km, planet_type, material_type);
+    r->effective_eps = eps * r->retention;
+    r->m = m;
+    r->m_class = m;
+    r->D = D_km * 1000.0;
+    r->v_class = sqrt(2.0*(U/r->effective_eps)/m);
+    double gamma = 1.0 + (U/r->effective_eps)/(m*c*c);
+    double beta2 = 1.0 - 1.0/(gamma*gamma);
+    r->v_rel = c * sqrt(beta2<=0.0?0.0:beta2);
+    r->U = U;
+    r->destroyed = r->v_rel < 0.99*c;
+    r->status = UNBIND_OK;
+    r->iterations = 0;
+    r->solver_state = UNBIND_V_RUNNING;
+}
+
+// Diameter + density -> mass and required speed
+void unbind_diameter_to_speed(double D_km, double rho, double eps, double U, int planet_type,
+                              int material_type, unbind_result* r) {
+    const double c = UNBIND_SPEED_OF_LIGHT;
+    r->retention = atmospheric_retention(D_km, planet_type, material_type);
+    r->effective_eps = eps * r->retention;
+    double D = D_km * 1000.0;
+    double volume = (4.0/3.0) * UNBIND_PI * pow(D/2.0, 3.0);
+    r->m = rho * volume;
+    r->m_class = r->m;
+    r->D = D;
+    r->v_class = sqrt(2.0 * (U/r->effective_eps) / r->m);
+    double gamma = 1.0 + (U/r->effective_eps) / (r->m * c * c);
+    double beta2 = 1.0 - 1.0/(gamma*gamma);
+    r->v_rel = c * sqrt(beta2<=0.0?0.0:beta2);
+    r->U = U;
+    r->destroyed = r->v_rel < 0.99*c;
+    r->status = UNBIND_OK;
+    r->iterations = 0;
+    r->solver_state = UNBIND_V_RUNNING;
+}
+
+// Speed + density -> minimum required mass and equivalent diameter.
+// Retention depends on the diameter being solved for; see unbind_v_step().
+// Returns UNBIND_OK, or UNBIND_ERR_SPEED if the speed is not below c.
+int unbind_speed_to_mass(double v_km_s, double rho, double eps, double U, int planet_type,
+                         int material_type, unbind_result* r) {
+    const double c = UNBIND_SPEED_OF_LIGHT;
+    const unbind_retention_table* t = unbind_retention_table_for(planet_type, material_type);
+    double v = v_km_s * 1000.0;
+    double beta = v / c;
+    if (beta >= 1.0) return UNBIND_ERR_SPEED;
+
+    // Sizes assuming no atmospheric losses and top-band retention bracket the answer
+    double gamma = 1.0 / sqrt(1.0 - beta*beta);
+    double k_per_mass = (gamma - 1.0) * c * c;
+    double m_req = U / (eps * k_per_mass);
+    double volume = m_req / rho;
+    double D_km_vac = 2.0 * cbrt((3.0*volume)/(4.0*UNBIND_PI)) / 1000.0;
+    volume = U / (eps * t->value[t->n_breakpoints] * k_per_mass) / rho;
+    double D_km_top = 2.0 * cbrt((3.0*volume)/(4.0*UNBIND_PI)) / 1000.0;
+
+    unbind_v_state s;
+    unbind_v_init(&s, t, D_km_vac, D_km_top);
+    double retention, effective_eps, D_next;
+    do {
+        retention = unbind_retention_lookup(t, s.D);
+        effective_eps = eps * retention;
+        m_req = U / (effective_eps * k_per_mass);
+        volume = m_req / rho;
+        D_next = 2.0 * cbrt((3.0*volume)/(4.0*UNBIND_PI));
+    } while (unbind_v_step(&s, t, retention, D_next / 1000.0,
+                           unbind_retention_lookup(t, D_next / 1000.0)) == UNBIND_V_RUNNING);
+
+    if (s.state != UNBIND_V_FIXED_POINT) {
+        // No size in any band meets U exactly: the smallest impactor that does is s.D
+        retention = unbind_retention_lookup(t, s.D);
+        effective_eps = eps * retention;
+        D_next = s.D * 1000.0;
+        m_req = rho * (4.0/3.0) * UNBIND_PI * pow(D_next/2.0, 3.0);
+    }
+
+    r->retention = retention;
+    r->effective_eps = effective_eps;
+    r->m = m_req;
+    r->m_class = 2.0*U / (effective_eps * v * v);
+    r->D = D_next;
+    r->v_class = v;
+    r->v_rel = v;
+    r->U = U;
+    r->destroyed = 0;
+    r->status = UNBIND_OK;
+    r->iterations = s.iterations;
+    r->solver_state = s.state;
+    return UNBIND_OK;
+}
+
+// Scalar entry point: dispatch on in->mode. Returns (and stores) the status.
+int unbind_solve(const unbind_input* in, unbind_result* out) {
+    double U = get_planetary_binding_energy(in->planet);
+    int status = UNBIND_OK;
+
+    memset(out, 0, sizeof(*out));
+    out->U = U;
+    switch (in->mode) {
+        case 'm': case 'M':
+            if (in->value <= 0.0 || in->epsilon <= 0.0) { status = UNBIND_ERR_INPUT; break; }
+            unbind_mass_to_speed(in->value, in->epsilon, U, in->planet, in->material, out);
+            break;
+        case 'd': case 'D':
+            if (in->value <= 0.0 || in->rho <= 0.0 || in->epsilon <= 0.0) { status = UNBIND_ERR_INPUT; break; }
+            unbind_diameter_to_speed(in->value, in->rho, in->epsilon, U, in->planet, in->material, out);
+            break;
+        case 'v': case 'V':
+            if (in->value <= 0.0 || in->rho <= 0.0 || in->epsilon <= 0.0) { status = UNBIND_ERR_INPUT; break; }
+            status = unbind_speed_to_mass(in->value, in->rho, in->epsilon, U, in->planet, in->material, out);
+            break;
+        default:
+            status = UNBIND_ERR_MODE;
+    }
+    out->status = status;
+    return status;
+}
+
+// Array entry point: out[i] = solve(in[i]). Returns the number of failed elements.
+size_t unbind_solve_array(const unbind_input* in, unbind_result* out, size_t n) {
+    size_t failed = 0;
+    for (size_t i = 0; i < n; i++)
+        if (unbind_solve(&in[i], &out[i]) != UNBIND_OK) failed++;
+    return failed;
+}
+
+/* ---------------------------------------------------------------------------
+ * unbindDose model
+ * ------------------------------------------------------------------------- */
+
+double calc_dose(double F, double A, double f, double M, double cos_theta) {
+    return (F * A * f * cos_theta) / M;
+}
+
+// Defaults match the unbindDose command line (Earth destruction seen from the Moon)
+void unbind_dose_defaults(unbind_dose_input* in) {
+    in->E = 2.49e32;
+    in->eta = 3e-3;
+    in->d = 3.844e8;
+    in->A = 0.7;
+    in->M = 70.0;
+    in->f = 1.0;
+    in->theta_deg = 75.0;
+    in->atmos_trans = 1.0;
+}
+
+// Fluence F = eta*E/(4*pi*d^2) attenuated by atmos_trans, upper and lower bound doses
+void unbind_dose(const unbind_dose_input* in, unbind_dose_result* out) {
+    double cos_theta = cos(in->theta_deg * UNBIND_PI / 180.0);
+    double F = in->eta * in->E / (4.0 * UNBIND_PI * in->d * in->d);
+    double F_attenuated = F * in->atmos_trans;
+    out->fluence = F_attenuated;
+    out->dose_upper = calc_dose(F_attenuated, in->A, in->f, in->M, 1.0);
+    out->dose_lower = calc_dose(F_attenuated, in->A, in->f, in->M, cos_theta);
+}
+
+// The same doses at 1 m from the event (Gy m^2); at distance d they are k / d^2
+void unbind_dose_coefficients(const unbind_dose_input* in, double* k_upper, double* k_lower) {
+    double F1 = in->eta * in->E / (4.0 * UNBIND_PI) * in->atmos_trans;
+    *k_upper = calc_dose(F1, in->A, in->f, in->M, 1.0);
+    *k_lower = calc_dose(F1, in->A, in->f, in->M, cos(in->theta_deg * UNBIND_PI / 180.0));
+}
+
+void unbind_dose_array(const unbind_dose_input* in, unbind_dose_result* out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        unbind_dose(&in[i], &out[i]);
+}
@@ -0,0 +1,393 @@
+/* libunbind.h
+* (C) 2025 - George McGinn - MIT License
+* Reentrant physics core shared by unbindEnergy and unbindDose.
+*
+* Build:
+*   Static : gcc -O2 -c libunbind.c libunbind_simd.c libunbind_entry.c libunbind_spectrum.c &&
+*            ar rcs libunbind.a libunbind.o libunbind_simd.o libunbind_entry.o libunbind_spectrum.o
+*   Shared : gcc -O2 -fPIC -shared libunbind.c libunbind_simd.c libunbind_entry.c libunbind_spectrum.c \
+*            -o libunbind.so -lm
+*   Linked : gcc -O2 unbindEnergy.c libunbind.c libunbind_simd.c libunbind_entry.c -o unbindEnergy -lm
+*
+* Notes:
+*  - No function in this library performs I/O or touches global mutable state,
+*    so every entry point may be called concurrently from any number of threads.
+*  - Inputs are passed in structs and results are written to caller-owned structs.
+*    Each solver has a scalar form and an array-at-a-time form.
+*  - Units follow the command-line tools: mass in kg, diameter in km, speed in km/s
+*    on input; results are SI (kg, m, m/s) except where a field name says otherwise.
+*  - UNBIND_API_VERSION is bumped whenever a struct layout or signature changes.
+*/
+
+#ifndef LIBUNBIND_H
+#define LIBUNBIND_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define UNBIND_API_VERSION 3
+
+#define UNBIND_SPEED_OF_LIGHT 299792458.0          // m/s
+#define UNBIND_PI 3.14159265358979323846           // PI
+#define UNBIND_DEFAULT_DENSITY 3000.0              // kg/m^3, typical asteroid
+#define UNBIND_MERCURY_MASS 3.30e23                // kg
+#define UNBIND_CERES_MASS 9.38e20                  // kg
+#define UNBIND_LETHAL_DOSE 8.0                     // Gy, lethal without treatment
+
+// Planet type constants for atmospheric modeling
+#define PLANET_EARTH 0
+#define PLANET_MARS 1
+#define PLANET_VENUS 2
+#define PLANET_JUPITER 3
+#define PLANET_SATURN 4
+#define PLANET_URANUS 5
+#define PLANET_NEPTUNE 6
+#define PLANET_PLUTO 7
+#define PLANET_MOON 8
+#define PLANET_VACUUM 9
+#define PLANET_COUNT 10
+
+// Material type constants
+#define MATERIAL_STONY 0
+#define MATERIAL_IRON 1
+#define MATERIAL_COMETARY 2
+#define MATERIAL_COUNT 3
+
+// Solver modes (same letters as the unbindEnergy command line)
+#define UNBIND_MODE_MASS 'm'
+#define UNBIND_MODE_DIAMETER 'd'
+#define UNBIND_MODE_SPEED 'v'
+
+// Status codes
+#define UNBIND_OK 0
+#define UNBIND_ERR_INPUT -1        // non-positive mass, diameter, speed, density or epsilon
+#define UNBIND_ERR_SPEED -2        // speed is not below c
+#define UNBIND_ERR_MODE -3         // unknown solver mode
+
+// One unbindEnergy scenario
+typedef struct {
+    char   mode;          // UNBIND_MODE_MASS, UNBIND_MODE_DIAMETER or UNBIND_MODE_SPEED
+    double value;         // mass (kg), diameter (km) or speed (km/s), depending on mode
+    double rho;           // bulk density (kg/m^3); 'm' estimates diameter at 3000 kg/m^3
+    double epsilon;       // coupling efficiency
+    int    planet;        // PLANET_*
+    int    material;      // MATERIAL_*
+} unbind_input;
+
+// Result of one m/d/v evaluation (SI units)
+typedef struct {
+    double U;              // target binding energy (J)
+    double retention;      // fraction of KE reaching the surface
+    double effective_eps;  // epsilon * retention
+    double m;              // mass (kg): input for 'm', computed for 'd', required for 'v'
+    double m_class;        // 'v' only: classical required mass (kg), otherwise m
+    double D;              // diameter (m): estimated for 'm', input for 'd', required for 'v'
+    double v_class;        // classical required speed (m/s), input speed for 'v'
+    double v_rel;          // relativistic required speed (m/s), input speed for 'v'
+    int    destroyed;      // 'm'/'d': 1 if v_rel < 0.99c (target can be unbound)
+    int    status;         // UNBIND_OK or UNBIND_ERR_*
+    int    iterations;     // 'v': retention solver iterations (0 for 'm'/'d')
+    int    solver_state;   // 'v': UNBIND_V_FIXED_POINT, UNBIND_V_BAND_EDGE or UNBIND_V_MAX_ITER
+} unbind_result;
+
+/* 'v' mode retention solver. The required diameter D solves D = f(D), where f(D) is the
+ * size needed at retention(D). Retention is a non-decreasing step function of D, so
+ * g(D) = D - f(D) is increasing and the answer is bracketed by the vacuum size (g <= 0)
+ * and the top-band size (g >= 0). Each step tries the fixed-point update and falls back
+ * to bisection (over breakpoints first) when it leaves the bracket. When no band holds a
+ * fixed point the minimum sits on a retention breakpoint (UNBIND_V_BAND_EDGE). */
+#define UNBIND_V_RUNNING 0
+#define UNBIND_V_FIXED_POINT 1     // D = f(D) inside one retention band
+#define UNBIND_V_BAND_EDGE 2       // minimum impactor sits on a retention breakpoint
+#define UNBIND_V_MAX_ITER 3        // iteration cap hit; D is the upper bracket (conservative)
+#define UNBIND_V_ITER_CAP 100
+#define UNBIND_V_RTOL 1e-12        // relative bracket width treated as converged
+
+typedef struct {
+    double lo, hi;         // bracket on D (km): g(lo) < 0 <= g(hi)
+    double D;              // current iterate (km)
+    int    iterations;
+    int    state;          // UNBIND_V_*
+} unbind_v_state;
+
+// Piecewise-constant retention versus diameter for one planet/material (see libunbind.c)
+#define UNBIND_RETENTION_SLOTS 8
+typedef struct {
+    int    n_breakpoints;                            // at most UNBIND_RETENTION_SLOTS - 1
+    double breakpoint_km[UNBIND_RETENTION_SLOTS];    // ascending; unused slots are +Inf
+    double value[UNBIND_RETENTION_SLOTS];            // n_breakpoints + 1 band values
+} unbind_retention_table;
+
+// Structure-of-arrays batch: one mode/planet/material, n inputs (libunbind_simd.c)
+typedef struct {
+    char   mode;           // UNBIND_MODE_MASS, UNBIND_MODE_DIAMETER or UNBIND_MODE_SPEED
+    int    planet;         // PLANET_*
+    int    material;       // MATERIAL_*
+    double U;              // binding energy (J); 0 selects get_planetary_binding_energy(planet)
+    double rho;            // density (kg/m^3) used when rho_v is NULL
+    double epsilon;        // coupling efficiency used when eps_v is NULL
+    const double* value;   // n masses (kg), diameters (km) or speeds (km/s)
+    const double* rho_v;   // optional per-element density
+    const double* eps_v;   // optional per-element epsilon
+    size_t n;
+    const double* ret_v;   // optional per-element retention in place of the planet's table
+} unbind_soa_input;
+
+// Output columns; any pointer may be NULL to skip that column
+typedef struct {
+    double* retention;
+    double* m;             // kg: input 'm', computed 'd', required 'v'
+    double* D_km;          // km: estimated 'm', input 'd', required 'v'
+    double* v_class;       // m/s ('m' and 'd')
+    double* v_rel;         // m/s ('m' and 'd')
+    double* m_class;       // kg ('v')
+    unsigned char* destroyed;  // 1 if v_rel < 0.99c ('m' and 'd'), 0 for 'v'
+    int* iterations;       // 'v': retention solver iterations
+} unbind_soa_result;
+
+#define UNBIND_SIMD_SCALAR 0
+#define UNBIND_SIMD_AVX2 1
+#define UNBIND_SIMD_AVX512 2
+
+// One unbindDose scenario
+typedef struct {
+    double E;              // total energy released (J)
+    double eta;            // fraction of E emitted as radiation
+    double d;              // distance from the event (m)
+    double A;              // fraction of radiation absorbed by body
+    double M;              // body mass (kg)
+    double f;              // fraction of body exposed
+    double theta_deg;      // angle of incidence for the lower bound (degrees)
+    double atmos_trans;    // atmospheric transmission factor (1.0 = vacuum)
+} unbind_dose_input;
+
+typedef struct {
+    double fluence;        // attenuated fluence (J/m^2)
+    double dose_upper;     // overhead exposure (Gy)
+    double dose_lower;     // exposure at theta_deg (Gy)
+} unbind_dose_result;
+
+// Multi-group photon attenuation (libunbind_spectrum.c): eta E split into n energy groups,
+// each attenuated through a column of absorber by its own mass attenuation coefficient
+#define UNBIND_ABSORBER_AIR 0
+#define UNBIND_ABSORBER_WATER 1
+#define UNBIND_ABSORBER_COUNT 2
+
+typedef struct {
+    int n;                 // energy groups
+    const double* weight;  // share of the emitted energy in each group (sums to 1)
+    const double* mu;      // absorber mass attenuation coefficient per group (cm^2/g)
+} unbind_spectrum;
+
+// Layered spherical atmosphere for slant-path columns (libunbind_spectrum.c): exponential
+// within each layer and continuous in density, with the column from the ground tabulated
+// by zenith angle from each layer's Chapman function
+#define UNBIND_ATMOSPHERE_LAYERS 8
+#define UNBIND_SLANT_POINTS 1024
+
+typedef struct {
+    double radius;                                  // to altitude 0 (m)
+    int n;                                          // layers
+    double base[UNBIND_ATMOSPHERE_LAYERS];          // altitude of each layer's base (m), base[0] = 0
+    double H[UNBIND_ATMOSPHERE_LAYERS];             // scale height in each layer (m)
+    double rho[UNBIND_ATMOSPHERE_LAYERS];           // density at each base (g/cm^3)
+    // Filled by unbind_atmosphere_init(): the column (g/cm^2) over w = y / (1 + y),
+    // y = y_scale cos(zenith), w_scale table points per unit w
+    double y_scale, w_scale;
+    double column[UNBIND_SLANT_POINTS];
+} unbind_atmosphere;
+
+// Atmospheric entry model (libunbind_entry.c): n impactors on straight paths through the
+// planet's exponential atmosphere, with drag, ablation and gravity
+#define UNBIND_ENTRY_SURFACE 0     // reached the surface (the 1-bar level on giant planets)
+#define UNBIND_ENTRY_ABLATED 1     // ablated to below 1e-9 of its mass
+#define UNBIND_ENTRY_STOPPED 2     // slowed below 0.1% of the entry speed (dark flight)
+#define UNBIND_ENTRY_MAX_STEPS 3   // step cap hit; results are where it stopped
+
+typedef struct {
+    int    planet;         // PLANET_*: atmosphere (the Moon and vacuum deliver everything)
+    int    material;       // MATERIAL_*: drag and heat-transfer coefficients, heat of ablation
+    double speed;          // entry speed (km/s) used when speed_v is NULL
+    double angle_deg;      // entry angle above the horizon, (0, 90]
+    double rho;            // impactor density (kg/m^3) used when rho_v is NULL
+    const double* D_km;    // n diameters (km)
+    const double* speed_v; // optional per-element entry speed
+    const double* rho_v;   // optional per-element density
+    size_t n;
+} unbind_entry_input;
+
+// Output columns; any pointer may be NULL to skip that column
+typedef struct {
+    double* fraction;      // kinetic energy delivered / kinetic energy at entry
+    double* mass_fraction; // surviving mass / entry mass
+    double* v_end;         // m/s at the surface, or where the body stopped or ablated away
+    int*    outcome;       // UNBIND_ENTRY_*
+    int*    steps;         // accepted integrator steps
+} unbind_entry_result;
+
+// Fragmentation (pancake) model: the entry model, except that the body breaks up once the
+// ram pressure exceeds its strength and the debris then spreads sideways, so airbursts
+// come out explicitly. Inputs as unbind_entry_input, plus strength and the deposition bins.
+typedef struct {
+    int    planet;         // PLANET_*
+    int    material;       // MATERIAL_*
+    double speed;          // entry speed (km/s) used when speed_v is NULL
+    double angle_deg;      // entry angle above the horizon, (0, 90]
+    double rho;            // impactor density (kg/m^3) used when rho_v is NULL
+    double strength;       // Pa, used when strength_v is NULL; 0 for the material's default
+    const double* D_km;    // n diameters (km)
+    const double* speed_v; // optional per-element entry speed
+    const double* rho_v;   // optional per-element density
+    const double* strength_v;  // optional per-element strength
+    double bin_km;         // deposition bin height (km); bin b covers [b, b + 1) bin_km
+    int    n_bins;         // bins per trajectory, from the surface up; 0 for none
+    size_t n;
+} unbind_frag_input;
+
+// Output columns; any pointer may be NULL to skip that column
+typedef struct {
+    double* breakup_km;    // altitude where the ram pressure reached the strength, NaN if never
+    double* burst_km;      // altitude of the peak energy deposition rate, NaN without an atmosphere
+    double* peak_J_m;      // that peak rate, J per metre of altitude
+    double* fraction;      // kinetic energy delivered / kinetic energy at entry
+    double* mass_fraction; // surviving mass / entry mass
+    double* v_end;         // m/s, as unbind_entry_result
+    double* deposition;    // n x n_bins energy deposited in the air (J) per altitude bin,
+                           // row-major; overwritten, and the caller's to reuse between calls
+    int*    outcome;       // UNBIND_ENTRY_*
+    int*    steps;         // accepted integrator steps
+} unbind_frag_result;
+
+// Entry-model retention for one planet and material, tabulated on a regular grid over log10
+// diameter, log10 entry speed and entry angle (unbind_surface.c builds the tables and maps
+// them from disk). The model sees size and density only through their product, so the
+// diameter axis is the equivalent diameter at UNBIND_DEFAULT_DENSITY: D rho / 3000.
+// The values belong to the caller.
+#define UNBIND_SURFACE_AXES 3
+#define UNBIND_SURFACE_DIAMETER 0  // log10 km at 3000 kg/m^3
+#define UNBIND_SURFACE_SPEED 1     // log10 km/s
+#define UNBIND_SURFACE_ANGLE 2     // degrees above the horizon
+
+typedef struct {
+    int    n[UNBIND_SURFACE_AXES];        // grid points per axis, >= 2
+    double lo[UNBIND_SURFACE_AXES];       // first and last point, in axis units
+    double hi[UNBIND_SURFACE_AXES];
+    double scale[UNBIND_SURFACE_AXES];    // (n - 1) / (hi - lo)
+    size_t stride[UNBIND_SURFACE_AXES];   // diameter varies fastest
+    const float* value;                   // delivered energy fraction at each grid point
+} unbind_retention_surface;
+
+// Retention for unbind_solve_soa_model(): ret[j] for diameter D_km[j] (km) and density rho_v[j]
+// (rho when rho_v is NULL). row[j] is the element's index in the solve call, for models with
+// per-element parameters.
+typedef void (*unbind_retention_model)(void* ctx, const double* D_km, const double* rho_v, double rho,
+                                       const size_t* row, size_t n, double* ret);
+
+/* Planet and material tables */
+double get_planetary_binding_energy(int planet_type);
+double atmospheric_retention(double diameter_km, int planet_type, int material_type);
+const unbind_retention_table* unbind_retention_table_for(int planet_type, int material_type);
+double unbind_retention_lookup(const unbind_retention_table* t, double diameter_km);
+void unbind_v_init(unbind_v_state* s, const unbind_retention_table* t, double D_vac_km, double D_top_km);
+int unbind_v_step(unbind_v_state* s, const unbind_retention_table* t, double ret, double D_next_km,
+                  double ret_next);   // returns s->state
+int get_planet_type(const char* planet_name);       // unknown names -> PLANET_EARTH
+int get_material_type(const char* material_name);   // unknown names -> MATERIAL_STONY
+int unbind_lookup_planet(const char* planet_name);  // unknown names -> -1
+int unbind_lookup_material(const char* material_name);
+const char* unbind_planet_name(int planet_type);
+const char* unbind_material_name(int material_type);
+int unbind_parse_planet_list(const char* list, int* out, int max);     // "all" or "earth,mars"
+int unbind_parse_material_list(const char* list, int* out, int max);
+
+/* unbindEnergy solvers */
+void unbind_input_defaults(unbind_input* in);
+void unbind_mass_to_speed(double m, double eps, double U, int planet_type, int material_type,
+                          unbind_result* r);
+void unbind_diameter_to_speed(double D_km, double rho, double eps, double U, int planet_type,
+                              int material_type, unbind_result* r);
+int unbind_speed_to_mass(double v_km_s, double rho, double eps, double U, int planet_type,
+                         int material_type, unbind_result* r);
+int unbind_solve(const unbind_input* in, unbind_result* out);
+size_t unbind_solve_array(const unbind_input* in, unbind_result* out, size_t n);  // returns failures
+
+/* SIMD structure-of-arrays kernels (libunbind_simd.c). Speeds at or above c give NaN. */
+int unbind_simd_level(void);                 // best UNBIND_SIMD_* supported by this CPU
+const char* unbind_simd_name(int level);
+int unbind_solve_soa(const unbind_soa_input* in, unbind_soa_result* out);
+int unbind_solve_soa_level(const unbind_soa_input* in, unbind_soa_result* out, int level);
+void unbind_retention_array(const unbind_retention_table* t, const double* D_km, double* out, size_t n);
+
+/* Atmospheric entry model (libunbind_entry.c). Invalid elements give NaN. */
+int unbind_entry_array(const unbind_entry_input* in, unbind_entry_result* out);
+int unbind_entry_array_level(const unbind_entry_input* in, unbind_entry_result* out, int level);
+// unbind_solve_soa() with each row's retention taken from the entry model (the energy
+// fraction its impactor delivers entering at speed_km_s and angle_deg) instead of the table
+int unbind_entry_solve_soa(const unbind_soa_input* in, double speed_km_s, double angle_deg,
+                           unbind_soa_result* out);
+// Retention surfaces: trilinear lookup, clamped to the grid (a few ns, no libm calls)
+int unbind_surface_init(unbind_retention_surface* s, const int n[UNBIND_SURFACE_AXES],
+                        const double lo[UNBIND_SURFACE_AXES], const double hi[UNBIND_SURFACE_AXES],
+                        const float* value);
+size_t unbind_surface_size(const unbind_retention_surface* s);            // grid points
+double unbind_surface_axis(const unbind_retention_surface* s, int axis, int i);  // km, km/s, degrees
+double unbind_surface_lookup(const unbind_retention_surface* s, double D_km, double speed_km_s,
+                             double rho, double angle_deg);
+void unbind_surface_array(const unbind_retention_surface* s, const double* D_km, const double* speed_v,
+                          double speed_km_s, const double* rho_v, double rho, const double* angle_v,
+                          double angle_deg, double* out, size_t n);
+// unbind_solve_soa() with retention from any model, or from a surface (speed_v and angle_v,
+// when given, are indexed like in->value)
+int unbind_solve_soa_model(const unbind_soa_input* in, unbind_retention_model model, void* ctx,
+                           unbind_soa_result* out);
+int unbind_surface_solve_soa(const unbind_soa_input* in, const unbind_retention_surface* s,
+                             const double* speed_v, double speed_km_s, const double* angle_v,
+                             double angle_deg, unbind_soa_result* out);
+// Fragmentation model: lockstep groups as in the entry model; allocates nothing
+int unbind_frag_array(const unbind_frag_input* in, unbind_frag_result* out);
+int unbind_frag_array_level(const unbind_frag_input* in, unbind_frag_result* out, int level);
+double unbind_frag_strength(int material_type);     // default strength (Pa), NaN if unknown
+
+/* unbindDose model */
+double calc_dose(double F, double A, double f, double M, double cos_theta);
+void unbind_dose_defaults(unbind_dose_input* in);
+void unbind_dose(const unbind_dose_input* in, unbind_dose_result* out);
+void unbind_dose_array(const unbind_dose_input* in, unbind_dose_result* out, size_t n);
+void unbind_dose_coefficients(const unbind_dose_input* in, double* k_upper, double* k_lower);  // Gy m^2
+// Dose-field row (libunbind_simd.c): k / r^2 as float for observers at x = x0 + i dx, i < n,
+// measured from the event, r2_yz being their squared distance from it along the other axes
+void unbind_dose_row(double k_upper, double k_lower, double x0, double dx, double r2_yz,
+                     float* upper, float* lower, size_t n);
+
+/* Multi-group attenuation (libunbind_spectrum.c) */
+int unbind_lookup_absorber(const char* name);           // UNBIND_ABSORBER_*, or -1
+const char* unbind_absorber_name(int absorber);
+double unbind_attenuation(int absorber, double e_mev);  // mu/rho (cm^2/g), NIST tables
+// mu at e_mev from any table of n (energy, mu) pairs in increasing energy, log-log
+double unbind_attenuation_table(const double* energy_mev, const double* mu, int n, double e_mev);
+// n log-spaced groups over [e_lo, e_hi]: centre energies and blackbody weights at kT
+// (flat per ln E when kT <= 0), normalized to 1
+int unbind_spectrum_groups(int n, double e_lo_mev, double e_hi_mev, double kT_mev, double* energy_mev,
+                           double* weight);
+// T[i] = sum_g weight[g] exp(-mu[g] X[i]): the transmitted fraction through X[i] g/cm^2
+void unbind_spectrum_transmission(const unbind_spectrum* s, const double* X, double* T, size_t n);
+void unbind_spectrum_transmission_level(const unbind_spectrum* s, const double* X, double* T, size_t n,
+                                        int level);
+// n layers with bases base_m[] (base_m[0] = 0) and scale heights H_m[] over a sphere of
+// radius_m, rho0 g/cm^3 at altitude 0; builds the slant-column table
+int unbind_atmosphere_init(unbind_atmosphere* a, double radius_m, double rho0_g_cm3, int n,
+                           const double* base_m, const double* H_m);
+// Built-in profile of a PLANET_*: layered US Standard Atmosphere for Earth, one layer elsewhere
+int unbind_atmosphere_planet(unbind_atmosphere* a, int planet);
+// X[i]: column (g/cm^2) from altitude 0 to space at cos(zenith) mu[i]; Inf for mu[i] <= 0
+void unbind_slant_column(const unbind_atmosphere* a, const double* mu, double* X, size_t n);
+void unbind_slant_column_level(const unbind_atmosphere* a, const double* mu, double* X, size_t n, int level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1140 @@
+/* libunbind_entry.c
+* (C) 2025 - George McGinn - MIT License
+* Atmospheric entry model: drag, ablation and gravity along the impactor's path through an
+* exponential atmosphere, as a physics-based alternative to the retention step tables.
+* Build: gcc -O2 -c libunbind_entry.c -o libunbind_entry.o   (part of libunbind)
+*
+* Notes:
+*  - Single-body equations on a straight path at angle theta above the horizon (flat planet):
+*      dv/dt     = g sin(theta) - Cd rho_a A v^2 / (2 m)
+*      dm/dt     = -Ch rho_a A v^3 / (2 Q)
+*      drho_a/dt = rho_a v sin(theta) / H          (rho_a = rho_0 exp(-h / H))
+*      dh/dt     = -v sin(theta)
+*    The body keeps its shape, so A = A0 (m/m0)^(2/3). Integrating s = (m/m0)^(1/3) instead
+*    of m, and the air density alongside the altitude, makes every right-hand side rational:
+*      dv/dt = g sin(theta) - Cd k rho_a v^2 / s,   ds/dt = -Ch k rho_a v^3 / (3 Q),
+*      k = 3 / (8 r0 rho_i)
+*    so the integrator needs no exp, pow or cbrt.
+*  - A trajectory starts ENTRY_TOP_SCALE_HEIGHTS scale heights up and ends at the surface
+*    (the 1-bar level on the giant planets), when less than ENTRY_MIN_S^3 of the mass is
+*    left, or when the body has slowed below ENTRY_STOP_SPEED of its entry speed. The
+*    delivered fraction is m v^2 at the end over m v^2 at entry. It can slightly exceed 1 on
+*    large bodies where gravity adds more energy over the path than the air takes away.
+*  - Dormand-Prince 5(4) with a step size per trajectory. Trajectories advance in lockstep
+*    in groups of ENTRY_LANES: each stage is one loop over the lanes, which the compiler
+*    vectorizes, and AVX2 / AVX-512 copies of the step are picked at run time as in
+*    libunbind_simd.c. A lane that finishes is refilled from the next input at once, so
+*    long and short trajectories do not hold each other up. The controller scales the step
+*    by err^(-1/4) (two square roots) rather than err^(-1/5), to keep pow() out of the loop.
+*  - All paths perform the same IEEE operations in the same order (no FMA) and return
+*    bit-identical results.
+*  - Atmospheres: surface density, scale height and gravity from the NSSDCA fact sheets
+*    (see Atmospheric_Shielding_Effects_on_Planetary_Impactors.md). Materials: Cd = 1,
+*    Ch = 0.1, Q = 8 MJ/kg for stony and iron bodies, 2.5 MJ/kg for cometary ones.
+*  - A trajectory costs a few hundred steps, thousands of times a table lookup;
+*    unbind_entry_solve_soa() is meant to be called from the sweep's worker threads.
+*  - Size and density enter only through k, so a trajectory depends on D rho, not on D and
+*    rho apart. Retention surfaces use that to tabulate the delivered fraction once over
+*    (log10 D rho / 3000, log10 v, angle) for runs too large to integrate every sample. The
+*    lookup is trilinear on float values with a libm-free log10 and costs a few
+*    nanoseconds; away from the grid it clamps to the nearest edge.
+*  - unbind_solve_soa_model() is the solver behind both: any retention model that maps
+*    diameters to delivered fractions drives the 'm', 'd' and 'v' modes.
+*  - unbind_frag_array() adds breakup (the pancake model). The body is intact until the
+*    ram pressure rho_a v^2 reaches its strength; from then on its radius R grows as
+*      R d^2R/dt^2 = Cd rho_a v^2 / (2 rho_i)
+*    and drag and ablation act on the spreading area, until R reaches FRAG_PANCAKE_LIMIT
+*    times the original and the debris cloud flies on at that size. The state is
+*    (v, m/m0, R/R0, d(R/R0)/dt, rho_a, h) and runs in lockstep groups like the entry
+*    model; with an infinite strength it reproduces unbind_entry_array() to 1e-5.
+*  - Energy given to the air on each accepted step (kinetic energy lost plus the work
+*    of gravity) is spread evenly over the altitude the step covered, into the caller's
+*    bins, and the step with the largest energy per metre marks the burst altitude.
+*    Default strengths (5 MPa stony, 50 MPa iron, 0.1 MPa cometary) put a Chelyabinsk-
+*    like body (19 m, 19 km/s, 18 degrees) into its peak at about 30 km and a 60 m
+*    Tunguska-like one (15 km/s, 45 degrees) at about 11 km.
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "libunbind.h"
+
+// Keep GCC from contracting a*b+c so every path rounds identically
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define UNBIND_HAVE_X86_SIMD 1
+#endif
+
+#define ENTRY_LANES 8                  // trajectories per lockstep group
+#define ENTRY_BLOCK 256                // rows per unbind_solve_soa_model() block
+#define SURFACE_LANES 16               // lookups interleaved by unbind_surface_array()
+#define ENTRY_TOP_SCALE_HEIGHTS 15.0   // start altitude (rho_a = 3e-7 rho_0)
+#define ENTRY_RTOL 1e-7                // relative tolerance per step
+#define ENTRY_MIN_S 1e-3               // (m/m0)^(1/3) at which the body counts as ablated
+#define ENTRY_STOP_SPEED 1e-3          // fraction of the entry speed at which it counts as stopped
+#define ENTRY_GROUND_M 1.0             // altitude (m) at which the surface is reached
+#define ENTRY_STEP_CAP 100000          // step attempts per trajectory
+#define ENTRY_SOLVE_ITER 60            // unbind_entry_solve_soa() 'v' root-finder rounds
+#define ENTRY_SOLVE_TOL 1e-10          // on log diameter
+#define FRAG_PANCAKE_LIMIT 7.0         // R/R0 at which fragmented debris stops spreading
+
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#define PARAM(arr, scalar, i) ((arr) ? (arr)[i] : (scalar))
+
+typedef struct {
+    double rho0;           // surface (1 bar) density, kg/m^3; 0 for airless bodies
+    double H;              // scale height, m
+    double g;              // surface gravity, m/s^2
+} entry_atmosphere;
+
+typedef struct {
+    double Cd;             // drag coefficient
+    double Ch;             // heat-transfer coefficient
+    double Q;              // heat of ablation, J/kg
+} entry_material;
+
+static const entry_atmosphere atmospheres[PLANET_COUNT] = {
+    [PLANET_EARTH]   = { 1.217,   8500.0,  9.81 },
+    [PLANET_MARS]    = { 0.020,  11100.0,  3.71 },
+    [PLANET_VENUS]   = { 65.0,   15900.0,  8.87 },
+    [PLANET_JUPITER] = { 0.16,   27000.0, 24.79 },
+    [PLANET_SATURN]  = { 0.19,   59500.0, 10.44 },
+    [PLANET_URANUS]  = { 0.42,   27700.0,  8.87 },
+    [PLANET_NEPTUNE] = { 0.45,   19700.0, 11.15 },
+    [PLANET_PLUTO]   = { 8.0e-5, 60000.0,  0.62 },
+    [PLANET_MOON]    = { 0.0,        1.0,  1.62 },
+    [PLANET_VACUUM]  = { 0.0,        1.0,  0.0 },
+};
+
+static const entry_material materials[MATERIAL_COUNT] = {
+    [MATERIAL_STONY]    = { 1.0, 0.1, 8.0e6 },
+    [MATERIAL_IRON]     = { 1.0, 0.1, 8.0e6 },
+    [MATERIAL_COMETARY] = { 1.0, 0.1, 2.5e6 },
+};
+
+// Dormand-Prince 5(4): stage weights, and the 5th-order minus the 4th-order solution
+static const double DP_A[6][6] = {
+    { 1.0/5.0 },
+    { 3.0/40.0, 9.0/40.0 },
+    { 44.0/45.0, -56.0/15.0, 32.0/9.0 },
+    { 19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0 },
+    { 9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0 },
+    { 35.0/384.0, 0.0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0 },
+};
+static const double DP_E[7] = {
+    71.0/57600.0, 0.0, -71.0/16695.0, 71.0/1920.0, -17253.0/339200.0, 22.0/525.0, -1.0/40.0
+};
+
+// One lockstep group. Idle lanes hold a harmless dummy state.
+typedef struct {
+    double v[ENTRY_LANES], s[ENTRY_LANES], r[ENTRY_LANES], h[ENTRY_LANES];      // state
+    double pv[ENTRY_LANES], ps[ENTRY_LANES], ph[ENTRY_LANES];                  // start of the last accepted step
+    double drag[ENTRY_LANES];      // Cd k
+    double abl[ENTRY_LANES];       // Ch k / (3 Q)
+    double dt[ENTRY_LANES];
+    int    accepted[ENTRY_LANES];
+} entry_lanes;
+
+typedef struct {
+    double gs;             // g sin(theta)
+    double sn;             // sin(theta)
+    double up;             // sin(theta) / H
+} entry_path;
+
+static ALWAYS_INLINE void entry_rhs(const entry_lanes* e, const entry_path* c, const double* v,
+                                    const double* s, const double* r, double* dv, double* ds,
+                                    double* dr, double* dh) {
+    for (int l = 0; l < ENTRY_LANES; l++) {
+        double q = r[l] * v[l];
+        dv[l] = c->gs - e->drag[l] * q * v[l] / s[l];
+        ds[l] = -e->abl[l] * q * v[l] * v[l];
+        dr[l] = q * c->up;
+        dh[l] = -v[l] * c->sn;
+    }
+}
+
+static ALWAYS_INLINE double max2(double a, double b) { return a > b ? a : b; }
+
+// One Dormand-Prince step on every lane: accept or reject it and pick the next step size
+static ALWAYS_INLINE void entry_step(entry_lanes* e, const entry_path* c) {
+    double kv[7][ENTRY_LANES], ks[7][ENTRY_LANES], kr[7][ENTRY_LANES], kh[7][ENTRY_LANES];
+    double yv[ENTRY_LANES], ys[ENTRY_LANES], yr[ENTRY_LANES], yh[ENTRY_LANES];
+    double tv[ENTRY_LANES], ts[ENTRY_LANES], tr[ENTRY_LANES], th[ENTRY_LANES];
+
+    entry_rhs(e, c, e->v, e->s, e->r, kv[0], ks[0], kr[0], kh[0]);
+    for (int j = 1; j < 7; j++) {
+        for (int l = 0; l < ENTRY_LANES; l++) tv[l] = ts[l] = tr[l] = th[l] = 0.0;
+        for (int i = 0; i < j; i++) {
+            double a = DP_A[j-1][i];
+            for (int l = 0; l < ENTRY_LANES; l++) {
+                tv[l] += a * kv[i][l];
+                ts[l] += a * ks[i][l];
+                tr[l] += a * kr[i][l];
+                th[l] += a * kh[i][l];
+            }
+        }
+        for (int l = 0; l < ENTRY_LANES; l++) {
+            yv[l] = e->v[l] + e->dt[l] * tv[l];
+            ys[l] = e->s[l] + e->dt[l] * ts[l];
+            yr[l] = e->r[l] + e->dt[l] * tr[l];
+            yh[l] = e->h[l] + e->dt[l] * th[l];
+        }
+        entry_rhs(e, c, yv, ys, yr, kv[j], ks[j], kr[j], kh[j]);
+    }
+    // The 7th stage point is the 5th-order solution (y now holds it)
+
+    for (int l = 0; l < ENTRY_LANES; l++) tv[l] = ts[l] = tr[l] = th[l] = 0.0;
+    for (int i = 0; i < 7; i++) {
+        double a = DP_E[i];
+        for (int l = 0; l < ENTRY_LANES; l++) {
+            tv[l] += a * kv[i][l];
+            ts[l] += a * ks[i][l];
+            tr[l] += a * kr[i][l];
+            th[l] += a * kh[i][l];
+        }
+    }
+    double err[ENTRY_LANES], fac[ENTRY_LANES];
+    for (int l = 0; l < ENTRY_LANES; l++) {
+        double dt = e->dt[l];
+        double ev = fabs(dt * tv[l]) / (ENTRY_RTOL * max2(fabs(e->v[l]), fabs(yv[l])) + 1e-6);
+        double es = fabs(dt * ts[l]) / (ENTRY_RTOL * max2(fabs(e->s[l]), fabs(ys[l])) + 1e-12);
+        double er = fabs(dt * tr[l]) / (ENTRY_RTOL * max2(fabs(e->r[l]), fabs(yr[l])) + 1e-30);
+        double eh = fabs(dt * th[l]) / (ENTRY_RTOL * max2(fabs(e->h[l]), fabs(yh[l])) + 1e-3);
+        err[l] = max2(max2(ev, es), max2(er, eh));
+    }
+    // sqrt() may set errno, which keeps this loop scalar; it is 8 roots against 7 stages
+    for (int l = 0; l < ENTRY_LANES; l++) fac[l] = 0.9 / sqrt(sqrt(err[l]));
+    for (int l = 0; l < ENTRY_LANES; l++) {
+        double f = fac[l] >= 0.2 ? fac[l] : 0.2;           // also catches NaN
+        f = f <= 5.0 ? f : 5.0;
+        int ok = err[l] <= 1.0;
+        e->accepted[l] = ok;
+        e->pv[l] = ok ? e->v[l] : e->pv[l];
+        e->ps[l] = ok ? e->s[l] : e->ps[l];
+        e->ph[l] = ok ? e->h[l] : e->ph[l];
+        e->v[l] = ok ? yv[l] : e->v[l];
+        e->s[l] = ok ? ys[l] : e->s[l];
+        e->r[l] = ok ? yr[l] : e->r[l];
+        e->h[l] = ok ? yh[l] : e->h[l];
+        // Do not step far past the ground: at most the time to fall the remaining height
+        double to_ground = (e->h[l] + 0.5 * ENTRY_GROUND_M) / (e->v[l] * c->sn);
+        double dt = e->dt[l] * f;
+        e->dt[l] = dt <= to_ground ? dt : to_ground;
+    }
+}
+
+typedef void (*entry_step_fn)(entry_lanes* e, const entry_path* c);
+
+static void entry_step_scalar(entry_lanes* e, const entry_path* c) { entry_step(e, c); }
+
+#ifdef UNBIND_HAVE_X86_SIMD
+static __attribute__((target("avx2"))) void entry_step_avx2(entry_lanes* e, const entry_path* c) {
+    entry_step(e, c);
+}
+static __attribute__((target("avx512f"))) void entry_step_avx512(entry_lanes* e, const entry_path* c) {
+    entry_step(e, c);
+}
+#endif
+
+static entry_step_fn select_step(int level) {
+#ifdef UNBIND_HAVE_X86_SIMD
+    if (level >= UNBIND_SIMD_AVX512 && __builtin_cpu_supports("avx512f")) return entry_step_avx512;
+    if (level >= UNBIND_SIMD_AVX2 && __builtin_cpu_supports("avx2")) return entry_step_avx2;
+#else
+    (void)level;
+#endif
+    return entry_step_scalar;
+}
+
+static void put_result(unbind_entry_result* out, size_t i, double fraction, double mass_fraction,
+                       double v_end, int outcome, int steps) {
+    if (out->fraction) out->fraction[i] = fraction;
+    if (out->mass_fraction) out->mass_fraction[i] = mass_fraction;
+    if (out->v_end) out->v_end[i] = v_end;
+    if (out->outcome) out->outcome[i] = outcome;
+    if (out->steps) out->steps[i] = steps;
+}
+
+// One unbind_entry_array() call: the lockstep group and where each lane's row came from
+typedef struct {
+    const unbind_entry_input* in;
+    unbind_entry_result* out;
+    const entry_atmosphere* atm;
+    const entry_material* mat;
+    entry_path path;
+    double h_top, r_top;           // start altitude and air density
+    entry_lanes e;
+    size_t row[ENTRY_LANES];       // input index, or ENTRY_IDLE
+    double v_in[ENTRY_LANES];      // entry speed, m/s
+    int steps[ENTRY_LANES], tries[ENTRY_LANES];
+    size_t next;                   // next input to start
+    int active;
+} entry_run;
+
+#define ENTRY_IDLE ((size_t)-1)
+
+// Start the next input that needs integrating on lane l, or leave the lane idle
+static void fill_lane(entry_run* run, int l) {
+    const unbind_entry_input* in = run->in;
+    entry_lanes* e = &run->e;
+    e->v[l] = e->s[l] = e->h[l] = e->dt[l] = 1.0;
+    e->pv[l] = e->ps[l] = e->ph[l] = 1.0;
+    e->r[l] = e->drag[l] = e->abl[l] = 0.0;
+    run->row[l] = ENTRY_IDLE;
+    while (run->next < in->n) {
+        size_t i = run->next++;
+        double D = in->D_km[i];
+        double v = PARAM(in->speed_v, in->speed, i) * 1000.0;
+        double rho = PARAM(in->rho_v, in->rho, i);
+        if (!(D > 0.0 && v > 0.0 && rho > 0.0) || isinf(D) || isinf(v)) {
+            put_result(run->out, i, NAN, NAN, NAN, UNBIND_ENTRY_SURFACE, 0);
+            continue;
+        }
+        if (run->atm->rho0 <= 0.0) {
+            put_result(run->out, i, 1.0, 1.0, v, UNBIND_ENTRY_SURFACE, 0);
+            continue;
+        }
+        double k = 3.0 / (8.0 * D * 500.0 * rho);
+        e->drag[l] = run->mat->Cd * k;
+        e->abl[l] = run->mat->Ch * k / (3.0 * run->mat->Q);
+        e->v[l] = e->pv[l] = v;
+        e->s[l] = e->ps[l] = 1.0;
+        e->r[l] = run->r_top;
+        e->h[l] = e->ph[l] = run->h_top;
+        e->dt[l] = 0.01 * run->atm->H / (v * run->path.sn);
+        run->row[l] = i;
+        run->v_in[l] = v;
+        run->steps[l] = run->tries[l] = 0;
+        run->active++;
+        return;
+    }
+}
+
+// Lane l after a step: write its result and refill it if the trajectory has ended
+static void finish_lane(entry_run* run, int l) {
+    entry_lanes* e = &run->e;
+    run->tries[l]++;
+    run->steps[l] += e->accepted[l];
+    int outcome = -1;
+    double v = e->v[l], s = e->s[l];
+    if (e->h[l] <= ENTRY_GROUND_M) {
+        outcome = UNBIND_ENTRY_SURFACE;
+        if (e->h[l] < 0.0) {
+            // Back up along the last step to h = 0
+            double w = e->ph[l] / (e->ph[l] - e->h[l]);
+            v = e->pv[l] + w * (v - e->pv[l]);
+            s = e->ps[l] + w * (s - e->ps[l]);
+        }
+    } else if (s <= ENTRY_MIN_S) {
+        outcome = UNBIND_ENTRY_ABLATED;
+    } else if (v <= ENTRY_STOP_SPEED * run->v_in[l]) {
+        outcome = UNBIND_ENTRY_STOPPED;
+    } else if (run->tries[l] >= ENTRY_STEP_CAP) {
+        outcome = UNBIND_ENTRY_MAX_STEPS;
+    }
+    if (outcome < 0) return;
+    s = s > 0.0 ? s : 0.0;
+    double mass = s * s * s;
+    double ratio = v / run->v_in[l];
+    put_result(run->out, run->row[l], mass * ratio * ratio, mass, v, outcome, run->steps[l]);
+    run->active--;
+    fill_lane(run, l);
+}
+
+int unbind_entry_array_level(const unbind_entry_input* in, unbind_entry_result* out, int level) {
+    if (in->planet < 0 || in->planet >= PLANET_COUNT || in->material < 0 || in->material >= MATERIAL_COUNT ||
+        !(in->angle_deg > 0.0 && in->angle_deg <= 90.0))
+        return UNBIND_ERR_INPUT;
+    entry_step_fn step = select_step(level);
+    entry_run run;
+    memset(&run, 0, sizeof(run));
+    run.in = in;
+    run.out = out;
+    run.atm = &atmospheres[in->planet];
+    run.mat = &materials[in->material];
+    run.path.sn = sin(in->angle_deg * UNBIND_PI / 180.0);
+    run.path.gs = run.atm->g * run.path.sn;
+    run.path.up = run.path.sn / run.atm->H;
+    run.h_top = ENTRY_TOP_SCALE_HEIGHTS * run.atm->H;
+    run.r_top = run.atm->rho0 * exp(-ENTRY_TOP_SCALE_HEIGHTS);
+
+    for (int l = 0; l < ENTRY_LANES; l++) fill_lane(&run, l);
+    while (run.active > 0) {
+        step(&run.e, &run.path);
+        for (int l = 0; l < ENTRY_LANES; l++)
+            if (run.row[l] != ENTRY_IDLE) finish_lane(&run, l);
+    }
+    return UNBIND_OK;
+}
+
+int unbind_entry_array(const unbind_entry_input* in, unbind_entry_result* out) {
+    return unbind_entry_array_level(in, out, UNBIND_SIMD_AVX512);
+}
+
+
+/* ---------------------------------------------------------------------------
+ * Retention surfaces: the entry model tabulated on a regular grid
+ * ------------------------------------------------------------------------- */
+
+int unbind_surface_init(unbind_retention_surface* s, const int n[UNBIND_SURFACE_AXES],
+                        const double lo[UNBIND_SURFACE_AXES], const double hi[UNBIND_SURFACE_AXES],
+                        const float* value) {
+    size_t stride = 1;
+    for (int a = 0; a < UNBIND_SURFACE_AXES; a++) {
+        if (n[a] < 2 || !(hi[a] > lo[a]) || isinf(lo[a]) || isinf(hi[a])) return UNBIND_ERR_INPUT;
+        s->n[a] = n[a];
+        s->lo[a] = lo[a];
+        s->hi[a] = hi[a];
+        s->scale[a] = (n[a] - 1) / (hi[a] - lo[a]);
+        s->stride[a] = stride;
+        stride *= (size_t)n[a];
+    }
+    if (stride > (size_t)INT32_MAX) return UNBIND_ERR_INPUT;     // corners are indexed with int
+    s->value = value;
+    return UNBIND_OK;
+}
+
+size_t unbind_surface_size(const unbind_retention_surface* s) {
+    return s->stride[UNBIND_SURFACE_AXES - 1] * (size_t)s->n[UNBIND_SURFACE_AXES - 1];
+}
+
+double unbind_surface_axis(const unbind_retention_surface* s, int axis, int i) {
+    double x = s->lo[axis] + (s->hi[axis] - s->lo[axis]) * i / (s->n[axis] - 1);
+    if (i == s->n[axis] - 1) x = s->hi[axis];
+    return axis == UNBIND_SURFACE_ANGLE ? x : pow(10.0, x);
+}
+
+// log10 without libm, to well under a cell: exponent from the bits, then
+// ln m = 2 atanh((m-1)/(m+1)) on m in [sqrt(1/2), sqrt(2)), five terms (|z| < 0.172).
+// For positive finite x only. The range reduction is done on the bits, without a branch.
+static ALWAYS_INLINE double surface_log10(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    uint64_t mant = bits & 0x000fffffffffffffULL;
+    int big = mant > 0x6a09e667f3bcdULL;                   // mantissa bits of sqrt(2)
+    int e = (int)(bits >> 52) - 1023 + big;
+    bits = mant | (0x3ff0000000000000ULL - ((uint64_t)big << 52));   // m in [1, 2) or [0.5, 1)
+    double m;
+    memcpy(&m, &bits, sizeof(m));
+    double z = (m - 1.0) / (m + 1.0), z2 = z * z;
+    double ln_m = 2.0 * z * (1.0 + z2 * (1.0/3.0 + z2 * (1.0/5.0 + z2 * (1.0/7.0 + z2 * (1.0/9.0)))));
+    return (e + ln_m * 1.4426950408889634) * 0.30102999566398120;
+}
+
+// Cell index and offset along one axis, clamped to the grid
+static ALWAYS_INLINE double surface_cell(const unbind_retention_surface* s, int a, double x, int* base) {
+    double t = (x - s->lo[a]) * s->scale[a];
+    double top = s->n[a] - 1;
+    t = t > 0.0 ? t : 0.0;
+    t = t < top ? t : top;
+    int i = (int)t;
+    i = i < s->n[a] - 2 ? i : s->n[a] - 2;
+    *base += i * (int)s->stride[a];
+    return t - i;
+}
+
+// Trilinear: 8 corners from the cell at base, interpolated along diameter, then speed and angle
+static ALWAYS_INLINE double surface_corners(const unbind_retention_surface* s, int base, double wd, double wv,
+                                            double wa) {
+    const float* p = s->value;
+    int sv = (int)s->stride[UNBIND_SURFACE_SPEED];
+    int q = base + (int)s->stride[UNBIND_SURFACE_ANGLE];
+    double c0 = p[base] + wd * ((double)p[base + 1] - p[base]);
+    double c1 = p[base + sv] + wd * ((double)p[base + sv + 1] - p[base + sv]);
+    double c2 = p[q] + wd * ((double)p[q + 1] - p[q]);
+    double c3 = p[q + sv] + wd * ((double)p[q + sv + 1] - p[q + sv]);
+    c0 += wv * (c1 - c0);
+    c2 += wv * (c3 - c2);
+    return c0 + wa * (c2 - c0);
+}
+
+double unbind_surface_lookup(const unbind_retention_surface* s, double D_km, double speed_km_s,
+                             double rho, double angle_deg) {
+    if (!(D_km > 0.0 && speed_km_s > 0.0 && rho > 0.0) || isinf(D_km * rho) || isinf(speed_km_s) || isnan(angle_deg))
+        return NAN;
+    int base = 0;
+    double wd = surface_cell(s, UNBIND_SURFACE_DIAMETER, surface_log10(D_km * rho * (1.0 / UNBIND_DEFAULT_DENSITY)), &base);
+    double wv = surface_cell(s, UNBIND_SURFACE_SPEED, surface_log10(speed_km_s), &base);
+    double wa = surface_cell(s, UNBIND_SURFACE_ANGLE, angle_deg, &base);
+    return surface_corners(s, base, wd, wv, wa);
+}
+
+// SURFACE_LANES lookups in phases, each a short loop over the lanes that the compiler
+// vectorizes (gathers for the corners). One lookup alone is a long dependent chain (a
+// division, two polynomials, eight loads), so this is about 3x faster than calling
+// unbind_surface_lookup() per point. Invalid elements are looked up at a harmless point and
+// set to NaN at the end; in one loop with the lookup GCC would branch around it instead.
+static ALWAYS_INLINE void surface_lanes(const unbind_retention_surface* s, const double* D_km, const double* v,
+                                        const double* rho, const double* angle, double* out) {
+    double x[SURFACE_LANES], y[SURFACE_LANES], z[SURFACE_LANES];
+    double wd[SURFACE_LANES], wv[SURFACE_LANES], wa[SURFACE_LANES];
+    int base[SURFACE_LANES], ok[SURFACE_LANES];
+    for (int i = 0; i < SURFACE_LANES; i++) {
+        double dr = D_km[i] * rho[i];
+        ok[i] = (dr > 0.0) & (v[i] > 0.0) & (rho[i] > 0.0) & (dr < INFINITY) & (v[i] < INFINITY) &
+                (angle[i] == angle[i]);
+        x[i] = ok[i] ? dr * (1.0 / UNBIND_DEFAULT_DENSITY) : 1.0;
+        y[i] = ok[i] ? v[i] : 1.0;
+        z[i] = ok[i] ? angle[i] : 0.0;
+    }
+    for (int i = 0; i < SURFACE_LANES; i++) {
+        x[i] = surface_log10(x[i]);
+        y[i] = surface_log10(y[i]);
+    }
+    for (int i = 0; i < SURFACE_LANES; i++) {
+        base[i] = 0;
+        wd[i] = surface_cell(s, UNBIND_SURFACE_DIAMETER, x[i], &base[i]);
+        wv[i] = surface_cell(s, UNBIND_SURFACE_SPEED, y[i], &base[i]);
+        wa[i] = surface_cell(s, UNBIND_SURFACE_ANGLE, z[i], &base[i]);
+    }
+    for (int i = 0; i < SURFACE_LANES; i++) out[i] = surface_corners(s, base[i], wd[i], wv[i], wa[i]);
+    for (int i = 0; i < SURFACE_LANES; i++) out[i] = ok[i] ? out[i] : NAN;
+}
+
+typedef void (*surface_lanes_fn)(const unbind_retention_surface* s, const double* D_km, const double* v,
+                                 const double* rho, const double* angle, double* out);
+
+static void surface_lanes_scalar(const unbind_retention_surface* s, const double* D_km, const double* v,
+                                 const double* rho, const double* angle, double* out) {
+    surface_lanes(s, D_km, v, rho, angle, out);
+}
+
+// GCC's default cost model at -O2 does not vectorize the corner gathers; "cheap" does
+#ifdef UNBIND_HAVE_X86_SIMD
+static __attribute__((target("avx2"), optimize("vect-cost-model=cheap"))) void surface_lanes_avx2(
+        const unbind_retention_surface* s, const double* D_km, const double* v, const double* rho,
+        const double* angle, double* out) {
+    surface_lanes(s, D_km, v, rho, angle, out);
+}
+static __attribute__((target("avx512f"), optimize("vect-cost-model=cheap"))) void surface_lanes_avx512(
+        const unbind_retention_surface* s, const double* D_km, const double* v, const double* rho,
+        const double* angle, double* out) {
+    surface_lanes(s, D_km, v, rho, angle, out);
+}
+#endif
+
+static surface_lanes_fn select_lanes(int level) {
+#ifdef UNBIND_HAVE_X86_SIMD
+    if (level >= UNBIND_SIMD_AVX512 && __builtin_cpu_supports("avx512f")) return surface_lanes_avx512;
+    if (level >= UNBIND_SIMD_AVX2 && __builtin_cpu_supports("avx2")) return surface_lanes_avx2;
+#else
+    (void)level;
+#endif
+    return surface_lanes_scalar;
+}
+
+void unbind_surface_array(const unbind_retention_surface* s, const double* D_km, const double* speed_v,
+                          double speed_km_s, const double* rho_v, double rho, const double* angle_v,
+                          double angle_deg, double* out, size_t n) {
+    surface_lanes_fn lanes = select_lanes(UNBIND_SIMD_AVX512);
+    unbind_retention_surface g = *s;      // a local copy, so the stores cannot alias the axes
+    double D[SURFACE_LANES], v[SURFACE_LANES], r[SURFACE_LANES], a[SURFACE_LANES], f[SURFACE_LANES];
+    for (size_t off = 0; off < n; off += SURFACE_LANES) {
+        size_t m = n - off < SURFACE_LANES ? n - off : SURFACE_LANES;
+        // A short last group is padded with its first element
+        for (size_t i = 0; i < SURFACE_LANES; i++) {
+            size_t k = off + (i < m ? i : 0);
+            D[i] = D_km[k];
+            v[i] = PARAM(speed_v, speed_km_s, k);
+            r[i] = PARAM(rho_v, rho, k);
+            a[i] = PARAM(angle_v, angle_deg, k);
+        }
+        lanes(&g, D, v, r, a, f);
+        memcpy(out + off, f, m * sizeof(double));
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Solvers with a retention model
+ * ------------------------------------------------------------------------- */
+
+// One 'v' block: the model's inputs for the lanes being evaluated, gathered by row
+typedef struct {
+    unbind_retention_model model;
+    void* ctx;
+    const double* rho_v;   // the block's densities, or NULL
+    double rho;
+    size_t off;            // the block's first row in the solve call
+    double x[ENTRY_BLOCK], rho_g[ENTRY_BLOCK], f[ENTRY_BLOCK];
+    size_t row[ENTRY_BLOCK];
+} model_eval;
+
+static void model_set(model_eval* m, size_t j, size_t i, double D_km) {
+    m->x[j] = D_km;
+    m->row[j] = m->off + i;
+    if (m->rho_v) m->rho_g[j] = m->rho_v[i];
+}
+
+static void model_run(model_eval* m, size_t count) {
+    m->model(m->ctx, m->x, m->rho_v ? m->rho_g : NULL, m->rho, m->row, count, m->f);
+}
+
+// 'v' mode for one block. The delivered fraction f grows with D, and at a given speed the
+// required size is D = D_vac f(D)^(-1/3), so x = ln D is the root of the increasing function
+// x - ln D_vac + ln f(e^x) / 3. Each lane is bracketed from D_vac upward by decades and
+// solved by regula falsi (Illinois), every round one model call on the live lanes.
+static void solve_speed_block(model_eval* me, const double* D_vac, size_t n, double* ret, int* iterations) {
+    double lo[ENTRY_BLOCK], hi[ENTRY_BLOCK], g_lo[ENTRY_BLOCK], g_hi[ENTRY_BLOCK];
+    int side[ENTRY_BLOCK], iter[ENTRY_BLOCK];
+    size_t lane[ENTRY_BLOCK];
+    const double* f = me->f;
+
+    // f at D_vac: a lane that already delivers everything needs no search
+    size_t live = 0;
+    for (size_t i = 0; i < n; i++) {
+        iter[i] = 0;
+        if (isnan(D_vac[i])) {
+            ret[i] = NAN;
+            continue;
+        }
+        lane[live] = i;
+        model_set(me, live, i, D_vac[i]);
+        live++;
+    }
+    model_run(me, live);
+    size_t keep = 0, n_over = 0;
+    size_t over[ENTRY_BLOCK];
+    for (size_t j = 0; j < live; j++) {
+        size_t i = lane[j];
+        lo[i] = log(D_vac[i]);
+        g_lo[i] = log(f[j]) / 3.0;
+        hi[i] = lo[i];
+        g_hi[i] = g_lo[i];
+        side[i] = 0;
+        ret[i] = f[j];
+        if (g_lo[i] < 0.0) lane[keep++] = i;
+        else if (!isnan(g_lo[i])) over[n_over++] = i;
+    }
+    live = keep;
+
+    // f(D_vac) >= 1 (gravity adds a little on large bodies): f is flat there, so one
+    // fixed-point step from D_vac is as good as a search
+    if (n_over > 0) {
+        for (size_t j = 0; j < n_over; j++)
+            model_set(me, j, over[j], D_vac[over[j]] * exp(-log(ret[over[j]]) / 3.0));
+        model_run(me, n_over);
+        for (size_t j = 0; j < n_over; j++) {
+            ret[over[j]] = f[j];
+            iter[over[j]] = 1;
+        }
+    }
+
+    // Upper bracket: step up a decade at a time until the lane delivers enough
+    size_t search[ENTRY_BLOCK], n_search = live;
+    memcpy(search, lane, live * sizeof(size_t));
+    for (int round = 0; round < 12 && n_search > 0; round++) {
+        for (size_t j = 0; j < n_search; j++) {
+            size_t i = search[j];
+            hi[i] += log(10.0);
+            model_set(me, j, i, exp(hi[i]));
+        }
+        model_run(me, n_search);
+        keep = 0;
+        for (size_t j = 0; j < n_search; j++) {
+            size_t i = search[j];
+            iter[i]++;
+            g_hi[i] = hi[i] - log(D_vac[i]) + log(f[j]) / 3.0;
+            if (g_hi[i] < 0.0) {
+                lo[i] = hi[i];
+                g_lo[i] = g_hi[i];
+                search[keep++] = i;
+            }
+        }
+        n_search = keep;
+    }
+    // A lane still short after 12 decades is left as NaN
+    keep = 0;
+    for (size_t j = 0; j < live; j++) {
+        size_t i = lane[j];
+        if (g_hi[i] >= 0.0) lane[keep++] = i;
+        else ret[i] = NAN;
+    }
+    live = keep;
+
+    // Illinois: the false-position point, halving the weight of a side kept twice
+    for (int round = 0; round < ENTRY_SOLVE_ITER && live > 0; round++) {
+        for (size_t j = 0; j < live; j++) {
+            size_t i = lane[j];
+            double t = g_lo[i] / (g_lo[i] - g_hi[i]);
+            if (!(t > 0.0 && t < 1.0)) t = 0.5;          // -Inf where nothing is delivered
+            model_set(me, j, i, exp(lo[i] + t * (hi[i] - lo[i])));
+        }
+        model_run(me, live);
+        keep = 0;
+        for (size_t j = 0; j < live; j++) {
+            size_t i = lane[j];
+            double xi = log(me->x[j]);
+            double g = xi - log(D_vac[i]) + log(f[j]) / 3.0;
+            iter[i]++;
+            if (g < 0.0) {
+                lo[i] = xi;
+                g_lo[i] = g;
+                if (side[i] == -1) g_hi[i] *= 0.5;
+                side[i] = -1;
+            } else {
+                hi[i] = xi;
+                g_hi[i] = g;
+                if (side[i] == 1) g_lo[i] *= 0.5;
+                side[i] = 1;
+            }
+            if (hi[i] - lo[i] <= ENTRY_SOLVE_TOL || g == 0.0) ret[i] = f[j];
+            else lane[keep++] = i;
+        }
+        live = keep;
+    }
+    // Round cap: keep the upper end of the bracket (conservative, as UNBIND_V_MAX_ITER)
+    if (live > 0) {
+        for (size_t j = 0; j < live; j++) model_set(me, j, lane[j], exp(hi[lane[j]]));
+        model_run(me, live);
+        for (size_t j = 0; j < live; j++) ret[lane[j]] = f[j];
+    }
+    if (iterations)
+        for (size_t i = 0; i < n; i++) iterations[i] = iter[i];
+}
+
+static unbind_soa_result offset_result(const unbind_soa_result* out, size_t off) {
+    unbind_soa_result r;
+    r.retention = out->retention ? out->retention + off : NULL;
+    r.m = out->m ? out->m + off : NULL;
+    r.D_km = out->D_km ? out->D_km + off : NULL;
+    r.v_class = out->v_class ? out->v_class + off : NULL;
+    r.v_rel = out->v_rel ? out->v_rel + off : NULL;
+    r.m_class = out->m_class ? out->m_class + off : NULL;
+    r.destroyed = out->destroyed ? out->destroyed + off : NULL;
+    r.iterations = out->iterations ? out->iterations + off : NULL;
+    return r;
+}
+
+int unbind_solve_soa_model(const unbind_soa_input* in, unbind_retention_model model, void* ctx,
+                           unbind_soa_result* out) {
+    char mode = in->mode;
+    if (mode != 'm' && mode != 'M' && mode != 'd' && mode != 'D' && mode != 'v' && mode != 'V')
+        return UNBIND_ERR_MODE;
+    if (!model || in->planet < 0 || in->planet >= PLANET_COUNT || in->material < 0 || in->material >= MATERIAL_COUNT)
+        return UNBIND_ERR_INPUT;
+
+    double D_km[ENTRY_BLOCK], ret[ENTRY_BLOCK], D_vac[ENTRY_BLOCK], m[ENTRY_BLOCK];
+    size_t row[ENTRY_BLOCK];
+    int iterations[ENTRY_BLOCK];
+    model_eval me;
+    memset(&me, 0, sizeof(me));
+    me.model = model;
+    me.ctx = ctx;
+    me.rho = in->rho;
+
+    for (size_t off = 0; off < in->n; off += ENTRY_BLOCK) {
+        size_t n = in->n - off < ENTRY_BLOCK ? in->n - off : ENTRY_BLOCK;
+        unbind_soa_input sub = *in;
+        sub.value = in->value + off;
+        sub.rho_v = in->rho_v ? in->rho_v + off : NULL;
+        sub.eps_v = in->eps_v ? in->eps_v + off : NULL;
+        sub.n = n;
+        sub.ret_v = ret;
+        unbind_soa_result r = offset_result(out, off);
+        for (size_t i = 0; i < n; i++) row[i] = off + i;
+
+        switch (mode) {
+            case 'm': case 'M':
+                // Same size estimate as the solver: 3000 kg/m^3
+                for (size_t i = 0; i < n; i++)
+                    D_km[i] = 2.0 * cbrt((3.0 * sub.value[i] / UNBIND_DEFAULT_DENSITY) / (4.0*UNBIND_PI)) / 1000.0;
+                model(ctx, D_km, NULL, UNBIND_DEFAULT_DENSITY, row, n, ret);
+                unbind_solve_soa(&sub, &r);
+                break;
+            case 'd': case 'D':
+                model(ctx, sub.value, sub.rho_v, in->rho, row, n, ret);
+                unbind_solve_soa(&sub, &r);
+                break;
+            default: {
+                // Vacuum size first (retention 1), then the search, then the final sizes
+                unbind_soa_result vac;
+                memset(&vac, 0, sizeof(vac));
+                vac.D_km = D_vac;
+                vac.m = m;
+                for (size_t i = 0; i < n; i++) ret[i] = 1.0;
+                unbind_solve_soa(&sub, &vac);
+                me.rho_v = sub.rho_v;
+                me.off = off;
+                solve_speed_block(&me, D_vac, n, ret, iterations);
+                unbind_solve_soa(&sub, &r);
+                if (r.iterations) memcpy(r.iterations, iterations, n * sizeof(int));
+                break;
+            }
+        }
+    }
+    return UNBIND_OK;
+}
+
+// Entry-model retention: one unbind_entry_array() call per model call
+static void entry_model(void* ctx, const double* D_km, const double* rho_v, double rho,
+                        const size_t* row, size_t n, double* ret) {
+    (void)row;
+    unbind_entry_input e = *(const unbind_entry_input*)ctx;
+    unbind_entry_result er;
+    memset(&er, 0, sizeof(er));
+    e.D_km = D_km;
+    e.rho_v = rho_v;
+    e.rho = rho;
+    e.n = n;
+    er.fraction = ret;
+    unbind_entry_array(&e, &er);
+}
+
+int unbind_entry_solve_soa(const unbind_soa_input* in, double speed_km_s, double angle_deg,
+                           unbind_soa_result* out) {
+    if (!(speed_km_s > 0.0) || !(angle_deg > 0.0 && angle_deg <= 90.0))
+        return UNBIND_ERR_INPUT;
+    unbind_entry_input e;
+    memset(&e, 0, sizeof(e));
+    e.planet = in->planet;
+    e.material = in->material;
+    e.speed = speed_km_s;
+    e.angle_deg = angle_deg;
+    return unbind_solve_soa_model(in, entry_model, &e, out);
+}
+
+typedef struct {
+    const unbind_retention_surface* s;
+    const double* speed_v;
+    const double* angle_v;
+    double speed, angle;
+} surface_model_ctx;
+
+static void surface_model(void* ctx, const double* D_km, const double* rho_v, double rho,
+                          const size_t* row, size_t n, double* ret) {
+    const surface_model_ctx* c = ctx;
+    double v[ENTRY_BLOCK], a[ENTRY_BLOCK];
+    for (size_t j = 0; j < n; j++) {
+        v[j] = PARAM(c->speed_v, c->speed, row[j]);
+        a[j] = PARAM(c->angle_v, c->angle, row[j]);
+    }
+    unbind_surface_array(c->s, D_km, v, 0.0, rho_v, rho, a, 0.0, ret, n);
+}
+
+int unbind_surface_solve_soa(const unbind_soa_input* in, const unbind_retention_surface* s,
+                             const double* speed_v, double speed_km_s, const double* angle_v,
+                             double angle_deg, unbind_soa_result* out) {
+    if (!s || !s->value) return UNBIND_ERR_INPUT;
+    surface_model_ctx c = { s, speed_v, angle_v, speed_km_s, angle_deg };
+    return unbind_solve_soa_model(in, surface_model, &c, out);
+}
+
+
+/* ---------------------------------------------------------------------------
+ * Fragmentation: the pancake model
+ * ------------------------------------------------------------------------- */
+
+// State of a fragmenting trajectory: speed, m/m0, R/R0, d(R/R0)/dt, air density, altitude
+#define FRAG_V 0
+#define FRAG_M 1
+#define FRAG_X 2
+#define FRAG_U 3
+#define FRAG_R 4
+#define FRAG_H 5
+#define FRAG_STATE 6
+
+static const double frag_strengths[MATERIAL_COUNT] = {
+    [MATERIAL_STONY]    = 5.0e6,
+    [MATERIAL_IRON]     = 5.0e7,
+    [MATERIAL_COMETARY] = 1.0e5,
+};
+
+// Error floors per state component, added to ENTRY_RTOL times its size
+static const double frag_floor[FRAG_STATE] = { 1e-6, 1e-12, 1e-12, 1e-9, 1e-30, 1e-3 };
+
+// One lockstep group, as entry_lanes. cx and cu switch the radius equations per lane
+// without branches: 1, 0 while intact; 0, 1 while the debris spreads; 0, 0 once flat.
+typedef struct {
+    double y[FRAG_STATE][ENTRY_LANES];     // state
+    double p[FRAG_STATE][ENTRY_LANES];     // start of the last accepted step
+    double drag[ENTRY_LANES];              // Cd k
+    double abl[ENTRY_LANES];               // Ch k / Q
+    double spread[ENTRY_LANES];            // Cd / (2 rho_i R0^2)
+    double cx[ENTRY_LANES], cu[ENTRY_LANES];
+    double dt[ENTRY_LANES];
+    int    accepted[ENTRY_LANES];
+} frag_lanes;
+
+static ALWAYS_INLINE void frag_rhs(const frag_lanes* e, const entry_path* c,
+                                   const double (*y)[ENTRY_LANES], double (*dy)[ENTRY_LANES]) {
+    for (int l = 0; l < ENTRY_LANES; l++) {
+        double v = y[FRAG_V][l], x = y[FRAG_X][l];
+        double q = y[FRAG_R][l] * v, area = x * x;
+        double dm = -e->abl[l] * q * v * v * area;
+        dy[FRAG_V][l] = c->gs - e->drag[l] * q * v * area / y[FRAG_M][l];
+        dy[FRAG_M][l] = dm;
+        dy[FRAG_X][l] = e->cx[l] * dm / (3.0 * area) + e->cu[l] * y[FRAG_U][l];
+        dy[FRAG_U][l] = e->cu[l] * e->spread[l] * q * v / x;
+        dy[FRAG_R][l] = q * c->up;
+        dy[FRAG_H][l] = -v * c->sn;
+    }
+}
+
+// One Dormand-Prince step on every lane, with the tableau and controller of entry_step()
+static ALWAYS_INLINE void frag_step(frag_lanes* e, const entry_path* c) {
+    double k[7][FRAG_STATE][ENTRY_LANES], t[FRAG_STATE][ENTRY_LANES], yn[FRAG_STATE][ENTRY_LANES];
+
+    frag_rhs(e, c, (const double (*)[ENTRY_LANES])e->y, k[0]);
+    for (int j = 1; j < 7; j++) {
+        for (int m = 0; m < FRAG_STATE; m++)
+            for (int l = 0; l < ENTRY_LANES; l++) t[m][l] = 0.0;
+        for (int i = 0; i < j; i++) {
+            double a = DP_A[j-1][i];
+            for (int m = 0; m < FRAG_STATE; m++)
+                for (int l = 0; l < ENTRY_LANES; l++) t[m][l] += a * k[i][m][l];
+        }
+        for (int m = 0; m < FRAG_STATE; m++)
+            for (int l = 0; l < ENTRY_LANES; l++) yn[m][l] = e->y[m][l] + e->dt[l] * t[m][l];
+        frag_rhs(e, c, (const double (*)[ENTRY_LANES])yn, k[j]);
+    }
+
+    for (int m = 0; m < FRAG_STATE; m++)
+        for (int l = 0; l < ENTRY_LANES; l++) t[m][l] = 0.0;
+    for (int i = 0; i < 7; i++) {
+        double a = DP_E[i];
+        for (int m = 0; m < FRAG_STATE; m++)
+            for (int l = 0; l < ENTRY_LANES; l++) t[m][l] += a * k[i][m][l];
+    }
+    double err[ENTRY_LANES], fac[ENTRY_LANES];
+    for (int l = 0; l < ENTRY_LANES; l++) err[l] = 0.0;
+    for (int m = 0; m < FRAG_STATE; m++)
+        for (int l = 0; l < ENTRY_LANES; l++)
+            err[l] = max2(err[l], fabs(e->dt[l] * t[m][l]) /
+                                  (ENTRY_RTOL * max2(fabs(e->y[m][l]), fabs(yn[m][l])) + frag_floor[m]));
+    for (int l = 0; l < ENTRY_LANES; l++) fac[l] = 0.9 / sqrt(sqrt(err[l]));
+    for (int l = 0; l < ENTRY_LANES; l++) {
+        double f = fac[l] >= 0.2 ? fac[l] : 0.2;
+        f = f <= 5.0 ? f : 5.0;
+        int ok = err[l] <= 1.0;
+        e->accepted[l] = ok;
+        for (int m = 0; m < FRAG_STATE; m++) {
+            e->p[m][l] = ok ? e->y[m][l] : e->p[m][l];
+            e->y[m][l] = ok ? yn[m][l] : e->y[m][l];
+        }
+        double to_ground = (e->y[FRAG_H][l] + 0.5 * ENTRY_GROUND_M) / (e->y[FRAG_V][l] * c->sn);
+        double dt = e->dt[l] * f;
+        e->dt[l] = dt <= to_ground ? dt : to_ground;
+    }
+}
+
+typedef void (*frag_step_fn)(frag_lanes* e, const entry_path* c);
+
+static void frag_step_scalar(frag_lanes* e, const entry_path* c) { frag_step(e, c); }
+
+#ifdef UNBIND_HAVE_X86_SIMD
+static __attribute__((target("avx2"))) void frag_step_avx2(frag_lanes* e, const entry_path* c) {
+    frag_step(e, c);
+}
+static __attribute__((target("avx512f"))) void frag_step_avx512(frag_lanes* e, const entry_path* c) {
+    frag_step(e, c);
+}
+#endif
+
+static frag_step_fn select_frag_step(int level) {
+#ifdef UNBIND_HAVE_X86_SIMD
+    if (level >= UNBIND_SIMD_AVX512 && __builtin_cpu_supports("avx512f")) return frag_step_avx512;
+    if (level >= UNBIND_SIMD_AVX2 && __builtin_cpu_supports("avx2")) return frag_step_avx2;
+#else
+    (void)level;
+#endif
+    return frag_step_scalar;
+}
+
+double unbind_frag_strength(int material_type) {
+    if (material_type < 0 || material_type >= MATERIAL_COUNT) return NAN;
+    return frag_strengths[material_type];
+}
+
+static void put_frag(unbind_frag_result* out, size_t i, double breakup, double burst, double peak,
+                     double fraction, double mass_fraction, double v_end, int outcome, int steps) {
+    if (out->breakup_km) out->breakup_km[i] = breakup;
+    if (out->burst_km) out->burst_km[i] = burst;
+    if (out->peak_J_m) out->peak_J_m[i] = peak;
+    if (out->fraction) out->fraction[i] = fraction;
+    if (out->mass_fraction) out->mass_fraction[i] = mass_fraction;
+    if (out->v_end) out->v_end[i] = v_end;
+    if (out->outcome) out->outcome[i] = outcome;
+    if (out->steps) out->steps[i] = steps;
+}
+
+// One unbind_frag_array() call, as entry_run, plus what each lane has deposited so far
+typedef struct {
+    const unbind_frag_input* in;
+    unbind_frag_result* out;
+    const entry_atmosphere* atm;
+    const entry_material* mat;
+    entry_path path;
+    double h_top, r_top;
+    double width;                  // deposition bin height, m
+    double strength;               // Pa, when in->strength_v is NULL
+    frag_lanes e;
+    size_t row[ENTRY_LANES];       // input index, or ENTRY_IDLE
+    double v_in[ENTRY_LANES];      // entry speed, m/s
+    double m0[ENTRY_LANES];        // entry mass, kg
+    double Y[ENTRY_LANES];         // strength, Pa
+    double breakup[ENTRY_LANES], burst[ENTRY_LANES], peak[ENTRY_LANES];   // m, m, J/m
+    double* bins[ENTRY_LANES];     // the row's deposition bins, or NULL
+    int steps[ENTRY_LANES], tries[ENTRY_LANES];
+    size_t next;
+    int active;
+} frag_run;
+
+// Spread energy e evenly over the altitudes [lo, hi] (m) of the bins it overlaps; energy
+// above the top bin is not binned
+static void frag_bin(double* bins, int n_bins, double width, double lo, double hi, double e) {
+    if (lo >= n_bins * width) return;
+    int b = (int)(lo / width);
+    if (!(hi > lo)) {
+        bins[b] += e;
+        return;
+    }
+    double per_m = e / (hi - lo);
+    for (; b < n_bins && b * width < hi; b++) {
+        double top = (b + 1) * width < hi ? (b + 1) * width : hi;
+        double bottom = b * width > lo ? b * width : lo;
+        bins[b] += per_m * (top - bottom);
+    }
+}
+
+static void frag_fill_lane(frag_run* run, int l) {
+    const unbind_frag_input* in = run->in;
+    frag_lanes* e = &run->e;
+    for (int m = 0; m < FRAG_STATE; m++) e->y[m][l] = e->p[m][l] = 1.0;
+    e->y[FRAG_R][l] = e->p[FRAG_R][l] = 0.0;
+    e->drag[l] = e->abl[l] = e->spread[l] = e->cx[l] = e->cu[l] = 0.0;
+    e->dt[l] = 1.0;
+    run->row[l] = ENTRY_IDLE;
+    while (run->next < in->n) {
+        size_t i = run->next++;
+        double* bins = run->out->deposition ? run->out->deposition + i * (size_t)in->n_bins : NULL;
+        if (bins) memset(bins, 0, (size_t)in->n_bins * sizeof(double));
+        double D = in->D_km[i];
+        double v = PARAM(in->speed_v, in->speed, i) * 1000.0;
+        double rho = PARAM(in->rho_v, in->rho, i);
+        double Y = PARAM(in->strength_v, run->strength, i);
+        if (!(D > 0.0 && v > 0.0 && rho > 0.0 && Y > 0.0) || isinf(D) || isinf(v)) {
+            put_frag(run->out, i, NAN, NAN, NAN, NAN, NAN, NAN, UNBIND_ENTRY_SURFACE, 0);
+            continue;
+        }
+        if (run->atm->rho0 <= 0.0) {
+            put_frag(run->out, i, NAN, NAN, 0.0, 1.0, 1.0, v, UNBIND_ENTRY_SURFACE, 0);
+            continue;
+        }
+        double R0 = D * 500.0;
+        double k = 3.0 / (8.0 * R0 * rho);
+        e->drag[l] = run->mat->Cd * k;
+        e->abl[l] = run->mat->Ch * k / run->mat->Q;
+        e->spread[l] = run->mat->Cd / (2.0 * rho * R0 * R0);
+        e->cx[l] = 1.0;
+        e->y[FRAG_V][l] = e->p[FRAG_V][l] = v;
+        e->y[FRAG_U][l] = e->p[FRAG_U][l] = 0.0;
+        e->y[FRAG_R][l] = e->p[FRAG_R][l] = run->r_top;
+        e->y[FRAG_H][l] = e->p[FRAG_H][l] = run->h_top;
+        e->dt[l] = 0.01 * run->atm->H / (v * run->path.sn);
+        run->row[l] = i;
+        run->v_in[l] = v;
+        run->m0[l] = (4.0 / 3.0) * UNBIND_PI * R0 * R0 * R0 * rho;
+        run->Y[l] = Y;
+        run->breakup[l] = run->burst[l] = NAN;
+        run->peak[l] = 0.0;
+        run->bins[l] = bins;
+        run->steps[l] = run->tries[l] = 0;
+        run->active++;
+        return;
+    }
+}
+
+// Lane l after a step: deposit the step's energy, switch to spreading or flat when due,
+// and write the result and refill the lane if the trajectory has ended
+static void frag_finish_lane(frag_run* run, int l) {
+    frag_lanes* e = &run->e;
+    run->tries[l]++;
+    if (e->accepted[l]) {
+        run->steps[l]++;
+        double y[FRAG_STATE], p[FRAG_STATE];
+        for (int m = 0; m < FRAG_STATE; m++) {
+            y[m] = e->y[m][l];
+            p[m] = e->p[m][l];
+        }
+        if (y[FRAG_H] < 0.0) {
+            // Back up along the last step to h = 0
+            double w = p[FRAG_H] / (p[FRAG_H] - y[FRAG_H]);
+            for (int m = 0; m < FRAG_STATE; m++) e->y[m][l] = y[m] = p[m] + w * (y[m] - p[m]);
+            y[FRAG_H] = e->y[FRAG_H][l] = 0.0;
+        }
+
+        // Energy given to the air: kinetic energy lost plus the work done by gravity
+        double dh = p[FRAG_H] - y[FRAG_H];
+        double energy = 0.5 * run->m0[l] * (p[FRAG_M] * p[FRAG_V] * p[FRAG_V] - y[FRAG_M] * y[FRAG_V] * y[FRAG_V])
+                      + run->m0[l] * run->atm->g * dh * 0.5 * (p[FRAG_M] + y[FRAG_M]);
+        if (dh > 0.0 && energy / dh > run->peak[l]) {
+            run->peak[l] = energy / dh;
+            run->burst[l] = 0.5 * (p[FRAG_H] + y[FRAG_H]);
+        }
+        if (run->bins[l]) frag_bin(run->bins[l], run->in->n_bins, run->width, y[FRAG_H], p[FRAG_H], energy);
+
+        double pressure = y[FRAG_R] * y[FRAG_V] * y[FRAG_V];
+        if (e->cx[l] != 0.0 && pressure >= run->Y[l]) {
+            double p0 = p[FRAG_R] * p[FRAG_V] * p[FRAG_V];
+            double w = p0 < run->Y[l] ? (run->Y[l] - p0) / (pressure - p0) : 0.0;
+            run->breakup[l] = p[FRAG_H] - w * dh;
+            e->cx[l] = 0.0;
+            e->cu[l] = 1.0;
+        } else if (e->cu[l] != 0.0 && y[FRAG_X] >= FRAG_PANCAKE_LIMIT) {
+            e->y[FRAG_X][l] = FRAG_PANCAKE_LIMIT;
+            e->y[FRAG_U][l] = 0.0;
+            e->cu[l] = 0.0;
+        }
+    }
+
+    int outcome = -1;
+    double v = e->y[FRAG_V][l], mass = e->y[FRAG_M][l];
+    if (e->y[FRAG_H][l] <= ENTRY_GROUND_M) outcome = UNBIND_ENTRY_SURFACE;
+    else if (mass <= ENTRY_MIN_S * ENTRY_MIN_S * ENTRY_MIN_S) outcome = UNBIND_ENTRY_ABLATED;
+    else if (v <= ENTRY_STOP_SPEED * run->v_in[l]) outcome = UNBIND_ENTRY_STOPPED;
+    else if (run->tries[l] >= ENTRY_STEP_CAP) outcome = UNBIND_ENTRY_MAX_STEPS;
+    if (outcome < 0) return;
+    mass = mass > 0.0 ? mass : 0.0;
+    double ratio = v / run->v_in[l];
+    put_frag(run->out, run->row[l], run->breakup[l] / 1000.0, run->burst[l] / 1000.0, run->peak[l],
+             mass * ratio * ratio, mass, v, outcome, run->steps[l]);
+    run->active--;
+    frag_fill_lane(run, l);
+}
+
+int unbind_frag_array_level(const unbind_frag_input* in, unbind_frag_result* out, int level) {
+    if (in->planet < 0 || in->planet >= PLANET_COUNT || in->material < 0 || in->material >= MATERIAL_COUNT ||
+        !(in->angle_deg > 0.0 && in->angle_deg <= 90.0) || in->n_bins < 0 ||
+        (in->n_bins > 0 && !(in->bin_km > 0.0)))
+        return UNBIND_ERR_INPUT;
+    frag_step_fn step = select_frag_step(level);
+    frag_run run;
+    memset(&run, 0, sizeof(run));
+    run.in = in;
+    run.out = out;
+    run.atm = &atmospheres[in->planet];
+    run.mat = &materials[in->material];
+    run.path.sn = sin(in->angle_deg * UNBIND_PI / 180.0);
+    run.path.gs = run.atm->g * run.path.sn;
+    run.path.up = run.path.sn / run.atm->H;
+    run.h_top = ENTRY_TOP_SCALE_HEIGHTS * run.atm->H;
+    run.r_top = run.atm->rho0 * exp(-ENTRY_TOP_SCALE_HEIGHTS);
+    run.width = in->bin_km * 1000.0;
+    run.strength = in->strength > 0.0 ? in->strength : frag_strengths[in->material];
+
+    for (int l = 0; l < ENTRY_LANES; l++) frag_fill_lane(&run, l);
+    while (run.active > 0) {
+        step(&run.e, &run.path);
+        for (int l = 0; l < ENTRY_LANES; l++)
+            if (run.row[l] != ENTRY_IDLE) frag_finish_lane(&run, l);
+    }
+    return UNBIND_OK;
+}
+
+int unbind_frag_array(const unbind_frag_input* in, unbind_frag_result* out) {
+    return unbind_frag_array_level(in, out, UNBIND_SIMD_AVX512);
+}
@@ -0,0 +1,440 @@
+/* unbindBench.c
+* (C) 2025 - George McGinn - MIT License
+* Micro-benchmarks for every libunbind solver path and the dose kernels.
+* Build: gcc -O2 unbindBench.c libunbind.c libunbind_simd.c libunbind_entry.c libunbind_spectrum.c -o unbindBench -lm
+*
+* Usage:
+*   ./unbindBench [n=65536] [reps=15] [seed=1] [filter=<substring>]
+*
+* Examples:
+*   ./unbindBench
+*   ./unbindBench filter=v/ reps=31
+*   ./unbindBench n=1e6 filter=retention
+*
+* Notes:
+*  - Each benchmark runs n operations per repetition, after one untimed warm-up repetition.
+*    The table gives the median, minimum and maximum ns/op over the repetitions, the
+*    coefficient of variation (stddev / mean) and the throughput at the median.
+*  - Inputs are generated once from the counter-based generator in unbind_rng.h, so a seed
+*    gives the same data on every machine:
+*      diameters  log-uniform 1e-4 .. 100 km (straddles every retention breakpoint, 1 m .. 15 km)
+*      masses     those diameters at 3000 kg/m^3
+*      speeds     chosen so the vacuum-retention required size is log-uniform over the same
+*                 range, so 'v' lands in every band (and on band edges) as in real catalogs
+*    Element i uses planet/material combination i mod 30 in the scalar forms, so the branch
+*    and table-lookup behaviour is that of a mixed catalog; batch (SoA) forms take the same
+*    data in 30 per-combination slices.
+*  - "scalar" rows call the one-scenario entry points in a loop, "array" rows the
+*    array-of-structs forms and "soa/<isa>" rows the SIMD kernels at each level the CPU supports.
+*  - "entry/soa" integrates one atmospheric entry trajectory per diameter (20 km/s, 45 degrees);
+*    it costs microseconds per op, so it dominates the run time (filter= it out if needed).
+*  - "spectrum/soa" is the transmitted fraction of one column (the diameters read as g/cm^2)
+*    through BENCH_GROUPS groups of a 10 keV blackbody in air, so one op is that many exponentials.
+*  - "slant/soa" is Earth's atmospheric column toward a source at a spread of zenith angles, past
+*    the horizon included; the table is built before the first timed run.
+*  - Results are summed into a checksum that is printed last, so no call can be optimized away.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "libunbind.h"
+#include "unbind_rng.h"
+
+#define BENCH_COMBOS (PLANET_COUNT * MATERIAL_COUNT)
+#define BENCH_MAX_REPS 1000
+#define BENCH_D_MIN_KM 1e-4
+#define BENCH_D_MAX_KM 100.0
+#define BENCH_GROUPS 128
+
+typedef struct {
+    size_t n;
+    double* D_km;              // diameters (km)
+    double* mass;              // kg
+    double* speed;             // km/s, calibrated to planet[i]
+    double* speed_soa;         // km/s, calibrated to the planet of the element's SoA slice
+    int* planet;               // per element, combination i mod BENCH_COMBOS
+    int* material;
+    unbind_input* inputs[3];   // 'm', 'd', 'v' array-of-structs inputs
+    unbind_result* results;
+    unbind_dose_input* dose_in;
+    unbind_dose_result* dose_out;
+    double* col[6];            // SoA output columns
+    unsigned char* destroyed;
+    int* iterations;
+    int simd_level;            // UNBIND_SIMD_* for the soa rows
+} bench_data;
+
+typedef double (*bench_fn)(bench_data* b);
+
+// Checksum term; scenarios out of range (e.g. no sub-c solution) give NaN or Inf fields
+static inline double finite_or_zero(double x) {
+    return isfinite(x) ? x : 0.0;
+}
+
+static double sum_results(const unbind_result* r, size_t n) {
+    double s = 0.0;
+    for (size_t i = 0; i < n; i++) s += finite_or_zero(r[i].m + r[i].D);
+    return s;
+}
+
+/* ---------------------------------------------------------------------------
+* Solver paths
+* -------------------------------------------------------------------------*/
+
+static double solve_scalar(bench_data* b, int k) {
+    double s = 0.0;
+    for (size_t i = 0; i < b->n; i++) {
+        unbind_result r;
+        unbind_solve(&b->inputs[k][i], &r);
+        s += finite_or_zero(r.m + r.D);
+    }
+    return s;
+}
+
+static double solve_array(bench_data* b, int k) {
+    unbind_solve_array(b->inputs[k], b->results, b->n);
+    return sum_results(b->results, b->n);
+}
+
+// One SoA call per planet/material slice of the same data
+static double solve_soa(bench_data* b, char mode, const double* values) {
+    size_t slice = b->n / BENCH_COMBOS;
+    double s = 0.0;
+    for (int c = 0; c < BENCH_COMBOS; c++) {
+        size_t first = (size_t)c * slice;
+        size_t count = c == BENCH_COMBOS - 1 ? b->n - first : slice;
+        unbind_soa_input in = { mode, c / MATERIAL_COUNT, c % MATERIAL_COUNT, 0.0,
+                                UNBIND_DEFAULT_DENSITY, 1.0, values + first, NULL, NULL, count, NULL };
+        unbind_soa_result out = { b->col[0] + first, b->col[1] + first, b->col[2] + first,
+                                  b->col[3] + first, b->col[4] + first, b->col[5] + first,
+                                  b->destroyed + first, b->iterations + first };
+        unbind_solve_soa_level(&in, &out, b->simd_level);
+    }
+    for (size_t i = 0; i < b->n; i++) s += finite_or_zero(b->col[1][i] + b->col[2][i]);
+    return s;
+}
+
+static double m_scalar(bench_data* b) { return solve_scalar(b, 0); }
+static double d_scalar(bench_data* b) { return solve_scalar(b, 1); }
+static double v_scalar(bench_data* b) { return solve_scalar(b, 2); }
+static double m_array(bench_data* b) { return solve_array(b, 0); }
+static double d_array(bench_data* b) { return solve_array(b, 1); }
+static double v_array(bench_data* b) { return solve_array(b, 2); }
+static double m_soa(bench_data* b) { return solve_soa(b, UNBIND_MODE_MASS, b->mass); }
+static double d_soa(bench_data* b) { return solve_soa(b, UNBIND_MODE_DIAMETER, b->D_km); }
+static double v_soa(bench_data* b) { return solve_soa(b, UNBIND_MODE_SPEED, b->speed_soa); }
+
+/* ---------------------------------------------------------------------------
+* Table lookups
+* -------------------------------------------------------------------------*/
+
+static double retention_scalar(bench_data* b) {
+    double s = 0.0;
+    for (size_t i = 0; i < b->n; i++)
+        s += atmospheric_retention(b->D_km[i], b->planet[i], b->material[i]);
+    return s;
+}
+
+static double retention_array(bench_data* b) {
+    size_t slice = b->n / BENCH_COMBOS;
+    double s = 0.0;
+    for (int c = 0; c < BENCH_COMBOS; c++) {
+        size_t first = (size_t)c * slice;
+        size_t count = c == BENCH_COMBOS - 1 ? b->n - first : slice;
+        const unbind_retention_table* t = unbind_retention_table_for(c / MATERIAL_COUNT, c % MATERIAL_COUNT);
+        unbind_retention_array(t, b->D_km + first, b->col[0] + first, count);
+    }
+    for (size_t i = 0; i < b->n; i++) s += b->col[0][i];
+    return s;
+}
+
+// One entry-model call per planet/material slice of the diameters
+static double entry_soa(bench_data* b) {
+    size_t slice = b->n / BENCH_COMBOS;
+    double s = 0.0;
+    for (int c = 0; c < BENCH_COMBOS; c++) {
+        size_t first = (size_t)c * slice;
+        size_t count = c == BENCH_COMBOS - 1 ? b->n - first : slice;
+        unbind_entry_input in = { c / MATERIAL_COUNT, c % MATERIAL_COUNT, 20.0, 45.0, UNBIND_DEFAULT_DENSITY,
+                                  b->D_km + first, NULL, NULL, count };
+        unbind_entry_result out = { b->col[0] + first, NULL, NULL, NULL, NULL };
+        unbind_entry_array_level(&in, &out, b->simd_level);
+    }
+    for (size_t i = 0; i < b->n; i++) s += b->col[0][i];
+    return s;
+}
+
+static double binding_scalar(bench_data* b) {
+    double s = 0.0;
+    for (size_t i = 0; i < b->n; i++) s += get_planetary_binding_energy(b->planet[i]);
+    return s;
+}
+
+/* ---------------------------------------------------------------------------
+* Dose
+* -------------------------------------------------------------------------*/
+
+static double calc_dose_scalar(bench_data* b) {
+    double s = 0.0;
+    for (size_t i = 0; i < b->n; i++) {
+        const unbind_dose_input* in = &b->dose_in[i];    // eta*E as fluence, atmos_trans as cos
+        s += calc_dose(in->eta * in->E, in->A, in->f, in->M, in->atmos_trans);
+    }
+    return s;
+}
+
+static double dose_scalar(bench_data* b) {
+    double s = 0.0;
+    for (size_t i = 0; i < b->n; i++) {
+        unbind_dose_result r;
+        unbind_dose(&b->dose_in[i], &r);
+        s += r.dose_upper + r.dose_lower;
+    }
+    return s;
+}
+
+static double dose_array(bench_data* b) {
+    double s = 0.0;
+    unbind_dose_array(b->dose_in, b->dose_out, b->n);
+    for (size_t i = 0; i < b->n; i++) s += b->dose_out[i].dose_upper + b->dose_out[i].dose_lower;
+    return s;
+}
+
+// One dose-field row of n observers 1000 km apart, at the Moon's distance off the row
+static double dose_row(bench_data* b) {
+    double k_upper, k_lower, s = 0.0;
+    unbind_dose_coefficients(&b->dose_in[0], &k_upper, &k_lower);
+    float* upper = (float*)b->col[0];            // n doubles hold both float rows
+    float* lower = upper + b->n;
+    unbind_dose_row(k_upper, k_lower, -5e5 * (double)b->n, 1e6, 3.844e8 * 3.844e8, upper, lower, b->n);
+    for (size_t i = 0; i < b->n; i++) s += (double)upper[i] + (double)lower[i];
+    return s;
+}
+
+// Multi-group transmission of n columns
+static double spectrum_soa(bench_data* b) {
+    static double energy[BENCH_GROUPS], weight[BENCH_GROUPS], mu[BENCH_GROUPS];
+    static int ready;
+    if (!ready) {
+        unbind_spectrum_groups(BENCH_GROUPS, 1e-3, 20.0, 1e-2, energy, weight);
+        for (int g = 0; g < BENCH_GROUPS; g++) mu[g] = unbind_attenuation(UNBIND_ABSORBER_AIR, energy[g]);
+        ready = 1;
+    }
+    unbind_spectrum spectrum = { BENCH_GROUPS, weight, mu };
+    double s = 0.0;
+    unbind_spectrum_transmission_level(&spectrum, b->D_km, b->col[0], b->n, b->simd_level);
+    for (size_t i = 0; i < b->n; i++) s += b->col[0][i];
+    return s;
+}
+
+// Slant-path columns of Earth's atmosphere at n zenith angles
+static double slant_soa(bench_data* b) {
+    static unbind_atmosphere atm;
+    static double* mu;
+    if (!mu) {
+        if (!(mu = malloc(b->n * sizeof(double)))) return NAN;
+        unbind_atmosphere_planet(&atm, PLANET_EARTH);
+        for (size_t i = 0; i < b->n; i++) mu[i] = cos(1.7 * (double)i / (double)b->n);
+    }
+    double s = 0.0;
+    unbind_slant_column_level(&atm, mu, b->col[0], b->n, b->simd_level);
+    for (size_t i = 0; i < b->n; i++) s += finite_or_zero(b->col[0][i]);
+    return s;
+}
+
+typedef struct {
+    const char* name;
+    bench_fn fn;
+    int soa;                   // run once per supported SIMD level
+} bench_case;
+
+static const bench_case bench_cases[] = {
+    { "m/scalar",              m_scalar,          0 },
+    { "m/array",               m_array,           0 },
+    { "m/soa",                 m_soa,             1 },
+    { "d/scalar",              d_scalar,          0 },
+    { "d/array",               d_array,           0 },
+    { "d/soa",                 d_soa,             1 },
+    { "v/scalar",              v_scalar,          0 },
+    { "v/array",               v_array,           0 },
+    { "v/soa",                 v_soa,             1 },
+    { "retention/scalar",      retention_scalar,  0 },
+    { "retention/array",       retention_array,   0 },
+    { "entry/soa",             entry_soa,         1 },
+    { "binding_energy/scalar", binding_scalar,    0 },
+    { "calc_dose/scalar",      calc_dose_scalar,  0 },
+    { "dose/scalar",           dose_scalar,       0 },
+    { "dose/array",            dose_array,        0 },
+    { "dose/row",              dose_row,          0 },
+    { "spectrum/soa",          spectrum_soa,      1 },
+    { "slant/soa",             slant_soa,         1 },
+};
+
+static double now_seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Time reps repetitions of fn and print one table row
+static double run_case(const char* name, bench_fn fn, bench_data* b, int reps) {
+    double ns[BENCH_MAX_REPS];
+    double checksum = fn(b);                      // warm-up: caches, branch predictors, page faults
+    for (int r = 0; r < reps; r++) {
+        double t0 = now_seconds();
+        checksum += fn(b);
+        ns[r] = (now_seconds() - t0) * 1e9 / (double)b->n;
+    }
+    double mean = 0.0, var = 0.0;
+    for (int r = 0; r < reps; r++) mean += ns[r];
+    mean /= reps;
+    for (int r = 0; r < reps; r++) var += (ns[r] - mean) * (ns[r] - mean);
+    double sd = reps > 1 ? sqrt(var / (reps - 1)) : 0.0;
+    qsort(ns, (size_t)reps, sizeof(double), cmp_double);
+    double median = reps % 2 ? ns[reps/2] : 0.5 * (ns[reps/2 - 1] + ns[reps/2]);
+    printf("%-28s %10.2f %10.2f %10.2f %7.2f%% %10.2f\n",
+           name, median, ns[0], ns[reps-1], mean > 0.0 ? 100.0 * sd / mean : 0.0, 1e3 / median);
+    return checksum;
+}
+
+// Speed (km/s) at which mass m carries energy U: (gamma - 1) m c^2 = U. Kept a little
+// below c, where small impactors on massive planets would otherwise round to c exactly.
+static double bench_speed(double U, double m) {
+    double gamma = 1.0 + U / (m * UNBIND_SPEED_OF_LIGHT * UNBIND_SPEED_OF_LIGHT);
+    double beta = sqrt(fmax(1.0 - 1.0 / (gamma * gamma), 1e-30));
+    return UNBIND_SPEED_OF_LIGHT * fmin(beta, 1.0 - 1e-12) / 1000.0;
+}
+
+// Deterministic inputs (see Notes)
+static int bench_init(bench_data* b, size_t n, uint64_t seed) {
+    memset(b, 0, sizeof(*b));
+    b->n = n;
+    b->D_km = malloc(n * sizeof(double));
+    b->mass = malloc(n * sizeof(double));
+    b->speed = malloc(n * sizeof(double));
+    b->speed_soa = malloc(n * sizeof(double));
+    b->planet = malloc(n * sizeof(int));
+    b->material = malloc(n * sizeof(int));
+    for (int k = 0; k < 3; k++) b->inputs[k] = malloc(n * sizeof(unbind_input));
+    b->results = malloc(n * sizeof(unbind_result));
+    b->dose_in = malloc(n * sizeof(unbind_dose_input));
+    b->dose_out = malloc(n * sizeof(unbind_dose_result));
+    for (int k = 0; k < 6; k++) b->col[k] = malloc(n * sizeof(double));
+    b->destroyed = malloc(n);
+    b->iterations = malloc(n * sizeof(int));
+    if (!b->D_km || !b->mass || !b->speed || !b->speed_soa || !b->planet || !b->material || !b->inputs[0] ||
+        !b->inputs[1] || !b->inputs[2] || !b->results || !b->dose_in || !b->dose_out ||
+        !b->col[0] || !b->col[1] || !b->col[2] || !b->col[3] || !b->col[4] || !b->col[5] ||
+        !b->destroyed || !b->iterations)
+        return -1;
+
+    const double span = log(BENCH_D_MAX_KM / BENCH_D_MIN_KM);
+    unbind_dose_input dose_defaults;
+    unbind_dose_defaults(&dose_defaults);
+    size_t slice = n / BENCH_COMBOS;
+    for (size_t i = 0; i < n; i++) {
+        double u1, u2, u3, u4;
+        unbind_rng_u01x2(seed, i, 0, &u1, &u2);
+        unbind_rng_u01x2(seed, i, 1, &u3, &u4);
+        // SoA rows slice the same arrays by combination, scalar rows rotate through them
+        int combo = (int)(i % BENCH_COMBOS);
+        b->planet[i] = combo / MATERIAL_COUNT;
+        b->material[i] = combo % MATERIAL_COUNT;
+        int soa_planet = (int)((i / slice < BENCH_COMBOS ? i / slice : BENCH_COMBOS - 1) / MATERIAL_COUNT);
+
+        double D = BENCH_D_MIN_KM * exp(u1 * span);
+        double m = UNBIND_DEFAULT_DENSITY * UNBIND_PI / 6.0 * pow(D * 1000.0, 3);
+        b->D_km[i] = D;
+        b->mass[i] = m;
+
+        // Speed whose vacuum required size is another log-uniform draw D2, for the element's
+        // planet in the scalar layout and for its slice's planet in the SoA layout
+        double D2 = BENCH_D_MIN_KM * exp(u2 * span);
+        double m2 = UNBIND_DEFAULT_DENSITY * UNBIND_PI / 6.0 * pow(D2 * 1000.0, 3);
+        b->speed[i] = bench_speed(get_planetary_binding_energy(b->planet[i]), m2);
+        b->speed_soa[i] = bench_speed(get_planetary_binding_energy(soa_planet), m2);
+
+        for (int k = 0; k < 3; k++) {
+            unbind_input* in = &b->inputs[k][i];
+            unbind_input_defaults(in);
+            in->mode = "mdv"[k];
+            in->value = k == 0 ? m : k == 1 ? D : b->speed[i];
+            in->planet = b->planet[i];
+            in->material = b->material[i];
+        }
+
+        // Dose: a few decades of energy and distance around the Earth-Moon default
+        unbind_dose_input* d = &b->dose_in[i];
+        *d = dose_defaults;
+        d->E *= pow(10.0, 4.0 * u3 - 2.0);
+        d->d *= pow(10.0, 2.0 * u4 - 1.0);
+        d->theta_deg = 90.0 * u3;
+        d->atmos_trans = u4;
+    }
+    return 0;
+}
+
+static void bench_free(bench_data* b) {
+    free(b->D_km); free(b->mass); free(b->speed); free(b->speed_soa); free(b->planet); free(b->material);
+    for (int k = 0; k < 3; k++) free(b->inputs[k]);
+    free(b->results); free(b->dose_in); free(b->dose_out);
+    for (int k = 0; k < 6; k++) free(b->col[k]);
+    free(b->destroyed); free(b->iterations);
+}
+
+int main(int argc, char** argv) {
+    double n_arg = 65536;
+    int reps = 15;
+    uint64_t seed = 1;
+    const char* filter = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "n=", 2) == 0) n_arg = atof(argv[i] + 2);
+        else if (strncmp(argv[i], "reps=", 5) == 0) reps = atoi(argv[i] + 5);
+        else if (strncmp(argv[i], "seed=", 5) == 0) seed = strtoull(argv[i] + 5, NULL, 10);
+        else if (strncmp(argv[i], "filter=", 7) == 0) filter = argv[i] + 7;
+        else {
+            fprintf(stderr, "Usage: %s [n=65536] [reps=15] [seed=1] [filter=<substring>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n_arg < BENCH_COMBOS || reps < 1 || reps > BENCH_MAX_REPS) {
+        fprintf(stderr, "n must be at least %d and reps between 1 and %d.\n", BENCH_COMBOS, BENCH_MAX_REPS);
+        return 1;
+    }
+
+    bench_data b;
+    if (bench_init(&b, (size_t)n_arg, seed) != 0) {
+        fprintf(stderr, "Out of memory.\n");
+        bench_free(&b);
+        return 1;
+    }
+
+    int best = unbind_simd_level();
+    fprintf(stderr, "BENCH  : n=%zu reps=%d seed=%llu simd=%s\n",
+            b.n, reps, (unsigned long long)seed, unbind_simd_name(best));
+    printf("%-28s %10s %10s %10s %8s %10s\n", "benchmark", "median_ns", "min_ns", "max_ns", "cv", "Mop/s");
+
+    double checksum = 0.0;
+    for (size_t c = 0; c < sizeof(bench_cases) / sizeof(bench_cases[0]); c++) {
+        const bench_case* bc = &bench_cases[c];
+        for (int level = 0; level <= (bc->soa ? best : 0); level++) {
+            char name[64];
+            if (bc->soa) snprintf(name, sizeof(name), "%s/%s", bc->name, unbind_simd_name(level));
+            else snprintf(name, sizeof(name), "%s", bc->name);
+            if (filter && !strstr(name, filter)) continue;
+            b.simd_level = level;
+            checksum += run_case(name, bc->fn, &b, reps);
+        }
+    }
+    fprintf(stderr, "BENCH  : checksum %.17g\n", checksum);
+    bench_free(&b);
+    return 0;
+}
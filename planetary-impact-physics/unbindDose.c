@@ -1,15 +1,32 @@
 /* unbindDose.c 
 * (C) 2025 - George McGinn - MIT License
 * Compute the upper and lower bound lunar dose from Earth destruction impact in Grays
-* Build: gcc -O2 unbindDose.c -o unbindDose -lm
+* Build: gcc -O2 -pthread unbindDose.c libunbind.c libunbind_simd.c libunbind_spectrum.c unbind_fmt.c unbind_pool.c \
+*        unbind_dosegrid.c unbind_dosespec.c unbind_doseglobe.c unbind_dosepop.c \
+*        unbind_dosemc.c -o unbindDose -lm
 *
 * Usage:
 *   ./unbindDose [E=2.49e32] [eta=3e-3] [d=3.844e8] [A=0.7] [M=70.0] [f=1.0] [theta_deg=75.0] [atmos_trans=1.0]
+*   ./unbindDose grid <file> [x=lo:hi:n] [y=lo:hi:n] [z=lo:hi:n] [source=x,y,z] [E=...] ... [preview=<file>]
+*     (dose field over a grid of observers, see unbind_dosegrid.c)
+*   ./unbindDose spectrum [d=...] [E=...] ... [spectrum=blackbody:10] [absorber=air] [column=0] [medium=0]
+*     (multi-group attenuation in place of a single atmos_trans, see unbind_dosespec.c)
+*   ./unbindDose globe [planet=earth] [lat=-90:90:181] [lon=-180:180:361] [source=0,0] [E=...] ...
+*     (observers on the ground through the slant path of the atmosphere, see unbind_doseglobe.c)
+*   ./unbindDose exposure <raster> [levels=1,4,8] [histogram=<file.csv>] [source=0,0] [E=...] ...
+*     (population at or above each dose from a population raster, see unbind_dosepop.c)
+*   ./unbindDose transport [slabs=air:1033,water:30] [histories=1e6] [spectrum=...] [E=...] ...
+*     (Monte Carlo photon transport with scattering and secondaries, see unbind_dosemc.c)
 *
 * Examples:
 *   ./unbindDose
 *   ./unbindDose 2.49e32 3e-3 3.844e8 0.7 70 1 75
 *   ./unbindDose 2.49e32 3e-3 3.844e8 0.7 70 1 75 0.1
+*   ./unbindDose grid earth_moon.udg E=5e23 preview=earth_moon.ppm > lethal.csv
+*   ./unbindDose spectrum spectrum=blackbody:300 column=1033
+*   ./unbindDose globe planet=mars spectrum=blackbody:100 > mars.csv
+*   ./unbindDose exposure gpw_2020_30_sec.flt source=40,-100 spectrum=blackbody:2000
+*   ./unbindDose transport spectrum=blackbody:2000 histories=1e8
 *
 * Where:
 *  - E = total energy (J) released by Earth destruction
@@ -26,9 +43,11 @@
 *  - Upper boundary dose assumes direct overhead exposure (max exposure)
 *  - Lower boundary dose assumes angle theta_deg from vertical (glancing blow)   
 *  - This is a simplified model with basic atmospheric attenuation but does not account 
-*    for energy-dependent absorption, radiation type differences, secondary radiation, etc.
+*    for radiation type differences, secondary radiation, etc.; energy-dependent absorption
+*    is in the spectrum mode and the grid mode's spectral options, and the path length
+*    through the atmosphere at the observer's zenith angle in the globe mode; the transport
+*    mode follows scattered and secondary photons through slabs of absorber
 *  - 8 Gy is a lethal dose for humans (without medical treatment)
-*  - M_PI is defined if not available in math.h 
 *  - Dose = (fluence * A * f * cos(theta)) / M
 *           where fluence = (eta * E) / (4 * pi * d^2) (J/m^2)  
 *  - cos(theta) = cosine of angle of incidence (1.0 for upper boundary, cos(theta_deg) for lower boundary)      
@@ -36,42 +55,54 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-double calc_dose(double F, double A, double f, double M, double cos_theta) {
-    return (F * A * f * cos_theta) / M;
-}
+#include <string.h>
+#include "libunbind.h"
+#include "unbind_fmt.h"
+#include "unbind_dosegrid.h"
+#include "unbind_dosespec.h"
+#include "unbind_doseglobe.h"
+#include "unbind_dosepop.h"
+#include "unbind_dosemc.h"
+
 int main(int argc, char **argv) {
-    double E   = argc>1 ? atof(argv[1]) : 2.49e32;
-    double eta = argc>2 ? atof(argv[2]) : 3e-3;
-    double d   = argc>3 ? atof(argv[3]) : 3.844e8;
-    double A   = argc>4 ? atof(argv[4]) : 0.7;
-    double M   = argc>5 ? atof(argv[5]) : 70.0;
-    double f   = argc>6 ? atof(argv[6]) : 1.0;
-    double theta_deg = argc>7 ? atof(argv[7]) : 75.0;
-    double atmos_trans = argc>8 ? atof(argv[8]) : 1.0;
+    unbind_dose_input in;
+    unbind_dose_result out;
+
+    if (argc > 1 && strcmp(argv[1], "grid") == 0) return run_dosegrid(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "spectrum") == 0) return run_dose_spectrum(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "globe") == 0) return run_doseglobe(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "exposure") == 0) return run_dosepop(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "transport") == 0) return run_dosemc(argc, argv);
+    unbind_dose_defaults(&in);
+    if (argc>1) in.E   = atof(argv[1]);
+    if (argc>2) in.eta = atof(argv[2]);
+    if (argc>3) in.d   = atof(argv[3]);
+    if (argc>4) in.A   = atof(argv[4]);
+    if (argc>5) in.M   = atof(argv[5]);
+    if (argc>6) in.f   = atof(argv[6]);
+    if (argc>7) in.theta_deg = atof(argv[7]);
+    if (argc>8) in.atmos_trans = atof(argv[8]);
 
-    double cos_theta = cos(theta_deg * M_PI / 180.0);
-    double F = eta * E / (4.0 * M_PI * d * d);
-    double F_attenuated = F * atmos_trans;
-    double D_upper = calc_dose(F_attenuated, A, f, M, 1.0);
-    double D_lower = calc_dose(F_attenuated, A, f, M, cos_theta);
+    unbind_dose(&in, &out);
+    double theta_deg = in.theta_deg;
+    double F_attenuated = out.fluence;
+    double D_upper = out.dose_upper;
+    double D_lower = out.dose_lower;
+    unbind_out* report = unbind_stdout();
 
-    printf("Impact Generated Radiation Dose\n");
-    printf("-------------------------------\n\n");
-    printf("fluence = %.6e J/m^2\n\n", F_attenuated);
-    printf("Dose (upper boundary, max exposure) = %.6e Gy\n", D_upper);
+    unbind_out_printf(report, "Impact Generated Radiation Dose\n");
+    unbind_out_printf(report, "-------------------------------\n\n");
+    unbind_out_printf(report, "fluence = %.6e J/m^2\n\n", F_attenuated);
+    unbind_out_printf(report, "Dose (upper boundary, max exposure) = %.6e Gy\n", D_upper);
     if (D_upper>8){   
-            printf("*** WARNING: Dose exceeds 8 Gy (lethal dose for humans)\n\n");
+            unbind_out_printf(report, "*** WARNING: Dose exceeds 8 Gy (lethal dose for humans)\n\n");
     }
-    printf("Dose (lower boundary, angle %.1f deg, glancing blow) = %.6e Gy\n",
+    unbind_out_printf(report, "Dose (lower boundary, angle %.1f deg, glancing blow) = %.6e Gy\n",
            theta_deg, D_lower);
     if (D_lower>8){   
-            printf("*** WARNING: Dose exceeds 8 Gy (lethal dose for humans)\n");
+            unbind_out_printf(report, "*** WARNING: Dose exceeds 8 Gy (lethal dose for humans)\n");
     }
-    printf("\n");
+    unbind_out_printf(report, "\n");
     
-    return 0;
+    return unbind_out_flush(report) == 0 ? 0 : 1;
 }
\ No newline at end of file
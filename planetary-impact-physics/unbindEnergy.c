@@ -2,7 +2,10 @@
 * (C) 2025 - George McGinn - MIT License
 * Compute impactor size from speed, or speed from size/mass, to meet
 * the selected planet's unbinding energy U, with full relativistic kinetic energy.
-* Build: gcc -O2 unbindEnergy.c -o unbindEnergy -lm
+* Build: gcc -O2 -pthread unbindEnergy.c libunbind.c libunbind_simd.c libunbind_entry.c unbind_sweep.c unbind_mc.c \
+*        unbind_pool.c unbind_proto.c unbind_server.c unbind_stream.c unbind_fmt.c unbind_bin.c unbind_registry.c \
+*        unbind_catalog.c unbind_pairs.c unbind_boundary.c unbind_surface.c unbind_airburst.c \
+*        unbind_mpcorb.c unbind_shard.c -o unbindEnergy -lm
 *
 * Usage:
 *   Given speed -> required size (assume bulk density):
@@ -11,6 +14,45 @@
 *     ./unbindEnergy d <diameter_km> [rho_kg_m3=3000] [epsilon=1.0] [name] [planet] [material]
 *   Given mass -> required speed:
 *     ./unbindEnergy m <mass_kg> [epsilon=1.0] [name] [planet] [material]
+*   Batch catalog (every row x planet x material x epsilon, CSV to stdout):
+*     ./unbindEnergy batch <catalog.csv|-> [planets=all] [materials=all] [epsilons=1.0] [bin=<file|->]
+*                          [bodies=<file>]
+*   Parameter sweep (grid of value x rho x epsilon x planet x material, multithreaded):
+*     ./unbindEnergy sweep <m|d|v> <value-axis> [rho=<axis>] [eps=<axis>] [planets=all] [materials=all] [threads=0]
+*                          [bin=<file|->] [bodies=<file>] [retention=table|entry[:<speed_km_s>[:<angle_deg>]]]
+*                          [surface=<file.urs>]
+*     (axis: lin:a:b:n, log:a:b:n or a comma list; see unbind_sweep.c)
+*   All pairs (every catalog impactor against every target; matrix layout in unbind_pairs.h):
+*     ./unbindEnergy pairs <catalog.csv> [targets=catalog|planets|<bodies file>] [material=stony] [eps=1.0]
+*                          [out=<file>] [threads=0]
+*   Destruction boundary (the diameter-speed curve where impacts start to unbind the target):
+*     ./unbindEnergy boundary [planets=all] [materials=all] [eps=1.0] [rho=3000] [D=1e-4:1e4]
+*                             [v=0.01:299792] [cells=4096] [bodies=<file>]
+*   Monte Carlo uncertainty (quantiles and destruction probability, multithreaded):
+*     ./unbindEnergy mc <m|d|v> <value-dist> [rho=<dist>] [eps=<dist>] [speed=<dist>|diameter=<dist>]
+*                       [planet=earth] [material=stony] [samples=1000000] [threads=0] [seed=1]
+*                       [surface=<file.urs>] [angle=<dist>]
+*     (dist: x, uniform:a:b, loguniform:a:b, normal:mean:sd, lognormal:median:sigma, empirical:<file>)
+*   Retention surfaces (the entry model tabulated for surface= on sweep and mc; see unbind_surface.c):
+*     ./unbindEnergy surface <file.urs> [planets=all] [materials=all] [D=1e-5:1e3:65] [speed=2:100:49]
+*                            [angle=15:90:16] [threads=0]
+*   Airbursts (breakup altitude, deposition profile and surviving mass per catalog row; see unbind_airburst.c):
+*     ./unbindEnergy airburst <catalog.csv|-> [planets=earth] [materials=all] [speed=20] [angle=45] [rho=3000]
+*                             [strength=<Pa>] [profile=<file>] [dz=1] [top=100] [threads=0]
+*   Orbit file (impact speeds of every planet-crossing object in an MPCORB.DAT file; see unbind_mpcorb.c):
+*     ./unbindEnergy mpcorb <MPCORB.DAT|-> [planets=earth] [materials=stony] [eps=1.0] [rho=3000] [albedo=0.14]
+*                           [threads=0]
+*   Sharded and resumable runs (shard=, out=, checkpoint= and every= on batch, sweep and mc; see unbind_shard.h):
+*     ./unbindEnergy sweep d log:1e-4:1e4:1000000 shard=0/4 out=s0.csv checkpoint=s0.ckpt
+*     ./unbindEnergy merge s0.csv s1.csv s2.csv s3.csv > sweep.csv
+*   Binary results (bin= on batch or sweep writes the columnar format of unbind_bin.h instead of CSV):
+*     ./unbindEnergy bin2csv <file.ubr> [where=<column>:<lo>:<hi>] [bodies=<file>]
+*   Other target bodies (bodies= on batch, sweep and bin2csv; format in unbind_registry.h):
+*     ./unbindEnergy batch catalog.csv titan,ceres,europa all 1.0 bodies="Target Bodies (unbindEnergy).csv"
+*   Query server (one CSV request per line over a Unix socket or loopback TCP; see unbind_proto.h):
+*     ./unbindEnergy serve <unix:/path | tcp:port> [threads=0]
+*   Stream (the same requests on stdin, one reply per line on stdout):
+*     cat requests.csv | ./unbindEnergy --stream [--flush]
 *
 * Examples:
 *     ./unbindEnergy m 1.2e17 0.25 "1036 Ganymed" earth stony
@@ -24,6 +66,9 @@
 *     ./unbindEnergy d 5.0 3000 0.25 "Large comet" uranus cometary
 *     ./unbindEnergy d 10.0 7800 1.0 "Massive iron" neptune iron
 *     ./unbindEnergy d 0.01 1000 1.0 "Tiny rock" pluto stony
+*     ./unbindEnergy batch "Space Bodies (unbindEnergy).csv" earth,mars,moon all 0.25,1.0
+*     ./unbindEnergy sweep d log:0.001:1000:601 rho=lin:1000:8000:8 eps=0.25,1.0
+*     ./unbindEnergy mc m loguniform:1e9:1e12 eps=uniform:0.1:1 speed=normal:26:3 planet=mars samples=1e8
 *
 * Where:
 *  - mass_kg = mass of impactor (kg) (1e9 to 1e23 typical range)
@@ -59,215 +104,513 @@
 *  - 1 AU = 1.496e11 m
 *  - Mercury mass = 3.30e23 kg
 *  - Ceres mass = 9.38e20 kg
+*
+* Batch mode:
+*  - Reads the "Space Bodies (unbindEnergy).csv" layout: "Name","Mass (kg)","Diameter (km)",
+*    "Typical Speed (km/s)","Notes/Type". Columns are matched by header name when a header row
+*    is present, otherwise taken positionally.
+*  - Quoted fields, thousands separators ("12,742"), ranges ("1e9-1e12", evaluated at the
+*    geometric mean) and placeholders ("—", "-", empty) are accepted.
+*  - planets/materials/epsilons are comma-separated lists; "all" selects every planet or material.
+*  - Each row runs the 'm' solver when a mass is given, the 'd' solver when a diameter is given
+*    and the 'v' solver when a speed is given. Density is mass/volume when both mass and diameter
+*    are known, otherwise 3000 kg/m^3.
+*  - Output is one CSV line per evaluation, streamed as the catalog is read, so catalogs of any
+*    size run in a single process with constant memory.
 */ 
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+#include "libunbind.h"
+#include "unbind_sweep.h"
+#include "unbind_mc.h"
+#include "unbind_proto.h"
+#include "unbind_server.h"
+#include "unbind_stream.h"
+#include "unbind_fmt.h"
+#include "unbind_bin.h"
+#include "unbind_registry.h"
+#include "unbind_catalog.h"
+#include "unbind_pairs.h"
+#include "unbind_boundary.h"
+#include "unbind_surface.h"
+#include "unbind_airburst.h"
+#include "unbind_mpcorb.h"
+#include "unbind_shard.h"
+
+/* ---------------------------------------------------------------------------
+ * Batch catalog mode
+ * ------------------------------------------------------------------------- */
+
+#define BATCH_MAX_FIELDS 32
+#define BATCH_READ_SIZE (1 << 20)   // bytes per fread() from the catalog
+#define BATCH_MAX_LINE  (1 << 16)   // longest catalog line accepted
+#define BATCH_MAX_EPS   64
+#define BATCH_ROW_MAX   (12 * UNBIND_FMT_MAX)   // a row apart from its quoted name
 
-// Planet type constants for atmospheric modeling
-#define PLANET_EARTH 0
-#define PLANET_MARS 1
-#define PLANET_VENUS 2
-#define PLANET_JUPITER 3
-#define PLANET_SATURN 4
-#define PLANET_URANUS 5
-#define PLANET_NEPTUNE 6
-#define PLANET_PLUTO 7
-#define PLANET_MOON 8
-#define PLANET_VACUUM 9
-
-// Material type constants
-#define MATERIAL_STONY 0
-#define MATERIAL_IRON 1
-#define MATERIAL_COMETARY 2
-
-// Function to get gravitational binding energy based on planet type
-double get_planetary_binding_energy(int planet_type) {
-    switch(planet_type) {
-        case PLANET_EARTH:   return 2.49e32;  // J - Original value from code comments
-        case PLANET_MARS:    return 4.87e30;  // J - Calculated from NASA data
-        case PLANET_VENUS:   return 1.57e32;  // J - Calculated from NASA data
-        case PLANET_JUPITER: return 2.06e36;  // J - Calculated from NASA data
-        case PLANET_SATURN:  return 2.22e35;  // J - Calculated from NASA data
-        case PLANET_URANUS:  return 1.19e34;  // J - Calculated from NASA data
-        case PLANET_NEPTUNE: return 1.69e34;  // J - Calculated from NASA data
-        case PLANET_PLUTO:   return 2.85e27;  // J - Calculated from NASA data
-        case PLANET_MOON:    return 1.23e29;  // J - Moon binding energy
-        case PLANET_VACUUM:  
-        default:             return 2.49e32;  // J - Default to Earth
+// Batch run configuration (targets selected once, before the catalog is read)
+typedef struct {
+    const unbind_registry* reg;                       // target bodies (built-in or bodies=)
+    int* planets;                                     // registry indices
+    int n_planets;
+    int materials[MATERIAL_COUNT];
+    int n_materials;
+    double eps[BATCH_MAX_EPS];
+    int n_eps;
+    unbind_catalog_columns col;                       // catalog column indices
+    long rows;                                        // data rows evaluated
+    long lines;                                       // catalog lines read
+    unbind_bin_writer* bin;                           // bin= output, NULL for CSV
+    int bad_header;                                   // the header names no mass or diameter column
+} batch_config;
+
+// Parse a comma-separated list of positive epsilon values
+static int parse_eps_list(const char* list, double* out, int* n_out) {
+    const char* p = list;
+    char* end;
+    *n_out = 0;
+    while (*p) {
+        double e = strtod(p, &end);
+        if (end == p || e <= 0.0 || *n_out >= BATCH_MAX_EPS) return -1;
+        out[(*n_out)++] = e;
+        p = end;
+        if (*p == ',') p++;
+        else if (*p) return -1;
     }
+    return *n_out > 0 ? 0 : -1;
 }
 
-// Atmospheric retention function
-double atmospheric_retention(double diameter_km, int planet_type, int material_type) {
-    // Returns fraction of kinetic energy that reaches surface
-    switch(planet_type) {
-        case PLANET_EARTH:
-            if (material_type == MATERIAL_IRON) { // Iron - higher survival rate
-                if (diameter_km < 0.01) return 0.00;      // <10m: 0% retention
-                if (diameter_km < 0.03) return 0.20;      // 10-30m: 20% retention
-                if (diameter_km < 0.05) return 0.50;      // 30-50m: 50% retention  
-                if (diameter_km < 0.10) return 0.80;      // 50-100m: 80% retention
-                if (diameter_km < 0.20) return 0.90;      // 100-200m: 90% retention
-                return 0.95;                              // >200m: 95% retention
-            } else if (material_type == MATERIAL_COMETARY) { // Cometary - very low survival
-                if (diameter_km < 0.05) return 0.00;      // <50m: 0% retention
-                if (diameter_km < 0.20) return 0.05;      // 50-200m: 5% retention
-                return 0.80;                              // >200m: 80% retention
-            } else { // Stony (default)
-                if (diameter_km < 0.01) return 0.01;      // <10m: 1% retention
-                if (diameter_km < 0.03) return 0.10;      // 10-30m: 10% retention
-                if (diameter_km < 0.20) return 0.50;      // 30-200m: 50% retention
-                return 0.90;                              // >200m: 90% retention
-            }
-            break;
-            
-        case PLANET_MARS:
-            // Mars: minimal atmospheric protection (1.3% of Earth's density)
-            if (material_type == MATERIAL_IRON) { // Iron
-                if (diameter_km < 0.001) return 0.80;     // <1m: 80% retention
-                return 0.95;                              // >1m: 95% retention
-            } else if (material_type == MATERIAL_COMETARY) { // Cometary
-                if (diameter_km < 0.01) return 0.70;      // <10m: 70% retention
-                return 0.90;                              // >10m: 90% retention
-            } else { // Stony
-                if (diameter_km < 0.005) return 0.85;     // <5m: 85% retention
-                return 0.95;                              // >5m: 95% retention
-            }
-            break;
-            
-        case PLANET_VENUS:
-            // Venus: extreme atmospheric protection (53x denser than Earth)
-            if (material_type == MATERIAL_IRON) { // Iron - best survival chance
-                if (diameter_km < 0.10) return 0.00;      // <100m: 0% retention
-                if (diameter_km < 0.50) return 0.10;      // 100-500m: 10% retention
-                if (diameter_km < 1.00) return 0.50;      // 500m-1km: 50% retention
-                return 0.80;                              // >1km: 80% retention
-            } else if (material_type == MATERIAL_COMETARY) { // Cometary
-                if (diameter_km < 1.00) return 0.00;      // <1km: 0% retention
-                return 0.30;                              // >1km: 30% retention
-            } else { // Stony
-                if (diameter_km < 0.20) return 0.00;      // <200m: 0% retention
-                if (diameter_km < 1.00) return 0.05;      // 200m-1km: 5% retention
-                return 0.60;                              // >1km: 60% retention
-            }
-            break;
-            
-        case PLANET_JUPITER:
-            // Jupiter: massive atmospheric protection, crushing pressures
-            if (material_type == MATERIAL_IRON) { // Iron
-                if (diameter_km < 1.00) return 0.00;      // <1km: 0% retention
-                if (diameter_km < 10.0) return 0.01;      // 1-10km: 1% retention
-                return 0.20;                              // >10km: 20% retention
-            } else { // Stony/Cometary - essentially no survival
-                if (diameter_km < 10.0) return 0.00;      // <10km: 0% retention
-                return 0.10;                              // >10km: 10% retention
+// Write a CSV-quoted string
+static char* put_csv_string(char* p, const char* s) {
+    *p++ = '"';
+    for (; *s; s++) {
+        if (*s == '"') *p++ = '"';
+        *p++ = *s;
+    }
+    *p++ = '"';
+    return p;
+}
+
+// One output row: a binary row, or CSV formatted in place in the stdout buffer
+static void put_batch_result(batch_config* cfg, char mode, const char* name, int planet, int material,
+                             double eps, double rho, double value, const unbind_result* r, int destroyed) {
+    if (cfg->bin) {
+        unbind_bin_row row = { value, rho, eps, r->retention, r->effective_eps, r->m, r->v_class/1000.0,
+                               r->v_rel/1000.0, r->D/1000.0, (uint32_t)(cfg->rows - 1), (uint32_t)planet, mode,
+                               (unsigned char)material, (unsigned char)(destroyed != 0) };
+        unbind_bin_append(cfg->bin, &row, 1);
+        return;
+    }
+    unbind_out* out = unbind_stdout();
+    char* p = unbind_out_reserve(out, 2 * strlen(name) + UNBIND_BODY_NAME + BATCH_ROW_MAX);
+    *p++ = mode;
+    *p++ = ',';
+    p = put_csv_string(p, name);
+    *p++ = ',';
+    p = unbind_fmt_str(p, unbind_registry_name(cfg->reg, (size_t)planet));
+    *p++ = ',';
+    p = unbind_fmt_str(p, unbind_material_name(material));
+    *p++ = ',';
+    p = unbind_fmt_g(p, eps, 6);
+    *p++ = ',';
+    p = unbind_fmt_g(p, rho, 6);
+    *p++ = ',';
+    p = unbind_fmt_f(p, r->retention, 3);
+    *p++ = ',';
+    p = unbind_fmt_g(p, r->effective_eps, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r->m, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r->D/1000.0, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r->v_class/1000.0, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r->v_rel/1000.0, 6);
+    *p++ = ',';
+    *p++ = (char)('0' + (destroyed != 0));
+    *p++ = '\n';
+    unbind_out_advance(out, p);
+}
+
+// Evaluate one catalog row against every selected planet, material and epsilon
+static void batch_evaluate_row(char** fields, int n, batch_config* cfg) {
+    unbind_catalog_row row;
+    if (!unbind_catalog_row_parse(fields, n, &cfg->col, &row)) return;
+    double m = row.m, D_km = row.D_km, v_km_s = row.v_km_s;
+    int has_m = row.has_m, has_d = row.has_d, has_v = row.has_v;
+    const char* name = row.name;
+
+    double rho = UNBIND_DEFAULT_DENSITY;
+    if (has_m && has_d) {
+        double R = D_km * 500.0;
+        rho = m / ((4.0/3.0) * UNBIND_PI * R * R * R);
+    }
+    cfg->rows++;
+
+    unbind_result r;
+    for (int ip = 0; ip < cfg->n_planets; ip++) {
+        int planet = cfg->planets[ip];
+        const unbind_body* body = unbind_registry_body(cfg->reg, (size_t)planet);
+        double U = body->U;
+        int atmosphere = body->atmosphere;
+        for (int im = 0; im < cfg->n_materials; im++) {
+            int material = cfg->materials[im];
+            for (int ie = 0; ie < cfg->n_eps; ie++) {
+                double eps = cfg->eps[ie];
+                if (has_m) {
+                    unbind_mass_to_speed(m, eps, U, atmosphere, material, &r);
+                    put_batch_result(cfg, 'm', name, planet, material, eps, UNBIND_DEFAULT_DENSITY, m, &r, r.destroyed);
+                }
+                if (has_d) {
+                    unbind_diameter_to_speed(D_km, rho, eps, U, atmosphere, material, &r);
+                    put_batch_result(cfg, 'd', name, planet, material, eps, rho, D_km, &r, r.destroyed);
+                }
+                if (has_v && unbind_speed_to_mass(v_km_s, rho, eps, U, atmosphere, material, &r) == UNBIND_OK) {
+                    // Destroyed when the body's actual mass meets the requirement at its speed
+                    double m_actual = has_m ? m : rho * (4.0/3.0) * UNBIND_PI * pow(D_km * 500.0, 3.0);
+                    int destroyed = (has_m || has_d) ? (m_actual >= r.m) : 0;
+                    put_batch_result(cfg, 'v', name, planet, material, eps, rho, v_km_s, &r, destroyed);
+                }
             }
-            break;
-            
-        case PLANET_SATURN:
-            // Saturn: similar to Jupiter but larger scale height allows deeper penetration
-            if (material_type == MATERIAL_IRON) { // Iron
-                if (diameter_km < 0.50) return 0.00;      // <500m: 0% retention
-                if (diameter_km < 5.00) return 0.05;      // 500m-5km: 5% retention
-                return 0.30;                              // >5km: 30% retention
-            } else { // Stony/Cometary
-                if (diameter_km < 5.00) return 0.00;      // <5km: 0% retention
-                return 0.15;                              // >5km: 15% retention
+        }
+    }
+}
+
+static void batch_process_line(char* line, batch_config* cfg) {
+    char* fields[BATCH_MAX_FIELDS];
+    size_t len = strlen(line);
+    if (len && line[len-1] == '\r') line[--len] = '\0';
+    cfg->lines++;
+    if (len == 0) return;
+
+    int n = unbind_split_csv(line, fields, BATCH_MAX_FIELDS);
+    int header = cfg->lines == 1 ? unbind_catalog_header(fields, n, &cfg->col) : 0;
+    if (header < 0) cfg->bad_header = 1;
+    if (header != 0) return;
+    batch_evaluate_row(fields, n, cfg);
+}
+
+// Column names from the catalog's first line, for a run that starts past it
+static void batch_read_header(FILE* in, char* buf, batch_config* cfg) {
+    char* fields[BATCH_MAX_FIELDS];
+    cfg->lines = 1;
+    if (!fgets(buf, BATCH_MAX_LINE, in)) return;
+    size_t len = strlen(buf);
+    while (len && (buf[len-1] == '\n' || buf[len-1] == '\r')) buf[--len] = '\0';
+    if (len == 0) return;
+    int n = unbind_split_csv(buf, fields, BATCH_MAX_FIELDS);
+    if (unbind_catalog_header(fields, n, &cfg->col) < 0) cfg->bad_header = 1;
+}
+
+// batch <catalog.csv|-> [planets=all] [materials=all] [epsilons=1.0] [bin=<file|->] [bodies=<file>]
+//       [shard=i/N] [out=<file>] [checkpoint=<file>] [every=30]
+// The planet, material and epsilon lists may also be given bare, in that order.
+// With shard= or checkpoint= the work units are the catalog's bytes: a shard owns the
+// lines that start in its byte range (unbind_shard.h).
+int run_batch(int argc, char** argv) {
+    static const char header[] =
+        "mode,name,planet,material,epsilon,rho_kg_m3,retention,eps_eff,mass_kg,diameter_km,v_class_km_s,v_rel_km_s,destroyed\n";
+    batch_config cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    unbind_catalog_default_columns(&cfg.col);
+
+    // Options may appear anywhere after the catalog. planets=, materials= and epsilons= may also
+    // be given bare, in that order; a bare list fills the first of the three not yet set.
+    static const char* const list_keys[3] = { "planets=", "materials=", "epsilons=" };
+    const char* pos[3] = { "all", "all", "1.0" };
+    int given[3] = { 0, 0, 0 };
+    const char* bin_path = NULL;
+    const char* bodies_path = NULL;
+    unbind_shard shard;
+    unbind_shard_init(&shard);
+    for (int i = 3; i < argc; i++) {
+        int opt, key = -1;
+        for (int k = 0; k < 3; k++)
+            if (strncmp(argv[i], list_keys[k], strlen(list_keys[k])) == 0) key = k;
+        if (key >= 0) {
+            pos[key] = argv[i] + strlen(list_keys[key]);
+            given[key] = 1;
+        }
+        else if (strncmp(argv[i], "bin=", 4) == 0) bin_path = argv[i] + 4;
+        else if (strncmp(argv[i], "bodies=", 7) == 0) bodies_path = argv[i] + 7;
+        else if ((opt = unbind_shard_option(argv[i], &shard)) != 0) {
+            if (opt < 0) {
+                fprintf(stderr, "Bad batch option: %s\n", argv[i]);
+                return 1;
             }
-            break;
-            
-        case PLANET_URANUS:
-            // Uranus: ice giant with thick hydrogen/helium atmosphere + ices
-            if (material_type == MATERIAL_IRON) { // Iron
-                if (diameter_km < 2.00) return 0.00;      // <2km: 0% retention
-                if (diameter_km < 10.0) return 0.02;      // 2-10km: 2% retention
-                return 0.25;                              // >10km: 25% retention
-            } else { // Stony/Cometary
-                if (diameter_km < 10.0) return 0.00;      // <10km: 0% retention
-                return 0.15;                              // >10km: 15% retention
+        }
+        else {
+            int k = 0;
+            while (k < 3 && given[k]) k++;
+            if (k == 3) {
+                fprintf(stderr, "Unknown batch option: %s\n", argv[i]);
+                return 1;
             }
-            break;
-            
-        case PLANET_NEPTUNE:
-            // Neptune: densest ice giant, even more protective than Uranus
-            if (material_type == MATERIAL_IRON) { // Iron
-                if (diameter_km < 3.00) return 0.00;      // <3km: 0% retention
-                if (diameter_km < 15.0) return 0.01;      // 3-15km: 1% retention
-                return 0.20;                              // >15km: 20% retention
-            } else { // Stony/Cometary
-                if (diameter_km < 15.0) return 0.00;      // <15km: 0% retention
-                return 0.10;                              // >15km: 10% retention
+            pos[k] = argv[i];
+            given[k] = 1;
+        }
+    }
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s batch <catalog.csv|-> [planets=all] [materials=all] [epsilons=1.0] [bin=<file|->]\n"
+                        "          [bodies=<file>] [shard=i/N] [out=<file>] [checkpoint=<file>] [every=30]\n", argv[0]);
+        return 1;
+    }
+    int ranged = shard.sharded || shard.checkpoint_path;
+    if (bin_path && (ranged || shard.out_path)) {
+        fprintf(stderr, "shard=, out= and checkpoint= apply to CSV output, not bin=.\n");
+        return 1;
+    }
+    if (ranged && strcmp(argv[2], "-") == 0) {
+        fprintf(stderr, "shard= and checkpoint= need a catalog file, not stdin.\n");
+        return 1;
+    }
+    shard.fingerprint = unbind_shard_fingerprint(argc, argv);
+    unbind_registry* reg = unbind_registry_open(bodies_path);
+    if (!reg) return 1;
+    cfg.reg = reg;
+    cfg.n_planets = unbind_registry_parse_list(reg, pos[0], &cfg.planets);
+    cfg.n_materials = unbind_parse_material_list(pos[1], cfg.materials, MATERIAL_COUNT);
+    if (cfg.n_planets < 0 || cfg.n_materials < 0) {
+        fprintf(stderr, "Planets/materials must be comma-separated names or 'all'.\n");
+        free(cfg.planets);
+        unbind_registry_free(reg);
+        return 1;
+    }
+    if (parse_eps_list(pos[2], cfg.eps, &cfg.n_eps) != 0) {
+        fprintf(stderr, "Epsilons must be a comma-separated list of positive numbers.\n");
+        free(cfg.planets);
+        unbind_registry_free(reg);
+        return 1;
+    }
+
+    FILE* in = strcmp(argv[2], "-") == 0 ? stdin : fopen(argv[2], "rb");
+    char* buf = in ? malloc(BATCH_READ_SIZE + BATCH_MAX_LINE + 1) : NULL;
+    if (bin_path && buf) {
+        int fd = unbind_bin_open_output(bin_path);
+        cfg.bin = fd < 0 ? NULL : unbind_bin_create(fd);
+    }
+    if (!in || !buf || (bin_path && !cfg.bin)) {
+        if (!in) fprintf(stderr, "Cannot open catalog: %s\n", argv[2]);
+        else if (!buf) fprintf(stderr, "Out of memory.\n");
+        else fprintf(stderr, "Cannot write binary output: %s\n", bin_path);
+        free(buf);
+        if (in && in != stdin) fclose(in);
+        free(cfg.planets);
+        unbind_registry_free(reg);
+        return 1;
+    }
+    int status = 0, resumed = 0;
+    uint64_t at = 0, limit = UINT64_MAX;          // file offset of buf[0]; lines starting at limit are not ours
+    if (ranged) {
+        struct stat st;
+        void* payload;
+        uint64_t payload_bytes;
+        if (fstat(fileno(in), &st) != 0 || !S_ISREG(st.st_mode)) {
+            fprintf(stderr, "Cannot shard %s: not a regular file.\n", argv[2]);
+            resumed = -1;
+        } else if ((resumed = unbind_shard_start(&shard, (uint64_t)st.st_size, &payload, &payload_bytes)) >= 0) {
+            free(payload);
+        }
+        at = shard.next;
+        limit = shard.end;
+        if (resumed >= 0 && at > 0) {
+            // The header comes from the first line; the line under our first byte is the previous shard's
+            batch_read_header(in, buf, &cfg);
+            int c = fseeko(in, (off_t)at - 1, SEEK_SET) == 0 ? fgetc(in) : EOF;
+            while (c != EOF && c != '\n') c = fgetc(in), at++;
+            if (c == EOF) at = limit;
+        }
+    }
+    if (resumed < 0 || (!bin_path && unbind_shard_open_output(&shard, resumed) != 0)) status = 1;
+    else if (!bin_path && !resumed) {
+        unbind_shard_header(&shard, "batch");
+        unbind_out_write(unbind_stdout(), header, sizeof(header) - 1);
+    }
+
+    // Stream the catalog: complete lines are processed in place, the partial
+    // tail is carried to the front of the buffer before the next read.
+    size_t carry = 0, got;
+    int stop = status != 0 || cfg.bad_header || at >= limit, finished = resumed > 0 && shard.next >= shard.end;
+    while (!stop && (got = fread(buf + carry, 1, BATCH_READ_SIZE, in)) > 0) {
+        size_t avail = carry + got;
+        char* start = buf;
+        char* nl;
+        while ((nl = memchr(start, '\n', avail - (size_t)(start - buf))) != NULL) {
+            if (at + (uint64_t)(start - buf) >= limit) {
+                stop = 1;
+                break;
             }
-            break;
-            
-        case PLANET_PLUTO:
-            // Pluto: extremely thin nitrogen atmosphere (1 Pa vs Earth's 101,325 Pa)
-            if (material_type == MATERIAL_IRON) { // Iron
-                if (diameter_km < 0.001) return 0.95;     // <1m: 95% retention
-                return 0.99;                              // >1m: 99% retention
-            } else if (material_type == MATERIAL_COMETARY) { // Cometary
-                if (diameter_km < 0.01) return 0.90;      // <10m: 90% retention
-                return 0.98;                              // >10m: 98% retention
-            } else { // Stony
-                if (diameter_km < 0.005) return 0.92;     // <5m: 92% retention
-                return 0.98;                              // >5m: 98% retention
+            *nl = '\0';
+            batch_process_line(start, &cfg);
+            if (cfg.bad_header) {
+                status = stop = 1;
+                break;
             }
-            break;
-
-        case PLANET_MOON:
-            // Moon: essentially no atmosphere (3*10^-15 Pa vs Earth's 101,325 Pa)
-            // Extremely thin exosphere provides virtually no protection
-            if (material_type == MATERIAL_IRON) { // Iron
-                if (diameter_km < 0.001) return 0.99;     // <1m: 99% retention
-                return 1.00;                              // >1m: 100% retention
-            } else if (material_type == MATERIAL_COMETARY) { // Cometary
-                if (diameter_km < 0.001) return 0.98;     // <1m: 98% retention
-                return 0.99;                              // >1m: 99% retention
-            } else { // Stony
-                if (diameter_km < 0.001) return 0.99;     // <1m: 99% retention
-                return 1.00;                              // >1m: 100% retention
+            start = nl + 1;
+            uint64_t next = at + (uint64_t)(start - buf);
+            if (next < limit && unbind_shard_due(&shard) && unbind_shard_save(&shard, next, NULL, 0) != 0) {
+                status = stop = 1;
+                break;
             }
+        }
+        if (stop) break;
+        carry = avail - (size_t)(start - buf);
+        if (carry > BATCH_MAX_LINE) {
+            fprintf(stderr, "Catalog line %ld too long.\n", cfg.lines + 1);
+            status = 1;
             break;
-            
-        case PLANET_VACUUM:
-        default:
-            return 1.00; // No atmospheric losses
+        }
+        at += (uint64_t)(start - buf);
+        memmove(buf, start, carry);
     }
-}
+    if (!stop && status == 0 && carry > 0 && at < limit) {
+        buf[carry] = '\0';
+        batch_process_line(buf, &cfg);
+    }
+    if (cfg.bad_header) {
+        fprintf(stderr, "Catalog header names neither a mass nor a diameter column.\n");
+        status = 1;
+    }
+    if (ferror(in)) {
+        fprintf(stderr, "Error reading catalog: %s\n", argv[2]);
+        status = 1;
+    }
+    if (status == 0 && ranged && !finished) unbind_shard_trailer(&shard);
+    if ((cfg.bin ? unbind_bin_finish(cfg.bin) : unbind_out_flush(unbind_stdout())) != 0) {
+        fprintf(stderr, "Error writing output.\n");
+        status = 1;
+    }
+    if (status == 0 && shard.checkpoint_path && unbind_shard_save(&shard, shard.end, NULL, 0) != 0) status = 1;
+    unbind_shard_close_output(&shard);
+    fprintf(stderr, "BATCH  : %ld rows x %d planets x %d materials x %d epsilons\n",
+        cfg.rows, cfg.n_planets, cfg.n_materials, cfg.n_eps);
 
-// Helper function to get planet type from string
-int get_planet_type(const char* planet_name) {
-    if (!planet_name) return PLANET_EARTH; // default
-    if (strcasecmp(planet_name, "earth") == 0) return PLANET_EARTH;
-    if (strcasecmp(planet_name, "mars") == 0) return PLANET_MARS;
-    if (strcasecmp(planet_name, "venus") == 0) return PLANET_VENUS;
-    if (strcasecmp(planet_name, "jupiter") == 0) return PLANET_JUPITER;
-    if (strcasecmp(planet_name, "saturn") == 0) return PLANET_SATURN;
-    if (strcasecmp(planet_name, "uranus") == 0) return PLANET_URANUS;
-    if (strcasecmp(planet_name, "neptune") == 0) return PLANET_NEPTUNE;
-    if (strcasecmp(planet_name, "pluto") == 0) return PLANET_PLUTO;
-    if (strcasecmp(planet_name, "moon") == 0) return PLANET_MOON;
-    if (strcasecmp(planet_name, "vacuum") == 0) return PLANET_VACUUM;
-    return PLANET_EARTH; // default to Earth if unknown
+    free(buf);
+    if (in != stdin) fclose(in);
+    free(cfg.planets);
+    unbind_registry_free(reg);
+    return status;
 }
 
-// Helper function to get material type from string
-int get_material_type(const char* material_name) {
-    if (!material_name) return MATERIAL_STONY; // default to stony
-    if (strcasecmp(material_name, "iron") == 0) return MATERIAL_IRON;
-    if (strcasecmp(material_name, "cometary") == 0) return MATERIAL_COMETARY;
-    if (strcasecmp(material_name, "stony") == 0) return MATERIAL_STONY;
-    return MATERIAL_STONY; // default to stony
+/* ---------------------------------------------------------------------------
+ * Binary result files
+ * ------------------------------------------------------------------------- */
+
+// bin2csv <file.ubr> [where=<column>:<lo>:<hi>] [bodies=<file>]
+// Prints a bin= file as sweep-layout CSV. With where=, only rows with lo <= column <= hi
+// are printed, and blocks whose min/max statistics exclude the range are skipped unread.
+// Planet names come from bodies=, which must be the file the results were written with.
+int run_bin2csv(int argc, char** argv) {
+    static const char header[] =
+        "mode,planet,material,epsilon,rho_kg_m3,retention,eps_eff,mass_kg,diameter_km,v_class_km_s,v_rel_km_s,destroyed\n";
+    int where_col = -1;
+    double lo = -INFINITY, hi = INFINITY;
+    const char* bodies_path = NULL;
+    for (int i = 3; i < argc; i++) {
+        char name[32];
+        if (strncmp(argv[i], "bodies=", 7) == 0) {
+            bodies_path = argv[i] + 7;
+        } else if (strncmp(argv[i], "where=", 6) != 0 ||
+                   sscanf(argv[i] + 6, "%31[^:]:%lf:%lf", name, &lo, &hi) != 3 ||
+                   (where_col = unbind_bin_column_index(name)) < 0) {
+            fprintf(stderr, "where= takes <column>:<lo>:<hi> with a column name from unbind_bin.c.\n");
+            return 1;
+        }
+    }
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s bin2csv <file.ubr> [where=<column>:<lo>:<hi>] [bodies=<file>]\n", argv[0]);
+        return 1;
+    }
+    unbind_registry* reg = unbind_registry_open(bodies_path);
+    if (!reg) return 1;
+
+    unbind_bin_file f;
+    if (unbind_bin_open(argv[2], &f) != 0) {
+        fprintf(stderr, "Cannot read binary results: %s\n", argv[2]);
+        unbind_registry_free(reg);
+        return 1;
+    }
+    // One decoding buffer per printed column, and one for where=
+    double* scratch = malloc((size_t)13 * f.header->block_rows * sizeof(double));
+    if (!scratch) {
+        fprintf(stderr, "Out of memory.\n");
+        unbind_bin_close(&f);
+        unbind_registry_free(reg);
+        return 1;
+    }
+    unbind_out* out = unbind_stdout();
+    unbind_out_write(out, header, sizeof(header) - 1);
+    uint64_t printed = 0, skipped = 0;
+    for (size_t b = 0; b < f.n_blocks; b++) {
+        unbind_bin_block blk;
+        unbind_bin_get_block(&f, b, &blk);
+        if (where_col >= 0 && (blk.max[where_col] < lo || blk.min[where_col] > hi)) {
+            skipped++;
+            continue;
+        }
+        size_t rows = f.header->block_rows;
+        const double* mode = unbind_bin_doubles(&blk, UNBIND_BIN_MODE, scratch);
+        const double* planet = unbind_bin_doubles(&blk, UNBIND_BIN_PLANET, scratch + rows);
+        const double* material = unbind_bin_doubles(&blk, UNBIND_BIN_MATERIAL, scratch + 2 * rows);
+        const double* destroyed = unbind_bin_doubles(&blk, UNBIND_BIN_DESTROYED, scratch + 3 * rows);
+        const double* eps = unbind_bin_doubles(&blk, UNBIND_BIN_EPSILON, scratch + 4 * rows);
+        const double* rho = unbind_bin_doubles(&blk, UNBIND_BIN_RHO, scratch + 5 * rows);
+        const double* ret = unbind_bin_doubles(&blk, UNBIND_BIN_RETENTION, scratch + 6 * rows);
+        const double* eps_eff = unbind_bin_doubles(&blk, UNBIND_BIN_EPS_EFF, scratch + 7 * rows);
+        const double* m = unbind_bin_doubles(&blk, UNBIND_BIN_MASS, scratch + 8 * rows);
+        const double* D_km = unbind_bin_doubles(&blk, UNBIND_BIN_DIAMETER, scratch + 9 * rows);
+        const double* v_class = unbind_bin_doubles(&blk, UNBIND_BIN_V_CLASS, scratch + 10 * rows);
+        const double* v_rel = unbind_bin_doubles(&blk, UNBIND_BIN_V_REL, scratch + 11 * rows);
+        const double* where = where_col >= 0 ? unbind_bin_doubles(&blk, where_col, scratch + 12 * rows) : NULL;
+        for (size_t i = 0; i < blk.rows; i++) {
+            if (where && !(where[i] >= lo && where[i] <= hi)) continue;
+            char* p = unbind_out_reserve(out, UNBIND_BODY_NAME + BATCH_ROW_MAX);
+            *p++ = (char)mode[i];
+            *p++ = ',';
+            p = unbind_fmt_str(p, unbind_registry_name(reg, (size_t)planet[i]));
+            *p++ = ',';
+            p = unbind_fmt_str(p, unbind_material_name((int)material[i]));
+            *p++ = ',';
+            p = unbind_fmt_g(p, eps[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_g(p, rho[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_f(p, ret[i], 3);
+            *p++ = ',';
+            p = unbind_fmt_g(p, eps_eff[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, m[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, D_km[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, v_class[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, v_rel[i], 6);
+            *p++ = ',';
+            *p++ = (char)('0' + (int)destroyed[i]);
+            *p++ = '\n';
+            unbind_out_advance(out, p);
+            printed++;
+        }
+    }
+    int status = unbind_out_flush(out) == 0 ? 0 : 1;
+    fprintf(stderr, "BIN    : %llu rows in %zu blocks, %llu printed, %llu blocks skipped\n",
+            (unsigned long long)f.n_rows, f.n_blocks, (unsigned long long)printed, (unsigned long long)skipped);
+    free(scratch);
+    unbind_bin_close(&f);
+    unbind_registry_free(reg);
+    return status;
 }
 
 int main(int argc, char** argv){
-    const double c  = 299792458.0;             // m/s
-    const double PI = 3.14159265358979323846;  // PI
-    const double MERCURY_MASS = 3.30e23;       // kg
-    const double CERES_MASS   = 9.38e20;       // kg
+    const double c  = UNBIND_SPEED_OF_LIGHT;   // m/s
+    const double MERCURY_MASS = UNBIND_MERCURY_MASS;
+    const double CERES_MASS   = UNBIND_CERES_MASS;
 
     char* object_name = NULL;
     char* planet_name = NULL;
@@ -277,6 +620,19 @@ int main(int argc, char** argv){
     int planet_type = PLANET_EARTH; // default to Earth
     int material_type = MATERIAL_STONY; // default to stony
     double U; // Will be set based on planet type
+
+    if (argc > 1 && strcmp(argv[1], "batch") == 0) return run_batch(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "bin2csv") == 0) return run_bin2csv(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "pairs") == 0) return run_pairs(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "boundary") == 0) return run_boundary(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "surface") == 0) return run_surface(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "airburst") == 0) return run_airburst(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "mpcorb") == 0) return run_mpcorb(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "merge") == 0) return run_merge(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "sweep") == 0) return run_sweep(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "mc") == 0) return run_mc(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) return run_server(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--stream") == 0) return run_stream(argc, argv);
     
     if (argc > 3) {
         // Check for atmospheric parameters (planet and material) at the end
@@ -324,12 +680,31 @@ int main(int argc, char** argv){
             "Usage:\n"
             "  %s m <mass_kg> [epsilon=1.0] [name] [planet/body] [impactor material]\n"
             "  %s d <diameter_km> [rho_kg_m3=3000] [epsilon=1.0] [name] [planet/body] [impactor material]\n"
-            "  %s v <speed_km_s> [rho_kg_m3=3000] [epsilon=1.0] [name] [planet/body] [impactor material]\n",
+            "  %s v <speed_km_s> [rho_kg_m3=3000] [epsilon=1.0] [name] [planet/body] [impactor material]\n"
+            "  %s batch <catalog.csv|-> [planets=all] [materials=all] [epsilons=1.0] [bin=<file|->] [bodies=<file>]\n"
+            "  %s sweep <m|d|v> <value-axis> [rho=<axis>] [eps=<axis>] [planets=all] [materials=all] [threads=0] [bin=<file|->]\n"
+            "      [bodies=<file>] [retention=table|entry[:<speed_km_s>[:<angle_deg>]]] [surface=<file.urs>]\n"
+            "  %s bin2csv <file.ubr> [where=<column>:<lo>:<hi>] [bodies=<file>]\n"
+            "  %s pairs <catalog.csv> [targets=catalog|planets|<bodies file>] [material=stony] [eps=1.0] [out=<file>] [threads=0]\n"
+            "  %s boundary [planets=all] [materials=all] [eps=1.0] [rho=3000] [D=1e-4:1e4] [v=0.01:299792] [cells=4096]\n"
+            "      [bodies=<file>]\n"
+            "  %s mc <m|d|v> <value-dist> [rho=<dist>] [eps=<dist>] [speed=<dist>|diameter=<dist>] [planet=earth] [material=stony] [samples=1000000] [threads=0] [seed=1]\n"
+            "      [surface=<file.urs>] [angle=<dist>]\n"
+            "  %s surface <file.urs> [planets=all] [materials=all] [D=1e-5:1e3:65] [speed=2:100:49] [angle=15:90:16]\n"
+            "      [threads=0]\n"
+            "  %s airburst <catalog.csv|-> [planets=earth] [materials=all] [speed=20] [angle=45] [rho=3000] [strength=<Pa>]\n"
+            "      [profile=<file>] [dz=1] [top=100] [threads=0]\n"
+            "  %s mpcorb <MPCORB.DAT|-> [planets=earth] [materials=stony] [eps=1.0] [rho=3000] [albedo=0.14] [threads=0]\n"
+            "  %s merge <shard> <shard> ...   (batch, sweep and mc take shard=i/N out=<file> checkpoint=<file> every=30)\n"
+            "  %s serve <unix:/path | tcp:port> [threads=0]\n"
+            "  %s --stream [--flush]   (requests on stdin, see unbind_proto.h)\n",
+            argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0],
             argv[0], argv[0], argv[0]);
         return 1;
     }
 
     char mode = argv[1][0];
+    unbind_out* out = unbind_stdout();   // report lines go through the fast formatter
 
     if (mode=='m' || mode=='M'){
         // Input: mass -> required speed (both classical & relativistic)
@@ -340,35 +715,32 @@ int main(int argc, char** argv){
         }
         
         // Estimate diameter from mass to calculate atmospheric retention
-        double volume = m / 3000.0; // Assume 3000 kg/m³ density for estimation
-        double D_km = 2.0 * cbrt((3.0*volume)/(4.0*PI)) / 1000.0;
-        double retention = atmospheric_retention(D_km, planet_type, material_type);
-        double effective_eps = eps * retention;
+        unbind_result r;
+        unbind_mass_to_speed(m, eps, U, planet_type, material_type, &r);
+        double retention = r.retention;
+        double effective_eps = r.effective_eps;
         
-        if (has_object) printf("OBJECT : %s\n", object_name);
-        if (planet_name) printf("PLANET : %s (U = %.6e J)\n", planet_name, U);
-        if (material_name) printf("MATERIAL: %s (retention = %.3f)\n", material_name, retention);
+        if (has_object) unbind_out_printf(out, "OBJECT : %s\n", object_name);
+        if (planet_name) unbind_out_printf(out, "PLANET : %s (U = %.6e J)\n", planet_name, U);
+        if (material_name) unbind_out_printf(out, "MATERIAL: %s (retention = %.3f)\n", material_name, retention);
 
-        printf("INPUT  : m = %.6e kg, epsilon = %.3f\n", m, eps);
-        printf("TARGET : U/epsilon_eff = %.6e J (eff. epsilon = %.3f)\n", U/effective_eps, effective_eps);
+        unbind_out_printf(out, "INPUT  : m = %.6e kg, epsilon = %.3f\n", m, eps);
+        unbind_out_printf(out, "TARGET : U/epsilon_eff = %.6e J (eff. epsilon = %.3f)\n", U/effective_eps, effective_eps);
         
-        double v_class = sqrt(2.0*(U/effective_eps)/m);
-        double gamma = 1.0 + (U/effective_eps)/(m*c*c);
-        double v_rel, beta2;
-        beta2 = 1.0 - 1.0/(gamma*gamma);
-        v_rel = c * sqrt(beta2<=0.0?0.0:beta2);
+        double v_class = r.v_class;
+        double v_rel = r.v_rel;
         
-        printf("RESULT : Required speed (classical)    = %.3f km/s\n", v_class/1000.0);
-        printf("         Required speed (relativistic) = %.3f km/s\n", v_rel/1000.0);
+        unbind_out_printf(out, "RESULT : Required speed (classical)    = %.3f km/s\n", v_class/1000.0);
+        unbind_out_printf(out, "         Required speed (relativistic) = %.3f km/s\n", v_rel/1000.0);
         if (v_rel >= 0.99*c) {
-            printf("         NOTE: v_rel ~ c (ultra-relativistic).\n");
-            printf("         CONCLUSION: %s SURVIVES - object too small to unbind planet\n", 
+            unbind_out_printf(out, "         NOTE: v_rel ~ c (ultra-relativistic).\n");
+            unbind_out_printf(out, "         CONCLUSION: %s SURVIVES - object too small to unbind planet\n", 
                 planet_name ? planet_name : "TARGET");
         } else {
-            printf("         CONCLUSION: %s DESTROYED at %.3f km/s impact\n", 
+            unbind_out_printf(out, "         CONCLUSION: %s DESTROYED at %.3f km/s impact\n", 
                 planet_name ? planet_name : "TARGET", v_rel/1000.0);
         }
-        return 0;
+        return unbind_out_flush(out) == 0 ? 0 : 1;
     }
 
     if (mode=='d' || mode=='D'){
@@ -381,36 +753,34 @@ int main(int argc, char** argv){
         }
         
         // Calculate atmospheric retention based on diameter
-        double retention = atmospheric_retention(D_km, planet_type, material_type);
-        double effective_eps = eps * retention;
+        unbind_result r;
+        unbind_diameter_to_speed(D_km, rho, eps, U, planet_type, material_type, &r);
+        double retention = r.retention;
+        double effective_eps = r.effective_eps;
         
-        if (has_object) printf("OBJECT : %s\n", object_name);
-        if (planet_name) printf("PLANET : %s (U = %.6e J)\n", planet_name, U);
-        if (material_name) printf("MATERIAL: %s (retention = %.3f)\n", material_name, retention);
-
-        double D = D_km * 1000.0;
-        double volume = (4.0/3.0) * PI * pow(D/2.0, 3.0);
-        double m = rho * volume;
-        double v_class = sqrt(2.0 * (U/effective_eps) / m);
-        double gamma = 1.0 + (U/effective_eps) / (m * c * c);
-        double beta2 = 1.0 - 1.0/(gamma*gamma);
-        double v_rel = c * sqrt(beta2<=0.0?0.0:beta2);
-
-        printf("INPUT  : D = %.3f km, rho = %.0f kg/m^3, epsilon = %.3f\n", D_km, rho, eps);
-        printf("TARGET : U/epsilon_eff = %.6e J (eff. epsilon = %.3f)\n", U/effective_eps, effective_eps);
-        printf("RESULT : Mass = %.6e kg (%.3f Mercury, %.3f Ceres)\n",
+        if (has_object) unbind_out_printf(out, "OBJECT : %s\n", object_name);
+        if (planet_name) unbind_out_printf(out, "PLANET : %s (U = %.6e J)\n", planet_name, U);
+        if (material_name) unbind_out_printf(out, "MATERIAL: %s (retention = %.3f)\n", material_name, retention);
+
+        double m = r.m;
+        double v_class = r.v_class;
+        double v_rel = r.v_rel;
+
+        unbind_out_printf(out, "INPUT  : D = %.3f km, rho = %.0f kg/m^3, epsilon = %.3f\n", D_km, rho, eps);
+        unbind_out_printf(out, "TARGET : U/epsilon_eff = %.6e J (eff. epsilon = %.3f)\n", U/effective_eps, effective_eps);
+        unbind_out_printf(out, "RESULT : Mass = %.6e kg (%.3f Mercury, %.3f Ceres)\n",
             m, m/MERCURY_MASS, m/CERES_MASS);
-        printf("         Required speed (classical)    = %.3f km/s\n", v_class/1000.0);
-        printf("         Required speed (relativistic) = %.3f km/s\n", v_rel/1000.0);
+        unbind_out_printf(out, "         Required speed (classical)    = %.3f km/s\n", v_class/1000.0);
+        unbind_out_printf(out, "         Required speed (relativistic) = %.3f km/s\n", v_rel/1000.0);
         if (v_rel >= 0.99*c) {
-            printf("         NOTE: v_rel ~ c (ultra-relativistic).\n");
-            printf("         CONCLUSION: %s SURVIVES - object too small to unbind planet\n", 
+            unbind_out_printf(out, "         NOTE: v_rel ~ c (ultra-relativistic).\n");
+            unbind_out_printf(out, "         CONCLUSION: %s SURVIVES - object too small to unbind planet\n", 
                 planet_name ? planet_name : "TARGET");
         } else {
-            printf("         CONCLUSION: %s DESTROYED at %.3f km/s impact\n", 
+            unbind_out_printf(out, "         CONCLUSION: %s DESTROYED at %.3f km/s impact\n", 
                 planet_name ? planet_name : "TARGET", v_rel/1000.0);
         }
-        return 0;
+        return unbind_out_flush(out) == 0 ? 0 : 1;
     }
 
     if (mode=='v' || mode=='V'){
@@ -423,58 +793,47 @@ int main(int argc, char** argv){
             fprintf(stderr,"Inputs must be positive.\n"); return 1;
         }
         
-        if (has_object) printf("OBJECT : %s\n", object_name);
+        if (has_object) unbind_out_printf(out, "OBJECT : %s\n", object_name);
         if (planet_name) {
-            printf("PLANET : %s (U = %.6e J)\n", planet_name, U);
+            unbind_out_printf(out, "PLANET : %s (U = %.6e J)\n", planet_name, U);
         } else {
-            printf("PLANET : %s (U = %.6e J)\n", "target", U);                       
+            unbind_out_printf(out, "PLANET : %s (U = %.6e J)\n", "target", U);                       
         }
 
-        double v = v_km_s * 1000.0;
-        double beta = v / c;
-        if (beta >= 1.0){
+        unbind_result r;
+        if (unbind_speed_to_mass(v_km_s, rho, eps, U, planet_type, material_type, &r) != UNBIND_OK){
+            unbind_out_flush(out);
             fprintf(stderr,"Speed must be < c.\n"); return 1;
         }
-        
-        // First calculate assuming no atmospheric losses to get initial diameter estimate
-        double gamma = 1.0 / sqrt(1.0 - beta*beta);
-        double k_per_mass = (gamma - 1.0) * c * c;
-        double m_req = U / (eps * k_per_mass);
-        double volume = m_req / rho;
-        double D_initial = 2.0 * cbrt((3.0*volume)/(4.0*PI));
-        double D_km_initial = D_initial / 1000.0;
-        
-        // Calculate atmospheric retention based on this diameter
-        double retention = atmospheric_retention(D_km_initial, planet_type, material_type);
-        double effective_eps = eps * retention;
-        
-        // Recalculate with atmospheric effects
-        m_req = U / (effective_eps * k_per_mass);
-        volume = m_req / rho;
-        D_initial = 2.0 * cbrt((3.0*volume)/(4.0*PI));
-        D_km_initial = D_initial / 1000.0;
-        
-        // Iterate once more for better accuracy
-        retention = atmospheric_retention(D_km_initial, planet_type, material_type);
-        effective_eps = eps * retention;
-        m_req = U / (effective_eps * k_per_mass);
-        volume = m_req / rho;
-        double D = 2.0 * cbrt((3.0*volume)/(4.0*PI));
-        double m_class = 2.0*U / (effective_eps * v * v);
-
-        if (material_name) printf("MATERIAL: %s (retention = %.3f)\n", material_name, retention);
-        printf("INPUT  : v = %.3f km/s, rho = %.0f kg/m^3, epsilon = %.3f\n", v_km_s, rho, eps);
-        printf("TARGET : U/epsilon_eff = %.6e J (eff. epsilon = %.3f)\n", U/effective_eps, effective_eps);
-        printf("RESULT : Minimum required mass (relativistic)   = %.6e kg (%.3f Mercury, %.3f Ceres)\n",
+        double retention = r.retention;
+        double effective_eps = r.effective_eps;
+        double m_req = r.m;
+        double D = r.D;
+        double m_class = r.m_class;
+
+        if (material_name) unbind_out_printf(out, "MATERIAL: %s (retention = %.3f)\n", material_name, retention);
+        unbind_out_printf(out, "INPUT  : v = %.3f km/s, rho = %.0f kg/m^3, epsilon = %.3f\n", v_km_s, rho, eps);
+        unbind_out_printf(out, "TARGET : U/epsilon_eff = %.6e J (eff. epsilon = %.3f)\n", U/effective_eps, effective_eps);
+        unbind_out_printf(out, "RESULT : Minimum required mass (relativistic)   = %.6e kg (%.3f Mercury, %.3f Ceres)\n",
             m_req, m_req/MERCURY_MASS, m_req/CERES_MASS);
-        printf("         Classical mass (for reference)         = %.6e kg\n", m_class);
-        printf("         Minimum equivalent diameter            = %.3f km\n", D/1000.0);
+        unbind_out_printf(out, "         Classical mass (for reference)         = %.6e kg\n", m_class);
+        unbind_out_printf(out, "         Minimum equivalent diameter            = %.3f km\n", D/1000.0);
 
         if (planet_name) {
-            printf("         NOTE: Any impactor ≥ %.3f km at %.3f km/s will unbind %s\n", D/1000.0, v_km_s, planet_name);
+            unbind_out_printf(out, "         NOTE: Any impactor ≥ %.3f km at %.3f km/s will unbind %s\n", D/1000.0, v_km_s, planet_name);
         } else {
-            printf("         NOTE: Any impactor ≥ %.3f km at %.3f km/s will unbind target\n", D/1000.0, v_km_s);                   
-        }        
+            unbind_out_printf(out, "         NOTE: Any impactor ≥ %.3f km at %.3f km/s will unbind target\n", D/1000.0, v_km_s);
+        }
+        if (unbind_out_flush(out) != 0) return 1;
+        /* Solver diagnostics go to stderr so the 'v' report on stdout stays as it was. */
+        if (r.solver_state == UNBIND_V_FIXED_POINT) {
+            fprintf(stderr, "SOLVER : retention fixed point in %d iteration(s)\n", r.iterations);
+        } else if (r.solver_state == UNBIND_V_BAND_EDGE) {
+            fprintf(stderr, "SOLVER : minimum sits on the %.3f km retention breakpoint (%d iterations)\n",
+                D/1000.0, r.iterations);
+        } else {
+            fprintf(stderr, "SOLVER : iteration cap (%d) reached, diameter is an upper bound\n", r.iterations);
+        }
         return 0;
     }
 
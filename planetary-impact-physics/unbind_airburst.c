@@ -0,0 +1,379 @@
+/* unbind_airburst.c
+* (C) 2025 - George McGinn - MIT License
+* Airburst mode for unbindEnergy (see unbind_airburst.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy airburst <catalog.csv|-> [planets=earth] [materials=all] [speed=20] [angle=45] [rho=3000]
+*                           [strength=<Pa>] [profile=<file>] [dz=1] [top=100] [threads=0]
+*
+* Examples:
+*   ./unbindEnergy airburst "Space Bodies (unbindEnergy).csv" materials=stony
+*   ./unbindEnergy airburst neos.csv materials=stony,iron angle=30 profile=deposition.csv dz=0.5 top=80
+*   ./unbindEnergy airburst chelyabinsk.csv planets=earth,mars strength=1e6
+*
+* Notes:
+*  - Catalog rows are read as in the batch mode (unbind_catalog.h). The impactor is the
+*    row's diameter, or its mass at rho= when it has no diameter; a row with both gives
+*    its own density. Rows without a speed enter at speed=. Every row is run for every
+*    planet and material at the same entry angle.
+*  - The body flies intact until the ram pressure rho_a v^2 reaches its strength, then
+*    flattens into a pancake that spreads sideways until its radius is 7 times the
+*    original (libunbind_entry.c). strength= overrides the material defaults of
+*    unbind_frag_strength(): 5 MPa stony, 50 MPa iron, 0.1 MPa cometary.
+*  - Output is one CSV line per row, planet and material: the entry energy, the
+*    breakup altitude (empty if the body never broke up), the altitude and size of the
+*    peak energy deposition, the fraction of the entry energy and mass that reach the
+*    surface, and how the trajectory ended. Energies are in kilotons of TNT (4.184e12 J).
+*  - profile= also writes the deposition profile: one line per dz= km altitude layer
+*    (from the surface to top=) that received energy, in kt per km of altitude. The
+*    energy counted is what the body gives to the air: kinetic energy lost plus the work
+*    done on it by gravity.
+*  - The catalog is read AIRBURST_CHUNK rows at a time. All result and deposition arrays
+*    are allocated once for a chunk and reused for every chunk after it; the chunk's
+*    trajectories run on the thread pool in tasks of AIRBURST_TASK rows, and the output
+*    is written in catalog order, so it is the same for any thread count.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_fmt.h"
+#include "unbind_proto.h"
+#include "unbind_catalog.h"
+#include "unbind_airburst.h"
+
+#define AIRBURST_CHUNK 1024           // catalog rows per pool run
+#define AIRBURST_TASK 64              // rows per unbind_frag_array() call
+#define AIRBURST_NAME 128             // longest name kept, with the NUL
+#define AIRBURST_MAX_LINE (1 << 16)
+#define AIRBURST_MAX_FIELDS 32
+#define AIRBURST_MAX_BINS 100000
+#define AIRBURST_KT 4.184e12          // J per kiloton of TNT
+#define AIRBURST_ROW_MAX (16 * UNBIND_FMT_MAX)   // a row apart from its quoted name
+
+static const char* const outcome_names[] = { "surface", "ablated", "stopped", "max_steps" };
+
+typedef struct {
+    int planets[PLANET_COUNT], n_planets;
+    int materials[MATERIAL_COUNT], n_materials;
+    double angle, strength;           // degrees; Pa, 0 for the material default
+    double dz_km;
+    int n_bins;                       // 0 without profile=
+    // The chunk: catalog rows
+    char (*name)[AIRBURST_NAME];
+    double* D_km;
+    double* rho;
+    double* speed;
+    size_t n;
+    // Results, AIRBURST_CHUNK per planet/material pair (pair = planet * n_materials + material)
+    double *breakup, *burst, *peak, *fraction, *mass, *v_end;
+    int* outcome;
+    double* deposition;               // n_bins per result, NULL without profile=
+} airburst_job;
+
+static void airburst_task(void* ctx, size_t task, int worker) {
+    (void)worker;
+    airburst_job* job = ctx;
+    size_t blocks = (job->n + AIRBURST_TASK - 1) / AIRBURST_TASK;
+    size_t pair = task / blocks, i0 = (task % blocks) * AIRBURST_TASK;
+    size_t at = pair * AIRBURST_CHUNK + i0;
+
+    unbind_frag_input in;
+    memset(&in, 0, sizeof(in));
+    in.planet = job->planets[pair / (size_t)job->n_materials];
+    in.material = job->materials[pair % (size_t)job->n_materials];
+    in.angle_deg = job->angle;
+    in.strength = job->strength;
+    in.D_km = job->D_km + i0;
+    in.speed_v = job->speed + i0;
+    in.rho_v = job->rho + i0;
+    in.bin_km = job->dz_km;
+    in.n_bins = job->n_bins;
+    in.n = job->n - i0 < AIRBURST_TASK ? job->n - i0 : AIRBURST_TASK;
+    unbind_frag_result out = { job->breakup + at, job->burst + at, job->peak + at, job->fraction + at,
+                               job->mass + at, job->v_end + at,
+                               job->deposition ? job->deposition + at * (size_t)job->n_bins : NULL,
+                               job->outcome + at, NULL };
+    unbind_frag_array(&in, &out);
+}
+
+static char* put_quoted(char* p, const char* s) {
+    *p++ = '"';
+    for (; *s; s++) {
+        if (*s == '"') *p++ = '"';
+        *p++ = *s;
+    }
+    *p++ = '"';
+    return p;
+}
+
+// An altitude in km, or nothing when there is none
+static char* put_altitude(char* p, double km) {
+    return isnan(km) ? p : unbind_fmt_f(p, km, 3);
+}
+
+static void write_rows(const airburst_job* job, unbind_out* out) {
+    for (size_t i = 0; i < job->n; i++) {
+        double R = job->D_km[i] * 500.0, v = job->speed[i] * 1000.0;
+        double energy = 0.5 * job->rho[i] * (4.0/3.0) * UNBIND_PI * R * R * R * v * v / AIRBURST_KT;
+        for (int pair = 0; pair < job->n_planets * job->n_materials; pair++) {
+            size_t at = (size_t)pair * AIRBURST_CHUNK + i;
+            int material = job->materials[pair % job->n_materials];
+            double strength = job->strength > 0.0 ? job->strength : unbind_frag_strength(material);
+            char* p = unbind_out_reserve(out, 2 * strlen(job->name[i]) + AIRBURST_ROW_MAX);
+            p = put_quoted(p, job->name[i]);
+            *p++ = ',';
+            p = unbind_fmt_str(p, unbind_planet_name(job->planets[pair / job->n_materials]));
+            *p++ = ',';
+            p = unbind_fmt_str(p, unbind_material_name(material));
+            *p++ = ',';
+            p = unbind_fmt_e(p, job->D_km[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_g(p, job->rho[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_g(p, job->speed[i], 6);
+            *p++ = ',';
+            p = unbind_fmt_g(p, job->angle, 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, strength, 3);
+            *p++ = ',';
+            p = unbind_fmt_e(p, energy, 6);
+            *p++ = ',';
+            p = put_altitude(p, job->breakup[at]);
+            *p++ = ',';
+            p = put_altitude(p, job->burst[at]);
+            *p++ = ',';
+            p = unbind_fmt_e(p, job->peak[at] * 1000.0 / AIRBURST_KT, 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, job->fraction[at], 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, job->mass[at], 6);
+            *p++ = ',';
+            p = unbind_fmt_e(p, job->v_end[at] / 1000.0, 6);
+            *p++ = ',';
+            p = unbind_fmt_str(p, outcome_names[job->outcome[at]]);
+            *p++ = '\n';
+            unbind_out_advance(out, p);
+        }
+    }
+}
+
+static void write_profiles(const airburst_job* job, unbind_out* out) {
+    for (size_t i = 0; i < job->n; i++) {
+        for (int pair = 0; pair < job->n_planets * job->n_materials; pair++) {
+            const double* bins = job->deposition + ((size_t)pair * AIRBURST_CHUNK + i) * (size_t)job->n_bins;
+            for (int b = 0; b < job->n_bins; b++) {
+                if (!(bins[b] > 0.0)) continue;
+                char* p = unbind_out_reserve(out, 2 * strlen(job->name[i]) + AIRBURST_ROW_MAX);
+                p = put_quoted(p, job->name[i]);
+                *p++ = ',';
+                p = unbind_fmt_str(p, unbind_planet_name(job->planets[pair / job->n_materials]));
+                *p++ = ',';
+                p = unbind_fmt_str(p, unbind_material_name(job->materials[pair % job->n_materials]));
+                *p++ = ',';
+                p = unbind_fmt_f(p, (b + 0.5) * job->dz_km, 3);
+                *p++ = ',';
+                p = unbind_fmt_e(p, bins[b] / (AIRBURST_KT * job->dz_km), 6);
+                *p++ = '\n';
+                unbind_out_advance(out, p);
+            }
+        }
+    }
+}
+
+static int airburst_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s airburst <catalog.csv|-> [planets=earth] [materials=all] [speed=20] [angle=45] [rho=3000]\n"
+        "          [strength=<Pa>] [profile=<file>] [dz=1] [top=100] [threads=0]\n", prog);
+    return 1;
+}
+
+int run_airburst(int argc, char** argv) {
+    static const char header[] =
+        "name,planet,material,diameter_km,rho_kg_m3,speed_km_s,angle_deg,strength_pa,energy_kt,breakup_km,"
+        "burst_km,peak_kt_per_km,ground_energy_fraction,mass_fraction,v_end_km_s,outcome\n";
+    static const char profile_header[] = "name,planet,material,altitude_km,kt_per_km\n";
+    const char* planet_spec = "earth";
+    const char* material_spec = "all";
+    const char* profile_path = NULL;
+    double speed = 20.0, rho = UNBIND_DEFAULT_DENSITY, top_km = 100.0;
+    int threads = 0;
+    airburst_job job;
+    memset(&job, 0, sizeof(job));
+    job.angle = 45.0;
+    job.dz_km = 1.0;
+
+    if (argc < 3) return airburst_usage(argv[0]);
+    for (int i = 3; i < argc; i++) {
+        if (strncmp(argv[i], "planets=", 8) == 0) planet_spec = argv[i] + 8;
+        else if (strncmp(argv[i], "materials=", 10) == 0) material_spec = argv[i] + 10;
+        else if (strncmp(argv[i], "speed=", 6) == 0) speed = strtod(argv[i] + 6, NULL);
+        else if (strncmp(argv[i], "angle=", 6) == 0) job.angle = strtod(argv[i] + 6, NULL);
+        else if (strncmp(argv[i], "rho=", 4) == 0) rho = strtod(argv[i] + 4, NULL);
+        else if (strncmp(argv[i], "strength=", 9) == 0) job.strength = strtod(argv[i] + 9, NULL);
+        else if (strncmp(argv[i], "profile=", 8) == 0) profile_path = argv[i] + 8;
+        else if (strncmp(argv[i], "dz=", 3) == 0) job.dz_km = strtod(argv[i] + 3, NULL);
+        else if (strncmp(argv[i], "top=", 4) == 0) top_km = strtod(argv[i] + 4, NULL);
+        else if (strncmp(argv[i], "threads=", 8) == 0) threads = atoi(argv[i] + 8);
+        else {
+            fprintf(stderr, "Unknown airburst option: %s\n", argv[i]);
+            return airburst_usage(argv[0]);
+        }
+    }
+    job.n_planets = unbind_parse_planet_list(planet_spec, job.planets, PLANET_COUNT);
+    job.n_materials = unbind_parse_material_list(material_spec, job.materials, MATERIAL_COUNT);
+    if (job.n_planets < 0 || job.n_materials < 0) {
+        fprintf(stderr, "Planets/materials must be comma-separated names or 'all'.\n");
+        return 1;
+    }
+    if (!(speed > 0.0) || !(rho > 0.0) || !(job.angle > 0.0 && job.angle <= 90.0) || job.strength < 0.0) {
+        fprintf(stderr, "speed and rho must be positive, angle in (0, 90] and strength not negative.\n");
+        return 1;
+    }
+    if (profile_path) {
+        double bins = ceil(top_km / job.dz_km);
+        if (!(job.dz_km > 0.0) || !(bins >= 1.0 && bins <= AIRBURST_MAX_BINS)) {
+            fprintf(stderr, "dz and top must be positive, with at most %d layers.\n", AIRBURST_MAX_BINS);
+            return 1;
+        }
+        job.n_bins = (int)bins;
+    }
+
+    size_t results = (size_t)(job.n_planets * job.n_materials) * AIRBURST_CHUNK;
+    FILE* fp = strcmp(argv[2], "-") == 0 ? stdin : fopen(argv[2], "r");
+    int profile_fd = -1;
+    char* profile_buf = NULL;
+    char* line = malloc(AIRBURST_MAX_LINE);
+    unbind_pool* pool = NULL;
+    unbind_out profile;
+    int status = 1;
+    job.name = malloc(AIRBURST_CHUNK * AIRBURST_NAME);
+    job.D_km = malloc(AIRBURST_CHUNK * sizeof(double));
+    job.rho = malloc(AIRBURST_CHUNK * sizeof(double));
+    job.speed = malloc(AIRBURST_CHUNK * sizeof(double));
+    job.breakup = malloc(results * sizeof(double));
+    job.burst = malloc(results * sizeof(double));
+    job.peak = malloc(results * sizeof(double));
+    job.fraction = malloc(results * sizeof(double));
+    job.mass = malloc(results * sizeof(double));
+    job.v_end = malloc(results * sizeof(double));
+    job.outcome = malloc(results * sizeof(int));
+    if (job.n_bins > 0) job.deposition = malloc(results * (size_t)job.n_bins * sizeof(double));
+    if (!fp) {
+        fprintf(stderr, "Cannot open catalog: %s\n", argv[2]);
+        goto done;
+    }
+    if (!line || !job.name || !job.D_km || !job.rho || !job.speed || !job.breakup || !job.burst ||
+        !job.peak || !job.fraction || !job.mass || !job.v_end || !job.outcome ||
+        (job.n_bins > 0 && !job.deposition)) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    if (profile_path) {
+        profile_fd = open(profile_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        profile_buf = malloc(UNBIND_OUT_BUF);
+        if (profile_fd < 0 || !profile_buf) {
+            fprintf(stderr, "Cannot write deposition profiles: %s\n", profile_path);
+            goto done;
+        }
+        unbind_out_init(&profile, profile_fd, profile_buf, UNBIND_OUT_BUF);
+        unbind_out_write(&profile, profile_header, sizeof(profile_header) - 1);
+    }
+    pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        goto done;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    unbind_out* out = unbind_stdout();
+    unbind_out_write(out, header, sizeof(header) - 1);
+    unbind_catalog_columns col;
+    unbind_catalog_default_columns(&col);
+    long lines = 0, rows = 0;
+    int eof = 0;
+    status = 0;
+    while (!eof && status == 0) {
+        // Fill the chunk
+        job.n = 0;
+        while (job.n < AIRBURST_CHUNK) {
+            if (!fgets(line, AIRBURST_MAX_LINE, fp)) {
+                eof = 1;
+                break;
+            }
+            size_t len = strlen(line);
+            lines++;
+            if (len == AIRBURST_MAX_LINE - 1 && line[len-1] != '\n') {
+                fprintf(stderr, "Catalog line %ld too long.\n", lines);
+                status = 1;
+                break;
+            }
+            while (len && (line[len-1] == '\n' || line[len-1] == '\r')) line[--len] = '\0';
+            if (len == 0) continue;
+            char* fields[AIRBURST_MAX_FIELDS];
+            int n = unbind_split_csv(line, fields, AIRBURST_MAX_FIELDS);
+            int header = lines == 1 ? unbind_catalog_header(fields, n, &col) : 0;
+            if (header < 0) {
+                fprintf(stderr, "Catalog header names neither a mass nor a diameter column.\n");
+                status = 1;
+                eof = 1;
+                break;
+            }
+            if (header) continue;
+            unbind_catalog_row r;
+            if (!unbind_catalog_row_parse(fields, n, &col, &r) || !(r.has_m || r.has_d)) continue;
+
+            size_t k = job.n++;
+            double D = r.D_km, density = rho;
+            if (r.has_m && r.has_d)
+                density = r.m / ((4.0/3.0) * UNBIND_PI * pow(D * 500.0, 3.0));
+            else if (r.has_m)
+                D = cbrt(r.m / ((4.0/3.0) * UNBIND_PI * rho)) / 500.0;
+            memset(job.name[k], 0, AIRBURST_NAME);
+            strncpy(job.name[k], r.name, AIRBURST_NAME - 1);
+            job.D_km[k] = D;
+            job.rho[k] = density;
+            job.speed[k] = r.has_v ? r.v_km_s : speed;
+        }
+        if (job.n == 0) break;
+        rows += (long)job.n;
+
+        size_t blocks = (job.n + AIRBURST_TASK - 1) / AIRBURST_TASK;
+        unbind_pool_run(pool, blocks * (size_t)(job.n_planets * job.n_materials), airburst_task, &job);
+        write_rows(&job, out);
+        if (job.n_bins > 0) write_profiles(&job, &profile);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+    if (ferror(fp)) {
+        fprintf(stderr, "Error reading catalog: %s\n", argv[2]);
+        status = 1;
+    }
+    if (unbind_out_flush(out) != 0 || (job.n_bins > 0 && unbind_out_flush(&profile) != 0)) {
+        fprintf(stderr, "Error writing output.\n");
+        status = 1;
+    }
+    long trajectories = rows * job.n_planets * job.n_materials;
+    fprintf(stderr, "BURST  : %ld rows x %d planets x %d materials, %ld trajectories on %d threads in %.3f s (%.3g us each)\n",
+            rows, job.n_planets, job.n_materials, trajectories, unbind_pool_threads(pool), secs,
+            trajectories > 0 ? 1e6 * secs / (double)trajectories : 0.0);
+
+done:
+    unbind_pool_destroy(pool);
+    if (profile_fd >= 0) close(profile_fd);
+    free(profile_buf);
+    if (fp && fp != stdin) fclose(fp);
+    free(line);
+    free(job.name); free(job.D_km); free(job.rho); free(job.speed);
+    free(job.breakup); free(job.burst); free(job.peak); free(job.fraction); free(job.mass); free(job.v_end);
+    free(job.outcome); free(job.deposition);
+    return status;
+}
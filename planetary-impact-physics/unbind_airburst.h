@@ -0,0 +1,14 @@
+/* unbind_airburst.h
+* (C) 2025 - George McGinn - MIT License
+* Airburst mode for unbindEnergy: breakup altitude, energy deposition profile and surviving
+* mass for every catalog row, from the fragmentation (pancake) model in libunbind_entry.c.
+*/
+
+#ifndef UNBIND_AIRBURST_H
+#define UNBIND_AIRBURST_H
+
+// airburst <catalog.csv|-> [planets=earth] [materials=all] [speed=20] [angle=45] [rho=3000]
+//          [strength=<Pa>] [profile=<file>] [dz=1] [top=100] [threads=0]
+int run_airburst(int argc, char** argv);
+
+#endif
@@ -0,0 +1,146 @@
+/* unbind_bin.h
+* (C) 2025 - George McGinn - MIT License
+* Binary columnar result files for batch and sweep runs: writer and mmap reader.
+*
+* File layout (native little-endian, every section 8-byte aligned):
+*   header      unbind_bin_header, then n_columns unbind_bin_column descriptors
+*   blocks      up to block_rows rows each, one after another:
+*                 unbind_bin_block_header
+*                 min[n_columns], max[n_columns]   (doubles; NaN ignored, +Inf/-Inf if none)
+*                 unbind_bin_chunk[n_columns]      (how each column is stored in this block)
+*                 column payloads (each padded to 8 bytes; none for SAME and PRODUCT)
+*
+* Reader use:
+*   unbind_bin_file f;
+*   if (unbind_bin_open("run.ubr", &f) == 0) {
+*       double* scratch = malloc(f.header->block_rows * sizeof(double));
+*       for (size_t b = 0; b < f.n_blocks; b++) {
+*           unbind_bin_block blk;
+*           unbind_bin_get_block(&f, b, &blk);
+*           if (blk.max[UNBIND_BIN_V_REL] < 50.0) continue;    // skip the block unread
+*           const double* v = unbind_bin_doubles(&blk, UNBIND_BIN_V_REL, scratch);
+*           ...
+*       }
+*       free(scratch);
+*       unbind_bin_close(&f);
+*   }
+*/
+
+#ifndef UNBIND_BIN_H
+#define UNBIND_BIN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UNBIND_BIN_MAGIC "UNBCOL1"         // 8 bytes with the NUL
+#define UNBIND_BIN_VERSION 3
+#define UNBIND_BIN_ENDIAN 0x01020304u
+#define UNBIND_BIN_BLOCK_ROWS 65536
+
+// Column types
+#define UNBIND_BIN_U8 1
+#define UNBIND_BIN_U32 2
+#define UNBIND_BIN_F64 3
+
+// Column encodings within a block
+#define UNBIND_BIN_PLAIN 0                 // rows values of the column's width
+#define UNBIND_BIN_CONST 1                 // one double, the value of every row
+#define UNBIND_BIN_SEQUENCE 2              // entries (first row, value) double pairs: counting runs
+#define UNBIND_BIN_DICT 3                  // entries doubles, then one bits-wide code per row (LSB first)
+#define UNBIND_BIN_SAME 4                  // nothing: equal to column ref[0]
+#define UNBIND_BIN_PRODUCT 5               // nothing: column ref[0] times column ref[1]
+
+// Columns, in file order
+#define UNBIND_BIN_MODE 0                  // u8: 'm', 'd' or 'v'
+#define UNBIND_BIN_VALUE 1                 // f64: input mass (kg), diameter (km) or speed (km/s)
+#define UNBIND_BIN_RHO 2                   // f64: kg/m^3
+#define UNBIND_BIN_EPSILON 3               // f64
+#define UNBIND_BIN_PLANET 4                // u32: target body index (PLANET_* or bodies= file order)
+#define UNBIND_BIN_MATERIAL 5              // u8: MATERIAL_*
+#define UNBIND_BIN_RETENTION 6             // f64
+#define UNBIND_BIN_EPS_EFF 7               // f64
+#define UNBIND_BIN_MASS 8                  // f64: kg
+#define UNBIND_BIN_V_CLASS 9               // f64: km/s
+#define UNBIND_BIN_V_REL 10                // f64: km/s
+#define UNBIND_BIN_DIAMETER 11             // f64: km
+#define UNBIND_BIN_DESTROYED 12            // u8
+#define UNBIND_BIN_SOURCE 13               // u32: batch catalog data row, sweep value-axis index
+#define UNBIND_BIN_COLUMNS 14
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;                       // UNBIND_BIN_ENDIAN as written
+    uint32_t n_columns;
+    uint32_t block_rows;
+    uint64_t n_rows;                       // 0 when written to a pipe (the reader counts blocks)
+    uint64_t data_offset;                  // first block
+    uint64_t reserved[3];
+} unbind_bin_header;
+
+typedef struct {
+    char     name[24];
+    uint32_t type;                         // UNBIND_BIN_U8 / U32 / F64
+    uint32_t width;                        // bytes per value
+} unbind_bin_column;
+
+typedef struct {
+    uint64_t rows;
+    uint64_t bytes;                        // whole block, this header included
+} unbind_bin_block_header;
+
+typedef struct {
+    uint8_t  encoding;                     // UNBIND_BIN_PLAIN ... PRODUCT
+    uint8_t  bits;                         // DICT code width: 1, 2, 4 or 8
+    uint16_t entries;                      // DICT values, SEQUENCE runs
+    uint16_t ref[2];                       // SAME and PRODUCT sources, always earlier columns
+    uint64_t offset;                       // payload, from the block start; 0 if there is none
+} unbind_bin_chunk;
+
+// One result row handed to the writer
+typedef struct {
+    double   value, rho, epsilon, retention, eps_eff, m, v_class, v_rel, D_km;
+    uint32_t source, planet;
+    char     mode;
+    unsigned char material, destroyed;
+} unbind_bin_row;
+
+/* Writer. Rows are buffered into column blocks and written with write(2) when a block fills. */
+typedef struct unbind_bin_writer unbind_bin_writer;
+
+int unbind_bin_open_output(const char* path);      // "-" is stdout; -1 on error
+unbind_bin_writer* unbind_bin_create(int fd);      // writes the header; NULL on error
+int unbind_bin_append(unbind_bin_writer* w, const unbind_bin_row* rows, size_t n);
+int unbind_bin_finish(unbind_bin_writer* w);       // last block, row count, close fd > 2, free; 0 or -1
+
+/* Reader. Column pointers point into the read-only mapping. */
+typedef struct {
+    const unsigned char* base;
+    size_t size;
+    const unbind_bin_header* header;
+    const unbind_bin_column* columns;
+    uint64_t n_rows;
+    size_t n_blocks;
+    uint64_t* block_offset;                // n_blocks entries
+} unbind_bin_file;
+
+typedef struct {
+    uint64_t rows;
+    uint64_t first_row;                    // row number of the block's first row in the file
+    const double* min;                     // n_columns entries
+    const double* max;
+    const unbind_bin_chunk* chunk;         // n_columns entries
+    const unsigned char* base;             // block start, which chunk offsets count from
+} unbind_bin_block;
+
+int unbind_bin_open(const char* path, unbind_bin_file* f);      // 0, or -1 with errno set
+void unbind_bin_close(unbind_bin_file* f);
+int unbind_bin_get_block(const unbind_bin_file* f, size_t b, unbind_bin_block* out);
+int unbind_bin_column_index(const char* name);     // -1 if unknown
+const char* unbind_bin_column_name(int column);
+double unbind_bin_value(const unbind_bin_block* blk, int column, size_t row);   // any column as double
+// A column's rows as doubles: in place when it is a PLAIN f64 column (or SAME as one), otherwise
+// decoded into scratch, which must hold blk->rows values
+const double* unbind_bin_doubles(const unbind_bin_block* blk, int column, double* scratch);
+
+#endif
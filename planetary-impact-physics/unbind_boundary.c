@@ -0,0 +1,321 @@
+/* unbind_boundary.c
+* (C) 2025 - George McGinn - MIT License
+* Destruction-boundary mode for unbindEnergy (see unbind_boundary.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy boundary [planets=all] [materials=all] [eps=1.0] [rho=3000] [D=1e-4:1e4] [v=0.01:299792]
+*                           [cells=4096] [bodies=<file>]
+*
+* Examples:
+*   ./unbindEnergy boundary planets=earth,mars materials=stony > boundary.csv
+*   ./unbindEnergy boundary planets=moon eps=0.25,1 D=0.001:100 v=1:299000 cells=16384
+*
+* Notes:
+*  - A point (D, v) is DESTROYED when eps * retention(D) * KE_rel(D, v) >= U, with the
+*    impactor mass rho * (4/3)pi(D/2)^3. The test is done on
+*    g = log(eps * retention * KE / U), evaluated on a log-log grid of cells x cells.
+*  - The grid is never filled. It is covered by 16 x 16 root cells, and a cell is split
+*    into four only while its corners disagree on the sign of g, down to single grid
+*    cells. KE grows with D and v and retention never falls as D grows, so the boundary
+*    is a non-increasing staircase: it cannot enter and leave a cell through the same
+*    side, and every cell it crosses has corners of both signs. No part of it is missed
+*    at any level, and the work is proportional to its length (about cells), not cells^2.
+*  - In a finest cell the crossings on its sides are interpolated linearly in g. On a
+*    side that spans a retention breakpoint the crossing is put on the breakpoint, where
+*    the boundary drops vertically. Every vertex is therefore within one grid cell
+*    ((log10 range) / cells decades) of the true curve.
+*  - Output is one CSV line per polyline vertex, in order of increasing diameter, for
+*    each planet, material and epsilon.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include "libunbind.h"
+#include "unbind_fmt.h"
+#include "unbind_sweep.h"
+#include "unbind_registry.h"
+#include "unbind_boundary.h"
+
+#define BOUNDARY_ROOT 16              // root cells per axis
+#define BOUNDARY_MAX_CELLS (1u << 24)
+
+typedef struct {
+    uint64_t key;                     // (x << 32 | y) + 1, 0 if empty
+    double g;
+} boundary_slot;
+
+typedef struct {
+    double x, y;                      // grid coordinates
+} boundary_point;
+
+typedef struct {
+    double U, eps, rho;
+    const unbind_retention_table* table;
+    double lx0, lx1, ly0, ly1;        // log10 of the D (km) and v (km/s) ranges
+    uint32_t n;                       // grid cells per axis
+    boundary_slot* cache;             // g at evaluated grid nodes
+    size_t mask, used;
+    boundary_point* pts;
+    size_t n_pts, cap_pts;
+    int error;
+} boundary_curve;
+
+// log(eps * retention * KE_rel / U) at grid node (x, y)
+static double boundary_g(const boundary_curve* c, uint32_t x, uint32_t y) {
+    const double cc = UNBIND_SPEED_OF_LIGHT;
+    double D_km = pow(10.0, c->lx0 + (c->lx1 - c->lx0) * x / c->n);
+    double v = 1000.0 * pow(10.0, c->ly0 + (c->ly1 - c->ly0) * y / c->n);
+    double ret = unbind_retention_lookup(c->table, D_km);
+    double R = D_km * 500.0;
+    double m = c->rho * (4.0/3.0) * UNBIND_PI * R * R * R;
+    double b2 = (v / cc) * (v / cc);
+    if (b2 >= 1.0) return INFINITY;
+    double s = sqrt(1.0 - b2);
+    double ke = b2 / (s * (1.0 + s)) * m * cc * cc;         // (gamma - 1) m c^2 without cancellation
+    return log(c->eps * ret * ke / c->U);                  // -Inf when retention is 0
+}
+
+static double cached_g(boundary_curve* c, uint32_t x, uint32_t y) {
+    uint64_t key = ((uint64_t)x << 32 | y) + 1;
+    if (2 * (c->used + 1) > c->mask + 1) {
+        size_t size = 2 * (c->mask + 1);
+        boundary_slot* grown = calloc(size, sizeof(boundary_slot));
+        if (!grown) {
+            c->error = 1;
+            return boundary_g(c, x, y);
+        }
+        for (size_t i = 0; i <= c->mask; i++) {
+            if (!c->cache[i].key) continue;
+            size_t j = (size_t)(c->cache[i].key * 0x9E3779B97F4A7C15ull >> 20) & (size - 1);
+            while (grown[j].key) j = (j + 1) & (size - 1);
+            grown[j] = c->cache[i];
+        }
+        free(c->cache);
+        c->cache = grown;
+        c->mask = size - 1;
+    }
+    size_t j = (size_t)(key * 0x9E3779B97F4A7C15ull >> 20) & c->mask;
+    while (c->cache[j].key && c->cache[j].key != key) j = (j + 1) & c->mask;
+    if (!c->cache[j].key) {
+        c->cache[j].key = key;
+        c->cache[j].g = boundary_g(c, x, y);
+        c->used++;
+    }
+    return c->cache[j].g;
+}
+
+static void add_point(boundary_curve* c, double x, double y) {
+    if (c->n_pts == c->cap_pts) {
+        size_t cap = c->cap_pts ? 2 * c->cap_pts : 1024;
+        boundary_point* grown = realloc(c->pts, cap * sizeof(boundary_point));
+        if (!grown) {
+            c->error = 1;
+            return;
+        }
+        c->pts = grown;
+        c->cap_pts = cap;
+    }
+    c->pts[c->n_pts].x = x;
+    c->pts[c->n_pts].y = y;
+    c->n_pts++;
+}
+
+// Fraction of the way from g0 to g1 where g crosses zero
+static double crossing(double g0, double g1) {
+    return isfinite(g0) && isfinite(g1) ? g0 / (g0 - g1) : 0.5;
+}
+
+// Crossing on the side from (x, y) to (x + 1, y): on a retention breakpoint inside it, if any
+static void horizontal_crossing(boundary_curve* c, uint32_t x, uint32_t y, double g0, double g1) {
+    double lo = c->lx0 + (c->lx1 - c->lx0) * x / c->n;
+    double hi = c->lx0 + (c->lx1 - c->lx0) * (x + 1) / c->n;
+    for (int i = 0; i < c->table->n_breakpoints; i++) {
+        double lb = log10(c->table->breakpoint_km[i]);
+        if (lb > lo && lb <= hi) {
+            add_point(c, x + (lb - lo) / (hi - lo), y);
+            return;
+        }
+    }
+    add_point(c, x + crossing(g0, g1), y);
+}
+
+static void refine(boundary_curve* c, uint32_t x, uint32_t y, uint32_t s) {
+    double g00 = cached_g(c, x, y), g10 = cached_g(c, x + s, y);
+    double g01 = cached_g(c, x, y + s), g11 = cached_g(c, x + s, y + s);
+    int inside = (g00 >= 0.0) + (g10 >= 0.0) + (g01 >= 0.0) + (g11 >= 0.0);
+    if (inside == 0 || inside == 4) return;
+    if (s > 1) {
+        uint32_t h = s / 2;
+        refine(c, x, y, h);
+        refine(c, x + h, y, h);
+        refine(c, x, y + h, h);
+        refine(c, x + h, y + h, h);
+        return;
+    }
+    if ((g00 >= 0.0) != (g10 >= 0.0)) horizontal_crossing(c, x, y, g00, g10);
+    if ((g01 >= 0.0) != (g11 >= 0.0)) horizontal_crossing(c, x, y + 1, g01, g11);
+    if ((g00 >= 0.0) != (g01 >= 0.0)) add_point(c, x, y + crossing(g00, g01));
+    if ((g10 >= 0.0) != (g11 >= 0.0)) add_point(c, x + 1, y + crossing(g10, g11));
+}
+
+// Increasing diameter; at equal diameter (a vertical drop) decreasing speed
+static int point_order(const void* a, const void* b) {
+    const boundary_point* p = a;
+    const boundary_point* q = b;
+    if (p->x != q->x) return p->x < q->x ? -1 : 1;
+    if (p->y != q->y) return p->y > q->y ? -1 : 1;
+    return 0;
+}
+
+static size_t print_curve(boundary_curve* c, const char* planet, int material, unbind_out* out) {
+    qsort(c->pts, c->n_pts, sizeof(boundary_point), point_order);
+    char prefix[UNBIND_BODY_NAME + 96], *p = prefix;
+    p = unbind_fmt_str(p, planet);
+    *p++ = ',';
+    p = unbind_fmt_str(p, unbind_material_name(material));
+    *p++ = ',';
+    p = unbind_fmt_g(p, c->eps, 6);
+    *p++ = ',';
+    p = unbind_fmt_g(p, c->rho, 6);
+    *p++ = ',';
+    size_t prefix_len = (size_t)(p - prefix), printed = 0;
+    for (size_t i = 0; i < c->n_pts; i++) {
+        if (i > 0 && c->pts[i].x == c->pts[i-1].x && c->pts[i].y == c->pts[i-1].y) continue;
+        p = unbind_out_reserve(out, prefix_len + 2 * UNBIND_FMT_MAX + 2);
+        memcpy(p, prefix, prefix_len);
+        p += prefix_len;
+        p = unbind_fmt_e(p, pow(10.0, c->lx0 + (c->lx1 - c->lx0) * c->pts[i].x / c->n), 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, pow(10.0, c->ly0 + (c->ly1 - c->ly0) * c->pts[i].y / c->n), 6);
+        *p++ = '\n';
+        unbind_out_advance(out, p);
+        printed++;
+    }
+    return printed;
+}
+
+static int parse_range(const char* spec, double* lo, double* hi) {
+    char tail;
+    return sscanf(spec, "%lf:%lf%c", lo, hi, &tail) == 2 && *lo > 0.0 && *hi > *lo ? 0 : -1;
+}
+
+static int boundary_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s boundary [planets=all] [materials=all] [eps=1.0] [rho=3000] [D=1e-4:1e4] [v=0.01:299792]\n"
+        "          [cells=4096] [bodies=<file>]\n"
+        "  eps, rho: lin:a:b:n | log:a:b:n | x1,x2,...   D (km), v (km/s): lo:hi\n", prog);
+    return 1;
+}
+
+int run_boundary(int argc, char** argv) {
+    const char* planet_spec = "all";
+    const char* material_spec = "all";
+    const char* eps_spec = "1.0";
+    const char* rho_spec = "3000";
+    const char* bodies_path = NULL;
+    double D_lo = 1e-4, D_hi = 1e4, v_lo = 0.01, v_hi = 299792.0;
+    long cells = 4096;
+
+    for (int i = 2; i < argc; i++) {
+        if (strncmp(argv[i], "planets=", 8) == 0) planet_spec = argv[i] + 8;
+        else if (strncmp(argv[i], "materials=", 10) == 0) material_spec = argv[i] + 10;
+        else if (strncmp(argv[i], "eps=", 4) == 0) eps_spec = argv[i] + 4;
+        else if (strncmp(argv[i], "rho=", 4) == 0) rho_spec = argv[i] + 4;
+        else if (strncmp(argv[i], "bodies=", 7) == 0) bodies_path = argv[i] + 7;
+        else if (strncmp(argv[i], "cells=", 6) == 0) cells = atol(argv[i] + 6);
+        else if (strncmp(argv[i], "D=", 2) == 0 && parse_range(argv[i] + 2, &D_lo, &D_hi) == 0) continue;
+        else if (strncmp(argv[i], "v=", 2) == 0 && parse_range(argv[i] + 2, &v_lo, &v_hi) == 0) continue;
+        else {
+            fprintf(stderr, "Bad boundary option: %s\n", argv[i]);
+            return boundary_usage(argv[0]);
+        }
+    }
+    if (cells < BOUNDARY_ROOT || cells > (long)BOUNDARY_MAX_CELLS || v_hi * 1000.0 >= UNBIND_SPEED_OF_LIGHT) {
+        fprintf(stderr, "cells must be %d to %u and speeds below c.\n", BOUNDARY_ROOT, BOUNDARY_MAX_CELLS);
+        return 1;
+    }
+
+    sweep_axis eps, rho;
+    int materials[MATERIAL_COUNT];
+    int* planets = NULL;
+    int status = 1;
+    memset(&eps, 0, sizeof(eps));
+    memset(&rho, 0, sizeof(rho));
+    unbind_registry* reg = unbind_registry_open(bodies_path);
+    if (!reg) return 1;
+    int n_planets = unbind_registry_parse_list(reg, planet_spec, &planets);
+    int n_materials = unbind_parse_material_list(material_spec, materials, MATERIAL_COUNT);
+    if (n_planets < 0 || n_materials < 0) {
+        fprintf(stderr, "Planets/materials must be comma-separated names or 'all'.\n");
+        goto done;
+    }
+    if (sweep_parse_axis(eps_spec, &eps) != 0 || sweep_parse_axis(rho_spec, &rho) != 0) {
+        fprintf(stderr, "eps and rho must be lin:a:b:n, log:a:b:n or a list.\n");
+        goto done;
+    }
+
+    boundary_curve c;
+    memset(&c, 0, sizeof(c));
+    c.n = BOUNDARY_ROOT;
+    while (c.n < (uint32_t)cells) c.n *= 2;
+    c.lx0 = log10(D_lo);
+    c.lx1 = log10(D_hi);
+    c.ly0 = log10(v_lo);
+    c.ly1 = log10(v_hi);
+    c.mask = 4095;
+    c.cache = calloc(c.mask + 1, sizeof(boundary_slot));
+    if (!c.cache) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+
+    static const char header[] = "planet,material,epsilon,rho_kg_m3,diameter_km,speed_km_s\n";
+    unbind_out* out = unbind_stdout();
+    unbind_out_write(out, header, sizeof(header) - 1);
+    size_t evals = 0, vertices = 0, curves = 0;
+    uint32_t root = c.n / BOUNDARY_ROOT;
+    for (int ip = 0; ip < n_planets; ip++) {
+        const unbind_body* body = unbind_registry_body(reg, (size_t)planets[ip]);
+        c.U = body->U;
+        for (int im = 0; im < n_materials; im++) {
+            c.table = unbind_retention_table_for(body->atmosphere, materials[im]);
+            for (size_t ie = 0; ie < eps.n; ie++) {
+                for (size_t ir = 0; ir < rho.n; ir++) {
+                    c.eps = eps.values[ie];
+                    c.rho = rho.values[ir];
+                    c.n_pts = 0;
+                    c.used = 0;
+                    memset(c.cache, 0, (c.mask + 1) * sizeof(boundary_slot));
+                    for (uint32_t y = 0; y < c.n; y += root)
+                        for (uint32_t x = 0; x < c.n; x += root)
+                            refine(&c, x, y, root);
+                    vertices += print_curve(&c, body->name, materials[im], out);
+                    evals += c.used;
+                    curves++;
+                }
+            }
+        }
+    }
+    status = c.error ? 1 : 0;
+    if (c.error) fprintf(stderr, "Out of memory.\n");
+    if (unbind_out_flush(out) != 0) {
+        fprintf(stderr, "Error writing boundary output.\n");
+        status = 1;
+    }
+    double grid = (double)curves * ((double)c.n + 1.0) * ((double)c.n + 1.0);
+    fprintf(stderr, "BOUND  : %zu curves, %zu vertices on a %u x %u grid, %zu evaluations (%.3g%% of the grid)\n",
+            curves, vertices, c.n, c.n, evals, grid > 0.0 ? 100.0 * (double)evals / grid : 0.0);
+    free(c.cache);
+    free(c.pts);
+
+done:
+    sweep_free_axis(&eps);
+    sweep_free_axis(&rho);
+    free(planets);
+    unbind_registry_free(reg);
+    return status;
+}
@@ -0,0 +1,14 @@
+/* unbind_boundary.h
+* (C) 2025 - George McGinn - MIT License
+* Destruction-boundary mode for unbindEnergy: the curve in the diameter-speed plane
+* that separates impacts which unbind the target from those it survives.
+*/
+
+#ifndef UNBIND_BOUNDARY_H
+#define UNBIND_BOUNDARY_H
+
+// boundary [planets=all] [materials=all] [eps=1.0] [rho=3000] [D=1e-4:1e4] [v=0.01:299792]
+//          [cells=4096] [bodies=<file>]
+int run_boundary(int argc, char** argv);
+
+#endif
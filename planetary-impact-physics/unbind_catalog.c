@@ -0,0 +1,73 @@
+/* unbind_catalog.c
+* (C) 2025 - George McGinn - MIT License
+* Catalog row parsing for the batch and pairs modes (see unbind_catalog.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include "unbind_catalog.h"
+
+void unbind_catalog_default_columns(unbind_catalog_columns* col) {
+    col->name = 0;
+    col->mass = 1;
+    col->diameter = 2;
+    col->speed = 3;
+}
+
+int unbind_catalog_header(char** fields, int n, unbind_catalog_columns* col) {
+    unbind_catalog_columns h = { -1, -1, -1, -1 };
+    int named = 0;
+    double dummy;
+    if (n > 1 && unbind_parse_catalog_number(fields[1], &dummy)) return 0;
+    for (int i = 0; i < n; i++) {
+        if (strncasecmp(fields[i], "name", 4) == 0) h.name = i;
+        else if (strncasecmp(fields[i], "mass", 4) == 0) h.mass = i;
+        else if (strncasecmp(fields[i], "diam", 4) == 0) h.diameter = i;
+        else if (strncasecmp(fields[i], "typical", 7) == 0 || strncasecmp(fields[i], "speed", 5) == 0 ||
+                 strncasecmp(fields[i], "velocity", 8) == 0) h.speed = i;
+        else continue;
+        named = 1;
+    }
+    if (!named) return 0;
+    if (h.mass < 0 && h.diameter < 0) return -1;
+    *col = h;
+    return 1;
+}
+
+// Thousands separators are dropped, a range "lo-hi" yields the geometric mean,
+// and placeholders ("—", "-", "", "n/a") are missing.
+int unbind_parse_catalog_number(const char* field, double* value) {
+    char buf[64];
+    size_t n = 0;
+    for (const char* p = field; *p && n < sizeof(buf)-1; p++) {
+        if (*p == ',' || *p == ' ') continue;
+        buf[n++] = *p;
+    }
+    buf[n] = '\0';
+
+    char* end;
+    double lo = strtod(buf, &end);
+    if (end == buf || lo <= 0.0) return 0;
+    if (*end == '-') {
+        char* end2;
+        double hi = strtod(end+1, &end2);
+        if (end2 == end+1 || hi <= 0.0 || *end2 != '\0') return 0;
+        *value = sqrt(lo * hi);
+        return 1;
+    }
+    if (*end != '\0') return 0;
+    *value = lo;
+    return 1;
+}
+
+int unbind_catalog_row_parse(char** fields, int n, const unbind_catalog_columns* col, unbind_catalog_row* row) {
+    row->m = row->D_km = row->v_km_s = 0.0;
+    row->has_m = col->mass >= 0 && col->mass < n && unbind_parse_catalog_number(fields[col->mass], &row->m);
+    row->has_d = col->diameter >= 0 && col->diameter < n && unbind_parse_catalog_number(fields[col->diameter], &row->D_km);
+    row->has_v = col->speed >= 0 && col->speed < n && unbind_parse_catalog_number(fields[col->speed], &row->v_km_s);
+    row->name = col->name >= 0 && col->name < n ? fields[col->name] : "";
+    return row->has_m || row->has_d || row->has_v;
+}
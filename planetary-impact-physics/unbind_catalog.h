@@ -0,0 +1,36 @@
+/* unbind_catalog.h
+* (C) 2025 - George McGinn - MIT License
+* Catalog rows in the "Space Bodies (unbindEnergy).csv" layout, shared by the batch and
+* pairs modes: "Name","Mass (kg)","Diameter (km)","Typical Speed (km/s)","Notes/Type".
+*
+* Notes:
+*  - Columns are matched by header name when the first line is a header, otherwise
+*    taken positionally (name, mass, diameter, speed). Columns a header leaves out are
+*    absent, and a header must name a mass or a diameter column.
+*  - Thousands separators ("12,742"), ranges ("1e9-1e12", evaluated at the geometric
+*    mean) and placeholders ("—", "-", empty) are accepted.
+*/
+
+#ifndef UNBIND_CATALOG_H
+#define UNBIND_CATALOG_H
+
+typedef struct {
+    int name, mass, diameter, speed;       // field indices, -1 if absent
+} unbind_catalog_columns;
+
+typedef struct {
+    const char* name;                      // points into the split line
+    double m, D_km, v_km_s;
+    int has_m, has_d, has_v;
+} unbind_catalog_row;
+
+void unbind_catalog_default_columns(unbind_catalog_columns* col);
+// Map header names to column indices; returns 1 if the fields were a header, 0 if they were
+// data, -1 for a header with neither a mass nor a diameter column (col is left unchanged)
+int unbind_catalog_header(char** fields, int n, unbind_catalog_columns* col);
+// Returns 1 and sets *value if a positive number was found, 0 otherwise
+int unbind_parse_catalog_number(const char* field, double* value);
+// Returns 1 if the row has a mass, diameter or speed, 0 if it has none
+int unbind_catalog_row_parse(char** fields, int n, const unbind_catalog_columns* col, unbind_catalog_row* row);
+
+#endif
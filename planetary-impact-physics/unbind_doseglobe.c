@@ -0,0 +1,383 @@
+/* unbind_doseglobe.c
+* (C) 2025 - George McGinn - MIT License
+* Surface-observer dose model and the globe mode for unbindDose (see unbind_doseglobe.h).
+* Build: part of unbindDose, see unbindDose.c
+*
+* Usage:
+*   ./unbindDose globe [planet=earth] [lat=-90:90:181] [lon=-180:180:361] [source=0,0] [d=3.844e8]
+*                      [E=2.49e32] [eta=3e-3] [A=0.7] [M=70] [f=1] [atmos_trans=1] [lethal=8]
+*                      [layers=<km:km,...>] [rho0=<kg/m^3>] [radius=<km>] [spectrum options]
+*                      [threads=0]
+*
+* Examples:
+*   ./unbindDose globe planet=mars E=1.23e29 d=5e8 > mars.csv
+*   ./unbindDose globe spectrum=blackbody:2000 lat=-90:90:1801 lon=-180:180:3601 > earth.csv
+*   ./unbindDose globe planet=venus layers=0:15.9,50:5 rho0=65 source=30,-60
+*
+* Notes:
+*  - The source sits at distance d from the planet's centre above the point source=. An
+*    observer on the ground at distance r from it, with the source at zenith angle chi,
+*    gets the unbindDose fluence eta E / (4 pi r^2) through the slant column of the
+*    atmosphere at chi (unbind_slant_column(), libunbind_spectrum.c) plus column= and
+*    medium= r, attenuated group by group. The upper dose is for a body facing the
+*    source, the lower one for level ground (times cos(chi)); they replace theta_deg.
+*    Observers with the source below the horizon get 0.
+*  - Output is one CSV line per observer, latitude rows from lat= lo to hi, longitude
+*    innermost: lat_deg,lon_deg,zenith_deg,column_g_cm2,transmission,dose_upper_gy,
+*    dose_lower_gy. Rows are tasks on the thread pool, formatted into per-row buffers and
+*    written in row order a window at a time, so the output does not depend on the
+*    thread count.
+*  - The stderr summary gives the share of the grid's area (cells weighted by cos(lat))
+*    that sees the source and that gets at least lethal=, summed in row order.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_fmt.h"
+#include "unbind_dosespec.h"
+#include "unbind_doseglobe.h"
+
+#define GLOBE_MAX_POINTS 100000           // per axis; a row buffer is GLOBE_LINE_MAX per point
+#define GLOBE_LINE_MAX 128                // upper bound on one formatted line
+#define GLOBE_WINDOW_PER_THREAD 4         // rows per window, per worker
+#define GLOBE_DEG (UNBIND_PI / 180.0)
+
+void doseglobe_init(doseglobe_model* g) {
+    memset(g, 0, sizeof(*g));
+    g->planet = PLANET_EARTH;
+    g->lethal = UNBIND_LETHAL_DOSE;
+    unbind_dose_defaults(&g->dose);
+    dosespec_init(&g->spec);
+}
+
+int doseglobe_option(const char* arg, doseglobe_model* g) {
+    struct { const char* name; double* value; } params[] = {
+        { "d=", &g->dose.d }, { "E=", &g->dose.E }, { "eta=", &g->dose.eta }, { "A=", &g->dose.A },
+        { "M=", &g->dose.M }, { "f=", &g->dose.f }, { "atmos_trans=", &g->dose.atmos_trans },
+        { "lethal=", &g->lethal }, { "rho0=", &g->rho0 }, { "radius=", &g->radius_km }
+    };
+    int spec = dosespec_option(arg, &g->spec);
+    if (spec != 0) return spec;
+    for (size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++) {
+        size_t len = strlen(params[p].name);
+        if (strncmp(arg, params[p].name, len) == 0) {
+            *params[p].value = atof(arg + len);
+            return 1;
+        }
+    }
+    if (strncmp(arg, "planet=", 7) == 0) {
+        g->planet = unbind_lookup_planet(arg + 7);
+        return g->planet >= 0 ? 1 : -1;
+    }
+    if (strncmp(arg, "layers=", 7) == 0) {
+        g->layers = arg + 7;
+        return 1;
+    }
+    if (strncmp(arg, "source=", 7) == 0) {
+        char tail;
+        return sscanf(arg + 7, "%lf,%lf%c", &g->source_lat, &g->source_lon, &tail) == 2 &&
+               fabs(g->source_lat) <= 90.0 && isfinite(g->source_lon) ? 1 : -1;
+    }
+    return 0;
+}
+
+// "base_km:H_km,..." into metres; the count, or -1
+static int parse_layers(const char* spec, double* base, double* H) {
+    int n = 0;
+    const char* p = spec;
+    while (*p) {
+        char* end;
+        if (n == UNBIND_ATMOSPHERE_LAYERS) return -1;
+        base[n] = strtod(p, &end) * 1000.0;
+        if (end == p || *end != ':') return -1;
+        p = end + 1;
+        H[n] = strtod(p, &end) * 1000.0;
+        if (end == p || (*end != ',' && *end != '\0')) return -1;
+        n++;
+        p = *end ? end + 1 : end;
+    }
+    return n;
+}
+
+int doseglobe_build(doseglobe_model* g) {
+    if (!(g->dose.M > 0.0) || !(g->lethal > 0.0)) {
+        fprintf(stderr, "lethal and M must be positive.\n");
+        return -1;
+    }
+    // The planet's profile, then any of layers=, rho0= and radius= in its place
+    unbind_atmosphere_planet(&g->atm, g->planet);
+    double base[UNBIND_ATMOSPHERE_LAYERS], H[UNBIND_ATMOSPHERE_LAYERS];
+    int n = g->atm.n;
+    memcpy(base, g->atm.base, sizeof(base));
+    memcpy(H, g->atm.H, sizeof(H));
+    if (g->layers && (n = parse_layers(g->layers, base, H)) < 1) {
+        fprintf(stderr, "Bad layers= (base_km:scale_height_km,... from 0 km, at most %d): %s\n",
+                UNBIND_ATMOSPHERE_LAYERS, g->layers);
+        return -1;
+    }
+    double radius = g->radius_km > 0.0 ? g->radius_km * 1000.0 : g->atm.radius;
+    double rho0 = g->rho0 > 0.0 ? g->rho0 * 1e-3 : g->atm.rho[0];
+    if (unbind_atmosphere_init(&g->atm, radius, rho0, n, base, H) != UNBIND_OK) {
+        fprintf(stderr, "Bad atmosphere: layers must start at 0 km and rise, with positive scale heights.\n");
+        return -1;
+    }
+    if (!(g->dose.d > radius)) {
+        fprintf(stderr, "d must be beyond the planet's radius (%.6e m).\n", radius);
+        return -1;
+    }
+    if (dosespec_build(&g->spec, &g->table) != 0) return -1;
+
+    double k_lower;
+    unbind_dose_coefficients(&g->dose, &g->k, &k_lower);
+    double clat = cos(g->source_lat * GLOBE_DEG);
+    g->source[0] = g->dose.d * clat * cos(g->source_lon * GLOBE_DEG);
+    g->source[1] = g->dose.d * clat * sin(g->source_lon * GLOBE_DEG);
+    g->source[2] = g->dose.d * sin(g->source_lat * GLOBE_DEG);
+    return 0;
+}
+
+void doseglobe_free(doseglobe_model* g) {
+    dosespec_free(&g->table);
+}
+
+void doseglobe_row(const doseglobe_model* g, double lat_deg, const double* cos_lon, const double* sin_lon,
+                   size_t n, const doseglobe_cells* out) {
+    double R = g->atm.radius;
+    double rc = R * cos(lat_deg * GLOBE_DEG), z = R * sin(lat_deg * GLOBE_DEG);
+    double* r = out->upper;                        // distances until the doses are known
+    for (size_t i = 0; i < n; i++) {
+        double x = rc * cos_lon[i], y = rc * sin_lon[i];
+        double vx = g->source[0] - x, vy = g->source[1] - y, vz = g->source[2] - z;
+        r[i] = sqrt(vx * vx + vy * vy + vz * vz);
+        out->mu[i] = (x * vx + y * vy + z * vz) / (R * r[i]);
+    }
+    unbind_slant_column(&g->atm, out->mu, out->column, n);
+    for (size_t i = 0; i < n; i++) out->column[i] += g->spec.column + g->spec.medium * 100.0 * r[i];
+    unbind_spectrum_transmission(&g->table.s, out->column, out->trans, n);
+    for (size_t i = 0; i < n; i++) {
+        double dose = g->k * out->trans[i] / (r[i] * r[i]);
+        out->upper[i] = dose;
+        out->lower[i] = out->mu[i] > 0.0 ? dose * out->mu[i] : 0.0;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Mode
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    char* data;
+    size_t len;
+    double lit, lethal_upper, lethal_lower;    // cos(lat)-weighted cells
+    double peak;                               // largest upper dose
+} globe_slot;
+
+typedef struct {
+    const doseglobe_model* model;
+    double lat_lo, lat_step;
+    const double* lon;                        // degrees
+    const double* cos_lon;
+    const double* sin_lon;
+    size_t n_lon;
+    size_t base;                              // first row of this window
+    size_t count;
+    globe_slot* slots;
+    double* scratch;                          // per worker: 5 n_lon
+} globe_window;
+
+static void globe_task(void* ctx, size_t task, int worker) {
+    globe_window* w = ctx;
+    const doseglobe_model* g = w->model;
+    globe_slot* slot = &w->slots[task];
+    size_t n = w->n_lon;
+    double* s = w->scratch + (size_t)worker * 5 * n;
+    doseglobe_cells c = { s, s + n, s + 2 * n, s + 3 * n, s + 4 * n };
+    double lat = w->lat_lo + (double)(w->base + task) * w->lat_step;
+    doseglobe_row(g, lat, w->cos_lon, w->sin_lon, n, &c);
+
+    double weight = cos(lat * GLOBE_DEG);
+    weight = weight > 0.0 ? weight : 0.0;
+    slot->lit = slot->lethal_upper = slot->lethal_lower = slot->peak = 0.0;
+    char* p = slot->data;
+    for (size_t i = 0; i < n; i++) {
+        p = unbind_fmt_g(p, lat, 9);
+        *p++ = ',';
+        p = unbind_fmt_g(p, w->lon[i], 9);
+        *p++ = ',';
+        p = unbind_fmt_f(p, acos(c.mu[i] < 1.0 ? c.mu[i] : 1.0) / GLOBE_DEG, 4);
+        *p++ = ',';
+        p = unbind_fmt_e(p, c.column[i], 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, c.trans[i], 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, c.upper[i], 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, c.lower[i], 6);
+        *p++ = '\n';
+        if (c.mu[i] > 0.0) slot->lit += weight;
+        if (c.upper[i] >= g->lethal) slot->lethal_upper += weight;
+        if (c.lower[i] >= g->lethal) slot->lethal_lower += weight;
+        if (c.upper[i] > slot->peak) slot->peak = c.upper[i];
+    }
+    slot->len = (size_t)(p - slot->data);
+}
+
+// "lo:hi:n" or a single value, within [-limit, limit]
+static int parse_axis(const char* spec, double limit, double* lo, double* hi, int* n) {
+    char tail;
+    if (sscanf(spec, "%lf:%lf:%d%c", lo, hi, n, &tail) == 3)
+        return *n >= 2 && *n <= GLOBE_MAX_POINTS && *hi > *lo && *lo >= -limit && *hi <= limit ? 0 : -1;
+    if (sscanf(spec, "%lf%c", lo, &tail) != 1 || !(fabs(*lo) <= limit)) return -1;
+    *hi = *lo;
+    *n = 1;
+    return 0;
+}
+
+static int doseglobe_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s globe [planet=earth] [lat=-90:90:181] [lon=-180:180:361] [source=0,0] [d=3.844e8]\n"
+        "          [E=2.49e32] [eta=3e-3] [A=0.7] [M=70] [f=1] [atmos_trans=1] [lethal=8]\n"
+        "          [layers=<base_km:H_km,...>] [rho0=<kg/m^3>] [radius=<km>] [threads=0]\n"
+        "          [spectrum=blackbody:<kT_keV>|flat|<file.csv>] [groups=128] [emin=1e-3] [emax=20]\n"
+        "          [absorber=air|water|<file.csv>] [column=0] [medium=0]\n", prog);
+    return 1;
+}
+
+int run_doseglobe(int argc, char** argv) {
+    static doseglobe_model g;
+    double lat_lo = -90.0, lat_hi = 90.0, lon_lo = -180.0, lon_hi = 180.0;
+    int n_lat = 181, n_lon = 361, threads = 0;
+    doseglobe_init(&g);
+    for (int i = 2; i < argc; i++) {
+        int opt = doseglobe_option(argv[i], &g);
+        if (opt > 0) continue;
+        if (opt == 0) {
+            if (strncmp(argv[i], "lat=", 4) == 0) {
+                if (parse_axis(argv[i] + 4, 90.0, &lat_lo, &lat_hi, &n_lat) == 0) continue;
+            } else if (strncmp(argv[i], "lon=", 4) == 0) {
+                if (parse_axis(argv[i] + 4, 360.0, &lon_lo, &lon_hi, &n_lon) == 0) continue;
+            } else if (strncmp(argv[i], "threads=", 8) == 0) {
+                threads = atoi(argv[i] + 8);
+                continue;
+            }
+        }
+        fprintf(stderr, "Bad globe option: %s\n", argv[i]);
+        return doseglobe_usage(argv[0]);
+    }
+    if (doseglobe_build(&g) != 0) {
+        doseglobe_free(&g);
+        return 1;
+    }
+
+    int status = 1;
+    size_t nx = (size_t)n_lon;
+    unbind_pool* pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        doseglobe_free(&g);
+        return 1;
+    }
+    int n_threads = unbind_pool_threads(pool);
+    size_t window_size = (size_t)n_threads * GLOBE_WINDOW_PER_THREAD;
+    double* lon = malloc(3 * nx * sizeof(double));
+    double* scratch = malloc((size_t)n_threads * 5 * nx * sizeof(double));
+    globe_slot* slots = calloc(2 * window_size, sizeof(globe_slot));
+    int ok = lon && scratch && slots;
+    for (size_t i = 0; ok && i < 2 * window_size; i++) ok = (slots[i].data = malloc(nx * GLOBE_LINE_MAX)) != NULL;
+    if (!ok) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    double lon_step = n_lon > 1 ? (lon_hi - lon_lo) / (n_lon - 1) : 0.0;
+    for (size_t i = 0; i < nx; i++) {
+        lon[i] = lon_lo + (double)i * lon_step;
+        lon[nx + i] = cos(lon[i] * GLOBE_DEG);
+        lon[2 * nx + i] = sin(lon[i] * GLOBE_DEG);
+    }
+    globe_window windows[2];
+    for (int k = 0; k < 2; k++) {
+        globe_window* w = &windows[k];
+        w->model = &g;
+        w->lat_lo = lat_lo;
+        w->lat_step = n_lat > 1 ? (lat_hi - lat_lo) / (n_lat - 1) : 0.0;
+        w->lon = lon;
+        w->cos_lon = lon + nx;
+        w->sin_lon = lon + 2 * nx;
+        w->n_lon = nx;
+        w->slots = slots + (size_t)k * window_size;
+        w->scratch = scratch;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    static const char header[] =
+        "lat_deg,lon_deg,zenith_deg,column_g_cm2,transmission,dose_upper_gy,dose_lower_gy\n";
+    unbind_out* out = unbind_stdout();
+    unbind_out_write(out, header, sizeof(header) - 1);
+
+    // Compute window k while window k-1 is written
+    double area = 0.0, lit = 0.0, lethal_upper = 0.0, lethal_lower = 0.0, peak = 0.0;
+    size_t n_windows = ((size_t)n_lat + window_size - 1) / window_size;
+    for (size_t k = 0; k <= n_windows; k++) {
+        if (k < n_windows) {
+            globe_window* w = &windows[k % 2];
+            w->base = k * window_size;
+            w->count = (size_t)n_lat - w->base < window_size ? (size_t)n_lat - w->base : window_size;
+            unbind_pool_submit(pool, w->count, globe_task, w);
+        }
+        if (k > 0) {
+            const globe_window* w = &windows[(k - 1) % 2];
+            for (size_t r = 0; r < w->count; r++) {
+                const globe_slot* s = &w->slots[r];
+                double weight = cos((lat_lo + (double)(w->base + r) * w->lat_step) * GLOBE_DEG);
+                unbind_out_write(out, s->data, s->len);
+                area += (weight > 0.0 ? weight : 0.0) * (double)nx;
+                lit += s->lit;
+                lethal_upper += s->lethal_upper;
+                lethal_lower += s->lethal_lower;
+                if (s->peak > peak) peak = s->peak;
+            }
+        }
+        if (k < n_windows) unbind_pool_wait(pool);
+    }
+    if (unbind_out_flush(out) != 0) {
+        fprintf(stderr, "Error writing globe output.\n");
+        goto done;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+    double cells = (double)n_lat * n_lon;
+    status = 0;
+
+    char described[256];
+    double overhead = 1.0, horizon = 1e-9, X_zenith, X_horizon;
+    unbind_slant_column(&g.atm, &overhead, &X_zenith, 1);
+    unbind_slant_column(&g.atm, &horizon, &X_horizon, 1);
+    dosespec_describe(&g.spec, &g.table, described, sizeof(described));
+    if (area > 0.0) {
+        lit /= area;
+        lethal_upper /= area;
+        lethal_lower /= area;
+    }
+    fprintf(stderr, "GLOBE  : %d x %d observers on %d threads in %.3f s (%.3e observers/s)\n",
+            n_lat, n_lon, n_threads, secs, secs > 0.0 ? cells / secs : 0.0);
+    fprintf(stderr, "GLOBE  : %s, %d layers: %.4e g/cm^2 overhead, %.4e at the horizon; %s\n",
+            g.layers ? "custom" : unbind_planet_name(g.planet), g.atm.n, X_zenith, X_horizon, described);
+    fprintf(stderr, "GLOBE  : source seen from %.2f%% of the area; %g Gy over %.2f%% (facing), %.2f%% (ground); "
+            "peak %.4e Gy\n", 100.0 * lit, g.lethal, 100.0 * lethal_upper, 100.0 * lethal_lower, peak);
+
+done:
+    if (slots)
+        for (size_t i = 0; i < 2 * window_size; i++) free(slots[i].data);
+    free(slots);
+    free(scratch);
+    free(lon);
+    unbind_pool_destroy(pool);
+    doseglobe_free(&g);
+    return status;
+}
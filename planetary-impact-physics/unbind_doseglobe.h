@@ -0,0 +1,62 @@
+/* unbind_doseglobe.h
+* (C) 2025 - George McGinn - MIT License
+* Observers on a planet's surface for unbindDose: the dose at each point of a latitude /
+* longitude grid from a source in a given direction, through the slant-path column of the
+* planet's atmosphere and the multi-group attenuation of unbind_dosespec.h. The globe mode
+* prints it as CSV; the model is shared with other modes that need doses on the ground.
+*
+* Options:
+*   planet=earth                 built-in atmosphere and radius (unbind_atmosphere_planet)
+*   layers=<km:km,...>           layer bases and scale heights in km, in place of the planet's
+*   rho0=<kg/m^3> radius=<km>    density at the ground and planet radius, likewise
+*   source=<lat>,<lon>           the point (degrees) with the source at its zenith (default 0,0)
+*   d=3.844e8                    source distance from the planet's centre (m)
+*   E= eta= A= M= f= atmos_trans= lethal=8    as in the unbindDose model
+*   and the spectral options of unbind_dosespec.h (absorber air by default)
+*/
+
+#ifndef UNBIND_DOSEGLOBE_H
+#define UNBIND_DOSEGLOBE_H
+
+#include <stddef.h>
+#include "libunbind.h"
+#include "unbind_dosespec.h"
+
+typedef struct {
+    int planet;                            // PLANET_*
+    const char* layers;                    // layers= as given, or NULL
+    double rho0, radius_km;                // <= 0: the planet's
+    double source_lat, source_lon;         // degrees
+    double lethal;                         // Gy
+    unbind_dose_input dose;                // theta_deg unused: the ground sets the angle
+    dosespec_options spec;
+    // Set by doseglobe_build()
+    unbind_atmosphere atm;
+    dosespec_table table;
+    double k;                              // dose at 1 m facing the source (Gy m^2)
+    double source[3];                      // source position from the planet's centre (m)
+} doseglobe_model;
+
+// Per observer results of doseglobe_row(), n each
+typedef struct {
+    double* mu;                            // cos of the source's zenith angle
+    double* column;                        // g/cm^2 along the path; Inf below the horizon
+    double* trans;                         // transmitted fraction
+    double* upper;                         // Gy facing the source
+    double* lower;                         // Gy on level ground: upper * cos(zenith)
+} doseglobe_cells;
+
+void doseglobe_init(doseglobe_model* g);
+// 1 if arg is one of the options above (stored in g), 0 if it is not, -1 if it is malformed
+int doseglobe_option(const char* arg, doseglobe_model* g);
+// Atmosphere, groups and dose coefficient; 0, or -1 (printed). Free with doseglobe_free().
+int doseglobe_build(doseglobe_model* g);
+void doseglobe_free(doseglobe_model* g);
+// n observers at latitude lat_deg and longitudes with the given cosines and sines
+void doseglobe_row(const doseglobe_model* g, double lat_deg, const double* cos_lon, const double* sin_lon,
+                   size_t n, const doseglobe_cells* out);
+
+// globe [lat=-90:90:181] [lon=-180:180:361] [threads=0] and the options above
+int run_doseglobe(int argc, char** argv);
+
+#endif
@@ -0,0 +1,574 @@
+/* unbind_dosegrid.c
+* (C) 2025 - George McGinn - MIT License
+* Dose-field mode for unbindDose (see unbind_dosegrid.h).
+* Build: part of unbindDose, see unbindDose.c
+*
+* Usage:
+*   ./unbindDose grid <file> [x=-5e8:5e8:2001] [y=-5e8:5e8:2001] [z=0] [source=0,0,0] [E=2.49e32]
+*                     [eta=3e-3] [A=0.7] [M=70] [f=1] [theta_deg=75] [atmos_trans=1] [lethal=8]
+*                     [preview=<file.pgm|file.ppm>] [layer=0] [threads=0] [spectrum options]
+*
+* Examples:
+*   ./unbindDose grid earth_moon.udg E=5e23 preview=earth_moon.ppm > lethal.csv
+*   ./unbindDose grid inner.udg x=-1e15:1e15:4001 y=-1e15:1e15:4001 z=-1e14:1e14:41 E=2.06e36
+*   ./unbindDose grid big.udg x=-2e13:2e13:10000 y=-2e13:2e13:10000 preview=big.pgm
+*   ./unbindDose grid gas.udg x=-1e12:1e12:2001 y=-1e12:1e12:2001 E=2.06e36 medium=1e-12 groups=256
+*
+* Notes:
+*  - Axes are lo:hi:n, evenly spaced, in metres; a single number is a one-point axis, so the
+*    default is the plane z = 0 around an event at the origin (the Earth-Moon system seen
+*    face on). Every cell gets the unbindDose model at its distance r from source=:
+*    upper = k_upper / r^2 and lower = k_lower / r^2, with the k from
+*    unbind_dose_coefficients() (the doses at 1 m). A cell on the source holds Inf.
+*  - Rows of the raster are computed by unbind_dose_row() (libunbind_simd.c) straight into
+*    the memory-mapped output file, DOSEGRID_TILE_ROWS rows per task on the thread pool.
+*    Cells are independent, so the file does not depend on the thread count.
+*  - The spectral options of unbind_dosespec.h scale both bands by the transmitted fraction
+*    T(column + medium r). Without medium= it is the same for every cell and goes into the
+*    k; with it each row's columns go through unbind_spectrum_transmission() in worker
+*    scratch, groups x cells exponentials, and the lethal distances are not printed.
+*  - The lethal= contour of each band is traced by marching squares over the same tiles
+*    (the row after a tile is computed again into worker scratch rather than read from the
+*    next tile) and printed as line segments, bound,z_m,x1_m,y1_m,x2_m,y2_m: all upper
+*    segments, then all lower, each in grid order. Crossings are interpolated in log dose,
+*    which follows a 1/r^2 fall-off far better than linear interpolation across a coarse
+*    cell; saddle cells are split by the mean of their corners.
+*    When the upper band has no segment the whole grid is on one side of the level, and the
+*    summary says which: the default x=/y= of +/-5e8 m only encloses the contour for E near
+*    5e23 J (the lethal radius grows as sqrt(E), 8.6e12 m at the default 2.49e32 J).
+*  - preview= draws the upper band of z layer layer= as a binary PGM, or a PPM when the
+*    name ends in .ppm (cells at or above the lethal dose in red). It is sampled down to at
+*    most DOSEGRID_PREVIEW_MAX pixels a side, y upwards, grey on a log scale from the
+*    smallest to the largest dose in the image (at most DOSEGRID_PREVIEW_DECADES decades),
+*    with the lethal contour in black (PGM) or yellow (PPM).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_fmt.h"
+#include "unbind_dosegrid.h"
+#include "unbind_dosespec.h"
+
+#define DOSEGRID_TILE_ROWS 16             // grid rows per task
+#define DOSEGRID_MAX_POINTS 1000000       // per axis
+#define DOSEGRID_MAX_CELLS 1e11
+#define DOSEGRID_PREVIEW_MAX 2048         // preview pixels on the longer side
+#define DOSEGRID_PREVIEW_DECADES 12.0     // log grey ramp below the layer's largest dose
+#define DOSEGRID_ROW_MAX 128              // longest contour line
+
+// One contour segment in grid coordinates (metres)
+typedef struct {
+    double z, x1, y1, x2, y2;
+} dosegrid_segment;
+
+typedef struct {
+    dosegrid_segment* seg[DOSEGRID_BANDS];
+    size_t n[DOSEGRID_BANDS], cap[DOSEGRID_BANDS];
+    int failed;                           // out of memory
+} dosegrid_tile;
+
+typedef struct {
+    int n[DOSEGRID_AXES];
+    double lo[DOSEGRID_AXES], step[DOSEGRID_AXES], source[DOSEGRID_AXES];
+    double k[DOSEGRID_BANDS];
+    double lethal;
+    const unbind_spectrum* spectrum;      // per-cell transmission when medium > 0, else NULL
+    double column, medium;
+    float* band[DOSEGRID_BANDS];          // into the mapped file
+    size_t tiles_per_layer;
+    float* scratch;                       // per worker: one row of each band
+    double* path;                         // per worker: one row of columns and transmissions
+    dosegrid_tile* tiles;
+    // preview
+    int layer, step_px, width, height;
+    float* image;
+} dosegrid_job;
+
+static double axis_at(const dosegrid_job* job, int axis, int i) {
+    return job->lo[axis] + (double)i * job->step[axis];
+}
+
+// Both bands of grid row j of layer l, with the worker's path scratch
+static void compute_row(const dosegrid_job* job, int l, int j, float* upper, float* lower, double* path) {
+    double dy = axis_at(job, 1, j) - job->source[1];
+    double dz = axis_at(job, 2, l) - job->source[2];
+    double r2_yz = dy * dy + dz * dz;
+    size_t nx = (size_t)job->n[0];
+    unbind_dose_row(job->k[0], job->k[1], job->lo[0] - job->source[0], job->step[0], r2_yz, upper, lower, nx);
+    if (!job->spectrum) return;
+    double* X = path;
+    double* T = path + nx;
+    for (size_t i = 0; i < nx; i++) {
+        double dx = axis_at(job, 0, (int)i) - job->source[0];
+        X[i] = job->column + job->medium * 100.0 * sqrt(dx * dx + r2_yz);
+    }
+    unbind_spectrum_transmission(job->spectrum, X, T, nx);
+    for (size_t i = 0; i < nx; i++) {
+        upper[i] = (float)(upper[i] * T[i]);
+        lower[i] = (float)(lower[i] * T[i]);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Marching squares
+ * ------------------------------------------------------------------------- */
+
+// Edges of a cell: 0 bottom (row j), 1 right, 2 top (row j+1), 3 left. Corners are numbered
+// bottom-left, bottom-right, top-right, top-left for the case index.
+static const signed char contour_edges[16][4] = {
+    { -1, -1, -1, -1 }, { 3, 0, -1, -1 }, { 0, 1, -1, -1 }, { 3, 1, -1, -1 },
+    { 1, 2, -1, -1 },   { 3, 0, 1, 2 },   { 0, 2, -1, -1 }, { 3, 2, -1, -1 },
+    { 2, 3, -1, -1 },   { 0, 2, -1, -1 }, { 0, 1, 2, 3 },   { 1, 2, -1, -1 },
+    { 3, 1, -1, -1 },   { 0, 1, -1, -1 }, { 3, 0, -1, -1 }, { -1, -1, -1, -1 }
+};
+
+// Where the dose crosses the level between corners a and b, as a fraction of the way
+static double crossing(double a, double b, double log_level) {
+    double la = log(a), lb = log(b);
+    double t = (log_level - la) / (lb - la);
+    return t >= 0.0 && t <= 1.0 ? t : 0.5;
+}
+
+static int push_segment(dosegrid_tile* t, int band, const dosegrid_segment* s) {
+    if (t->n[band] == t->cap[band]) {
+        size_t cap = t->cap[band] ? 2 * t->cap[band] : 256;
+        dosegrid_segment* p = realloc(t->seg[band], cap * sizeof(*p));
+        if (!p) return -1;
+        t->seg[band] = p;
+        t->cap[band] = cap;
+    }
+    t->seg[band][t->n[band]++] = *s;
+    return 0;
+}
+
+// Segments of the level contour in the cells between grid rows j (r0) and j+1 (r1)
+static void contour_row(const dosegrid_job* job, dosegrid_tile* t, int band, int l, int j,
+                        const float* r0, const float* r1) {
+    float level = (float)job->lethal;
+    double log_level = log(job->lethal);
+    double y0 = axis_at(job, 1, j), dy = job->step[1], dx = job->step[0];
+    dosegrid_segment s;
+    s.z = axis_at(job, 2, l);
+    for (int i = 0; i + 1 < job->n[0]; i++) {
+        int code = (r0[i] >= level) | (r0[i+1] >= level) << 1 | (r1[i+1] >= level) << 2 | (r1[i] >= level) << 3;
+        if (code == 0 || code == 15) continue;
+        double c[4] = { r0[i], r0[i+1], r1[i+1], r1[i] };
+        const signed char* e = contour_edges[code];
+        if ((code == 5 || code == 10) && (c[0] + c[1] + c[2] + c[3]) / 4.0 >= job->lethal)
+            e = contour_edges[code == 5 ? 10 : 5];
+        double x0 = axis_at(job, 0, i);
+        for (int k = 0; k < 4 && e[k] >= 0; k += 2) {
+            double px[2], py[2];
+            for (int m = 0; m < 2; m++) {
+                switch (e[k + m]) {
+                    case 0: px[m] = x0 + crossing(c[0], c[1], log_level) * dx; py[m] = y0; break;
+                    case 1: px[m] = x0 + dx; py[m] = y0 + crossing(c[1], c[2], log_level) * dy; break;
+                    case 2: px[m] = x0 + crossing(c[3], c[2], log_level) * dx; py[m] = y0 + dy; break;
+                    default: px[m] = x0; py[m] = y0 + crossing(c[0], c[3], log_level) * dy; break;
+                }
+            }
+            s.x1 = px[0];
+            s.y1 = py[0];
+            s.x2 = px[1];
+            s.y2 = py[1];
+            if (push_segment(t, band, &s) != 0) t->failed = 1;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Tasks
+ * ------------------------------------------------------------------------- */
+
+// DOSEGRID_TILE_ROWS rows of one layer, and their contour cells
+static void dosegrid_task(void* ctx, size_t task, int worker) {
+    const dosegrid_job* job = ctx;
+    dosegrid_tile* t = &job->tiles[task];
+    int l = (int)(task / job->tiles_per_layer);
+    int j0 = (int)(task % job->tiles_per_layer) * DOSEGRID_TILE_ROWS;
+    int j1 = j0 + DOSEGRID_TILE_ROWS < job->n[1] ? j0 + DOSEGRID_TILE_ROWS : job->n[1];
+    size_t nx = (size_t)job->n[0];
+    size_t plane = nx * (size_t)job->n[1];
+    float* band[DOSEGRID_BANDS];
+    for (int b = 0; b < DOSEGRID_BANDS; b++) band[b] = job->band[b] + (size_t)l * plane;
+    double* path = job->path ? job->path + (size_t)worker * 2 * nx : NULL;
+
+    for (int j = j0; j < j1; j++)
+        compute_row(job, l, j, band[0] + (size_t)j * nx, band[1] + (size_t)j * nx, path);
+
+    float* after[DOSEGRID_BANDS];
+    for (int b = 0; b < DOSEGRID_BANDS; b++) after[b] = job->scratch + ((size_t)worker * DOSEGRID_BANDS + b) * nx;
+    if (j1 < job->n[1]) compute_row(job, l, j1, after[0], after[1], path);
+    for (int b = 0; b < DOSEGRID_BANDS; b++)
+        for (int j = j0; j < j1 && j + 1 < job->n[1]; j++)
+            contour_row(job, t, b, l, j, band[b] + (size_t)j * nx,
+                        j + 1 == j1 ? after[b] : band[b] + (size_t)(j + 1) * nx);
+}
+
+// One preview row: the upper band sampled at the middle of each step_px x step_px block
+static void preview_task(void* ctx, size_t task, int worker) {
+    (void)worker;
+    const dosegrid_job* job = ctx;
+    int row = (int)task;
+    int j = (job->height - 1 - row) * job->step_px + job->step_px / 2;     // y upwards
+    if (j >= job->n[1]) j = job->n[1] - 1;
+    const float* src = job->band[0] + ((size_t)job->layer * (size_t)job->n[1] + (size_t)j) * (size_t)job->n[0];
+    float* dst = job->image + (size_t)row * (size_t)job->width;
+    for (int p = 0; p < job->width; p++) {
+        int i = p * job->step_px + job->step_px / 2;
+        dst[p] = src[i < job->n[0] ? i : job->n[0] - 1];
+    }
+}
+
+static int write_preview(const dosegrid_job* job, const char* path) {
+    size_t len = strlen(path);
+    int colour = len >= 4 && strcmp(path + len - 4, ".ppm") == 0;
+    size_t n = (size_t)job->width * (size_t)job->height;
+    float level = (float)job->lethal;
+    float smallest = INFINITY, largest = 0.0f;
+    for (size_t p = 0; p < n; p++) {
+        float v = job->image[p];
+        if (!(v > 0.0f) || isinf(v)) continue;
+        if (v < smallest) smallest = v;
+        if (v > largest) largest = v;
+    }
+    double top = log10(largest), bottom = log10(smallest);
+    if (bottom < top - DOSEGRID_PREVIEW_DECADES) bottom = top - DOSEGRID_PREVIEW_DECADES;
+    if (!(top > bottom)) bottom = top - 1.0;
+
+    unsigned char* pix = malloc(n * (colour ? 3 : 1));
+    FILE* fp = pix ? fopen(path, "wb") : NULL;
+    if (!fp) {
+        free(pix);
+        return -1;
+    }
+    for (int r = 0; r < job->height; r++) {
+        for (int c = 0; c < job->width; c++) {
+            size_t at = (size_t)r * (size_t)job->width + (size_t)c;
+            float v = job->image[at];
+            double g = v > 0.0f ? (log10(v) - bottom) / (top - bottom) : 0.0;
+            unsigned char grey = (unsigned char)(g >= 1.0 ? 255 : g > 0.0 ? 255.0 * g : 0);
+            // On the contour: lethal, with a 4-neighbour that is not
+            int lethal = v >= level, edge = 0;
+            if (lethal)
+                edge = (c > 0 && job->image[at - 1] < level) || (c + 1 < job->width && job->image[at + 1] < level) ||
+                       (r > 0 && job->image[at - job->width] < level) ||
+                       (r + 1 < job->height && job->image[at + job->width] < level);
+            if (!colour) {
+                pix[at] = edge ? 0 : grey;
+            } else {
+                unsigned char* q = pix + 3 * at;
+                q[0] = edge || lethal ? 255 : grey;
+                q[1] = edge ? 255 : lethal ? grey / 2 : grey;
+                q[2] = edge ? 0 : lethal ? grey / 2 : grey;
+            }
+        }
+    }
+    int err = fprintf(fp, "%s\n%d %d\n255\n", colour ? "P6" : "P5", job->width, job->height) < 0;
+    if (fwrite(pix, colour ? 3 : 1, n, fp) != n) err = 1;
+    if (fclose(fp) != 0) err = 1;
+    free(pix);
+    return err ? -1 : 0;
+}
+
+static int write_contours(const dosegrid_job* job, size_t n_tiles, size_t* count) {
+    static const char header[] = "bound,z_m,x1_m,y1_m,x2_m,y2_m\n";
+    static const char* bound_names[DOSEGRID_BANDS] = { "upper", "lower" };
+    unbind_out* out = unbind_stdout();
+    unbind_out_write(out, header, sizeof(header) - 1);
+    for (int b = 0; b < DOSEGRID_BANDS; b++) {
+        count[b] = 0;
+        for (size_t k = 0; k < n_tiles; k++) {
+            const dosegrid_tile* t = &job->tiles[k];
+            for (size_t s = 0; s < t->n[b]; s++) {
+                const dosegrid_segment* g = &t->seg[b][s];
+                char* p = unbind_out_reserve(out, DOSEGRID_ROW_MAX);
+                p = unbind_fmt_str(p, bound_names[b]);
+                *p++ = ',';
+                p = unbind_fmt_e(p, g->z, 9);
+                *p++ = ',';
+                p = unbind_fmt_e(p, g->x1, 9);
+                *p++ = ',';
+                p = unbind_fmt_e(p, g->y1, 9);
+                *p++ = ',';
+                p = unbind_fmt_e(p, g->x2, 9);
+                *p++ = ',';
+                p = unbind_fmt_e(p, g->y2, 9);
+                *p++ = '\n';
+                unbind_out_advance(out, p);
+            }
+            count[b] += t->n[b];
+        }
+    }
+    return unbind_out_flush(out);
+}
+
+/* ---------------------------------------------------------------------------
+ * Mode
+ * ------------------------------------------------------------------------- */
+
+// "lo:hi:n" (n >= 2, lo < hi) or a single value
+static int parse_axis(const char* spec, double* lo, double* hi, int* n) {
+    char tail;
+    if (sscanf(spec, "%lf:%lf:%d%c", lo, hi, n, &tail) == 3)
+        return *hi > *lo && *n >= 2 && *n <= DOSEGRID_MAX_POINTS && isfinite(*lo) && isfinite(*hi) ? 0 : -1;
+    if (sscanf(spec, "%lf%c", lo, &tail) != 1 || !isfinite(*lo)) return -1;
+    *hi = *lo;
+    *n = 1;
+    return 0;
+}
+
+// Size the output file, map it and fill in the header
+static unsigned char* map_output(const char* path, dosegrid_header* h, size_t* size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t band_bytes = (size_t)h->n[0] * h->n[1] * h->n[2] * sizeof(float);
+    h->band_offset[0] = (sizeof(*h) + page - 1) / page * page;
+    h->band_offset[1] = h->band_offset[0] + (band_bytes + page - 1) / page * page;
+    *size = (size_t)h->band_offset[1] + band_bytes;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, (off_t)*size) == 0)
+        map = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    memcpy(map, h, sizeof(*h));
+    return map;
+}
+
+static int dosegrid_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s grid <file> [x=-5e8:5e8:2001] [y=-5e8:5e8:2001] [z=0] [source=0,0,0] [E=2.49e32]\n"
+        "          [eta=3e-3] [A=0.7] [M=70] [f=1] [theta_deg=75] [atmos_trans=1] [lethal=8]\n"
+        "          [preview=<file.pgm|file.ppm>] [layer=0] [threads=0]\n"
+        "          [spectrum=blackbody:<kT_keV>|flat|<file.csv>] [groups=128] [emin=1e-3] [emax=20]\n"
+        "          [absorber=air|water|<file.csv>] [column=0] [medium=0]\n"
+        "  axes: lo:hi:n in metres, or one value; the lethal contour is printed as CSV\n", prog);
+    return 1;
+}
+
+int run_dosegrid(int argc, char** argv) {
+    if (argc < 3 || strchr(argv[2], '=')) return dosegrid_usage(argv[0]);
+    const char* path = argv[2];
+    const char* preview_path = NULL;
+    static const char* axis_opt[DOSEGRID_AXES] = { "x=", "y=", "z=" };
+    double lo[DOSEGRID_AXES] = { -5e8, -5e8, 0.0 }, hi[DOSEGRID_AXES] = { 5e8, 5e8, 0.0 };
+    int n[DOSEGRID_AXES] = { 2001, 2001, 1 };
+    double source[DOSEGRID_AXES] = { 0.0, 0.0, 0.0 };
+    double lethal = UNBIND_LETHAL_DOSE;
+    int layer = 0, threads = 0;
+    unbind_dose_input in;
+    dosespec_options spec;
+    unbind_dose_defaults(&in);
+    dosespec_init(&spec);
+    struct { const char* name; double* value; } params[] = {
+        { "E=", &in.E }, { "eta=", &in.eta }, { "A=", &in.A }, { "M=", &in.M }, { "f=", &in.f },
+        { "theta_deg=", &in.theta_deg }, { "atmos_trans=", &in.atmos_trans }, { "lethal=", &lethal }
+    };
+
+    for (int i = 3; i < argc; i++) {
+        int axis = -1, param = -1;
+        int spectral = dosespec_option(argv[i], &spec);
+        if (spectral > 0) continue;
+        if (spectral < 0) {
+            fprintf(stderr, "Bad grid option: %s\n", argv[i]);
+            return dosegrid_usage(argv[0]);
+        }
+        for (int a = 0; a < DOSEGRID_AXES; a++)
+            if (strncmp(argv[i], axis_opt[a], 2) == 0) axis = a;
+        for (size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++)
+            if (strncmp(argv[i], params[p].name, strlen(params[p].name)) == 0) param = (int)p;
+        if (axis >= 0) {
+            if (parse_axis(argv[i] + 2, &lo[axis], &hi[axis], &n[axis]) == 0) continue;
+        } else if (param >= 0) {
+            *params[param].value = atof(argv[i] + strlen(params[param].name));
+            continue;
+        } else if (strncmp(argv[i], "source=", 7) == 0) {
+            char tail;
+            if (sscanf(argv[i] + 7, "%lf,%lf,%lf%c", &source[0], &source[1], &source[2], &tail) == 3) continue;
+        } else if (strncmp(argv[i], "preview=", 8) == 0) {
+            preview_path = argv[i] + 8;
+            continue;
+        } else if (strncmp(argv[i], "layer=", 6) == 0) {
+            layer = atoi(argv[i] + 6);
+            continue;
+        } else if (strncmp(argv[i], "threads=", 8) == 0) {
+            threads = atoi(argv[i] + 8);
+            continue;
+        }
+        fprintf(stderr, "Bad grid option: %s\n", argv[i]);
+        return dosegrid_usage(argv[0]);
+    }
+    if ((double)n[0] * n[1] * n[2] > DOSEGRID_MAX_CELLS) {
+        fprintf(stderr, "Grid too large (at most %.0e cells).\n", DOSEGRID_MAX_CELLS);
+        return 1;
+    }
+    if (n[0] < 2 || n[1] < 2) {
+        fprintf(stderr, "x and y need at least 2 points each.\n");
+        return 1;
+    }
+    if (!(lethal > 0.0) || !(in.M > 0.0)) {
+        fprintf(stderr, "lethal and M must be positive.\n");
+        return 1;
+    }
+    if (layer < 0 || layer >= n[2]) {
+        fprintf(stderr, "layer must be a z index from 0 to %d.\n", n[2] - 1);
+        return 1;
+    }
+
+    dosespec_table table;
+    memset(&table, 0, sizeof(table));
+    if (spec.given && dosespec_build(&spec, &table) != 0) return 1;
+
+    dosegrid_job job;
+    memset(&job, 0, sizeof(job));
+    dosegrid_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, DOSEGRID_MAGIC, sizeof(h.magic));
+    h.version = DOSEGRID_VERSION;
+    h.endian = DOSEGRID_ENDIAN;
+    h.n_bands = DOSEGRID_BANDS;
+    for (int a = 0; a < DOSEGRID_AXES; a++) {
+        job.n[a] = n[a];
+        job.lo[a] = lo[a];
+        job.step[a] = n[a] > 1 ? (hi[a] - lo[a]) / (double)(n[a] - 1) : 0.0;
+        job.source[a] = source[a];
+        h.n[a] = (uint32_t)n[a];
+        h.lo[a] = lo[a];
+        h.hi[a] = hi[a];
+        h.source[a] = source[a];
+    }
+    unbind_dose_coefficients(&in, &job.k[0], &job.k[1]);
+    if (spec.given && spec.medium > 0.0) {
+        job.spectrum = &table.s;
+    } else if (spec.given) {
+        double T;
+        unbind_spectrum_transmission(&table.s, &spec.column, &T, 1);
+        job.k[0] *= T;
+        job.k[1] *= T;
+    }
+    job.column = spec.column;
+    job.medium = spec.medium;
+    h.column = spec.column;
+    h.medium = spec.medium;
+    job.lethal = lethal;
+    h.k[0] = job.k[0];
+    h.k[1] = job.k[1];
+    h.lethal = lethal;
+    job.layer = layer;
+
+    int status = 1;
+    size_t map_size = 0;
+    unsigned char* map = map_output(path, &h, &map_size);
+    if (!map) {
+        fprintf(stderr, "Cannot write raster file: %s\n", path);
+        dosespec_free(&table);
+        return 1;
+    }
+    for (int b = 0; b < DOSEGRID_BANDS; b++) job.band[b] = (float*)(map + h.band_offset[b]);
+    job.tiles_per_layer = ((size_t)n[1] + DOSEGRID_TILE_ROWS - 1) / DOSEGRID_TILE_ROWS;
+    size_t n_tiles = job.tiles_per_layer * (size_t)n[2];
+
+    unbind_pool* pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        munmap(map, map_size);
+        dosespec_free(&table);
+        return 1;
+    }
+    int n_threads = unbind_pool_threads(pool);
+    job.tiles = calloc(n_tiles, sizeof(dosegrid_tile));
+    job.scratch = malloc((size_t)n_threads * DOSEGRID_BANDS * (size_t)n[0] * sizeof(float));
+    if (job.spectrum) job.path = malloc((size_t)n_threads * 2 * (size_t)n[0] * sizeof(double));
+    if (!job.tiles || !job.scratch || (job.spectrum && !job.path)) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    unbind_pool_run(pool, n_tiles, dosegrid_task, &job);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+    for (size_t k = 0; k < n_tiles; k++) {
+        if (job.tiles[k].failed) {
+            fprintf(stderr, "Out of memory for the contour.\n");
+            goto done;
+        }
+    }
+
+    if (preview_path) {
+        int longest = n[0] > n[1] ? n[0] : n[1];
+        job.step_px = (longest + DOSEGRID_PREVIEW_MAX - 1) / DOSEGRID_PREVIEW_MAX;
+        job.width = (n[0] + job.step_px - 1) / job.step_px;
+        job.height = (n[1] + job.step_px - 1) / job.step_px;
+        job.image = malloc((size_t)job.width * (size_t)job.height * sizeof(float));
+        if (!job.image) {
+            fprintf(stderr, "Out of memory.\n");
+            goto done;
+        }
+        unbind_pool_run(pool, (size_t)job.height, preview_task, &job);
+        if (write_preview(&job, preview_path) != 0) {
+            fprintf(stderr, "Cannot write preview: %s\n", preview_path);
+            goto done;
+        }
+    }
+
+    size_t segments[DOSEGRID_BANDS];
+    if (write_contours(&job, n_tiles, segments) != 0) {
+        fprintf(stderr, "Error writing the contour.\n");
+        goto done;
+    }
+    // Without upper segments the grid lies wholly on one side of the level; find out which
+    size_t cells_total = (size_t)n[0] * (size_t)n[1] * (size_t)n[2], lethal_cells = 0;
+    if (segments[0] == 0)
+        for (size_t i = 0; i < cells_total; i++) lethal_cells += job.band[0][i] >= lethal;
+    if (munmap(map, map_size) != 0) {
+        fprintf(stderr, "Error writing raster file: %s\n", path);
+        map = NULL;
+        goto done;
+    }
+    map = NULL;
+    status = 0;
+
+    double cells = (double)n[0] * n[1] * n[2];
+    fprintf(stderr, "GRID   : %d x %d x %d cells on %d threads in %.3f s (%.3e cells/s), %.1f MB\n",
+            n[0], n[1], n[2], n_threads, secs, secs > 0.0 ? cells / secs : 0.0, (double)map_size / 1e6);
+    if (spec.given) {
+        char described[256];
+        dosespec_describe(&spec, &table, described, sizeof(described));
+        fprintf(stderr, "GRID   : %s; column %g g/cm^2 + medium %g g/cm^3\n", described, spec.column, spec.medium);
+    }
+    if (job.spectrum)
+        fprintf(stderr, "GRID   : %g Gy contour %zu + %zu segments\n", lethal, segments[0], segments[1]);
+    else
+        fprintf(stderr, "GRID   : %g Gy at %.4e m (upper), %.4e m (lower); contour %zu + %zu segments\n",
+                lethal, sqrt(job.k[0] / lethal), sqrt(job.k[1] / lethal), segments[0], segments[1]);
+    if (segments[0] == 0)
+        fprintf(stderr, lethal_cells == 0 ? "GRID   : no cell reaches %g Gy; widen x= and y= to enclose the contour\n"
+                                          : "GRID   : every cell is above %g Gy; the contour lies outside x= and y=\n",
+                lethal);
+
+done:
+    if (map) munmap(map, map_size);
+    if (job.tiles) {
+        for (size_t k = 0; k < n_tiles; k++)
+            for (int b = 0; b < DOSEGRID_BANDS; b++) free(job.tiles[k].seg[b]);
+    }
+    free(job.tiles);
+    free(job.scratch);
+    free(job.path);
+    free(job.image);
+    dosespec_free(&table);
+    unbind_pool_destroy(pool);
+    return status;
+}
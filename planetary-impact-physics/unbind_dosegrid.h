@@ -0,0 +1,49 @@
+/* unbind_dosegrid.h
+* (C) 2025 - George McGinn - MIT License
+* Dose-field mode for unbindDose: the upper and lower bound doses over a 2D or 3D grid of
+* observer positions around the event, written as a float raster, with the lethal-dose
+* contour and an optional PGM/PPM preview.
+*
+* Raster file (native little-endian):
+*   dosegrid_header
+*   upper band at band_offset[0]     n[2] x n[1] x n[0] floats (Gy), x varying fastest, then y and z
+*   lower band at band_offset[1]     the same at theta_deg
+* With spectral options (unbind_dosespec.h) every cell also carries the transmitted fraction
+* T(column + medium r): folded into k when medium is 0, so k / r^2 still holds, else per cell.
+* Both offsets are page aligned, so a band can be mapped directly, e.g. in numpy:
+*   up = np.memmap(path, dtype='<f4', mode='r', offset=h.band_offset[0], shape=(nz, ny, nx))
+*/
+
+#ifndef UNBIND_DOSEGRID_H
+#define UNBIND_DOSEGRID_H
+
+#include <stdint.h>
+
+#define DOSEGRID_MAGIC "UNBDOSE"           // 8 bytes with the NUL
+#define DOSEGRID_VERSION 2
+#define DOSEGRID_ENDIAN 0x01020304u
+#define DOSEGRID_AXES 3                    // x, y, z
+#define DOSEGRID_BANDS 2                   // upper, lower
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;                       // DOSEGRID_ENDIAN as written
+    uint32_t n[DOSEGRID_AXES];             // points per axis
+    uint32_t n_bands;                      // DOSEGRID_BANDS
+    double   lo[DOSEGRID_AXES];            // first and last point of each axis (m)
+    double   hi[DOSEGRID_AXES];
+    double   source[DOSEGRID_AXES];        // where the event is (m)
+    double   k[DOSEGRID_BANDS];            // dose at 1 m (Gy m^2); a cell at distance r holds k / r^2
+    double   lethal;                       // contour level (Gy)
+    uint64_t band_offset[DOSEGRID_BANDS];
+    double   column;                       // g/cm^2 in front of every cell (0 without spectral options)
+    double   medium;                       // g/cm^3 along the path
+} dosegrid_header;
+
+// grid <file> [x=-5e8:5e8:2001] [y=-5e8:5e8:2001] [z=0] [source=0,0,0] [E=2.49e32] [eta=3e-3]
+//      [A=0.7] [M=70] [f=1] [theta_deg=75] [atmos_trans=1] [lethal=8] [preview=<file.pgm|.ppm>]
+//      [layer=0] [threads=0] [spectrum options, see unbind_dosespec.h]
+int run_dosegrid(int argc, char** argv);
+
+#endif
@@ -0,0 +1,567 @@
+/* unbind_dosemc.c
+* (C) 2025 - George McGinn - MIT License
+* Monte Carlo photon transport mode for unbindDose (see unbind_dosemc.h).
+* Build: part of unbindDose, see unbindDose.c
+*
+* Usage:
+*   ./unbindDose transport [slabs=air:1033,water:30] [bins=10] [histories=1e6] [seed=1] [theta_deg=0]
+*                          [d=3.844e8] [E=2.49e32] [eta=3e-3] [atmos_trans=1] [threads=0]
+*                          [spectrum=blackbody:10] [groups=128] [emin=1e-3] [emax=20]
+*
+* Examples:
+*   ./unbindDose transport spectrum=blackbody:2000 histories=1e8
+*   ./unbindDose transport slabs=water:100 bins=50 spectrum=1.25mev.csv E=1e30 d=1e7
+*   ./unbindDose transport slabs=air:300,water:2,air:1 theta_deg=60 spectrum=flat histories=1e9
+*
+* Notes:
+*  - A parallel beam enters the top of the stack at theta_deg. Each history starts one photon
+*    at the energy of a spectrum group drawn by its share of the energy, weighted 1/E so
+*    that every history carries the same energy; tallies are shares of the incident energy,
+*    turned into Gy in each depth bin by the unbindDose fluence eta E atmos_trans / (4 pi d^2)
+*    through the top: dose = fluence cos(theta) share / (bin mass per m^2). A, M and f do
+*    not enter; the dose is that of the bin's own absorber.
+*  - Interactions come from the absorber tables of libunbind_spectrum.c: Compton scattering
+*    is the Klein-Nishina cross section of the absorber's electrons (sampled by Kahn's
+*    method), and the rest of the tabulated total is photoabsorption below 2 m_e c^2 and
+*    pair production above it (photoabsorption is under 0.3% of the total there for air and
+*    water). Coherent scattering is in the tabulated total and so counts as absorption, a
+*    few percent of the total from 20 to 60 keV. Pair production leaves E - 2 m_e c^2 where
+*    it happens and two 511 keV photons back to back. Electrons are absorbed where they are
+*    made (kerma), and so are photons below DOSEMC_E_CUT.
+*  - Each slab is split into bins= depth bins, the detector volumes. Output is one CSV line
+*    per bin: slab,absorber,depth_lo_g_cm2,depth_hi_g_cm2,dose_gy,primary_gy,
+*    scattered_fraction,rel_err. primary_gy is what the source photons leave at their
+*    first interaction; the rest comes from scattered and annihilation photons. rel_err is
+*    the standard error of the dose from the spread between tasks.
+*  - Histories run DOSEMC_TASK to a pool task, each task on its own random stream (its
+*    number under seed=, unbind_rng.h) with its own tallies. A worker keeps DOSEMC_BATCH
+*    photons in flight in SoA arrays allocated before the run, moves each one event at a
+*    time and compacts the survivors, starting new histories in the freed slots. The tasks'
+*    tallies are added in task order, so a run does not depend on the thread count.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include "libunbind.h"
+#include "unbind_rng.h"
+#include "unbind_pool.h"
+#include "unbind_dosespec.h"
+#include "unbind_dosemc.h"
+
+#define DOSEMC_TASK 65536                 // histories per pool task
+#define DOSEMC_BATCH 1024                 // photons in flight per worker
+#define DOSEMC_WINDOW_PER_THREAD 4        // tasks per worker between reductions
+#define DOSEMC_MAX_SLABS 16
+#define DOSEMC_MAX_BINS 4096              // depth bins in all slabs
+#define DOSEMC_MAX_HISTORIES 1e15
+#define DOSEMC_XS_POINTS 512              // cross-section table points, log-spaced
+#define DOSEMC_E_CUT 1e-3                 // MeV: photons below are absorbed
+#define DOSEMC_E_TOP 20.0                 // MeV: top of the tables (held above)
+#define DOSEMC_MC2 0.51099895             // electron rest energy (MeV)
+#define DOSEMC_RE 2.8179403262e-13        // classical electron radius (cm)
+#define DOSEMC_NA 6.02214076e23
+
+// Z/A of the built-in absorbers, for their electrons per gram
+static const double absorber_z_over_a[UNBIND_ABSORBER_COUNT] = { 0.49919, 0.55508 };
+
+typedef struct {
+    double mu[DOSEMC_XS_POINTS];          // total (cm^2/g)
+    double photo[DOSEMC_XS_POINTS];       // share of interactions that absorb
+    double pair[DOSEMC_XS_POINTS];        // share that make a pair
+} dosemc_material;
+
+typedef struct {
+    int material;                         // UNBIND_ABSORBER_*
+    double top, bottom;                   // g/cm^2 below the top of the stack
+    int first_bin, bins;
+    double bins_per_g;
+} dosemc_slab;
+
+typedef struct {
+    int n_slabs, n_bins;
+    dosemc_slab slab[DOSEMC_MAX_SLABS];
+    dosemc_material material[UNBIND_ABSORBER_COUNT];
+    double ln_e_cut, points_per_ln;       // table position of E: (ln E - ln_e_cut) points_per_ln
+    int n_groups;
+    const double* energy;                 // MeV
+    double* cdf;                          // cumulative energy share of the groups
+    double mu0;                           // cos(theta)
+    uint64_t seed, histories;
+} dosemc_plan;
+
+// Photons in flight, DOSEMC_BATCH per worker
+typedef struct {
+    double *E, *z, *w, *wt;               // MeV, g/cm^2, direction cosine down, weight (1/MeV)
+    int* slab;
+    unsigned char* primary;               // not yet interacted
+    unsigned char* partner;               // an annihilation photon waits at pz, pw, pslab
+    double *pz, *pw;
+    int* pslab;
+} dosemc_photons;
+
+typedef struct {
+    double* dep;                          // n_bins total, then n_bins primary (shares of the energy)
+    double reflected, transmitted, uncollided;
+    uint64_t histories, events;
+} dosemc_slot;
+
+typedef struct {
+    const dosemc_plan* plan;
+    size_t base, count;                   // tasks of this window
+    dosemc_slot* slots;
+    dosemc_photons photons;               // all workers'
+} dosemc_window;
+
+/* ---------------------------------------------------------------------------
+ * Physics
+ * ------------------------------------------------------------------------- */
+
+// Klein-Nishina cross section per electron (cm^2), k = E / m_e c^2
+static double klein_nishina(double k) {
+    double l = log1p(2.0 * k);
+    return 2.0 * UNBIND_PI * DOSEMC_RE * DOSEMC_RE *
+           ((1.0 + k) / (k * k) * (2.0 * (1.0 + k) / (1.0 + 2.0 * k) - l / k) + l / (2.0 * k) -
+            (1.0 + 3.0 * k) / ((1.0 + 2.0 * k) * (1.0 + 2.0 * k)));
+}
+
+static void build_material(dosemc_material* m, int absorber, const dosemc_plan* p) {
+    for (int i = 0; i < DOSEMC_XS_POINTS; i++) {
+        double e = exp(p->ln_e_cut + (double)i / p->points_per_ln);
+        double total = unbind_attenuation(absorber, e);
+        double compton = klein_nishina(e / DOSEMC_MC2) * DOSEMC_NA * absorber_z_over_a[absorber];
+        double rest = total > compton ? (total - compton) / total : 0.0;
+        m->mu[i] = total;
+        m->photo[i] = e > 2.0 * DOSEMC_MC2 ? 0.0 : rest;
+        m->pair[i] = e > 2.0 * DOSEMC_MC2 ? rest : 0.0;
+    }
+}
+
+// x = E / E' of a Compton scattering at k = E / m_e c^2 (Kahn's rejection method)
+static inline double compton_ratio(double k, unbind_rng_stream* rng) {
+    for (;;) {
+        double r1 = unbind_rng_next(rng), r2 = unbind_rng_next(rng), r3 = unbind_rng_next(rng);
+        if (r1 <= (1.0 + 2.0 * k) / (9.0 + 2.0 * k)) {
+            double x = 1.0 + 2.0 * k * r2;
+            if (r3 <= 4.0 * (1.0 / x - 1.0 / (x * x))) return x;
+        } else {
+            double x = (1.0 + 2.0 * k) / (1.0 + 2.0 * k * r2);
+            double c = 1.0 - (x - 1.0) / k;
+            if (r3 <= 0.5 * (c * c + 1.0 / x)) return x;
+        }
+    }
+}
+
+// Direction cosine to the normal after turning by angle acos(c) at a uniform azimuth
+static inline double rotate(double w, double c, unbind_rng_stream* rng) {
+    double a, b, r2;
+    do {
+        a = 2.0 * unbind_rng_next(rng) - 1.0;
+        b = 2.0 * unbind_rng_next(rng) - 1.0;
+        r2 = a * a + b * b;
+    } while (r2 > 1.0);
+    double w2 = w * c + sqrt(fmax(0.0, 1.0 - w * w) * fmax(0.0, 1.0 - c * c)) * (a * a - b * b) / r2;
+    return w2 > 1.0 ? 1.0 : (w2 < -1.0 ? -1.0 : w2);
+}
+
+static void start_photon(const dosemc_plan* p, const dosemc_photons* ph, size_t i, unbind_rng_stream* rng) {
+    double u = unbind_rng_next(rng);
+    int lo = 0, hi = p->n_groups - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (p->cdf[mid] < u) lo = mid + 1;
+        else hi = mid;
+    }
+    ph->E[i] = p->energy[lo];
+    ph->wt[i] = 1.0 / p->energy[lo];
+    ph->z[i] = 0.0;
+    ph->w[i] = p->mu0;
+    ph->slab[i] = 0;
+    ph->primary[i] = 1;
+    ph->partner[i] = 0;
+}
+
+// One flight and interaction of photon i; 0 if it is gone (absorbed or out of the stack)
+static int transport_step(const dosemc_plan* p, const dosemc_photons* ph, size_t i, unbind_rng_stream* rng,
+                          dosemc_slot* t) {
+    double E = ph->E[i], z = ph->z[i], w = ph->w[i], wt = ph->wt[i];
+    int s = ph->slab[i];
+    double x = (log(E) - p->ln_e_cut) * p->points_per_ln;
+    int k = x < DOSEMC_XS_POINTS - 2 ? (int)x : DOSEMC_XS_POINTS - 2;
+    double f = fmin(x - k, 1.0);
+
+    // Fly tau mean free paths, slab by slab
+    double tau = -log(unbind_rng_next(rng));
+    for (;;) {
+        const dosemc_slab* sl = &p->slab[s];
+        const dosemc_material* m = &p->material[sl->material];
+        double mu = m->mu[k] + f * (m->mu[k + 1] - m->mu[k]);
+        double edge = w > 0.0 ? sl->bottom : sl->top;
+        double room = w != 0.0 ? (edge - z) / w : INFINITY;
+        if (tau < room * mu) {
+            z += tau / mu * w;
+            break;
+        }
+        tau -= room * mu;
+        z = edge;
+        s += w > 0.0 ? 1 : -1;
+        if (s < 0) {
+            t->reflected += wt * E;
+            return 0;
+        }
+        if (s == p->n_slabs) {
+            t->transmitted += wt * E;
+            if (ph->primary[i]) t->uncollided += wt * E;
+            return 0;
+        }
+    }
+
+    const dosemc_slab* sl = &p->slab[s];
+    const dosemc_material* m = &p->material[sl->material];
+    int bin = (int)((z - sl->top) * sl->bins_per_g);
+    bin = sl->first_bin + (bin < 0 ? 0 : (bin >= sl->bins ? sl->bins - 1 : bin));
+    double photo = m->photo[k] + f * (m->photo[k + 1] - m->photo[k]);
+    double pair = m->pair[k] + f * (m->pair[k + 1] - m->pair[k]);
+    double u = unbind_rng_next(rng), out;
+    if (u < photo || (u < photo + pair && E <= 2.0 * DOSEMC_MC2)) {
+        out = 0.0;
+    } else if (u < photo + pair) {
+        out = DOSEMC_MC2;
+        w = 2.0 * unbind_rng_next(rng) - 1.0;
+        ph->partner[i] = 1;
+        ph->pz[i] = z;
+        ph->pw[i] = -w;
+        ph->pslab[i] = s;
+        E -= DOSEMC_MC2;                 // the partner's share
+    } else {
+        double kk = E / DOSEMC_MC2;
+        double ratio = compton_ratio(kk, rng);
+        out = E / ratio;
+        w = rotate(w, 1.0 - (ratio - 1.0) / kk, rng);
+    }
+    if (out < DOSEMC_E_CUT) out = 0.0;
+    double deposit = wt * (E - out);
+    t->dep[bin] += deposit;
+    if (ph->primary[i]) t->dep[p->n_bins + bin] += deposit;
+    t->events++;
+    if (out == 0.0) return 0;
+    ph->E[i] = out;
+    ph->z[i] = z;
+    ph->w[i] = w;
+    ph->slab[i] = s;
+    ph->primary[i] = 0;
+    return 1;
+}
+
+/* ---------------------------------------------------------------------------
+ * Mode
+ * ------------------------------------------------------------------------- */
+
+static dosemc_photons worker_photons(const dosemc_photons* all, int worker) {
+    size_t o = (size_t)worker * DOSEMC_BATCH;
+    dosemc_photons ph = { all->E + o, all->z + o, all->w + o, all->wt + o, all->slab + o, all->primary + o,
+                          all->partner + o, all->pz + o, all->pw + o, all->pslab + o };
+    return ph;
+}
+
+static void dosemc_task(void* ctx, size_t task, int worker) {
+    dosemc_window* win = ctx;
+    const dosemc_plan* p = win->plan;
+    dosemc_slot* t = &win->slots[task];
+    dosemc_photons ph = worker_photons(&win->photons, worker);
+    uint64_t number = (uint64_t)(win->base + task);
+    uint64_t first = number * DOSEMC_TASK;
+    uint64_t count = p->histories - first < DOSEMC_TASK ? p->histories - first : DOSEMC_TASK;
+    memset(t->dep, 0, 2 * (size_t)p->n_bins * sizeof(double));
+    t->reflected = t->transmitted = t->uncollided = 0.0;
+    t->histories = count;
+    t->events = 0;
+
+    unbind_rng_stream rng;
+    unbind_rng_stream_init(&rng, p->seed, number);
+    size_t n = 0;
+    uint64_t started = 0;
+    while (started < count || n > 0) {
+        for (; n < DOSEMC_BATCH && started < count; n++, started++) start_photon(p, &ph, n, &rng);
+        size_t keep = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (!transport_step(p, &ph, i, &rng, t)) {
+                if (!ph.partner[i]) continue;
+                ph.E[i] = DOSEMC_MC2;
+                ph.z[i] = ph.pz[i];
+                ph.w[i] = ph.pw[i];
+                ph.slab[i] = ph.pslab[i];
+                ph.primary[i] = 0;
+                ph.partner[i] = 0;
+            }
+            if (keep != i) {
+                ph.E[keep] = ph.E[i];
+                ph.z[keep] = ph.z[i];
+                ph.w[keep] = ph.w[i];
+                ph.wt[keep] = ph.wt[i];
+                ph.slab[keep] = ph.slab[i];
+                ph.primary[keep] = ph.primary[i];
+                ph.partner[keep] = ph.partner[i];
+                ph.pz[keep] = ph.pz[i];
+                ph.pw[keep] = ph.pw[i];
+                ph.pslab[keep] = ph.pslab[i];
+            }
+            keep++;
+        }
+        n = keep;
+    }
+}
+
+static int parse_slabs(const char* spec, dosemc_plan* p) {
+    char name[32];
+    double thickness;
+    int used;
+    const char* s = spec;
+    double depth = 0.0;
+    p->n_slabs = 0;
+    while (*s) {
+        if (p->n_slabs == DOSEMC_MAX_SLABS || sscanf(s, "%31[^:]:%lf%n", name, &thickness, &used) != 2) return -1;
+        int absorber = unbind_lookup_absorber(name);
+        if (absorber < 0 || !(thickness > 0.0) || isinf(thickness)) return -1;
+        s += used;
+        if (*s != ',' && *s != '\0') return -1;
+        if (*s) s++;
+        dosemc_slab* sl = &p->slab[p->n_slabs++];
+        sl->material = absorber;
+        sl->top = depth;
+        sl->bottom = depth += thickness;
+    }
+    return p->n_slabs > 0 ? 0 : -1;
+}
+
+static int dosemc_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s transport [slabs=air:1033,water:30] [bins=10] [histories=1e6] [seed=1] [theta_deg=0]\n"
+        "          [d=3.844e8] [E=2.49e32] [eta=3e-3] [atmos_trans=1] [threads=0]\n"
+        "          [spectrum=blackbody:<kT_keV>|flat|<file.csv>] [groups=128] [emin=1e-3] [emax=20]\n"
+        "          (slab absorbers: air, water; thicknesses in g/cm^2)\n", prog);
+    return 1;
+}
+
+int run_dosemc(int argc, char** argv) {
+    static dosemc_plan p;
+    unbind_dose_input in;
+    dosespec_options spec;
+    const char* slabs = "air:1033,water:30";
+    double histories = 1e6;
+    int bins = 10, threads = 0;
+    memset(&p, 0, sizeof(p));
+    p.seed = 1;
+    unbind_dose_defaults(&in);
+    in.theta_deg = 0.0;
+    dosespec_init(&spec);
+    struct { const char* name; double* value; } params[] = {
+        { "d=", &in.d }, { "E=", &in.E }, { "eta=", &in.eta }, { "atmos_trans=", &in.atmos_trans },
+        { "theta_deg=", &in.theta_deg }, { "histories=", &histories }
+    };
+    for (int i = 2; i < argc; i++) {
+        int opt = dosespec_option(argv[i], &spec), param = -1;
+        if (opt > 0 && strncmp(argv[i], "absorber=", 9) != 0 && strncmp(argv[i], "column=", 7) != 0 &&
+            strncmp(argv[i], "medium=", 7) != 0)
+            continue;
+        for (size_t k = 0; opt == 0 && k < sizeof(params) / sizeof(params[0]); k++)
+            if (strncmp(argv[i], params[k].name, strlen(params[k].name)) == 0) param = (int)k;
+        if (param >= 0) {
+            *params[param].value = atof(argv[i] + strlen(params[param].name));
+            continue;
+        } else if (opt == 0 && strncmp(argv[i], "slabs=", 6) == 0) {
+            slabs = argv[i] + 6;
+            continue;
+        } else if (opt == 0 && strncmp(argv[i], "bins=", 5) == 0) {
+            bins = atoi(argv[i] + 5);
+            continue;
+        } else if (opt == 0 && strncmp(argv[i], "seed=", 5) == 0) {
+            p.seed = strtoull(argv[i] + 5, NULL, 0);
+            continue;
+        } else if (opt == 0 && strncmp(argv[i], "threads=", 8) == 0) {
+            threads = atoi(argv[i] + 8);
+            continue;
+        }
+        fprintf(stderr, opt > 0 ? "The transport absorbers are slabs=, not %s\n" : "Bad transport option: %s\n",
+                argv[i]);
+        return dosemc_usage(argv[0]);
+    }
+    if (parse_slabs(slabs, &p) != 0) {
+        fprintf(stderr, "Bad slabs= (absorber:g/cm^2,... with at most %d slabs): %s\n", DOSEMC_MAX_SLABS, slabs);
+        return 1;
+    }
+    if (bins < 1 || (double)bins * p.n_slabs > DOSEMC_MAX_BINS) {
+        fprintf(stderr, "bins must be at least 1, with at most %d bins in all.\n", DOSEMC_MAX_BINS);
+        return 1;
+    }
+    if (!(histories >= 1.0) || histories > DOSEMC_MAX_HISTORIES) {
+        fprintf(stderr, "histories must be from 1 to %.0e.\n", DOSEMC_MAX_HISTORIES);
+        return 1;
+    }
+    if (!(in.theta_deg >= 0.0 && in.theta_deg < 90.0)) {
+        fprintf(stderr, "theta_deg must be from 0 to below 90.\n");
+        return 1;
+    }
+    p.histories = (uint64_t)histories;
+    p.mu0 = cos(in.theta_deg * UNBIND_PI / 180.0);
+    p.n_bins = bins * p.n_slabs;
+    for (int s = 0; s < p.n_slabs; s++) {
+        p.slab[s].first_bin = s * bins;
+        p.slab[s].bins = bins;
+        p.slab[s].bins_per_g = bins / (p.slab[s].bottom - p.slab[s].top);
+    }
+    p.ln_e_cut = log(DOSEMC_E_CUT);
+    p.points_per_ln = (DOSEMC_XS_POINTS - 1) / log(DOSEMC_E_TOP / DOSEMC_E_CUT);
+    for (int a = 0; a < UNBIND_ABSORBER_COUNT; a++) build_material(&p.material[a], a, &p);
+
+    dosespec_table table;
+    memset(&table, 0, sizeof(table));
+    if (dosespec_build(&spec, &table) != 0) return 1;
+
+    int status = 1;
+    unbind_pool* pool = NULL;
+    dosemc_slot* slots = NULL;
+    double *tally = NULL, *doubles = NULL;
+    int* ints = NULL;
+    unsigned char* flags = NULL;
+    p.n_groups = table.n;
+    p.energy = table.energy;
+    p.cdf = malloc((size_t)table.n * sizeof(double));
+    if (!p.cdf) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    double total = 0.0;
+    for (int g = 0; g < table.n; g++) total += table.energy[g] >= DOSEMC_E_CUT ? table.weight[g] : 0.0;
+    if (!(total > 0.0)) {
+        fprintf(stderr, "The spectrum has no energy above %g MeV.\n", DOSEMC_E_CUT);
+        goto done;
+    }
+    double running = 0.0;
+    for (int g = 0; g < table.n; g++) {
+        running += table.energy[g] >= DOSEMC_E_CUT ? table.weight[g] : 0.0;
+        p.cdf[g] = running / total;
+    }
+    p.cdf[table.n - 1] = 1.0;
+
+    pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        goto done;
+    }
+    int n_threads = unbind_pool_threads(pool);
+    size_t window_size = (size_t)n_threads * DOSEMC_WINDOW_PER_THREAD;
+    size_t n_photons = (size_t)n_threads * DOSEMC_BATCH;
+    size_t nb = (size_t)p.n_bins;
+    slots = calloc(window_size, sizeof(dosemc_slot));
+    tally = calloc(window_size * 2 * nb, sizeof(double));
+    doubles = malloc(6 * n_photons * sizeof(double));
+    ints = malloc(2 * n_photons * sizeof(int));
+    flags = malloc(2 * n_photons);
+    if (!slots || !tally || !doubles || !ints || !flags) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    for (size_t k = 0; k < window_size; k++) slots[k].dep = tally + k * 2 * nb;
+    dosemc_window win = {
+        .plan = &p, .slots = slots,
+        .photons = { doubles, doubles + n_photons, doubles + 2 * n_photons, doubles + 3 * n_photons, ints,
+                     flags, flags + n_photons, doubles + 4 * n_photons, doubles + 5 * n_photons, ints + n_photons }
+    };
+
+    // Sums in task order; the batch statistics need the tasks' squares and sizes too
+    double* dep = calloc(4 * nb, sizeof(double));    // total, primary, sum S^2, sum n S
+    if (!dep) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    double reflected = 0.0, transmitted = 0.0, uncollided = 0.0, n2 = 0.0;
+    uint64_t events = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    size_t n_tasks = (size_t)((p.histories + DOSEMC_TASK - 1) / DOSEMC_TASK);
+    for (win.base = 0; win.base < n_tasks; win.base += window_size) {
+        win.count = n_tasks - win.base < window_size ? n_tasks - win.base : window_size;
+        unbind_pool_run(pool, win.count, dosemc_task, &win);
+        for (size_t k = 0; k < win.count; k++) {
+            const dosemc_slot* s = &slots[k];
+            double n = (double)s->histories;
+            for (size_t b = 0; b < nb; b++) {
+                dep[b] += s->dep[b];
+                dep[nb + b] += s->dep[nb + b];
+                dep[2 * nb + b] += s->dep[b] * s->dep[b];
+                dep[3 * nb + b] += n * s->dep[b];
+            }
+            reflected += s->reflected;
+            transmitted += s->transmitted;
+            uncollided += s->uncollided;
+            events += s->events;
+            n2 += n * n;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+
+    double N = (double)p.histories;
+    double fluence = in.eta * in.E * in.atmos_trans / (4.0 * UNBIND_PI * in.d * in.d);
+    printf("slab,absorber,depth_lo_g_cm2,depth_hi_g_cm2,dose_gy,primary_gy,scattered_fraction,rel_err\n");
+    for (int s = 0; s < p.n_slabs; s++) {
+        const dosemc_slab* sl = &p.slab[s];
+        double width = 1.0 / sl->bins_per_g;
+        for (int b = 0; b < sl->bins; b++) {
+            size_t k = (size_t)(sl->first_bin + b);
+            double share = dep[k] / N;
+            // Standard error of the share from the task sums S_i of n_i histories
+            double spread = dep[2 * nb + k] - 2.0 * share * dep[3 * nb + k] + share * share * n2;
+            double rel = share > 0.0 && n_tasks > 1 ?
+                sqrt(fmax(spread, 0.0) * (double)n_tasks / (double)(n_tasks - 1)) / dep[k] : INFINITY;
+            double gy = fluence * p.mu0 / (10.0 * width);    // per unit share
+            printf("%d,%s,%.6g,%.6g,%.6e,%.6e,%.6f,%.4e\n", s, unbind_absorber_name(sl->material),
+                   sl->top + b * width, sl->top + (b + 1) * width, gy * share, gy * dep[nb + k] / N,
+                   dep[k] > 0.0 ? 1.0 - dep[nb + k] / dep[k] : 0.0, rel);
+        }
+    }
+    if (fflush(stdout) != 0) {
+        fprintf(stderr, "Error writing transport output.\n");
+        free(dep);
+        goto done;
+    }
+    status = 0;
+
+    // Narrow-beam transmission of the same groups through the stack, for comparison
+    double narrow = 0.0, absorbed = 0.0;
+    for (int g = 0; g < table.n; g++) {
+        if (table.energy[g] < DOSEMC_E_CUT) continue;
+        double X = 0.0;
+        for (int s = 0; s < p.n_slabs; s++)
+            X += unbind_attenuation(p.slab[s].material, table.energy[g]) * (p.slab[s].bottom - p.slab[s].top);
+        narrow += table.weight[g] / total * exp(-X / p.mu0);
+    }
+    for (size_t b = 0; b < nb; b++) absorbed += dep[b];
+    char described[256];
+    dosespec_describe(&spec, &table, described, sizeof(described));
+    char* absorber_note = strstr(described, "; absorber");
+    if (absorber_note) *absorber_note = '\0';              // the slabs are the absorbers here
+    fprintf(stderr, "TRANSP : %llu histories (%llu interactions) on %d threads in %.3f s (%.3e histories/s)\n",
+            (unsigned long long)p.histories, (unsigned long long)events, n_threads, secs,
+            secs > 0.0 ? N / secs : 0.0);
+    fprintf(stderr, "TRANSP : %s at %g deg; %s\n", slabs, in.theta_deg, described);
+    fprintf(stderr, "TRANSP : energy absorbed %.4f%%, reflected %.4f%%, transmitted %.4f%% (uncollided %.4f%%, "
+            "narrow beam %.4f%%)\n", 100.0 * absorbed / N, 100.0 * reflected / N, 100.0 * transmitted / N,
+            100.0 * uncollided / N, 100.0 * narrow);
+    free(dep);
+
+done:
+    free(flags);
+    free(ints);
+    free(doubles);
+    free(tally);
+    free(slots);
+    free(p.cdf);
+    unbind_pool_destroy(pool);
+    dosespec_free(&table);
+    return status;
+}
@@ -0,0 +1,24 @@
+/* unbind_dosemc.h
+* (C) 2025 - George McGinn - MIT License
+* Monte Carlo photon transport mode for unbindDose: photons of the emitted spectrum followed
+* through a stack of absorber slabs (the atmosphere, shielding, the body) with Compton
+* scattering, photoabsorption and pair production, and the absorbed dose tallied in depth
+* bins, so the scattered and secondary radiation the other modes leave out is counted.
+*
+* Options:
+*   slabs=air:1033,water:30      absorber:thickness (g/cm^2) from the top down; absorbers as
+*                                absorber= of unbind_dosespec.h, the built-in ones only
+*   bins=10                      depth bins (detector volumes) per slab
+*   histories=1e6 seed=1         photon histories and the random stream key
+*   theta_deg=0                  angle of the incoming beam from the slab normal
+*   d= E= eta= atmos_trans=      the unbindDose fluence at the top of the stack
+*   threads=0 and the spectrum options of unbind_dosespec.h (spectrum=, groups=, emin=, emax=)
+*/
+
+#ifndef UNBIND_DOSEMC_H
+#define UNBIND_DOSEMC_H
+
+// transport [options above]
+int run_dosemc(int argc, char** argv);
+
+#endif
@@ -0,0 +1,560 @@
+/* unbind_dosepop.c
+* (C) 2025 - George McGinn - MIT License
+* Population exposure mode for unbindDose (see unbind_dosepop.h).
+* Build: part of unbindDose, see unbindDose.c
+*
+* Usage:
+*   ./unbindDose exposure <raster> [header=<file>] [values=count|density] [levels=1,4,8]
+*                         [histogram=<file.csv>] [bins=1e-2:1e4:10] [threads=0]
+*                         [planet=earth] [source=0,0] [d=3.844e8] [E=2.49e32] ... [spectrum options]
+*
+* Examples:
+*   ./unbindDose exposure gpw_2020_30_sec.flt source=40,-100 spectrum=blackbody:2000
+*   ./unbindDose exposure pop.bil values=density levels=0.5,1,2,4,8 histogram=pop_hist.csv
+*   ./unbindDose exposure landscan.bil header=landscan.hdr E=1e30 d=2e7 threads=8
+*
+* Notes:
+*  - The sidecar header is header=, or else the raster's name with its extension replaced by
+*    .hdr, or with .hdr added. Cells are people per cell (values=count), or per km^2
+*    (values=density, times the cell's area on the model planet's sphere).
+*  - Every populated cell is an observer at its centre with the dose of the globe mode
+*    (unbind_doseglobe.c): its distance from the source, the slant column of the planet's
+*    atmosphere and the spectral options; "upper" faces the source, "lower" is level ground.
+*  - The raster is never read whole. Each task maps one tile of rows, about
+*    DOSEPOP_TILE_BYTES, converts and gathers the populated cells of each row, computes
+*    their doses and unmaps the tile, so memory stays at a few tiles per thread whatever the
+*    raster size. Zero, negative and nodata cells cost only the read.
+*  - Each tile sums its own histogram and level totals in raster order; tiles are reduced in
+*    tile order a window at a time, so the results do not depend on the thread count.
+*  - Output: one CSV line per level, dose_gy,population_upper,population_lower,
+*    fraction_upper,fraction_lower, the population at or above the level and its share of
+*    the raster's total. The default levels are 1 Gy, 4 Gy and lethal=.
+*  - histogram= writes bin,dose_lo_gy,dose_hi_gy,population_upper,population_lower,
+*    above_upper,above_lower for log bins from lo to hi, per_decade to a decade (bins=), with
+*    one bin below lo (holding the zero doses) and one from hi up.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_dosespec.h"
+#include "unbind_doseglobe.h"
+#include "unbind_dosepop.h"
+
+#define DOSEPOP_TILE_BYTES (8u << 20)     // raster bytes per task
+#define DOSEPOP_WINDOW_PER_THREAD 4       // tiles per window, per worker
+#define DOSEPOP_MAX_LEVELS 16
+#define DOSEPOP_MAX_BINS 1024
+#define DOSEPOP_MAX_COLS 10000000
+#define DOSEPOP_MAX_LINE 256
+#define DOSEPOP_DEG (UNBIND_PI / 180.0)
+#define DOSEPOP_EDGE_TOL 1e-6             // degrees past the poles or 360 degrees of longitude
+
+enum { PIXEL_FLOAT, PIXEL_SIGNED, PIXEL_UNSIGNED };
+
+typedef struct {
+    int ncols, nrows;
+    double west, north, dx, dy;           // edges and cell size (degrees)
+    int has_nodata;
+    double nodata;                        // as the pixel type holds it
+    int type, bytes, swap;                // PIXEL_*, bytes per cell, byte order differs from ours
+    uint64_t skip;
+    uint64_t row_bytes;
+    int fd;
+    uint64_t size;
+} pop_raster;
+
+/* ---------------------------------------------------------------------------
+ * Raster
+ * ------------------------------------------------------------------------- */
+
+// header=, else <name without extension>.hdr, else <name>.hdr
+static FILE* open_header(const char* raster, const char* header, char* used, size_t size) {
+    if (header) {
+        snprintf(used, size, "%s", header);
+        return fopen(header, "r");
+    }
+    const char* slash = strrchr(raster, '/');
+    const char* dot = strrchr(raster, '.');
+    if (dot && (!slash || dot > slash + 1)) {
+        snprintf(used, size, "%.*s.hdr", (int)(dot - raster), raster);
+        FILE* fp = fopen(used, "r");
+        if (fp) return fp;
+    }
+    snprintf(used, size, "%s.hdr", raster);
+    return fopen(used, "r");
+}
+
+static int read_header(FILE* fp, const char* path, pop_raster* r) {
+    double xll = NAN, yll = NAN, cell = NAN, xdim = NAN, ydim = NAN, ulx = NAN, uly = NAN;
+    int x_center = 0, y_center = 0, nbits = 0, nbands = 1, msb = 0;
+    char pixeltype[64] = "";
+    char line[DOSEPOP_MAX_LINE], key[64], value[64];
+    r->ncols = r->nrows = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%63s %63s", key, value) != 2) continue;
+        for (char* k = key; *k; k++) *k = (char)(*k >= 'A' && *k <= 'Z' ? *k - 'A' + 'a' : *k);
+        if (strcmp(key, "ncols") == 0) r->ncols = atoi(value);
+        else if (strcmp(key, "nrows") == 0) r->nrows = atoi(value);
+        else if (strcmp(key, "xllcorner") == 0 || strcmp(key, "xllcenter") == 0) {
+            xll = atof(value);
+            x_center = strcmp(key + 3, "center") == 0;
+        } else if (strcmp(key, "yllcorner") == 0 || strcmp(key, "yllcenter") == 0) {
+            yll = atof(value);
+            y_center = strcmp(key + 3, "center") == 0;
+        }
+        else if (strcmp(key, "cellsize") == 0) cell = atof(value);
+        else if (strcmp(key, "xdim") == 0) xdim = atof(value);
+        else if (strcmp(key, "ydim") == 0) ydim = atof(value);
+        else if (strcmp(key, "ulxmap") == 0) ulx = atof(value);
+        else if (strcmp(key, "ulymap") == 0) uly = atof(value);
+        else if (strcmp(key, "nodata_value") == 0 || strcmp(key, "nodata") == 0) {
+            r->nodata = atof(value);
+            r->has_nodata = 1;
+        } else if (strcmp(key, "byteorder") == 0) msb = strcasecmp(value, "msbfirst") == 0 || strcasecmp(value, "m") == 0;
+        else if (strcmp(key, "nbits") == 0) nbits = atoi(value);
+        else if (strcmp(key, "pixeltype") == 0) snprintf(pixeltype, sizeof(pixeltype), "%s", value);
+        else if (strcmp(key, "skipbytes") == 0) r->skip = strtoull(value, NULL, 10);
+        else if (strcmp(key, "nbands") == 0) nbands = atoi(value);
+    }
+    if (r->ncols <= 0 || r->nrows <= 0 || r->ncols > DOSEPOP_MAX_COLS) {
+        fprintf(stderr, "Bad or missing ncols / nrows in %s (ncols at most %d).\n", path, DOSEPOP_MAX_COLS);
+        return -1;
+    }
+    if (nbands != 1) {
+        fprintf(stderr, "Only one-band rasters are supported (%s has %d).\n", path, nbands);
+        return -1;
+    }
+    if (isfinite(xll) && isfinite(yll) && cell > 0.0) {
+        r->dx = r->dy = cell;
+        r->west = x_center ? xll - 0.5 * cell : xll;
+        r->north = (y_center ? yll - 0.5 * cell : yll) + r->nrows * cell;
+    } else if (isfinite(ulx) && isfinite(uly) && xdim > 0.0 && ydim > 0.0) {
+        r->dx = xdim;
+        r->dy = ydim;
+        r->west = ulx - 0.5 * xdim;
+        r->north = uly + 0.5 * ydim;
+    } else {
+        fprintf(stderr, "No grid position in %s (xllcorner, yllcorner and cellsize, or ulxmap, ulymap, "
+                "xdim and ydim).\n", path);
+        return -1;
+    }
+    if (r->north > 90.0 + DOSEPOP_EDGE_TOL || r->north - r->nrows * r->dy < -90.0 - DOSEPOP_EDGE_TOL ||
+        r->ncols * r->dx > 360.0 + DOSEPOP_EDGE_TOL) {
+        fprintf(stderr, "The grid in %s is not within latitude -90 to 90 and 360 degrees of longitude.\n", path);
+        return -1;
+    }
+
+    if (pixeltype[0] == '\0' && nbits == 0) {
+        r->type = PIXEL_FLOAT;
+        nbits = 32;
+    } else if (pixeltype[0] == '\0' || strcasecmp(pixeltype, "unsignedint") == 0) {
+        r->type = PIXEL_UNSIGNED;
+    } else if (strcasecmp(pixeltype, "signedint") == 0) {
+        r->type = PIXEL_SIGNED;
+    } else if (strcasecmp(pixeltype, "float") == 0) {
+        r->type = PIXEL_FLOAT;
+        if (nbits == 0) nbits = 32;
+    } else {
+        fprintf(stderr, "Unknown pixeltype in %s: %s\n", path, pixeltype);
+        return -1;
+    }
+    if (nbits == 0) nbits = 8;
+    if ((nbits != 8 && nbits != 16 && nbits != 32 && nbits != 64) || (r->type == PIXEL_FLOAT && nbits < 32)) {
+        fprintf(stderr, "Unsupported nbits %d for this pixeltype in %s.\n", nbits, path);
+        return -1;
+    }
+    r->bytes = nbits / 8;
+    uint16_t one = 1;
+    r->swap = r->bytes > 1 && msb == (*(unsigned char*)&one == 1);
+    if (r->type == PIXEL_FLOAT && r->bytes == 4) r->nodata = (double)(float)r->nodata;
+    r->row_bytes = (uint64_t)r->ncols * (uint64_t)r->bytes;
+    return 0;
+}
+
+static int open_raster(const char* path, const char* header, pop_raster* r, char* used, size_t size) {
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+    FILE* fp = open_header(path, header, used, size);
+    if (!fp) {
+        fprintf(stderr, "Cannot open raster header: %s\n", used);
+        return -1;
+    }
+    int status = read_header(fp, used, r);
+    fclose(fp);
+    if (status != 0) return -1;
+    r->fd = open(path, O_RDONLY);
+    struct stat st;
+    if (r->fd < 0 || fstat(r->fd, &st) != 0) {
+        fprintf(stderr, "Cannot open raster: %s\n", path);
+        return -1;
+    }
+    r->size = (uint64_t)st.st_size;
+    if (r->size < r->skip || (r->size - r->skip) / r->row_bytes < (uint64_t)r->nrows) {
+        fprintf(stderr, "Raster %s is too small for %d x %d cells of %d bytes (%llu bytes).\n", path,
+                r->nrows, r->ncols, r->bytes, (unsigned long long)r->size);
+        return -1;
+    }
+    return 0;
+}
+
+static inline double cell_value(const unsigned char* p, const pop_raster* r) {
+    unsigned char b[8];
+    memcpy(b, p, (size_t)r->bytes);
+    if (r->swap)
+        for (int i = 0; i < r->bytes / 2; i++) {
+            unsigned char t = b[i];
+            b[i] = b[r->bytes - 1 - i];
+            b[r->bytes - 1 - i] = t;
+        }
+    switch (r->bytes) {
+    case 1:
+        return r->type == PIXEL_SIGNED ? (double)(int8_t)b[0] : (double)b[0];
+    case 2: {
+        uint16_t v;
+        memcpy(&v, b, 2);
+        return r->type == PIXEL_SIGNED ? (double)(int16_t)v : (double)v;
+    }
+    case 4: {
+        if (r->type == PIXEL_FLOAT) {
+            float f;
+            memcpy(&f, b, 4);
+            return (double)f;
+        }
+        uint32_t v;
+        memcpy(&v, b, 4);
+        return r->type == PIXEL_SIGNED ? (double)(int32_t)v : (double)v;
+    }
+    default: {
+        if (r->type == PIXEL_FLOAT) {
+            double d;
+            memcpy(&d, b, 8);
+            return d;
+        }
+        uint64_t v;
+        memcpy(&v, b, 8);
+        return r->type == PIXEL_SIGNED ? (double)(int64_t)v : (double)v;
+    }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Mode
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    double* hist;                             // n_bins upper, then n_bins lower
+    double above[2 * DOSEPOP_MAX_LEVELS];     // upper, then lower
+    double population, lit;
+    double collective[2];                     // person-Gy, upper and lower
+    uint64_t cells;                           // populated cells
+    int failed;                               // the tile could not be mapped
+} pop_slot;
+
+typedef struct {
+    const pop_raster* raster;
+    const doseglobe_model* model;
+    const double* cos_lon;
+    const double* sin_lon;
+    double km2_per_rad;                       // R^2 dlon in km^2, for values=density
+    const double* levels;
+    int n_levels;
+    double bin_lo, per_decade;
+    int n_bins;
+    int rows_per_tile;
+    size_t page;
+    size_t base;                              // first tile of this window
+    size_t count;
+    pop_slot* slots;
+    double* scratch;                          // per worker: 8 ncols
+} pop_window;
+
+// 0 below lo (and for zero doses), then per_decade bins a decade, the last from hi up
+static inline int dose_bin(double dose, double lo, double per_decade, int n_bins) {
+    if (!(dose >= lo)) return 0;
+    double k = log10(dose / lo) * per_decade + 1.0;
+    return k < (double)(n_bins - 1) ? (int)k : n_bins - 1;
+}
+
+static void pop_task(void* ctx, size_t task, int worker) {
+    pop_window* w = ctx;
+    const pop_raster* r = w->raster;
+    const doseglobe_model* g = w->model;
+    pop_slot* slot = &w->slots[task];
+    memset(slot->hist, 0, 2 * (size_t)w->n_bins * sizeof(double));
+    memset(slot->above, 0, sizeof(slot->above));
+    slot->population = slot->lit = slot->collective[0] = slot->collective[1] = 0.0;
+    slot->cells = 0;
+    slot->failed = 0;
+
+    int row0 = (int)((w->base + task) * (size_t)w->rows_per_tile);
+    int rows = r->nrows - row0 < w->rows_per_tile ? r->nrows - row0 : w->rows_per_tile;
+    uint64_t start = r->skip + (uint64_t)row0 * r->row_bytes;
+    uint64_t offset = start - start % w->page;
+    size_t length = (size_t)(start - offset + (uint64_t)rows * r->row_bytes);
+    void* map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, r->fd, (off_t)offset);
+    if (map == MAP_FAILED) {
+        slot->failed = 1;
+        return;
+    }
+    posix_madvise(map, length, POSIX_MADV_SEQUENTIAL);
+    const unsigned char* tile = (const unsigned char*)map + (start - offset);
+
+    size_t nx = (size_t)r->ncols;
+    double* s = w->scratch + (size_t)worker * 8 * nx;
+    double* pop = s;
+    double* cos_lon = s + nx;
+    double* sin_lon = s + 2 * nx;
+    doseglobe_cells c = { s + 3 * nx, s + 4 * nx, s + 5 * nx, s + 6 * nx, s + 7 * nx };
+    double* hist_upper = slot->hist;
+    double* hist_lower = slot->hist + w->n_bins;
+    for (int row = 0; row < rows; row++) {
+        double north = r->north - (double)(row0 + row) * r->dy;
+        double scale = w->km2_per_rad > 0.0 ?
+            w->km2_per_rad * (sin(north * DOSEPOP_DEG) - sin((north - r->dy) * DOSEPOP_DEG)) : 1.0;
+        const unsigned char* p = tile + (size_t)row * r->row_bytes;
+        size_t n = 0;
+        for (size_t i = 0; i < nx; i++, p += r->bytes) {
+            double v = cell_value(p, r);
+            if (!(v > 0.0) || (r->has_nodata && v == r->nodata)) continue;
+            pop[n] = v * scale;
+            cos_lon[n] = w->cos_lon[i];
+            sin_lon[n] = w->sin_lon[i];
+            n++;
+        }
+        if (n == 0) continue;
+        doseglobe_row(g, north - 0.5 * r->dy, cos_lon, sin_lon, n, &c);
+        slot->cells += n;
+        for (size_t i = 0; i < n; i++) {
+            double people = pop[i], upper = c.upper[i], lower = c.lower[i];
+            slot->population += people;
+            if (c.mu[i] > 0.0) slot->lit += people;
+            slot->collective[0] += people * upper;
+            slot->collective[1] += people * lower;
+            hist_upper[dose_bin(upper, w->bin_lo, w->per_decade, w->n_bins)] += people;
+            hist_lower[dose_bin(lower, w->bin_lo, w->per_decade, w->n_bins)] += people;
+            for (int l = 0; l < w->n_levels; l++) {
+                if (upper >= w->levels[l]) slot->above[l] += people;
+                if (lower >= w->levels[l]) slot->above[DOSEPOP_MAX_LEVELS + l] += people;
+            }
+        }
+    }
+    munmap(map, length);
+}
+
+static int parse_levels(const char* spec, double* levels) {
+    int n = 0;
+    const char* p = spec;
+    while (*p) {
+        char* end;
+        if (n == DOSEPOP_MAX_LEVELS) return -1;
+        levels[n] = strtod(p, &end);
+        if (end == p || !(levels[n] > 0.0) || isinf(levels[n]) || (*end != ',' && *end != '\0')) return -1;
+        n++;
+        p = *end ? end + 1 : end;
+    }
+    return n;
+}
+
+static int write_histogram(const char* path, const double* hist, int n_bins, double lo, double per_decade) {
+    static double above[2 * DOSEPOP_MAX_BINS];
+    double sum[2] = { 0.0, 0.0 };
+    for (int b = n_bins - 1; b >= 0; b--) {
+        above[b] = sum[0] += hist[b];
+        above[n_bins + b] = sum[1] += hist[n_bins + b];
+    }
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    int err = fprintf(fp, "bin,dose_lo_gy,dose_hi_gy,population_upper,population_lower,above_upper,above_lower\n") < 0;
+    for (int b = 0; b < n_bins && !err; b++) {
+        double d_lo = b == 0 ? 0.0 : lo * pow(10.0, (double)(b - 1) / per_decade);
+        double d_hi = b == n_bins - 1 ? INFINITY : lo * pow(10.0, (double)b / per_decade);
+        err = fprintf(fp, "%d,%.6e,%.6e,%.9e,%.9e,%.9e,%.9e\n", b, d_lo, d_hi, hist[b], hist[n_bins + b],
+                      above[b], above[n_bins + b]) < 0;
+    }
+    if (fclose(fp) != 0) err = 1;
+    return err ? -1 : 0;
+}
+
+static int dosepop_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s exposure <raster> [header=<file>] [values=count|density] [levels=1,4,8]\n"
+        "          [histogram=<file.csv>] [bins=1e-2:1e4:10] [threads=0]\n"
+        "          [planet=earth] [source=0,0] [d=3.844e8] [E=2.49e32] [eta=3e-3] [A=0.7] [M=70] [f=1]\n"
+        "          [atmos_trans=1] [lethal=8] [layers=<base_km:H_km,...>] [rho0=<kg/m^3>] [radius=<km>]\n"
+        "          [spectrum=blackbody:<kT_keV>|flat|<file.csv>] [groups=128] [emin=1e-3] [emax=20]\n"
+        "          [absorber=air|water|<file.csv>] [column=0] [medium=0]\n", prog);
+    return 1;
+}
+
+int run_dosepop(int argc, char** argv) {
+    static doseglobe_model g;
+    const char *header = NULL, *hist_path = NULL, *levels_spec = NULL;
+    double levels[DOSEPOP_MAX_LEVELS], bin_lo = 1e-2, bin_hi = 1e4, per_decade = 10.0;
+    int density = 0, threads = 0;
+    if (argc < 3 || strchr(argv[2], '=')) return dosepop_usage(argv[0]);
+    doseglobe_init(&g);
+    for (int i = 3; i < argc; i++) {
+        int opt = doseglobe_option(argv[i], &g);
+        if (opt > 0) continue;
+        if (opt == 0) {
+            if (strncmp(argv[i], "header=", 7) == 0) {
+                header = argv[i] + 7;
+                continue;
+            } else if (strcmp(argv[i], "values=count") == 0 || strcmp(argv[i], "values=density") == 0) {
+                density = argv[i][7] == 'd';
+                continue;
+            } else if (strncmp(argv[i], "levels=", 7) == 0) {
+                levels_spec = argv[i] + 7;
+                if (parse_levels(levels_spec, levels) > 0) continue;
+            } else if (strncmp(argv[i], "histogram=", 10) == 0) {
+                hist_path = argv[i] + 10;
+                continue;
+            } else if (strncmp(argv[i], "bins=", 5) == 0) {
+                char tail;
+                if (sscanf(argv[i] + 5, "%lf:%lf:%lf%c", &bin_lo, &bin_hi, &per_decade, &tail) == 3 &&
+                    bin_lo > 0.0 && bin_hi > bin_lo && per_decade >= 1.0 &&
+                    log10(bin_hi / bin_lo) * per_decade + 2.0 <= DOSEPOP_MAX_BINS)
+                    continue;
+            } else if (strncmp(argv[i], "threads=", 8) == 0) {
+                threads = atoi(argv[i] + 8);
+                continue;
+            }
+        }
+        fprintf(stderr, "Bad exposure option: %s\n", argv[i]);
+        return dosepop_usage(argv[0]);
+    }
+    int n_levels = 3;
+    if (levels_spec) {
+        n_levels = parse_levels(levels_spec, levels);
+    } else {
+        levels[0] = 1.0;
+        levels[1] = 4.0;
+        levels[2] = g.lethal;
+    }
+
+    pop_raster r;
+    char header_used[1024];
+    if (open_raster(argv[2], header, &r, header_used, sizeof(header_used)) != 0) {
+        if (r.fd >= 0) close(r.fd);
+        return 1;
+    }
+    if (doseglobe_build(&g) != 0) {
+        doseglobe_free(&g);
+        close(r.fd);
+        return 1;
+    }
+
+    int status = 1;
+    unbind_pool* pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        doseglobe_free(&g);
+        close(r.fd);
+        return 1;
+    }
+    int n_threads = unbind_pool_threads(pool);
+    size_t window_size = (size_t)n_threads * DOSEPOP_WINDOW_PER_THREAD;
+    size_t nx = (size_t)r.ncols;
+    int n_bins = (int)ceil(log10(bin_hi / bin_lo) * per_decade - 1e-9) + 2;
+    double* lon = malloc(2 * nx * sizeof(double));
+    double* scratch = malloc((size_t)n_threads * 8 * nx * sizeof(double));
+    double* hist = calloc((window_size + 1) * 2 * (size_t)n_bins, sizeof(double));
+    pop_slot* slots = calloc(window_size, sizeof(pop_slot));
+    if (!lon || !scratch || !hist || !slots) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    for (size_t i = 0; i < nx; i++) {
+        double deg = r.west + ((double)i + 0.5) * r.dx;
+        lon[i] = cos(deg * DOSEPOP_DEG);
+        lon[nx + i] = sin(deg * DOSEPOP_DEG);
+    }
+    for (size_t k = 0; k < window_size; k++) slots[k].hist = hist + (k + 1) * 2 * (size_t)n_bins;
+    double R_km = g.atm.radius * 1e-3;
+    pop_window w = {
+        .raster = &r, .model = &g, .cos_lon = lon, .sin_lon = lon + nx,
+        .km2_per_rad = density ? R_km * R_km * r.dx * DOSEPOP_DEG : 0.0,
+        .levels = levels, .n_levels = n_levels, .bin_lo = bin_lo, .per_decade = per_decade, .n_bins = n_bins,
+        .rows_per_tile = r.row_bytes >= DOSEPOP_TILE_BYTES ? 1 : (int)(DOSEPOP_TILE_BYTES / r.row_bytes),
+        .page = (size_t)sysconf(_SC_PAGESIZE), .slots = slots, .scratch = scratch
+    };
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    // Totals in tile order: hist (the first 2 n_bins) and the rest below
+    double above[2 * DOSEPOP_MAX_LEVELS] = { 0 };
+    double population = 0.0, lit = 0.0, collective[2] = { 0.0, 0.0 };
+    uint64_t cells = 0;
+    size_t n_tiles = ((size_t)r.nrows + (size_t)w.rows_per_tile - 1) / (size_t)w.rows_per_tile;
+    for (w.base = 0; w.base < n_tiles; w.base += window_size) {
+        w.count = n_tiles - w.base < window_size ? n_tiles - w.base : window_size;
+        unbind_pool_run(pool, w.count, pop_task, &w);
+        for (size_t t = 0; t < w.count; t++) {
+            const pop_slot* s = &slots[t];
+            if (s->failed) {
+                fprintf(stderr, "Cannot map rows %zu.. of raster %s\n", (w.base + t) * (size_t)w.rows_per_tile,
+                        argv[2]);
+                goto done;
+            }
+            for (int b = 0; b < 2 * n_bins; b++) hist[b] += s->hist[b];
+            for (int l = 0; l < DOSEPOP_MAX_LEVELS; l++) {
+                above[l] += s->above[l];
+                above[DOSEPOP_MAX_LEVELS + l] += s->above[DOSEPOP_MAX_LEVELS + l];
+            }
+            population += s->population;
+            lit += s->lit;
+            collective[0] += s->collective[0];
+            collective[1] += s->collective[1];
+            cells += s->cells;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+    double mb = (double)r.nrows * (double)r.row_bytes / 1048576.0;
+
+    printf("dose_gy,population_upper,population_lower,fraction_upper,fraction_lower\n");
+    for (int l = 0; l < n_levels; l++) {
+        double up = above[l], low = above[DOSEPOP_MAX_LEVELS + l];
+        printf("%g,%.9e,%.9e,%.6e,%.6e\n", levels[l], up, low, population > 0.0 ? up / population : 0.0,
+               population > 0.0 ? low / population : 0.0);
+    }
+    if (fflush(stdout) != 0) {
+        fprintf(stderr, "Error writing exposure output.\n");
+        goto done;
+    }
+    if (hist_path && write_histogram(hist_path, hist, n_bins, bin_lo, per_decade) != 0) {
+        fprintf(stderr, "Cannot write histogram file: %s\n", hist_path);
+        goto done;
+    }
+    status = 0;
+
+    char described[256];
+    dosespec_describe(&g.spec, &g.table, described, sizeof(described));
+    fprintf(stderr, "EXPOSE : %d x %d cells (%s) read in %zu tiles on %d threads in %.3f s (%.1f MB/s)\n",
+            r.nrows, r.ncols, header_used, n_tiles, n_threads, secs, secs > 0.0 ? mb / secs : 0.0);
+    fprintf(stderr, "EXPOSE : %s; %s\n", g.layers ? "custom atmosphere" : unbind_planet_name(g.planet), described);
+    fprintf(stderr, "EXPOSE : %.6e people in %llu cells, %.2f%% seeing the source; collective dose %.4e "
+            "(facing), %.4e (ground) person-Gy\n", population, (unsigned long long)cells,
+            population > 0.0 ? 100.0 * lit / population : 0.0, collective[0], collective[1]);
+
+done:
+    free(slots);
+    free(hist);
+    free(scratch);
+    free(lon);
+    unbind_pool_destroy(pool);
+    doseglobe_free(&g);
+    close(r.fd);
+    return status;
+}
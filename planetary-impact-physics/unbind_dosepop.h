@@ -0,0 +1,27 @@
+/* unbind_dosepop.h
+* (C) 2025 - George McGinn - MIT License
+* Exposure mode for unbindDose: the population receiving each dose level, from a population
+* raster on a latitude / longitude grid and the surface model of unbind_doseglobe.h.
+*
+* Raster: one band of raw cells, north row first, west to east, with a sidecar header of
+* "key value" lines as written by ESRI for .flt and .bil grids (keys in any case):
+*   ncols, nrows                      required
+*   xllcorner, yllcorner, cellsize    lower-left corner and cell size (degrees), or xllcenter and
+*                                     yllcenter, or ulxmap, ulymap (centre of the first cell),
+*                                     xdim and ydim
+*   nodata_value (or nodata)          cells holding it are skipped, as are negative and NaN cells
+*   byteorder                         lsbfirst or I (default), msbfirst or M
+*   nbits, pixeltype                  8, 16, 32 or 64 and signedint, unsignedint or float; the
+*                                     default is a 32-bit float, or unsigned with only nbits
+*   skipbytes                         bytes before the first cell (default 0)
+*   nbands                            1 if given
+*/
+
+#ifndef UNBIND_DOSEPOP_H
+#define UNBIND_DOSEPOP_H
+
+// exposure <raster> [header=<file>] [values=count|density] [levels=1,4,8]
+//          [histogram=<file.csv>] [bins=1e-2:1e4:10] [threads=0] and the unbind_doseglobe.h options
+int run_dosepop(int argc, char** argv);
+
+#endif
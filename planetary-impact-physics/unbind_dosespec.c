@@ -0,0 +1,294 @@
+/* unbind_dosespec.c
+* (C) 2025 - George McGinn - MIT License
+* Spectral options and the spectrum mode for unbindDose (see unbind_dosespec.h).
+* Build: part of unbindDose, see unbindDose.c
+*
+* Usage:
+*   ./unbindDose spectrum [d=3.844e8] [E=2.49e32] [eta=3e-3] [A=0.7] [M=70] [f=1] [theta_deg=75]
+*                         [atmos_trans=1] [spectrum=blackbody:10] [groups=128] [emin=1e-3] [emax=20]
+*                         [absorber=air] [column=0] [medium=0] [table=<file.csv>]
+*
+* Examples:
+*   ./unbindDose spectrum column=1033                      (sea-level air column)
+*   ./unbindDose spectrum spectrum=blackbody:300 absorber=water column=10 table=groups.csv
+*   ./unbindDose spectrum spectrum=measured.csv absorber=regolith.csv d=1e9 medium=1e-9
+*
+* Notes:
+*  - The report is the unbindDose one with the fluence scaled by the transmitted fraction
+*    T(X) of the column X = column + medium * d (d in cm), on top of atmos_trans. With no
+*    absorber in the way (the defaults) T = 1 and the doses are the classic ones.
+*  - table= writes one CSV line per group: group,energy_mev,weight,mu_cm2_g,transmission,
+*    the last being the group's own exp(-mu X).
+*  - Spectrum and absorber files are CSV with two numbers per line; lines that are blank,
+*    start with '#' or do not parse (a header) are skipped. Absorber coefficients are
+*    interpolated log-log at the group energies and held at the end values outside the file.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "libunbind.h"
+#include "unbind_fmt.h"
+#include "unbind_dosespec.h"
+
+#define DOSESPEC_MAX_LINE 256
+
+void dosespec_init(dosespec_options* o) {
+    memset(o, 0, sizeof(*o));
+    o->spectrum = "blackbody:10";
+    o->absorber = "air";
+    o->groups = 128;
+    o->e_min = 1e-3;
+    o->e_max = 20.0;
+}
+
+int dosespec_option(const char* arg, dosespec_options* o) {
+    if (strncmp(arg, "spectrum=", 9) == 0) {
+        o->spectrum = arg + 9;
+        if (!*o->spectrum) return -1;
+    } else if (strncmp(arg, "absorber=", 9) == 0) {
+        o->absorber = arg + 9;
+        if (!*o->absorber) return -1;
+    } else if (strncmp(arg, "groups=", 7) == 0) {
+        o->groups = atoi(arg + 7);
+        if (o->groups < 1 || o->groups > DOSESPEC_MAX_GROUPS) return -1;
+    } else if (strncmp(arg, "emin=", 5) == 0) {
+        o->e_min = strtod(arg + 5, NULL);
+        if (!(o->e_min > 0.0)) return -1;
+    } else if (strncmp(arg, "emax=", 5) == 0) {
+        o->e_max = strtod(arg + 5, NULL);
+        if (!(o->e_max > 0.0)) return -1;
+    } else if (strncmp(arg, "column=", 7) == 0) {
+        o->column = strtod(arg + 7, NULL);
+        if (!(o->column >= 0.0) || isinf(o->column)) return -1;
+    } else if (strncmp(arg, "medium=", 7) == 0) {
+        o->medium = strtod(arg + 7, NULL);
+        if (!(o->medium >= 0.0) || isinf(o->medium)) return -1;
+    } else {
+        return 0;
+    }
+    o->given = 1;
+    return 1;
+}
+
+// Up to max pairs of numbers from a CSV file; the count, or -1 (printed)
+static int load_pairs(const char* path, const char* what, int max, double* a, double* b) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Cannot open %s file: %s\n", what, path);
+        return -1;
+    }
+    char line[DOSESPEC_MAX_LINE];
+    int n = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        double x, y;
+        if (line[0] == '#' || sscanf(line, "%lf ,%lf", &x, &y) != 2) continue;
+        if (n == max) {
+            fprintf(stderr, "Too many lines in %s file %s (at most %d).\n", what, path, max);
+            n = -1;
+            break;
+        }
+        a[n] = x;
+        b[n] = y;
+        n++;
+    }
+    if (n >= 0 && ferror(fp)) {
+        fprintf(stderr, "Error reading %s file: %s\n", what, path);
+        n = -1;
+    }
+    fclose(fp);
+    if (n == 0) fprintf(stderr, "No %s lines in %s.\n", what, path);
+    return n > 0 ? n : -1;
+}
+
+static int build_groups(const dosespec_options* o, dosespec_table* t) {
+    if (strncmp(o->spectrum, "blackbody:", 10) == 0 || strcmp(o->spectrum, "flat") == 0) {
+        double kT = 0.0;
+        if (o->spectrum[0] == 'b') {
+            char tail;
+            if (sscanf(o->spectrum + 10, "%lf%c", &kT, &tail) != 1 || !(kT > 0.0)) {
+                fprintf(stderr, "Bad blackbody temperature: %s\n", o->spectrum);
+                return -1;
+            }
+        }
+        if (!(o->e_max > o->e_min)) {
+            fprintf(stderr, "emax must be above emin.\n");
+            return -1;
+        }
+        t->n = o->groups;
+        if (unbind_spectrum_groups(t->n, o->e_min, o->e_max, kT * 1e-3, t->energy, t->weight) != UNBIND_OK) {
+            fprintf(stderr, "No emission between emin and emax for %s.\n", o->spectrum);
+            return -1;
+        }
+        return 0;
+    }
+    t->n = load_pairs(o->spectrum, "spectrum", DOSESPEC_MAX_GROUPS, t->energy, t->weight);
+    if (t->n < 0) return -1;
+    double total = 0.0;
+    for (int g = 0; g < t->n; g++) {
+        if (!(t->energy[g] > 0.0) || !(t->weight[g] >= 0.0) || isinf(t->weight[g])) {
+            fprintf(stderr, "Bad group %d in %s: energies must be positive, weights not negative.\n", g + 1,
+                    o->spectrum);
+            return -1;
+        }
+        total += t->weight[g];
+    }
+    if (!(total > 0.0)) {
+        fprintf(stderr, "Spectrum %s has no weight.\n", o->spectrum);
+        return -1;
+    }
+    for (int g = 0; g < t->n; g++) t->weight[g] /= total;
+    return 0;
+}
+
+static int build_coefficients(const dosespec_options* o, dosespec_table* t) {
+    int absorber = unbind_lookup_absorber(o->absorber);
+    if (absorber >= 0) {
+        for (int g = 0; g < t->n; g++) t->mu[g] = unbind_attenuation(absorber, t->energy[g]);
+        return 0;
+    }
+    double* e = malloc(2 * DOSESPEC_MAX_TABLE * sizeof(double));
+    if (!e) {
+        fprintf(stderr, "Out of memory.\n");
+        return -1;
+    }
+    double* mu = e + DOSESPEC_MAX_TABLE;
+    int n = load_pairs(o->absorber, "absorber", DOSESPEC_MAX_TABLE, e, mu);
+    int status = n > 0 ? 0 : -1;
+    for (int k = 0; status == 0 && k < n; k++) {
+        if (!(mu[k] > 0.0) || !(e[k] > (k ? e[k-1] : 0.0))) {
+            fprintf(stderr, "Bad line %d in %s: energies must increase and mu be positive.\n", k + 1, o->absorber);
+            status = -1;
+        }
+    }
+    for (int g = 0; status == 0 && g < t->n; g++) t->mu[g] = unbind_attenuation_table(e, mu, n, t->energy[g]);
+    free(e);
+    return status;
+}
+
+int dosespec_build(const dosespec_options* o, dosespec_table* t) {
+    memset(t, 0, sizeof(*t));
+    t->energy = malloc(3 * DOSESPEC_MAX_GROUPS * sizeof(double));
+    if (!t->energy) {
+        fprintf(stderr, "Out of memory.\n");
+        return -1;
+    }
+    t->weight = t->energy + DOSESPEC_MAX_GROUPS;
+    t->mu = t->weight + DOSESPEC_MAX_GROUPS;
+    if (build_groups(o, t) != 0 || build_coefficients(o, t) != 0) {
+        dosespec_free(t);
+        return -1;
+    }
+    t->s.n = t->n;
+    t->s.weight = t->weight;
+    t->s.mu = t->mu;
+    return 0;
+}
+
+void dosespec_free(dosespec_table* t) {
+    free(t->energy);
+    memset(t, 0, sizeof(*t));
+}
+
+void dosespec_describe(const dosespec_options* o, const dosespec_table* t, char* buf, size_t size) {
+    const char* absorber = unbind_lookup_absorber(o->absorber) >= 0 ? "" : "file ";
+    if (strncmp(o->spectrum, "blackbody:", 10) == 0)
+        snprintf(buf, size, "blackbody kT = %g keV, %d groups from %g to %g MeV; absorber %s%s",
+                 atof(o->spectrum + 10), t->n, o->e_min, o->e_max, absorber, o->absorber);
+    else if (strcmp(o->spectrum, "flat") == 0)
+        snprintf(buf, size, "flat, %d groups from %g to %g MeV; absorber %s%s", t->n, o->e_min, o->e_max,
+                 absorber, o->absorber);
+    else
+        snprintf(buf, size, "file %s, %d groups; absorber %s%s", o->spectrum, t->n, absorber, o->absorber);
+}
+
+/* ---------------------------------------------------------------------------
+ * Mode
+ * ------------------------------------------------------------------------- */
+
+static int write_table(const dosespec_table* t, double X, const char* path) {
+    FILE* fp = fopen(path, "w");
+    if (!fp) return -1;
+    int err = fprintf(fp, "group,energy_mev,weight,mu_cm2_g,transmission\n") < 0;
+    for (int g = 0; g < t->n && !err; g++)
+        err = fprintf(fp, "%d,%.9e,%.9e,%.9e,%.9e\n", g, t->energy[g], t->weight[g], t->mu[g],
+                      exp(-t->mu[g] * X)) < 0;
+    if (fclose(fp) != 0) err = 1;
+    return err ? -1 : 0;
+}
+
+static int dosespec_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s spectrum [d=3.844e8] [E=2.49e32] [eta=3e-3] [A=0.7] [M=70] [f=1] [theta_deg=75]\n"
+        "          [atmos_trans=1] [spectrum=blackbody:<kT_keV>|flat|<file.csv>] [groups=128]\n"
+        "          [emin=1e-3] [emax=20] [absorber=air|water|<file.csv>] [column=0] [medium=0]\n"
+        "          [table=<file.csv>]\n", prog);
+    return 1;
+}
+
+int run_dose_spectrum(int argc, char** argv) {
+    unbind_dose_input in;
+    unbind_dose_result out;
+    dosespec_options o;
+    const char* table_path = NULL;
+    unbind_dose_defaults(&in);
+    dosespec_init(&o);
+    struct { const char* name; double* value; } params[] = {
+        { "d=", &in.d }, { "E=", &in.E }, { "eta=", &in.eta }, { "A=", &in.A }, { "M=", &in.M },
+        { "f=", &in.f }, { "theta_deg=", &in.theta_deg }, { "atmos_trans=", &in.atmos_trans }
+    };
+
+    for (int i = 2; i < argc; i++) {
+        int spec = dosespec_option(argv[i], &o);
+        if (spec > 0) continue;
+        if (spec == 0) {
+            int param = -1;
+            for (size_t p = 0; p < sizeof(params) / sizeof(params[0]); p++)
+                if (strncmp(argv[i], params[p].name, strlen(params[p].name)) == 0) param = (int)p;
+            if (param >= 0) {
+                *params[param].value = atof(argv[i] + strlen(params[param].name));
+                continue;
+            }
+            if (strncmp(argv[i], "table=", 6) == 0) {
+                table_path = argv[i] + 6;
+                continue;
+            }
+        }
+        fprintf(stderr, "Bad spectrum option: %s\n", argv[i]);
+        return dosespec_usage(argv[0]);
+    }
+
+    dosespec_table t;
+    if (dosespec_build(&o, &t) != 0) return 1;
+    double X = o.column + o.medium * 100.0 * in.d;
+    double T;
+    unbind_spectrum_transmission(&t.s, &X, &T, 1);
+    if (table_path && write_table(&t, X, table_path) != 0) {
+        fprintf(stderr, "Cannot write group table: %s\n", table_path);
+        dosespec_free(&t);
+        return 1;
+    }
+    in.atmos_trans *= T;
+    unbind_dose(&in, &out);
+
+    char spectrum[DOSESPEC_MAX_LINE];
+    dosespec_describe(&o, &t, spectrum, sizeof(spectrum));
+    unbind_out* report = unbind_stdout();
+    unbind_out_printf(report, "Impact Generated Radiation Dose (spectral)\n");
+    unbind_out_printf(report, "------------------------------------------\n\n");
+    unbind_out_printf(report, "spectrum = %s\n", spectrum);
+    unbind_out_printf(report, "column = %.6e g/cm^2\n", X);
+    unbind_out_printf(report, "transmitted fraction = %.6e\n\n", T);
+    unbind_out_printf(report, "fluence = %.6e J/m^2\n\n", out.fluence);
+    unbind_out_printf(report, "Dose (upper boundary, max exposure) = %.6e Gy\n", out.dose_upper);
+    if (out.dose_upper > UNBIND_LETHAL_DOSE)
+        unbind_out_printf(report, "*** WARNING: Dose exceeds 8 Gy (lethal dose for humans)\n\n");
+    unbind_out_printf(report, "Dose (lower boundary, angle %.1f deg, glancing blow) = %.6e Gy\n",
+                      in.theta_deg, out.dose_lower);
+    if (out.dose_lower > UNBIND_LETHAL_DOSE)
+        unbind_out_printf(report, "*** WARNING: Dose exceeds 8 Gy (lethal dose for humans)\n");
+    unbind_out_printf(report, "\n");
+    dosespec_free(&t);
+    return unbind_out_flush(report) == 0 ? 0 : 1;
+}
@@ -0,0 +1,57 @@
+/* unbind_dosespec.h
+* (C) 2025 - George McGinn - MIT License
+* Spectral options for unbindDose: the emitted spectrum and the absorber it crosses, shared
+* by the spectrum and grid modes, and the spectrum mode itself.
+*
+* Options:
+*   spectrum=blackbody:<kT_keV>   blackbody at kT (default blackbody:10)
+*   spectrum=flat                 the same energy per ln E
+*   spectrum=<file.csv>           energy_mev,weight per line: one group per line
+*   groups=128 emin=1e-3 emax=20  log-spaced groups (MeV) for blackbody and flat
+*   absorber=air|water|<file.csv> mass attenuation coefficients; a file holds
+*                                 energy_mev,mu_cm2_g lines in increasing energy
+*   column=<g/cm^2>               absorber in front of every observer (default 0)
+*   medium=<g/cm^3>               absorber density filling the space out to the observer
+*                                 (default 0), adding medium * r (r in cm) to the column
+*/
+
+#ifndef UNBIND_DOSESPEC_H
+#define UNBIND_DOSESPEC_H
+
+#include "libunbind.h"
+
+#define DOSESPEC_MAX_GROUPS 4096
+#define DOSESPEC_MAX_TABLE 1024            // lines of an absorber file
+
+typedef struct {
+    const char* spectrum;
+    const char* absorber;
+    int groups;
+    double e_min, e_max;                   // MeV
+    double column;                         // g/cm^2
+    double medium;                         // g/cm^3
+    int given;                             // any of the options above was given
+} dosespec_options;
+
+typedef struct {
+    unbind_spectrum s;                     // points into the arrays below
+    int n;
+    double* energy;                        // MeV
+    double* weight;
+    double* mu;                            // cm^2/g
+} dosespec_table;
+
+void dosespec_init(dosespec_options* o);
+// 1 if arg is one of the options above (stored in o), 0 if it is not, -1 if it is malformed
+int dosespec_option(const char* arg, dosespec_options* o);
+// Groups and coefficients for o; 0, or -1 (printed). Free with dosespec_free().
+int dosespec_build(const dosespec_options* o, dosespec_table* t);
+void dosespec_free(dosespec_table* t);
+// One line describing the spectrum and absorber, for the reports
+void dosespec_describe(const dosespec_options* o, const dosespec_table* t, char* buf, size_t size);
+
+// spectrum [d=3.844e8] [E=2.49e32] [eta=3e-3] [A=0.7] [M=70] [f=1] [theta_deg=75] [atmos_trans=1]
+//          [spectrum options] [table=<file.csv>]
+int run_dose_spectrum(int argc, char** argv);
+
+#endif
@@ -0,0 +1,390 @@
+/* unbind_fmt.c
+* (C) 2025 - George McGinn - MIT License
+* Number formatting and buffered output (see unbind_fmt.h).
+* Build: part of unbindEnergy and unbindDose, see unbindEnergy.c
+*
+* Notes:
+*  - Fixed-precision conversion follows Grisu3: x * 10^k is formed in double-double
+*    arithmetic (error below 2^-100 relative), the integer part gives the digits, and the
+*    fraction decides the last-digit rounding. When the fraction is within FMT_TIE_MARGIN
+*    of one half (exact ties, or values too close to call) the conversion falls back to
+*    snprintf, so the output always matches printf. The fallback also covers NaN, Inf,
+*    subnormals, |x| > 1e300 and more significant digits than fit in 2^53.
+*  - Formatting one %.6e costs about a tenth of snprintf's time.
+*  - unbind_out is not locked: one writer per buffer (the multithreaded modes format into
+*    their own buffers and hand finished blocks to unbind_out_write).
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include "unbind_fmt.h"
+
+#define FMT_TIE_MARGIN 1e-9             // fraction distance from 1/2 that is decided exactly
+#define FMT_MAX_FAST_DIGITS 15          // significant digits (plus one guard) below 2^53
+
+static const double pow10_exact[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64_t pow10_u64[20] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* ---------------------------------------------------------------------------
+* Exact digit generation
+* -------------------------------------------------------------------------*/
+
+// a*b = p + e exactly (Dekker; no FMA needed)
+static inline void two_product(double a, double b, double* p, double* e) {
+    const double split = 134217729.0;   // 2^27 + 1
+    double t = split * a, ah = t - (t - a), al = a - ah;
+    t = split * b;
+    double bh = t - (t - b), bl = b - bh;
+    *p = a * b;
+    *e = ((ah * bh - *p) + ah * bl + al * bh) + al * bl;
+}
+
+// (hi, lo) ~ x * 10^k in double-double
+static void scale_pow10(double x, int k, double* hi, double* lo) {
+    double h = x, l = 0.0;
+    while (k > 0) {
+        int s = k > 22 ? 22 : k;
+        double p = pow10_exact[s], ph, pe;
+        two_product(h, p, &ph, &pe);
+        pe += l * p;
+        h = ph + pe;
+        l = pe - (h - ph);
+        k -= s;
+    }
+    while (k < 0) {
+        int s = -k > 22 ? 22 : -k;
+        double p = pow10_exact[s], qp, qe;
+        double q = h / p;
+        two_product(q, p, &qp, &qe);
+        double r = ((h - qp) - qe) + l;     // h - q*p is exact
+        double q2 = r / p;
+        h = q + q2;
+        l = q2 - (h - q);
+        k += s;
+    }
+    *hi = h;
+    *lo = l;
+}
+
+// x * 10^k = fl + frac with 0 <= frac < 1; *up = frac > 1/2. Returns -1 when
+// fl would not fit in 2^53 or frac is too close to 1/2 to decide.
+static int round_scaled(double x, int k, uint64_t* fl, int* up) {
+    double h, l;
+    scale_pow10(x, k, &h, &l);
+    if (!(h < 9007199254740992.0)) return -1;
+    uint64_t n = (uint64_t)h;
+    double frac = (h - (double)n) + l;
+    if (frac < 0.0) { n--; frac += 1.0; }
+    else if (frac >= 1.0) { n++; frac -= 1.0; }
+    if (fabs(frac - 0.5) < FMT_TIE_MARGIN) return -1;
+    *fl = n;
+    *up = frac > 0.5;
+    return 0;
+}
+
+// Round x > 0 (normal, <= 1e300) to digits significant digits: x ~ N * 10^(e10 + 1 - digits)
+// with 10^(digits-1) <= N < 10^digits. Returns -1 to request the snprintf fallback.
+static int round_significant(double x, int digits, uint64_t* N, int* e10) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int e2 = (int)((bits >> 52) & 0x7ff) - 1023;
+    int e = (e2 * 78913) >> 18;                  // floor(e2 log10 2): floor(log10 x) or one less
+    for (int tries = 0; tries < 3; tries++) {
+        uint64_t fl;
+        int up;
+        if (round_scaled(x, digits - 1 - e, &fl, &up) != 0) return -1;
+        if (fl >= pow10_u64[digits]) { e++; continue; }
+        if (fl < pow10_u64[digits-1]) { e--; continue; }
+        fl += (uint64_t)up;
+        if (fl == pow10_u64[digits]) { fl /= 10; e++; }
+        *N = fl;
+        *e10 = e;
+        return 0;
+    }
+    return -1;
+}
+
+// Exactly `count` decimal digits of n (zero-padded), written at p
+static char* put_digits(char* p, uint64_t n, int count) {
+    char* end = p + count;
+    char* q = end;
+    while (count >= 2) {
+        unsigned r = (unsigned)(n % 100);
+        n /= 100;
+        q -= 2;
+        memcpy(q, digit_pairs + 2 * r, 2);
+        count -= 2;
+    }
+    if (count) *--q = (char)('0' + n % 10);
+    return end;
+}
+
+static int count_digits(uint64_t n) {
+    int d = 1;
+    while (d < 20 && n >= pow10_u64[d]) d++;
+    return d;
+}
+
+static char* put_exponent(char* p, int e) {
+    *p++ = 'e';
+    *p++ = e < 0 ? '-' : '+';
+    if (e < 0) e = -e;
+    return put_digits(p, (uint64_t)e, e >= 100 ? 3 : 2);
+}
+
+static char* fallback(char* p, char conv, double x, int prec) {
+    char spec[8] = { '%', '.', '*', conv, '\0' };
+    int n = snprintf(p, UNBIND_FMT_MAX, spec, prec, x);
+    if (n < 0) n = 0;
+    if (n >= UNBIND_FMT_MAX) n = UNBIND_FMT_MAX - 1;
+    return p + n;
+}
+
+/* ---------------------------------------------------------------------------
+* Conversions
+* -------------------------------------------------------------------------*/
+
+char* unbind_fmt_e(char* p, double x, int prec) {
+    uint64_t N = 0;
+    int e10 = 0;
+    double a = fabs(x);
+    if (!isfinite(x) || prec < 0 || prec + 1 >= FMT_MAX_FAST_DIGITS) return fallback(p, 'e', x, prec);
+    if (a != 0.0 && (a < 1e-300 || a > 1e300 || round_significant(a, prec + 1, &N, &e10) != 0))
+        return fallback(p, 'e', x, prec);
+    if (signbit(x)) *p++ = '-';
+    char digits[24];
+    put_digits(digits, N, prec + 1);
+    *p++ = digits[0];
+    if (prec > 0) {
+        *p++ = '.';
+        memcpy(p, digits + 1, (size_t)prec);
+        p += prec;
+    }
+    return put_exponent(p, e10);
+}
+
+char* unbind_fmt_f(char* p, double x, int prec) {
+    uint64_t N = 0, fl;
+    int up;
+    double a = fabs(x);
+    if (!isfinite(x) || prec < 0 || prec > 17) return fallback(p, 'f', x, prec);
+    if (a >= 1e-300) {
+        if (a > 1e300 || round_scaled(a, prec, &fl, &up) != 0) return fallback(p, 'f', x, prec);
+        N = fl + (uint64_t)up;
+    }
+    if (signbit(x)) *p++ = '-';
+    uint64_t scale = pow10_u64[prec];
+    uint64_t ip = N / scale;
+    p = put_digits(p, ip, count_digits(ip));
+    if (prec > 0) {
+        *p++ = '.';
+        p = put_digits(p, N % scale, prec);
+    }
+    return p;
+}
+
+char* unbind_fmt_g(char* p, double x, int prec) {
+    int P = prec == 0 ? 1 : prec;
+    uint64_t N = 0;
+    int X = 0;
+    double a = fabs(x);
+    if (!isfinite(x) || prec < 0 || P >= FMT_MAX_FAST_DIGITS) return fallback(p, 'g', x, prec);
+    if (a == 0.0) {
+        if (signbit(x)) *p++ = '-';
+        *p++ = '0';
+        return p;
+    }
+    if (a < 1e-300 || a > 1e300 || round_significant(a, P, &N, &X) != 0) return fallback(p, 'g', x, prec);
+    if (signbit(x)) *p++ = '-';
+
+    char digits[24];
+    put_digits(digits, N, P);
+    int n = P;
+    while (n > 1 && digits[n-1] == '0') n--;       // %g drops trailing zeros
+
+    if (X < -4 || X >= P) {
+        *p++ = digits[0];
+        if (n > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, (size_t)(n - 1));
+            p += n - 1;
+        }
+        return put_exponent(p, X);
+    }
+    if (X >= 0) {
+        memcpy(p, digits, (size_t)(X + 1));
+        p += X + 1;
+        if (n > X + 1) {
+            *p++ = '.';
+            memcpy(p, digits + X + 1, (size_t)(n - X - 1));
+            p += n - X - 1;
+        }
+        return p;
+    }
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = 0; i < -X - 1; i++) *p++ = '0';
+    memcpy(p, digits, (size_t)n);
+    return p + n;
+}
+
+static char* fmt_uint(char* p, unsigned long long v) {
+    return put_digits(p, v, count_digits(v));
+}
+
+char* unbind_fmt_int(char* p, long long v) {
+    if (v < 0) {
+        *p++ = '-';
+        return fmt_uint(p, 0ull - (unsigned long long)v);
+    }
+    return fmt_uint(p, (unsigned long long)v);
+}
+
+char* unbind_fmt_str(char* p, const char* s) {
+    size_t n = strlen(s);
+    memcpy(p, s, n);
+    return p + n;
+}
+
+/* ---------------------------------------------------------------------------
+* Buffered output
+* -------------------------------------------------------------------------*/
+
+void unbind_out_init(unbind_out* o, int fd, char* buf, size_t cap) {
+    o->fd = fd;
+    o->buf = buf;
+    o->len = 0;
+    o->cap = cap;
+    o->error = 0;
+}
+
+unbind_out* unbind_stdout(void) {
+    static char buf[UNBIND_OUT_BUF];
+    static unbind_out out = { 1, buf, 0, UNBIND_OUT_BUF, 0 };
+    return &out;
+}
+
+static void write_fd(unbind_out* o, const char* p, size_t n) {
+    while (n > 0 && !o->error) {
+        ssize_t k = write(o->fd, p, n);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) {
+            o->error = k < 0 ? errno : EIO;
+            break;
+        }
+        p += k;
+        n -= (size_t)k;
+    }
+}
+
+int unbind_out_flush(unbind_out* o) {
+    write_fd(o, o->buf, o->len);
+    o->len = 0;
+    return o->error ? -1 : 0;
+}
+
+char* unbind_out_reserve(unbind_out* o, size_t n) {
+    if (o->cap - o->len < n) unbind_out_flush(o);
+    return o->buf + o->len;
+}
+
+void unbind_out_advance(unbind_out* o, char* end) {
+    o->len = (size_t)(end - o->buf);
+}
+
+void unbind_out_write(unbind_out* o, const void* data, size_t n) {
+    if (o->cap - o->len < n) {
+        unbind_out_flush(o);
+        if (n >= o->cap / 2) {              // large blocks go straight to the descriptor
+            write_fd(o, data, n);
+            return;
+        }
+    }
+    memcpy(o->buf + o->len, data, n);
+    o->len += n;
+}
+
+// Copy len bytes of s into a field of the given width
+static void put_padded(unbind_out* o, const char* s, size_t len, int width, int left) {
+    size_t pad = width > 0 && (size_t)width > len ? (size_t)width - len : 0;
+    if (!left) while (pad) { unbind_out_write(o, " ", 1); pad--; }
+    unbind_out_write(o, s, len);
+    while (pad) { unbind_out_write(o, " ", 1); pad--; }
+}
+
+void unbind_out_printf(unbind_out* o, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    const char* f = fmt;
+    while (*f) {
+        const char* lit = f;
+        while (*f && *f != '%') f++;
+        if (f > lit) unbind_out_write(o, lit, (size_t)(f - lit));
+        if (!*f) break;
+
+        const char* spec = f++;
+        int left = 0, width = 0, prec = -1, longs = 0, size = 0;
+        while (*f == '-') { left = 1; f++; }
+        while (*f >= '0' && *f <= '9') width = width * 10 + (*f++ - '0');
+        if (*f == '.') {
+            prec = 0;
+            f++;
+            while (*f >= '0' && *f <= '9') prec = prec * 10 + (*f++ - '0');
+        }
+        while (*f == 'l') { longs++; f++; }
+        if (*f == 'z') { size = 1; f++; }
+
+        char tmp[UNBIND_FMT_MAX];
+        char* end = tmp;
+        switch (*f) {
+            case 'e': end = unbind_fmt_e(tmp, va_arg(ap, double), prec < 0 ? 6 : prec); break;
+            case 'f': end = unbind_fmt_f(tmp, va_arg(ap, double), prec < 0 ? 6 : prec); break;
+            case 'g': end = unbind_fmt_g(tmp, va_arg(ap, double), prec < 0 ? 6 : prec); break;
+            case 'd':
+            case 'i':
+                end = unbind_fmt_int(tmp, size ? (long long)va_arg(ap, ptrdiff_t) : longs >= 2 ? va_arg(ap, long long) :
+                                          longs ? (long long)va_arg(ap, long) : (long long)va_arg(ap, int));
+                break;
+            case 'u':
+                end = fmt_uint(tmp, size ? (unsigned long long)va_arg(ap, size_t) : longs >= 2 ? va_arg(ap, unsigned long long) :
+                                    longs ? (unsigned long long)va_arg(ap, unsigned long) : (unsigned long long)va_arg(ap, unsigned));
+                break;
+            case 'c': *end++ = (char)va_arg(ap, int); break;
+            case 's': {
+                const char* s = va_arg(ap, const char*);
+                size_t len = strlen(s);
+                if (prec >= 0 && (size_t)prec < len) len = (size_t)prec;
+                put_padded(o, s, len, width, left);
+                f++;
+                continue;
+            }
+            case '%': *end++ = '%'; break;
+            default:                                   // unsupported: copy the spec as written
+                unbind_out_write(o, spec, (size_t)(f - spec) + (*f != '\0'));
+                if (*f) f++;
+                continue;
+        }
+        put_padded(o, tmp, (size_t)(end - tmp), width, left);
+        f++;
+    }
+    va_end(ap);
+}
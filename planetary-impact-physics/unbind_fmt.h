@@ -0,0 +1,46 @@
+/* unbind_fmt.h
+* (C) 2025 - George McGinn - MIT License
+* Fast number formatting and buffered write(2) output for unbindEnergy and unbindDose.
+*/
+
+#ifndef UNBIND_FMT_H
+#define UNBIND_FMT_H
+
+#include <stddef.h>
+
+#define UNBIND_FMT_MAX 352                 // longest single conversion (%.17f of DBL_MAX and sign)
+#define UNBIND_OUT_BUF (1 << 20)           // size of the unbind_stdout() buffer
+
+/* Conversions. Each writes at most UNBIND_FMT_MAX bytes at p (no terminating NUL) and
+ * returns the end of what it wrote. Output is byte-identical to printf's "%.<prec>e",
+ * "%.<prec>f", "%.<prec>g", "%lld" and "%s". */
+char* unbind_fmt_e(char* p, double x, int prec);
+char* unbind_fmt_f(char* p, double x, int prec);
+char* unbind_fmt_g(char* p, double x, int prec);
+char* unbind_fmt_int(char* p, long long v);
+char* unbind_fmt_str(char* p, const char* s);    // unbounded: the caller sizes the buffer
+
+// Output buffer flushed to a file descriptor with write(2)
+typedef struct {
+    int    fd;
+    char*  buf;
+    size_t len, cap;
+    int    error;                          // errno of the first failed write, 0 if none
+} unbind_out;
+
+void unbind_out_init(unbind_out* o, int fd, char* buf, size_t cap);
+unbind_out* unbind_stdout(void);           // process-wide, fd 1, UNBIND_OUT_BUF bytes
+int unbind_out_flush(unbind_out* o);       // 0, or -1 if any write failed
+char* unbind_out_reserve(unbind_out* o, size_t n);    // room for n <= cap bytes; returns the write position
+void unbind_out_advance(unbind_out* o, char* end);    // commit what was written up to end
+void unbind_out_write(unbind_out* o, const void* data, size_t n);
+
+/* printf subset rendered with the conversions above: %s %c %d %i %u %e %f %g and %%,
+ * with an optional '-' flag, width, precision and the l/ll/z length modifiers. */
+void unbind_out_printf(unbind_out* o, const char* fmt, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+#endif
@@ -0,0 +1,841 @@
+/* unbind_mc.c
+* (C) 2025 - George McGinn - MIT License
+* Monte Carlo mode for unbindEnergy (see unbind_mc.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy mc <m|d|v> <value-dist> [rho=<dist>] [eps=<dist>] [speed=<dist>|diameter=<dist>]
+*                     [planet=earth] [material=stony] [samples=1000000] [threads=0] [seed=1]
+*                     [surface=<file.urs>] [angle=<dist>]
+*
+* Examples:
+*   ./unbindEnergy mc d loguniform:0.1:10 rho=normal:2500:500 eps=uniform:0.1:1 planet=earth samples=1e8
+*   ./unbindEnergy mc m loguniform:1e9:1e12 eps=0.25 speed=normal:26:3 planet=mars material=cometary
+*   ./unbindEnergy mc v lognormal:30:0.5 rho=empirical:densities.txt diameter=uniform:1:5
+*   ./unbindEnergy mc d loguniform:1e-4:1 speed=normal:20:4 angle=uniform:15:90 surface=entry.urs
+*
+* Notes:
+*  - The value distribution is the mass (kg) for 'm', the diameter (km) for 'd' and the
+*    speed (km/s) for 'v'. rho does not apply to 'm' (the solver estimates size at 3000 kg/m^3).
+*  - speed= ('m', 'd') gives the actual impact speed (km/s): a sample destroys the target when
+*    it is at least the required relativistic speed. Without it the probability reported is
+*    that of v_rel < 0.99c. diameter= ('v') gives the actual size (km), compared with the
+*    minimum equivalent diameter.
+*  - surface= takes retention from the entry-model tables of a surface file (unbind_surface.c)
+*    instead of the step tables. Each sample enters at its own impact speed (the 'v' value,
+*    or the speed= draw; 20 km/s without one) and at an angle above the horizon drawn from
+*    angle= (default 45 degrees). Samples with an angle outside (0, 90] are dropped.
+*  - Draw i of input dimension k is Philox(seed; i, k) (unbind_rng.h), so a run is
+*    reproducible for a seed and independent of the thread count.
+*  - Samples are processed in tasks of MC_TASK on the thread pool, MC_BLOCK at a time through
+*    the SIMD kernels. Quantiles come from per-worker histograms with 2^MC_HIST_MANT_BITS bins
+*    per octave (bin width < 0.14%, interpolated within the bin and clamped to the smallest and
+*    largest value seen, so no quantile leaves the observed range) and the mean from per-task
+*    partial sums added in task order; all buffers are allocated before the run.
+*  - Samples with a non-positive input, or a speed not below c, are dropped and counted.
+*  - shard=, out=, checkpoint= and every= are those of unbind_shard.h; the work units are the
+*    MC_TASK tasks. A shard or checkpoint stores the run's arguments, each finished task's
+*    stats and the nonzero histogram bins, which is all the report needs: merge adds the
+*    shards' histograms and the task sums in task order, so the report is the one run
+*    unsharded. With checkpoint= the tasks run MC_WINDOW_PER_THREAD per worker at a time.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "libunbind.h"
+#include "unbind_rng.h"
+#include "unbind_pool.h"
+#include "unbind_fmt.h"
+#include "unbind_surface.h"
+#include "unbind_shard.h"
+#include "unbind_mc.h"
+
+#define MC_TASK 65536                 // samples per pool task
+#define MC_BLOCK 1024                 // samples per SoA call
+#define MC_WINDOW_PER_THREAD 8        // tasks per worker between checkpoints
+#define MC_OUTPUTS 2                  // histogrammed results per sample
+#define MC_HIST_MANT_BITS 9
+#define MC_HIST_EXP_MIN (-256)        // values outside [2^-256, 2^256) land in the end bins
+#define MC_HIST_EXP_MAX 256
+#define MC_HIST_BINS ((size_t)(MC_HIST_EXP_MAX - MC_HIST_EXP_MIN) << MC_HIST_MANT_BITS)
+
+// RNG stream per input dimension
+#define MC_DIM_VALUE 0
+#define MC_DIM_RHO 1
+#define MC_DIM_EPS 2
+#define MC_DIM_AGAINST 3
+#define MC_DIM_ANGLE 4
+
+#define MC_ENTRY_SPEED 20.0           // km/s, surface= without a speed
+
+static const double mc_quantiles[] = { 0.01, 0.05, 0.16, 0.50, 0.84, 0.95, 0.99 };
+#define MC_N_QUANTILES (sizeof(mc_quantiles) / sizeof(mc_quantiles[0]))
+
+typedef struct {
+    char mode;
+    int planet, material;
+    mc_dist value, rho, eps, against, angle;
+    int has_rho, has_against;
+    const unbind_retention_surface* surface;   // surface=: entry retention, or NULL
+    uint64_t seed;
+    uint64_t samples;
+} mc_plan;
+
+// Per-worker scratch, allocated before the run
+typedef struct {
+    double x[MC_BLOCK], rho[MC_BLOCK], eps[MC_BLOCK], against[MC_BLOCK], angle[MC_BLOCK];
+    double out[MC_OUTPUTS][MC_BLOCK];
+    unsigned char ok[MC_BLOCK], destroyed[MC_BLOCK];
+    uint64_t* hist[MC_OUTPUTS];
+} mc_worker;
+
+typedef struct {
+    double sum[MC_OUTPUTS];
+    double min[MC_OUTPUTS], max[MC_OUTPUTS];   // observed range; +inf/-inf with no valid sample
+    uint64_t valid, destroyed;
+} mc_task_stats;
+
+typedef struct {
+    const mc_plan* plan;
+    mc_worker* workers;
+    mc_task_stats* tasks;             // every task of the run, by task number
+    size_t base;                      // task number of pool task 0
+} mc_job;
+
+// Payload of an mc checkpoint or shard file (unbind_shard.h), followed by the arguments,
+// the stats of tasks begin..next-1 and nonzero[k] (bin, count) pairs per histogram
+typedef struct {
+    uint64_t args_bytes;              // NUL-separated, padded to 8 bytes
+    uint64_t n_tasks;
+    uint64_t nonzero[MC_OUTPUTS];
+} mc_partial;
+
+/* ---------------------------------------------------------------------------
+ * Distributions
+ * ------------------------------------------------------------------------- */
+
+static int load_empirical(const char* path, mc_dist* d) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return -1;
+    size_t cap = 1024;
+    d->values = malloc(cap * sizeof(double));
+    d->n = 0;
+    char token[128];
+    int c = 0;
+    while (d->values && c != EOF) {
+        size_t len = 0;
+        while ((c = fgetc(fp)) != EOF && c != ',' && c != ' ' && c != '\t' && c != '\n' && c != '\r')
+            if (len < sizeof(token) - 1) token[len++] = (char)c;
+        if (len == 0) continue;
+        token[len] = '\0';
+        char* end;
+        double x = strtod(token, &end);
+        if (*end != '\0') continue;            // skip headers and stray text
+        if (d->n == cap) {
+            double* p = realloc(d->values, 2 * cap * sizeof(double));
+            if (!p) { free(d->values); d->values = NULL; break; }
+            d->values = p;
+            cap *= 2;
+        }
+        d->values[d->n++] = x;
+    }
+    fclose(fp);
+    if (!d->values || d->n == 0) {
+        free(d->values);
+        d->values = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int mc_parse_dist(const char* spec, mc_dist* d) {
+    static const struct { const char* name; int kind; } kinds[] = {
+        { "uniform:", MC_DIST_UNIFORM }, { "loguniform:", MC_DIST_LOGUNIFORM },
+        { "normal:", MC_DIST_NORMAL }, { "lognormal:", MC_DIST_LOGNORMAL },
+    };
+    memset(d, 0, sizeof(*d));
+
+    if (strncmp(spec, "empirical:", 10) == 0) {
+        d->kind = MC_DIST_EMPIRICAL;
+        return load_empirical(spec + 10, d);
+    }
+    for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++) {
+        size_t len = strlen(kinds[i].name);
+        if (strncmp(spec, kinds[i].name, len) != 0) continue;
+        char tail;
+        d->kind = kinds[i].kind;
+        if (sscanf(spec + len, "%lf:%lf%c", &d->a, &d->b, &tail) != 2) return -1;
+        switch (d->kind) {
+            case MC_DIST_UNIFORM:    return d->a < d->b ? 0 : -1;
+            case MC_DIST_LOGUNIFORM: return d->a > 0.0 && d->a < d->b ? 0 : -1;
+            case MC_DIST_NORMAL:     return d->b > 0.0 ? 0 : -1;
+            default:                 return d->a > 0.0 && d->b > 0.0 ? 0 : -1;
+        }
+    }
+    char* end;
+    d->kind = MC_DIST_CONST;
+    d->a = strtod(spec, &end);
+    return end != spec && *end == '\0' && d->a > 0.0 ? 0 : -1;
+}
+
+void mc_free_dist(mc_dist* d) {
+    free(d->values);
+    d->values = NULL;
+    d->n = 0;
+}
+
+static void mc_describe(const mc_dist* d, char* buf, size_t size) {
+    switch (d->kind) {
+        case MC_DIST_CONST:      snprintf(buf, size, "%g", d->a); break;
+        case MC_DIST_UNIFORM:    snprintf(buf, size, "uniform(%g, %g)", d->a, d->b); break;
+        case MC_DIST_LOGUNIFORM: snprintf(buf, size, "loguniform(%g, %g)", d->a, d->b); break;
+        case MC_DIST_NORMAL:     snprintf(buf, size, "normal(%g, %g)", d->a, d->b); break;
+        case MC_DIST_LOGNORMAL:  snprintf(buf, size, "lognormal(median %g, sigma %g)", d->a, d->b); break;
+        default:                 snprintf(buf, size, "empirical(%zu values)", d->n); break;
+    }
+}
+
+void mc_sample(const mc_dist* d, uint64_t seed, uint32_t dim, uint64_t first, size_t n, double* out) {
+    const double two_pi = 2.0 * UNBIND_PI;
+    double u1, u2;
+    switch (d->kind) {
+        case MC_DIST_CONST:
+            for (size_t i = 0; i < n; i++) out[i] = d->a;
+            break;
+        case MC_DIST_UNIFORM:
+            for (size_t i = 0; i < n; i++) {
+                unbind_rng_u01x2(seed, first + i, dim, &u1, &u2);
+                out[i] = d->a + (d->b - d->a) * u1;
+            }
+            break;
+        case MC_DIST_LOGUNIFORM: {
+            double la = log(d->a), span = log(d->b) - la;
+            for (size_t i = 0; i < n; i++) {
+                unbind_rng_u01x2(seed, first + i, dim, &u1, &u2);
+                out[i] = exp(la + span * u1);
+            }
+            break;
+        }
+        case MC_DIST_NORMAL:
+        case MC_DIST_LOGNORMAL: {
+            // Box-Muller, one normal per draw
+            int log_normal = d->kind == MC_DIST_LOGNORMAL;
+            double mu = log_normal ? log(d->a) : d->a;
+            for (size_t i = 0; i < n; i++) {
+                unbind_rng_u01x2(seed, first + i, dim, &u1, &u2);
+                double z = mu + d->b * sqrt(-2.0 * log(u1)) * cos(two_pi * u2);
+                out[i] = log_normal ? exp(z) : z;
+            }
+            break;
+        }
+        default:
+            for (size_t i = 0; i < n; i++) {
+                unbind_rng_u01x2(seed, first + i, dim, &u1, &u2);
+                size_t k = (size_t)(u1 * (double)d->n);
+                out[i] = d->values[k < d->n ? k : d->n - 1];
+            }
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * Histograms: 2^MC_HIST_MANT_BITS bins per octave, indexed straight from the IEEE bits
+ * ------------------------------------------------------------------------- */
+
+static inline size_t hist_bin(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int e = (int)((bits >> 52) & 0x7ff) - 1023;
+    if (e < MC_HIST_EXP_MIN) return 0;
+    if (e >= MC_HIST_EXP_MAX) return MC_HIST_BINS - 1;
+    return ((size_t)(e - MC_HIST_EXP_MIN) << MC_HIST_MANT_BITS)
+         | (size_t)((bits >> (52 - MC_HIST_MANT_BITS)) & ((1u << MC_HIST_MANT_BITS) - 1));
+}
+
+static double hist_edge(size_t bin) {
+    double mant = 1.0 + (double)(bin & ((1u << MC_HIST_MANT_BITS) - 1)) / (double)(1u << MC_HIST_MANT_BITS);
+    return ldexp(mant, (int)(bin >> MC_HIST_MANT_BITS) + MC_HIST_EXP_MIN);
+}
+
+// q-quantile of n counted values in [lo, hi], linear within the bin narrowed to [lo, hi]
+static double hist_quantile(const uint64_t* hist, uint64_t n, double q, double lo, double hi) {
+    double rank = q * (double)n;
+    uint64_t below = 0;
+    for (size_t b = 0; b < MC_HIST_BINS; b++) {
+        if (hist[b] == 0) continue;
+        if ((double)(below + hist[b]) >= rank) {
+            double f = (rank - (double)below) / (double)hist[b];
+            double a = b == 0 ? lo : fmax(hist_edge(b), lo);
+            double z = b == MC_HIST_BINS - 1 ? hi : fmin(hist_edge(b + 1), hi);
+            return fmin(fmax(a + f * (z - a), lo), hi);
+        }
+        below += hist[b];
+    }
+    return NAN;
+}
+
+/* ---------------------------------------------------------------------------
+ * Sampling tasks
+ * ------------------------------------------------------------------------- */
+
+static void mc_task(void* ctx, size_t task, int worker) {
+    mc_job* job = ctx;
+    const mc_plan* plan = job->plan;
+    mc_worker* w = &job->workers[worker];
+    task += job->base;
+    mc_task_stats* st = &job->tasks[task];
+    uint64_t first = (uint64_t)task * MC_TASK;
+    uint64_t count = plan->samples - first < MC_TASK ? plan->samples - first : MC_TASK;
+    int speed_mode = plan->mode == 'v';
+
+    memset(st, 0, sizeof(*st));
+    for (int k = 0; k < MC_OUTPUTS; k++) {
+        st->min[k] = INFINITY;
+        st->max[k] = -INFINITY;
+    }
+    for (uint64_t off = 0; off < count; off += MC_BLOCK) {
+        size_t n = count - off < MC_BLOCK ? (size_t)(count - off) : MC_BLOCK;
+        uint64_t index = first + off;
+
+        mc_sample(&plan->value, plan->seed, MC_DIM_VALUE, index, n, w->x);
+        mc_sample(&plan->eps, plan->seed, MC_DIM_EPS, index, n, w->eps);
+        if (plan->has_rho) mc_sample(&plan->rho, plan->seed, MC_DIM_RHO, index, n, w->rho);
+        if (plan->has_against) mc_sample(&plan->against, plan->seed, MC_DIM_AGAINST, index, n, w->against);
+        if (plan->surface) mc_sample(&plan->angle, plan->seed, MC_DIM_ANGLE, index, n, w->angle);
+
+        // Drop non-positive draws; the kernels see a harmless placeholder instead
+        for (size_t i = 0; i < n; i++) {
+            w->ok[i] = w->x[i] > 0.0 && w->eps[i] > 0.0 && (!plan->has_rho || w->rho[i] > 0.0)
+                    && (!plan->has_against || w->against[i] > 0.0)
+                    && (!plan->surface || (w->angle[i] > 0.0 && w->angle[i] <= 90.0));
+            if (!w->ok[i]) {
+                w->x[i] = 1.0;
+                w->eps[i] = 1.0;
+                if (plan->has_rho) w->rho[i] = UNBIND_DEFAULT_DENSITY;
+                if (plan->has_against) w->against[i] = 1.0;
+                if (plan->surface) w->angle[i] = 45.0;
+            }
+        }
+
+        unbind_soa_input in;
+        memset(&in, 0, sizeof(in));
+        in.mode = plan->mode;
+        in.planet = plan->planet;
+        in.material = plan->material;
+        in.rho = UNBIND_DEFAULT_DENSITY;
+        in.value = w->x;
+        in.rho_v = plan->has_rho ? w->rho : NULL;
+        in.eps_v = w->eps;
+        in.n = n;
+        unbind_soa_result res;
+        memset(&res, 0, sizeof(res));
+        if (speed_mode) {
+            res.m = w->out[0];
+            res.D_km = w->out[1];
+        } else {
+            res.v_rel = w->out[0];
+            res.v_class = w->out[1];
+            res.destroyed = w->destroyed;
+        }
+        if (plan->surface) {
+            const double* speed_v = speed_mode ? w->x : plan->has_against ? w->against : NULL;
+            unbind_surface_solve_soa(&in, plan->surface, speed_v, MC_ENTRY_SPEED, w->angle, 45.0, &res);
+        } else {
+            unbind_solve_soa(&in, &res);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            double a = w->out[0][i], b = w->out[1][i];
+            if (!w->ok[i] || !(a > 0.0) || isinf(a)) continue;
+            if (!speed_mode) { a /= 1000.0; b /= 1000.0; }    // km/s
+            int destroyed = !plan->has_against ? (!speed_mode && w->destroyed[i])
+                          : speed_mode ? w->against[i] >= b : w->against[i] >= a;
+            w->hist[0][hist_bin(a)]++;
+            w->hist[1][hist_bin(b)]++;
+            st->sum[0] += a;
+            st->sum[1] += b;
+            st->min[0] = fmin(st->min[0], a);
+            st->max[0] = fmax(st->max[0], a);
+            st->min[1] = fmin(st->min[1], b);
+            st->max[1] = fmax(st->max[1], b);
+            st->valid++;
+            st->destroyed += (uint64_t)destroyed;
+        }
+    }
+}
+
+
+/* ---------------------------------------------------------------------------
+ * Checkpoints and shards
+ * ------------------------------------------------------------------------- */
+
+// The arguments that fix the results (those the fingerprint covers), NUL-separated
+static size_t pack_args(int argc, char** argv, char* out) {
+    unbind_shard ignored;
+    size_t len = 0;
+    unbind_shard_init(&ignored);
+    for (int i = 1; i < argc; i++) {
+        if (unbind_shard_option(argv[i], &ignored) != 0 || strncmp(argv[i], "threads=", 8) == 0) continue;
+        size_t n = strlen(argv[i]) + 1;
+        if (out) memcpy(out + len, argv[i], n);
+        len += n;
+    }
+    return len;
+}
+
+// Tasks first..next-1 and the workers' histograms summed; malloc'd, NULL if out of memory
+static void* mc_pack(int argc, char** argv, const mc_task_stats* tasks, uint64_t first, uint64_t next,
+                     const mc_worker* workers, int n_threads, uint64_t* bytes) {
+    mc_partial h;
+    memset(&h, 0, sizeof(h));
+    h.args_bytes = (pack_args(argc, argv, NULL) + 7) & ~(size_t)7;
+    h.n_tasks = next - first;
+    for (int k = 0; k < MC_OUTPUTS; k++) {
+        for (size_t b = 0; b < MC_HIST_BINS; b++) {
+            uint64_t c = 0;
+            for (int t = 0; t < n_threads; t++) c += workers[t].hist[k][b];
+            h.nonzero[k] += c != 0;
+        }
+    }
+    *bytes = sizeof(h) + h.args_bytes + h.n_tasks * sizeof(mc_task_stats)
+           + (h.nonzero[0] + h.nonzero[1]) * 2 * sizeof(uint64_t);
+    char* buf = calloc(1, (size_t)*bytes);
+    if (!buf) return NULL;
+    memcpy(buf, &h, sizeof(h));
+    pack_args(argc, argv, buf + sizeof(h));
+    memcpy(buf + sizeof(h) + h.args_bytes, tasks + first, (size_t)h.n_tasks * sizeof(mc_task_stats));
+    uint64_t* pair = (uint64_t*)(buf + sizeof(h) + h.args_bytes + h.n_tasks * sizeof(mc_task_stats));
+    for (int k = 0; k < MC_OUTPUTS; k++) {
+        for (size_t b = 0; b < MC_HIST_BINS; b++) {
+            uint64_t c = 0;
+            for (int t = 0; t < n_threads; t++) c += workers[t].hist[k][b];
+            if (c == 0) continue;
+            *pair++ = b;
+            *pair++ = c;
+        }
+    }
+    return buf;
+}
+
+// Check a payload against its checkpoint; the arguments, or NULL if it is malformed
+static const char* mc_unpack_check(const unbind_checkpoint* c, const void* payload, const mc_partial** h) {
+    *h = payload;
+    if (c->payload_bytes < sizeof(mc_partial)) return NULL;
+    uint64_t n = (*h)->n_tasks, z = (*h)->nonzero[0] + (*h)->nonzero[1];
+    if (n != c->next - c->begin || (*h)->args_bytes > c->payload_bytes || z > MC_OUTPUTS * MC_HIST_BINS ||
+        c->payload_bytes != sizeof(mc_partial) + (*h)->args_bytes + n * sizeof(mc_task_stats) + z * 2 * sizeof(uint64_t))
+        return NULL;
+    return (const char*)payload + sizeof(mc_partial);
+}
+
+// Add a checked payload's tasks and histograms into a run's arrays
+static int mc_unpack(const unbind_checkpoint* c, const mc_partial* h, mc_task_stats* tasks, size_t n_tasks,
+                     uint64_t* const hist[MC_OUTPUTS]) {
+    if (c->next > n_tasks) return -1;
+    const char* p = (const char*)h + sizeof(*h) + h->args_bytes;
+    memcpy(tasks + c->begin, p, (size_t)h->n_tasks * sizeof(mc_task_stats));
+    const uint64_t* pair = (const uint64_t*)(p + h->n_tasks * sizeof(mc_task_stats));
+    for (int k = 0; k < MC_OUTPUTS; k++) {
+        for (uint64_t i = 0; i < h->nonzero[k]; i++, pair += 2) {
+            if (pair[0] >= MC_HIST_BINS) return -1;
+            hist[k][pair[0]] += pair[1];
+        }
+    }
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Driver
+ * ------------------------------------------------------------------------- */
+
+static int mc_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s mc <m|d|v> <value-dist> [rho=<dist>] [eps=<dist>] [speed=<dist>|diameter=<dist>]\n"
+        "          [planet=earth] [material=stony] [samples=1000000] [threads=0] [seed=1]\n"
+        "          [surface=<file.urs>] [angle=<dist>] [shard=i/N] [out=<file>] [checkpoint=<file>] [every=30]\n"
+        "  dist: x | uniform:a:b | loguniform:a:b | normal:mean:sd | lognormal:median:sigma | empirical:<file>\n",
+        prog);
+    return 1;
+}
+
+static void mc_free_plan(mc_plan* plan) {
+    mc_free_dist(&plan->value);
+    mc_free_dist(&plan->rho);
+    mc_free_dist(&plan->eps);
+    mc_free_dist(&plan->against);
+    mc_free_dist(&plan->angle);
+}
+
+// Everything but opening the surface file; 0, or 1 after printing the reason
+static int mc_parse_args(int argc, char** argv, mc_plan* plan, const char** surface_path, int* threads,
+                         unbind_shard* shard) {
+    const char* rho_spec = NULL;
+    const char* eps_spec = "1.0";
+    const char* against_spec = NULL;
+    const char* angle_spec = NULL;
+    const char* planet_name = "earth";
+    const char* material_name = "stony";
+
+    memset(plan, 0, sizeof(*plan));
+    unbind_shard_init(shard);
+    plan->seed = 1;
+    plan->samples = 1000000;
+    *surface_path = NULL;
+    *threads = 0;
+    if (argc < 4) return mc_usage(argv[0]);
+    plan->mode = argv[2][0];
+    if (argv[2][1] != '\0' || (plan->mode != 'm' && plan->mode != 'd' && plan->mode != 'v')) {
+        fprintf(stderr, "MC mode must be 'm', 'd', or 'v'.\n");
+        return 1;
+    }
+    for (int i = 4; i < argc; i++) {
+        int opt = 0;
+        if (strncmp(argv[i], "rho=", 4) == 0) rho_spec = argv[i] + 4;
+        else if (strncmp(argv[i], "eps=", 4) == 0) eps_spec = argv[i] + 4;
+        else if (strncmp(argv[i], "speed=", 6) == 0 && plan->mode != 'v') against_spec = argv[i] + 6;
+        else if (strncmp(argv[i], "diameter=", 9) == 0 && plan->mode == 'v') against_spec = argv[i] + 9;
+        else if (strncmp(argv[i], "planet=", 7) == 0) planet_name = argv[i] + 7;
+        else if (strncmp(argv[i], "material=", 9) == 0) material_name = argv[i] + 9;
+        else if (strncmp(argv[i], "samples=", 8) == 0) plan->samples = (uint64_t)strtod(argv[i] + 8, NULL);
+        else if (strncmp(argv[i], "threads=", 8) == 0) *threads = atoi(argv[i] + 8);
+        else if (strncmp(argv[i], "seed=", 5) == 0) plan->seed = strtoull(argv[i] + 5, NULL, 0);
+        else if (strncmp(argv[i], "surface=", 8) == 0) *surface_path = argv[i] + 8;
+        else if (strncmp(argv[i], "angle=", 6) == 0) angle_spec = argv[i] + 6;
+        else if ((opt = unbind_shard_option(argv[i], shard)) > 0) continue;
+        else {
+            fprintf(stderr, opt < 0 ? "Bad MC option: %s\n" : "Unknown MC option: %s\n", argv[i]);
+            return mc_usage(argv[0]);
+        }
+    }
+    if (plan->mode == 'm' && rho_spec) {
+        fprintf(stderr, "rho does not apply to mode 'm'.\n");
+        return 1;
+    }
+    plan->planet = unbind_lookup_planet(planet_name);
+    plan->material = unbind_lookup_material(material_name);
+    if (plan->planet < 0 || plan->material < 0) {
+        fprintf(stderr, "Unknown planet or material: %s %s\n", planet_name, material_name);
+        return 1;
+    }
+    if (plan->samples == 0) {
+        fprintf(stderr, "samples must be positive.\n");
+        return 1;
+    }
+    if (angle_spec && !*surface_path) {
+        fprintf(stderr, "angle applies only with surface=.\n");
+        return 1;
+    }
+    if (shard->sharded && !shard->out_path) {
+        fprintf(stderr, "An mc shard needs out= for its partial results.\n");
+        return 1;
+    }
+    plan->has_rho = rho_spec != NULL;
+    plan->has_against = against_spec != NULL;
+    if (mc_parse_dist(argv[3], &plan->value) != 0 || mc_parse_dist(eps_spec, &plan->eps) != 0 ||
+        (plan->has_rho && mc_parse_dist(rho_spec, &plan->rho) != 0) ||
+        (plan->has_against && mc_parse_dist(against_spec, &plan->against) != 0) ||
+        (*surface_path && mc_parse_dist(angle_spec ? angle_spec : "45", &plan->angle) != 0)) {
+        fprintf(stderr, "Bad distribution (or unreadable empirical file); see usage.\n");
+        mc_usage(argv[0]);
+        return 1;
+    }
+    shard->fingerprint = unbind_shard_fingerprint(argc, argv);
+    return 0;
+}
+
+static void mc_report(unbind_out* out, const char* label, const uint64_t* hist, uint64_t n, double mean,
+                      double lo, double hi, int scientific) {
+    unbind_out_printf(out, "         %s\n", label);
+    unbind_out_printf(out, scientific ? "           mean = %.6e\n" : "           mean = %.3f\n", mean);
+    for (size_t q = 0; q < MC_N_QUANTILES; q++) {
+        unbind_out_printf(out, scientific ? "           p%-3.0f = %.6e\n" : "           p%-3.0f = %.3f\n",
+               100.0 * mc_quantiles[q], hist_quantile(hist, n, mc_quantiles[q], lo, hi));
+    }
+}
+
+// Everything after the MC line: the inputs, then the results from every task's stats
+// (sums added in task order) and the merged histograms
+static void mc_print_results(unbind_out* out, const mc_plan* plan, const char* surface_path,
+                             const mc_task_stats* tasks, size_t n_tasks, uint64_t* const hist[MC_OUTPUTS]) {
+    uint64_t valid = 0, destroyed = 0;
+    double sum[MC_OUTPUTS] = { 0.0, 0.0 };
+    double lo[MC_OUTPUTS] = { INFINITY, INFINITY }, hi[MC_OUTPUTS] = { -INFINITY, -INFINITY };
+    for (size_t t = 0; t < n_tasks; t++) {
+        valid += tasks[t].valid;
+        destroyed += tasks[t].destroyed;
+        for (int k = 0; k < MC_OUTPUTS; k++) {
+            sum[k] += tasks[t].sum[k];
+            lo[k] = fmin(lo[k], tasks[t].min[k]);
+            hi[k] = fmax(hi[k], tasks[t].max[k]);
+        }
+    }
+
+    char desc[160];
+    const char* value_unit = plan->mode == 'm' ? "kg" : plan->mode == 'd' ? "km" : "km/s";
+    unbind_out_printf(out, "PLANET : %s (U = %.6e J)\n", unbind_planet_name(plan->planet), get_planetary_binding_energy(plan->planet));
+    unbind_out_printf(out, "MATERIAL: %s\n", unbind_material_name(plan->material));
+    mc_describe(&plan->value, desc, sizeof(desc));
+    unbind_out_printf(out, "INPUT  : %s ~ %s %s\n", plan->mode == 'm' ? "m" : plan->mode == 'd' ? "D" : "v", desc, value_unit);
+    if (plan->has_rho) {
+        mc_describe(&plan->rho, desc, sizeof(desc));
+        unbind_out_printf(out, "         rho ~ %s kg/m^3\n", desc);
+    }
+    mc_describe(&plan->eps, desc, sizeof(desc));
+    unbind_out_printf(out, "         epsilon ~ %s\n", desc);
+    if (plan->has_against) {
+        mc_describe(&plan->against, desc, sizeof(desc));
+        unbind_out_printf(out, "         %s ~ %s %s\n", plan->mode == 'v' ? "impactor diameter" : "impact speed", desc,
+               plan->mode == 'v' ? "km" : "km/s");
+    }
+    if (surface_path) {
+        mc_describe(&plan->angle, desc, sizeof(desc));
+        unbind_out_printf(out, "         entry angle ~ %s degrees (retention from %s)\n", desc, surface_path);
+    }
+    unbind_out_printf(out, "VALID  : %llu (%llu dropped: non-positive input or v >= c)\n",
+           (unsigned long long)valid, (unsigned long long)(plan->samples - valid));
+
+    if (valid > 0) {
+        double p = (double)destroyed / (double)valid;
+        double se = sqrt(p * (1.0 - p) / (double)valid);
+        unbind_out_printf(out, "RESULT :\n");
+        if (plan->mode == 'v') {
+            mc_report(out, "Minimum required mass (kg)", hist[0], valid, sum[0] / (double)valid, lo[0], hi[0], 1);
+            mc_report(out, "Minimum equivalent diameter (km)", hist[1], valid, sum[1] / (double)valid, lo[1], hi[1], 0);
+            if (plan->has_against)
+                unbind_out_printf(out, "         P(destroyed) = %.6f +/- %.6f (impactor diameter >= minimum)\n", p, se);
+        } else {
+            mc_report(out, "Required speed (relativistic) (km/s)", hist[0], valid, sum[0] / (double)valid, lo[0], hi[0], 0);
+            mc_report(out, "Required speed (classical) (km/s)", hist[1], valid, sum[1] / (double)valid, lo[1], hi[1], 1);
+            unbind_out_printf(out, "         P(destroyed) = %.6f +/- %.6f (%s)\n", p, se,
+                   plan->has_against ? "impact speed >= required speed" : "required v_rel < 0.99c");
+        }
+    }
+}
+
+int run_mc(int argc, char** argv) {
+    mc_plan plan;
+    const char* surface_path;
+    unbind_surface_file surface;
+    unbind_shard shard;
+    int threads;
+    int status = 1;
+    void* payload = NULL;
+    uint64_t payload_bytes;
+    unbind_pool* pool = NULL;
+    mc_worker* workers = NULL;
+    mc_task_stats* tasks = NULL;
+    uint64_t* hist = NULL;
+
+    memset(&surface, 0, sizeof(surface));
+    if (mc_parse_args(argc, argv, &plan, &surface_path, &threads, &shard) != 0) goto done;
+    if (surface_path) {
+        if (unbind_surface_open(surface_path, &surface) != 0) {
+            fprintf(stderr, "Cannot read retention surfaces: %s\n", surface_path);
+            goto done;
+        }
+        plan.surface = unbind_surface_find(&surface, plan.planet, plan.material);
+        if (!plan.surface) {
+            fprintf(stderr, "%s has no %s/%s table.\n", surface_path,
+                    unbind_planet_name(plan.planet), unbind_material_name(plan.material));
+            goto done;
+        }
+    }
+
+    size_t n_tasks = (size_t)((plan.samples + MC_TASK - 1) / MC_TASK);
+    int resumed = unbind_shard_start(&shard, n_tasks, &payload, &payload_bytes);
+    if (resumed < 0) goto done;
+    pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        goto done;
+    }
+    int n_threads = unbind_pool_threads(pool);
+    workers = calloc((size_t)n_threads, sizeof(mc_worker));
+    tasks = calloc(n_tasks, sizeof(mc_task_stats));
+    hist = calloc((size_t)n_threads * MC_OUTPUTS * MC_HIST_BINS, sizeof(uint64_t));
+    if (!workers || !tasks || !hist) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    for (int t = 0; t < n_threads; t++)
+        for (int k = 0; k < MC_OUTPUTS; k++)
+            workers[t].hist[k] = hist + ((size_t)t * MC_OUTPUTS + (size_t)k) * MC_HIST_BINS;
+    if (resumed) {
+        // The checkpoint's histograms go into worker 0's, its task stats into place
+        unbind_checkpoint c = { UNBIND_CHECKPOINT_MAGIC, shard.fingerprint, shard.index, shard.count,
+                                shard.begin, shard.end, shard.next, 0, payload_bytes };
+        const mc_partial* h;
+        if (!mc_unpack_check(&c, payload, &h) || mc_unpack(&c, h, tasks, n_tasks, workers[0].hist) != 0) {
+            fprintf(stderr, "Checkpoint %s is damaged.\n", shard.checkpoint_path);
+            goto done;
+        }
+        free(payload);
+        payload = NULL;
+    }
+
+    // Without checkpoint= the shard's tasks run as one job
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    mc_job job = { &plan, workers, tasks, 0 };
+    uint64_t started = shard.next;                 // the rate counts only this run's samples
+    size_t window = shard.checkpoint_path ? (size_t)n_threads * MC_WINDOW_PER_THREAD : (size_t)(shard.end - shard.next);
+    for (uint64_t t = shard.next; t < shard.end; ) {
+        size_t count = shard.end - t < window ? (size_t)(shard.end - t) : window;
+        job.base = (size_t)t;
+        unbind_pool_run(pool, count, mc_task, &job);
+        t += count;
+        if (t == shard.end || !unbind_shard_due(&shard)) continue;
+        payload = mc_pack(argc, argv, tasks, shard.begin, t, workers, n_threads, &payload_bytes);
+        if (!payload || unbind_shard_save(&shard, t, payload, payload_bytes) != 0) goto done;
+        free(payload);
+        payload = NULL;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+
+    if (shard.checkpoint_path || shard.sharded) {
+        payload = mc_pack(argc, argv, tasks, shard.begin, shard.end, workers, n_threads, &payload_bytes);
+        if (!payload || (shard.checkpoint_path && unbind_shard_save(&shard, shard.end, payload, payload_bytes) != 0))
+            goto done;
+    }
+    if (shard.sharded) {
+        // The shard's result is its final checkpoint, written to out=
+        unbind_checkpoint c = { UNBIND_CHECKPOINT_MAGIC, shard.fingerprint, shard.index, shard.count,
+                                shard.begin, shard.end, shard.end, 0, payload_bytes };
+        if (unbind_checkpoint_write(shard.out_path, &c, payload) != 0) {
+            fprintf(stderr, "Cannot write shard results: %s\n", shard.out_path);
+            goto done;
+        }
+        uint64_t first = shard.begin * MC_TASK, last = shard.end * MC_TASK < plan.samples ? shard.end * MC_TASK : plan.samples;
+        fprintf(stderr, "MC     : shard %u/%u, samples %llu-%llu of %llu, %d threads, %.3f s\n", shard.index, shard.count,
+                (unsigned long long)first, (unsigned long long)(last > first ? last - 1 : first),
+                (unsigned long long)plan.samples, n_threads, secs);
+        status = 0;
+        goto done;
+    }
+
+    // Deterministic reduction: integer histograms merged into worker 0, sums in task order
+    for (int t = 1; t < n_threads; t++)
+        for (int k = 0; k < MC_OUTPUTS; k++)
+            for (size_t b = 0; b < MC_HIST_BINS; b++) workers[0].hist[k][b] += workers[t].hist[k][b];
+    if (shard.out_path && unbind_shard_open_output(&shard, 0) != 0) goto done;
+    unbind_out* out = unbind_stdout();
+    uint64_t run_samples = plan.samples - (started * MC_TASK < plan.samples ? started * MC_TASK : plan.samples);
+    unbind_out_printf(out, "MC     : %llu samples, seed %llu, %d threads, %.3f s (%.3e samples/s)\n",
+           (unsigned long long)plan.samples, (unsigned long long)plan.seed, n_threads, secs,
+           secs > 0.0 ? (double)run_samples / secs : 0.0);
+    mc_print_results(out, &plan, surface_path, tasks, n_tasks, workers[0].hist);
+    status = unbind_out_flush(out) == 0 ? 0 : 1;
+
+done:
+    unbind_shard_close_output(&shard);
+    unbind_pool_destroy(pool);
+    free(payload);
+    free(hist);
+    free(tasks);
+    free(workers);
+    mc_free_plan(&plan);
+    unbind_surface_close(&surface);
+    return status;
+}
+
+int mc_merge(int n, char** paths) {
+    unbind_checkpoint* parts = calloc((size_t)n, sizeof(unbind_checkpoint));
+    void** payloads = calloc((size_t)n, sizeof(void*));
+    char** args = NULL;
+    mc_task_stats* tasks = NULL;
+    uint64_t* hist = calloc(MC_OUTPUTS * MC_HIST_BINS, sizeof(uint64_t));
+    unsigned char* seen = calloc((size_t)n, 1);
+    mc_plan plan;
+    unbind_shard shard;
+    const char* surface_path;
+    int threads, status = 1;
+    memset(&plan, 0, sizeof(plan));
+    if (!parts || !payloads || !hist || !seen) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+
+    const mc_partial* h0 = NULL;
+    const char* packed = NULL;
+    for (int i = 0; i < n; i++) {
+        const mc_partial* h;
+        if (unbind_checkpoint_read(paths[i], &parts[i], &payloads[i]) != 1 ||
+            !(packed = mc_unpack_check(&parts[i], payloads[i], &h))) {
+            fprintf(stderr, "%s is not an mc shard.\n", paths[i]);
+            goto done;
+        }
+        if (parts[i].n_shards != (uint32_t)n) {
+            fprintf(stderr, "%s is shard %u of %u, but %d files were given.\n", paths[i], parts[i].shard,
+                    parts[i].n_shards, n);
+            goto done;
+        }
+        if (parts[i].fingerprint != parts[0].fingerprint) {
+            fprintf(stderr, "%s is not a shard of the same run as %s.\n", paths[i], paths[0]);
+            goto done;
+        }
+        if (parts[i].next != parts[i].end) {
+            fprintf(stderr, "%s (shard %u/%u) is incomplete; resume it from its checkpoint.\n", paths[i],
+                    parts[i].shard, parts[i].n_shards);
+            goto done;
+        }
+        if (parts[i].shard >= (uint32_t)n || seen[parts[i].shard]++) {
+            fprintf(stderr, "%s repeats shard %u.\n", paths[i], parts[i].shard);
+            goto done;
+        }
+        if (i == 0) h0 = h;
+    }
+
+    // Rebuild the run's command line from the first shard
+    int argc = 1;
+    const char* p = (const char*)h0 + sizeof(*h0);
+    const char* end = p + h0->args_bytes;
+    for (const char* q = p; q < end && *q; q += strlen(q) + 1) argc++;
+    args = calloc((size_t)argc + 1, sizeof(char*));
+    if (!args) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    args[0] = "unbindEnergy";
+    for (int k = 1; k < argc; k++, p += strlen(p) + 1) args[k] = (char*)p;
+    if (argc < 2 || strcmp(args[1], "mc") != 0 || unbind_shard_fingerprint(argc, args) != parts[0].fingerprint ||
+        mc_parse_args(argc, args, &plan, &surface_path, &threads, &shard) != 0) {
+        fprintf(stderr, "%s does not hold a usable mc command line.\n", paths[0]);
+        goto done;
+    }
+
+    size_t n_tasks = (size_t)((plan.samples + MC_TASK - 1) / MC_TASK);
+    tasks = calloc(n_tasks, sizeof(mc_task_stats));
+    uint64_t* merged[MC_OUTPUTS] = { hist, hist + MC_HIST_BINS };
+    if (!tasks) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    for (int i = 0; i < n; i++) {
+        if (mc_unpack(&parts[i], payloads[i], tasks, n_tasks, merged) != 0) {
+            fprintf(stderr, "%s does not match the run's sample count.\n", paths[i]);
+            goto done;
+        }
+    }
+
+    unbind_out* out = unbind_stdout();
+    unbind_out_printf(out, "MC     : %llu samples, seed %llu, merged from %d shards\n",
+           (unsigned long long)plan.samples, (unsigned long long)plan.seed, n);
+    mc_print_results(out, &plan, surface_path, tasks, n_tasks, merged);
+    status = unbind_out_flush(out) == 0 ? 0 : 1;
+
+done:
+    if (payloads)
+        for (int i = 0; i < n; i++) free(payloads[i]);
+    free(payloads);
+    free(parts);
+    free(args);
+    free(tasks);
+    free(hist);
+    free(seen);
+    mc_free_plan(&plan);
+    return status;
+}
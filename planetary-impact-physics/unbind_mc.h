@@ -0,0 +1,46 @@
+/* unbind_mc.h
+* (C) 2025 - George McGinn - MIT License
+* Monte Carlo uncertainty propagation for unbindEnergy inputs.
+*
+* Distribution specifications:
+*   x                       constant
+*   uniform:a:b             uniform on [a, b]
+*   loguniform:a:b          log-uniform on [a, b], 0 < a < b
+*   normal:mean:sd          normal
+*   lognormal:median:sigma  log-normal; sigma is the standard deviation of ln(x)
+*   empirical:<file>        resample the numbers in a file (whitespace or comma separated)
+*/
+
+#ifndef UNBIND_MC_H
+#define UNBIND_MC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MC_DIST_CONST 0
+#define MC_DIST_UNIFORM 1
+#define MC_DIST_LOGUNIFORM 2
+#define MC_DIST_NORMAL 3
+#define MC_DIST_LOGNORMAL 4
+#define MC_DIST_EMPIRICAL 5
+
+typedef struct {
+    int kind;              // MC_DIST_*
+    double a, b;           // parameters, as written in the specification
+    double* values;        // empirical samples
+    size_t n;
+} mc_dist;
+
+int mc_parse_dist(const char* spec, mc_dist* d);   // 0 on success, -1 on bad spec or file
+void mc_free_dist(mc_dist* d);
+// out[i] = draw number first + i of dimension dim, for seed
+void mc_sample(const mc_dist* d, uint64_t seed, uint32_t dim, uint64_t first, size_t n, double* out);
+
+// mc <m|d|v> <value-dist> [rho=<dist>] [eps=<dist>] [speed=<dist>|diameter=<dist>]
+//    [planet=earth] [material=stony] [samples=1000000] [threads=0] [seed=1]
+//    [shard=i/N] [out=<file>] [checkpoint=<file>] [every=30]
+int run_mc(int argc, char** argv);
+// The report of a run from all of its shard files (see unbind_shard.h)
+int mc_merge(int n, char** paths);
+
+#endif
@@ -0,0 +1,543 @@
+/* unbind_mpcorb.c
+* (C) 2025 - George McGinn - MIT License
+* Orbit mode for unbindEnergy (see unbind_mpcorb.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy mpcorb <MPCORB.DAT|-> [planets=earth] [materials=stony] [eps=1.0] [rho=3000]
+*                         [albedo=0.14] [threads=0]
+*
+* Examples:
+*   ./unbindEnergy mpcorb MPCORB.DAT > earth_crossers.csv
+*   ./unbindEnergy mpcorb MPCORB.DAT planets=earth,mars,venus materials=stony,iron albedo=0.25
+*   gunzip -c MPCORB.DAT.gz | ./unbindEnergy mpcorb - planets=all
+*
+* Notes:
+*  - Each object's diameter comes from its absolute magnitude and the albedo= geometric
+*    albedo, D = 1329 km / sqrt(albedo) * 10^(-H/5). Objects without an H are skipped and
+*    counted. Lines that are not element records (the file's text header, its dashed rule,
+*    blank lines) are ignored.
+*  - Encounter speeds use Opik's approximation against a circular planet orbit in the
+*    ecliptic of radius MPCORB_PLANET_AU: U^2 = 3 - a_p/a - 2 sqrt((a/a_p)(1 - e^2)) cos i,
+*    v_inf = U v_p with v_p the planet's circular speed, and
+*    v_impact = sqrt(v_inf^2 + v_esc^2) with v_esc = sqrt(2GM/R) from the built-in body
+*    (unbind_registry.h). Only orbits that reach the planet's distance (q <= a_p <= Q) can
+*    hit it; the others produce no rows. The Moon is taken on Earth's orbit without
+*    Earth's gravity, and vacuum as Earth.
+*  - For every encounter and material the 'd' solver gives the retention and the speed
+*    the object would need to unbind the target at its own size (required_v_rel_km_s),
+*    and the 'v' solver the size it would need at its own impact speed
+*    (required_diameter_km). destroyed is 1 when v_impact reaches the required speed.
+*  - The file is read with read() in MPCORB_CHUNK blocks into two buffers. A block is cut
+*    at its last complete line and split into MPCORB_SLICE byte slices, each a pool task
+*    that owns the lines starting in it; a task formats its rows into its own output slot,
+*    and the slots are written in file order, so the output is the same for any thread
+*    count. The next block is read and the previous one written while a block is
+*    computed, so memory stays at two blocks and their slots whatever the file size.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_fmt.h"
+#include "unbind_proto.h"
+#include "unbind_registry.h"
+#include "unbind_mpcorb.h"
+
+#define MPCORB_CHUNK (16 << 20)       // bytes per read block
+#define MPCORB_SLICE (256 << 10)      // bytes per pool task
+#define MPCORB_SLICES (MPCORB_CHUNK / MPCORB_SLICE + 1)
+#define MPCORB_RECORD_MIN 103         // a record reaches the end of the semimajor axis
+#define MPCORB_SLICE_RECORDS (MPCORB_SLICE / MPCORB_RECORD_MIN + 1)
+#define MPCORB_ROW_MAX (16 * UNBIND_FMT_MAX)     // a row apart from its quoted name
+#define MPCORB_GM_SUN 1.32712440018e20           // m^3 s^-2
+#define MPCORB_AU 1.495978707e11                 // m
+
+// Heliocentric distance (AU) of each planet's circular orbit, by PLANET_*
+static const double MPCORB_PLANET_AU[PLANET_COUNT] = {
+    1.0, 1.5237, 0.7233, 5.2034, 9.5371, 19.1913, 30.069, 39.48, 1.0, 1.0
+};
+
+typedef struct {
+    int planets[PLANET_COUNT], n_planets;
+    int materials[MATERIAL_COUNT], n_materials;
+    double rho, epsilon;
+    double size_km;                   // 1329 / sqrt(albedo)
+    double a_p[PLANET_COUNT];         // AU, by position in planets[]
+    double v_p[PLANET_COUNT];         // km/s
+    double v_esc2[PLANET_COUNT];      // (km/s)^2
+} mpcorb_plan;
+
+typedef struct {
+    char* data;
+    size_t len, cap;
+    long records, skipped, encounters;
+    int failed;                       // out of memory while formatting
+} mpcorb_slot;
+
+// Per-worker arrays for one slice
+typedef struct {
+    const char** name;
+    int* name_len;
+    double *H, *D, *a, *e, *i;
+    int* at;                          // n_planets x records: encounter index, or -1
+    double *v_inf, *v_imp, *D_enc;    // n_planets x records, packed per planet
+    double *ret, *v_req, *D_req;      // n_planets x n_materials x records
+} mpcorb_scratch;
+
+typedef struct {
+    const mpcorb_plan* plan;
+    const char* data;
+    size_t len;                       // complete lines only
+    size_t count;                     // slices
+    mpcorb_slot* slots;
+    mpcorb_scratch* scratch;          // one per worker
+} mpcorb_job;
+
+/* ---------------------------------------------------------------------------
+ * Fixed-width fields
+ * ------------------------------------------------------------------------- */
+
+static const double pow10_exact[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+// A decimal number filling the field [s, s + width) apart from blanks. Integer digits
+// over an exact power of ten round the same way as strtod for the widths used here.
+static int parse_field(const char* s, size_t width, double* out) {
+    const char* end = s + width;
+    while (s < end && *s == ' ') s++;
+    int negative = 0;
+    if (s < end && (*s == '-' || *s == '+')) negative = *s++ == '-';
+    uint64_t mantissa = 0;
+    int digits = 0, decimals = 0, point = 0;
+    for (; s < end && *s != ' '; s++) {
+        if (*s == '.' && !point) point = 1;
+        else if (*s >= '0' && *s <= '9' && digits < 15) {
+            mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+            digits++;
+            decimals += point;
+        } else return 0;
+    }
+    while (s < end && *s == ' ') s++;
+    if (s != end || digits == 0) return 0;
+    double x = (double)mantissa / pow10_exact[decimals];
+    *out = negative ? -x : x;
+    return 1;
+}
+
+static int field_blank(const char* s, size_t width) {
+    for (size_t k = 0; k < width; k++)
+        if (s[k] != ' ') return 0;
+    return 1;
+}
+
+// Columns first..last (1-based) of a line of length len, trimmed; returns the length
+static int field_text(const char* line, size_t len, size_t first, size_t last, const char** out) {
+    if (len < first) return 0;
+    size_t b = first - 1, e = last < len ? last : len;
+    while (b < e && line[b] == ' ') b++;
+    while (e > b && line[e-1] == ' ') e--;
+    *out = line + b;
+    return (int)(e - b);
+}
+
+/* ---------------------------------------------------------------------------
+ * Tasks
+ * ------------------------------------------------------------------------- */
+
+static int slot_reserve(mpcorb_slot* s, size_t need) {
+    if (s->cap >= need) return 0;
+    size_t cap = s->cap ? s->cap : MPCORB_SLICE;
+    while (cap < need) cap *= 2;
+    char* p = realloc(s->data, cap);
+    if (!p) return -1;
+    s->data = p;
+    s->cap = cap;
+    return 0;
+}
+
+static char* put_quoted(char* p, const char* s, int len) {
+    *p++ = '"';
+    for (int k = 0; k < len; k++) {
+        if (s[k] == '"') *p++ = '"';
+        *p++ = s[k];
+    }
+    *p++ = '"';
+    return p;
+}
+
+// Parse the records of one slice into the worker's arrays; returns their number
+static size_t parse_slice(const mpcorb_job* job, size_t task, mpcorb_scratch* w, mpcorb_slot* slot) {
+    const char* data = job->data;
+    size_t pos = task * MPCORB_SLICE;
+    size_t stop = pos + MPCORB_SLICE < job->len ? pos + MPCORB_SLICE : job->len;
+    if (pos > 0 && data[pos-1] != '\n') {
+        const char* nl = memchr(data + pos, '\n', job->len - pos);
+        pos = nl ? (size_t)(nl - data) + 1 : job->len;
+    }
+
+    size_t n = 0;
+    while (pos < stop) {
+        const char* line = data + pos;
+        const char* nl = memchr(line, '\n', job->len - pos);
+        size_t len = nl ? (size_t)(nl - line) : job->len - pos;
+        pos += len + 1;
+        if (len && line[len-1] == '\r') len--;
+
+        double M, i, e, a, H;
+        if (len < MPCORB_RECORD_MIN || !parse_field(line + 26, 9, &M) || !parse_field(line + 59, 9, &i) ||
+            !parse_field(line + 70, 9, &e) || !parse_field(line + 92, 11, &a))
+            continue;
+        if (field_blank(line + 8, 5)) {
+            slot->skipped++;
+            continue;
+        }
+        if (!parse_field(line + 8, 5, &H)) continue;
+
+        int name_len = field_text(line, len, 167, 194, &w->name[n]);
+        if (name_len == 0) name_len = field_text(line, len, 1, 7, &w->name[n]);
+        w->name_len[n] = name_len;
+        w->H[n] = H;
+        w->D[n] = job->plan->size_km * pow(10.0, -0.2 * H);
+        w->a[n] = a;
+        w->e[n] = e;
+        w->i[n] = i;
+        n++;
+    }
+    return n;
+}
+
+static void mpcorb_task(void* ctx, size_t task, int worker) {
+    const mpcorb_job* job = ctx;
+    const mpcorb_plan* plan = job->plan;
+    mpcorb_scratch* w = &job->scratch[worker];
+    mpcorb_slot* slot = &job->slots[task];
+    slot->len = 0;
+    slot->records = slot->skipped = slot->encounters = 0;
+    slot->failed = 0;
+
+    size_t n = parse_slice(job, task, w, slot);
+    slot->records = (long)n;
+    const size_t R = MPCORB_SLICE_RECORDS;
+
+    // Encounters and solves, one planet at a time
+    size_t rows = 0, name_bytes = 0;
+    for (int ip = 0; ip < plan->n_planets; ip++) {
+        double a_p = plan->a_p[ip];
+        int* at = w->at + (size_t)ip * R;
+        double* v_inf = w->v_inf + (size_t)ip * R;
+        double* v_imp = w->v_imp + (size_t)ip * R;
+        double* D_enc = w->D_enc + (size_t)ip * R;
+        size_t m = 0;
+        for (size_t k = 0; k < n; k++) {
+            double a = w->a[k], e = w->e[k];
+            at[k] = -1;
+            if (!(a > 0.0) || !(e >= 0.0 && e < 1.0) || a * (1.0 - e) > a_p || a * (1.0 + e) < a_p) continue;
+            double U2 = 3.0 - a_p / a - 2.0 * sqrt(a / a_p * (1.0 - e * e)) * cos(w->i[k] * UNBIND_PI / 180.0);
+            double v = U2 > 0.0 ? sqrt(U2) * plan->v_p[ip] : 0.0;
+            at[k] = (int)m;
+            v_inf[m] = v;
+            v_imp[m] = sqrt(v * v + plan->v_esc2[ip]);
+            D_enc[m] = w->D[k];
+            name_bytes += 2 * (size_t)w->name_len[k];
+            m++;
+        }
+        rows += m;
+        if (m == 0) continue;
+        for (int im = 0; im < plan->n_materials; im++) {
+            size_t pair = (size_t)(ip * plan->n_materials + im) * R;
+            unbind_soa_input in;
+            memset(&in, 0, sizeof(in));
+            in.planet = plan->planets[ip];
+            in.material = plan->materials[im];
+            in.rho = plan->rho;
+            in.epsilon = plan->epsilon;
+            in.n = m;
+            unbind_soa_result res;
+            memset(&res, 0, sizeof(res));
+            in.mode = UNBIND_MODE_DIAMETER;
+            in.value = D_enc;
+            res.retention = w->ret + pair;
+            res.v_rel = w->v_req + pair;
+            unbind_solve_soa(&in, &res);
+            memset(&res, 0, sizeof(res));
+            in.mode = UNBIND_MODE_SPEED;
+            in.value = v_imp;
+            res.D_km = w->D_req + pair;
+            unbind_solve_soa(&in, &res);
+        }
+    }
+    slot->encounters = (long)rows;
+    if (slot_reserve(slot, (size_t)plan->n_materials * (rows * MPCORB_ROW_MAX + name_bytes)) != 0) {
+        slot->failed = 1;
+        return;
+    }
+
+    // Rows in file order: each object, then its planets and materials
+    char* p = slot->data;
+    for (size_t k = 0; k < n; k++) {
+        for (int ip = 0; ip < plan->n_planets; ip++) {
+            int j = w->at[(size_t)ip * R + k];
+            if (j < 0) continue;
+            double v_imp = w->v_imp[(size_t)ip * R + (size_t)j];
+            for (int im = 0; im < plan->n_materials; im++) {
+                size_t at = (size_t)(ip * plan->n_materials + im) * R + (size_t)j;
+                p = put_quoted(p, w->name[k], w->name_len[k]);
+                *p++ = ',';
+                p = unbind_fmt_str(p, unbind_planet_name(plan->planets[ip]));
+                *p++ = ',';
+                p = unbind_fmt_str(p, unbind_material_name(plan->materials[im]));
+                *p++ = ',';
+                p = unbind_fmt_f(p, w->H[k], 2);
+                *p++ = ',';
+                p = unbind_fmt_e(p, w->D[k], 6);
+                *p++ = ',';
+                p = unbind_fmt_f(p, w->a[k], 7);
+                *p++ = ',';
+                p = unbind_fmt_f(p, w->e[k], 7);
+                *p++ = ',';
+                p = unbind_fmt_f(p, w->i[k], 5);
+                *p++ = ',';
+                p = unbind_fmt_e(p, w->v_inf[(size_t)ip * R + (size_t)j], 6);
+                *p++ = ',';
+                p = unbind_fmt_e(p, v_imp, 6);
+                *p++ = ',';
+                p = unbind_fmt_f(p, w->ret[at], 3);
+                *p++ = ',';
+                p = unbind_fmt_e(p, w->D_req[at], 6);
+                *p++ = ',';
+                p = unbind_fmt_e(p, w->v_req[at] / 1000.0, 6);
+                *p++ = ',';
+                *p++ = v_imp * 1000.0 >= w->v_req[at] ? '1' : '0';
+                *p++ = '\n';
+            }
+        }
+    }
+    slot->len = (size_t)(p - slot->data);
+}
+
+/* ---------------------------------------------------------------------------
+ * Driver
+ * ------------------------------------------------------------------------- */
+
+static int scratch_alloc(mpcorb_scratch* w, int n_planets, int n_materials) {
+    const size_t R = MPCORB_SLICE_RECORDS;
+    size_t pairs = (size_t)(n_planets * n_materials);
+    memset(w, 0, sizeof(*w));
+    w->name = malloc(R * sizeof(*w->name));
+    w->name_len = malloc(R * sizeof(int));
+    w->H = malloc(5 * R * sizeof(double));
+    w->at = malloc((size_t)n_planets * R * sizeof(int));
+    w->v_inf = malloc(((size_t)n_planets * 3 + pairs * 3) * R * sizeof(double));
+    if (!w->name || !w->name_len || !w->H || !w->at || !w->v_inf) return -1;
+    w->D = w->H + R;
+    w->a = w->D + R;
+    w->e = w->a + R;
+    w->i = w->e + R;
+    w->v_imp = w->v_inf + (size_t)n_planets * R;
+    w->D_enc = w->v_imp + (size_t)n_planets * R;
+    w->ret = w->D_enc + (size_t)n_planets * R;
+    w->v_req = w->ret + pairs * R;
+    w->D_req = w->v_req + pairs * R;
+    return 0;
+}
+
+static void scratch_free(mpcorb_scratch* w) {
+    free(w->name); free(w->name_len); free(w->H); free(w->at); free(w->v_inf);
+}
+
+// Fill buf[have..cap) from fd; sets *eof at end of input. Returns the new length, or -1.
+static long read_block(int fd, char* buf, size_t have, size_t cap, int* eof) {
+    while (have < cap) {
+        ssize_t k = read(fd, buf + have, cap - have);
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0) return -1;
+        if (k == 0) {
+            *eof = 1;
+            break;
+        }
+        have += (size_t)k;
+    }
+    return (long)have;
+}
+
+static int write_job(const mpcorb_job* job, unbind_out* out, long totals[3]) {
+    for (size_t t = 0; t < job->count; t++) {
+        const mpcorb_slot* s = &job->slots[t];
+        if (s->failed) return -1;
+        unbind_out_write(out, s->data, s->len);
+        totals[0] += s->records;
+        totals[1] += s->skipped;
+        totals[2] += s->encounters;
+    }
+    return out->error ? -1 : 0;
+}
+
+static int mpcorb_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s mpcorb <MPCORB.DAT|-> [planets=earth] [materials=stony] [eps=1.0] [rho=3000]\n"
+        "          [albedo=0.14] [threads=0]\n", prog);
+    return 1;
+}
+
+int run_mpcorb(int argc, char** argv) {
+    static const char header[] =
+        "name,planet,material,H,diameter_km,a_au,e,i_deg,v_inf_km_s,v_impact_km_s,retention,"
+        "required_diameter_km,required_v_rel_km_s,destroyed\n";
+    const char* planet_spec = "earth";
+    const char* material_spec = "stony";
+    double albedo = 0.14;
+    int threads = 0;
+    mpcorb_plan plan;
+    memset(&plan, 0, sizeof(plan));
+    plan.rho = UNBIND_DEFAULT_DENSITY;
+    plan.epsilon = 1.0;
+
+    if (argc < 3) return mpcorb_usage(argv[0]);
+    for (int i = 3; i < argc; i++) {
+        if (strncmp(argv[i], "planets=", 8) == 0) planet_spec = argv[i] + 8;
+        else if (strncmp(argv[i], "materials=", 10) == 0) material_spec = argv[i] + 10;
+        else if (strncmp(argv[i], "eps=", 4) == 0) plan.epsilon = strtod(argv[i] + 4, NULL);
+        else if (strncmp(argv[i], "rho=", 4) == 0) plan.rho = strtod(argv[i] + 4, NULL);
+        else if (strncmp(argv[i], "albedo=", 7) == 0) albedo = strtod(argv[i] + 7, NULL);
+        else if (strncmp(argv[i], "threads=", 8) == 0) threads = atoi(argv[i] + 8);
+        else {
+            fprintf(stderr, "Unknown mpcorb option: %s\n", argv[i]);
+            return mpcorb_usage(argv[0]);
+        }
+    }
+    plan.n_planets = unbind_parse_planet_list(planet_spec, plan.planets, PLANET_COUNT);
+    plan.n_materials = unbind_parse_material_list(material_spec, plan.materials, MATERIAL_COUNT);
+    if (plan.n_planets < 0 || plan.n_materials < 0) {
+        fprintf(stderr, "Planets/materials must be comma-separated names or 'all'.\n");
+        return 1;
+    }
+    if (!(plan.epsilon > 0.0) || !(plan.rho > 0.0) || !(albedo > 0.0 && albedo <= 1.0)) {
+        fprintf(stderr, "eps and rho must be positive and albedo in (0, 1].\n");
+        return 1;
+    }
+    plan.size_km = 1329.0 / sqrt(albedo);
+
+    unbind_registry* reg = unbind_registry_builtin();
+    if (!reg) {
+        fprintf(stderr, "Out of memory.\n");
+        return 1;
+    }
+    for (int ip = 0; ip < plan.n_planets; ip++) {
+        int planet = plan.planets[ip];
+        const unbind_body* b = unbind_registry_body(reg, planet == PLANET_VACUUM ? PLANET_EARTH : (size_t)planet);
+        plan.a_p[ip] = MPCORB_PLANET_AU[planet];
+        plan.v_p[ip] = sqrt(MPCORB_GM_SUN / (plan.a_p[ip] * MPCORB_AU)) / 1000.0;
+        plan.v_esc2[ip] = 2.0 * UNBIND_GRAVITATIONAL_CONSTANT * b->mass / b->radius / 1e6;
+    }
+    unbind_registry_free(reg);
+
+    int fd = strcmp(argv[2], "-") == 0 ? STDIN_FILENO : open(argv[2], O_RDONLY);
+    char* blocks[2] = { malloc(MPCORB_CHUNK), malloc(MPCORB_CHUNK) };
+    mpcorb_slot* slots = calloc(2 * MPCORB_SLICES, sizeof(mpcorb_slot));
+    mpcorb_scratch* scratch = NULL;
+    unbind_pool* pool = NULL;
+    int n_threads = 0, status = 1;
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open orbit file: %s\n", argv[2]);
+        goto done;
+    }
+    pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        goto done;
+    }
+    n_threads = unbind_pool_threads(pool);
+    scratch = calloc((size_t)n_threads, sizeof(mpcorb_scratch));
+    if (!blocks[0] || !blocks[1] || !slots || !scratch) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    for (int t = 0; t < n_threads; t++) {
+        if (scratch_alloc(&scratch[t], plan.n_planets, plan.n_materials) != 0) {
+            fprintf(stderr, "Out of memory.\n");
+            goto done;
+        }
+    }
+    mpcorb_job jobs[2];
+    for (int k = 0; k < 2; k++) {
+        jobs[k].plan = &plan;
+        jobs[k].slots = slots + (size_t)k * MPCORB_SLICES;
+        jobs[k].scratch = scratch;
+        jobs[k].count = 0;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    unbind_out* out = unbind_stdout();
+    unbind_out_write(out, header, sizeof(header) - 1);
+    long totals[3] = { 0, 0, 0 };
+    int eof = 0, write_error = 0;
+    long have = read_block(fd, blocks[0], 0, MPCORB_CHUNK, &eof);
+
+    // Compute block k while block k-1 is written and block k+1 is read
+    status = 0;
+    size_t k = 0;
+    while (have > 0 && status == 0) {
+        mpcorb_job* job = &jobs[k % 2];
+        const char* data = blocks[k % 2];
+        size_t len = (size_t)have;
+        if (!eof) {
+            const char* nl = data + len;
+            while (nl > data && nl[-1] != '\n') nl--;
+            if (nl == data) {
+                fprintf(stderr, "Orbit file line longer than %d bytes.\n", MPCORB_CHUNK);
+                status = 1;
+                break;
+            }
+            len = (size_t)(nl - data);
+        }
+        job->data = data;
+        job->len = len;
+        job->count = (len + MPCORB_SLICE - 1) / MPCORB_SLICE;
+        unbind_pool_submit(pool, job->count, mpcorb_task, job);
+        if (k > 0 && write_job(&jobs[(k - 1) % 2], out, totals) != 0) write_error = status = 1;
+        char* next = blocks[(k + 1) % 2];
+        size_t tail = (size_t)have - len;
+        memcpy(next, data + len, tail);
+        have = eof ? (long)tail : read_block(fd, next, tail, MPCORB_CHUNK, &eof);
+        unbind_pool_wait(pool);
+        k++;
+    }
+    if (status == 0 && k > 0 && write_job(&jobs[(k - 1) % 2], out, totals) != 0) write_error = 1;
+    if (have < 0) {
+        fprintf(stderr, "Error reading orbit file: %s\n", argv[2]);
+        status = 1;
+    }
+    if (unbind_out_flush(out) != 0) write_error = 1;
+    if (write_error) {
+        fprintf(stderr, "Error writing orbit output.\n");
+        status = 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+    fprintf(stderr, "MPCORB : %ld objects (%ld without H skipped), %ld encounters x %d materials on %d threads in %.3f s\n",
+            totals[0], totals[1], totals[2], plan.n_materials, n_threads, secs);
+
+done:
+    unbind_pool_destroy(pool);
+    if (scratch)
+        for (int t = 0; t < n_threads; t++) scratch_free(&scratch[t]);
+    free(scratch);
+    if (slots)
+        for (size_t t = 0; t < 2 * MPCORB_SLICES; t++) free(slots[t].data);
+    free(slots);
+    free(blocks[0]); free(blocks[1]);
+    if (fd > STDIN_FILENO) close(fd);
+    return status;
+}
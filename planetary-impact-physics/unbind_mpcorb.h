@@ -0,0 +1,22 @@
+/* unbind_mpcorb.h
+* (C) 2025 - George McGinn - MIT License
+* Orbit mode for unbindEnergy: impact speeds from the orbital elements of an MPCORB.DAT
+* file (the Minor Planet Center's fixed-width export format), fed to the 'd' and 'v'
+* solvers for every object whose orbit crosses a target planet's.
+*
+* Fields read (1-based columns of MPCORB.DAT):
+*   9-13    H, absolute magnitude (objects without one are skipped)
+*   60-68   i, inclination to the ecliptic (degrees)
+*   71-79   e, eccentricity
+*   93-103  a, semimajor axis (AU)
+*   167-194 readable designation (the packed one in 1-7 when absent)
+*/
+
+#ifndef UNBIND_MPCORB_H
+#define UNBIND_MPCORB_H
+
+// mpcorb <MPCORB.DAT|-> [planets=earth] [materials=stony] [eps=1.0] [rho=3000] [albedo=0.14]
+//        [threads=0]
+int run_mpcorb(int argc, char** argv);
+
+#endif
@@ -0,0 +1,372 @@
+/* unbind_pairs.c
+* (C) 2025 - George McGinn - MIT License
+* All-pairs impactor x target mode for unbindEnergy (see unbind_pairs.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy pairs <catalog.csv> [targets=catalog|planets|<bodies file>] [material=stony] [eps=1.0]
+*                        [out=<file>] [threads=0]
+*
+* Examples:
+*   ./unbindEnergy pairs "Space Bodies (unbindEnergy).csv"
+*   ./unbindEnergy pairs asteroids.csv targets=exoplanets.csv eps=0.25 out=pairs.mat
+*
+* Notes:
+*  - Impactors are the catalog rows with a mass or a diameter (mass at 3000 kg/m^3) and
+*    are evaluated like batch 'm' rows, so each cell is that row's v_rel_km_s. Below
+*    PAIRS_CLASSICAL_BELOW the classical speed is stored instead: there gamma - 1 is lost
+*    to rounding (v_rel would print as 0) while the two agree to better than 1e-8.
+*  - targets=catalog (the default) uses the catalog rows with both a mass and a diameter,
+*    with U = (3/5)GM^2/R; rows named like a built-in planet take that planet's U and
+*    atmosphere, others are airless. targets=planets uses the built-in planets and any
+*    other value is a bodies file (unbind_registry.h).
+*  - Without out= the matrix is printed as CSV (one row per impactor), for small runs.
+*    With out= it is written straight into a memory-mapped file of the layout above.
+*  - Work is cut into tiles of PAIRS_TILE_I impactors. A tile runs the SIMD kernels
+*    (unbind_solve_soa) once per target into PAIRS_TILE_J x PAIRS_TILE_I scratch blocks
+*    that stay in cache, then transposes it into PAIRS_TILE_J consecutive matrix
+*    columns of each impactor row. Tiles are independent, so the result does not depend
+*    on the thread count.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_fmt.h"
+#include "unbind_proto.h"
+#include "unbind_catalog.h"
+#include "unbind_registry.h"
+#include "unbind_pairs.h"
+
+#define PAIRS_TILE_I 256              // impactors per task
+#define PAIRS_TILE_J 32               // targets per scratch block
+#define PAIRS_CLASSICAL_BELOW (1e-4 * UNBIND_SPEED_OF_LIGHT)   // m/s
+#define PAIRS_MAX_LINE (1 << 16)
+#define PAIRS_MAX_FIELDS 32
+
+// One side of the product: names, catalog rows, and the per-side values
+typedef struct {
+    char (*name)[PAIRS_NAME];
+    long* row;                        // catalog data row, -1 if not from the catalog
+    double* m;                        // impactors: mass (kg)
+    double* U;                        // targets: binding energy (J)
+    int* atmosphere;                  // targets: PLANET_*
+    size_t n, cap;
+} pairs_set;
+
+typedef struct {
+    const pairs_set* imp;
+    const pairs_set* tgt;
+    int material;
+    double epsilon;
+    double* matrix;                   // imp->n x tgt->n
+    double* scratch;                  // 2 x PAIRS_TILE_J x PAIRS_TILE_I per worker
+} pairs_job;
+
+static int set_push(pairs_set* s, const char* name, long row, double m, double U, int atmosphere) {
+    if (s->n == s->cap) {
+        size_t cap = s->cap ? 2 * s->cap : 1024;
+        void* p[5] = { realloc(s->name, cap * PAIRS_NAME), realloc(s->row, cap * sizeof(long)),
+                       realloc(s->m, cap * sizeof(double)), realloc(s->U, cap * sizeof(double)),
+                       realloc(s->atmosphere, cap * sizeof(int)) };
+        if (p[0]) s->name = p[0];
+        if (p[1]) s->row = p[1];
+        if (p[2]) s->m = p[2];
+        if (p[3]) s->U = p[3];
+        if (p[4]) s->atmosphere = p[4];
+        if (!p[0] || !p[1] || !p[2] || !p[3] || !p[4]) return -1;
+        s->cap = cap;
+    }
+    memset(s->name[s->n], 0, PAIRS_NAME);
+    strncpy(s->name[s->n], name, PAIRS_NAME - 1);
+    s->row[s->n] = row;
+    s->m[s->n] = m;
+    s->U[s->n] = U;
+    s->atmosphere[s->n] = atmosphere;
+    s->n++;
+    return 0;
+}
+
+static void set_free(pairs_set* s) {
+    free(s->name); free(s->row); free(s->m); free(s->U); free(s->atmosphere);
+    memset(s, 0, sizeof(*s));
+}
+
+// Read the catalog into the impactor set and, when catalog_targets, the target set
+static int load_catalog(const char* path, pairs_set* imp, pairs_set* tgt, int catalog_targets,
+                        const unbind_registry* planets) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Cannot open catalog: %s\n", path);
+        return -1;
+    }
+    char* line = malloc(PAIRS_MAX_LINE);
+    unbind_catalog_columns col;
+    unbind_catalog_default_columns(&col);
+    long lines = 0, rows = 0;
+    int status = line ? 0 : -1;
+    while (status == 0 && fgets(line, PAIRS_MAX_LINE, fp)) {
+        size_t len = strlen(line);
+        lines++;
+        if (len == PAIRS_MAX_LINE - 1 && line[len-1] != '\n') {
+            fprintf(stderr, "Catalog line %ld too long.\n", lines);
+            status = -2;
+            break;
+        }
+        while (len && (line[len-1] == '\n' || line[len-1] == '\r')) line[--len] = '\0';
+        if (len == 0) continue;
+        char* fields[PAIRS_MAX_FIELDS];
+        int n = unbind_split_csv(line, fields, PAIRS_MAX_FIELDS);
+        int header = lines == 1 ? unbind_catalog_header(fields, n, &col) : 0;
+        if (header < 0) {
+            fprintf(stderr, "Catalog header names neither a mass nor a diameter column.\n");
+            status = -2;
+            break;
+        }
+        if (header) continue;
+        unbind_catalog_row r;
+        if (!unbind_catalog_row_parse(fields, n, &col, &r)) continue;
+        rows++;
+
+        double R = r.D_km * 500.0;
+        double volume = (4.0/3.0) * UNBIND_PI * R * R * R;
+        if ((r.has_m || r.has_d) &&
+            set_push(imp, r.name, rows - 1, r.has_m ? r.m : UNBIND_DEFAULT_DENSITY * volume, 0.0, 0) != 0)
+            status = -1;
+        if (catalog_targets && r.has_m && r.has_d) {
+            int builtin = unbind_registry_find(planets, r.name);
+            const unbind_body* b = builtin >= 0 ? unbind_registry_body(planets, (size_t)builtin) : NULL;
+            double U = b ? b->U : 0.6 * UNBIND_GRAVITATIONAL_CONSTANT * r.m * r.m / R;
+            if (set_push(tgt, r.name, rows - 1, r.m, U, b ? b->atmosphere : PLANET_VACUUM) != 0) status = -1;
+        }
+    }
+    if (status == -1) fprintf(stderr, "Out of memory.\n");
+    else if (status == 0 && ferror(fp)) {
+        fprintf(stderr, "Error reading catalog: %s\n", path);
+        status = -1;
+    }
+    free(line);
+    fclose(fp);
+    return status;
+}
+
+static void pairs_task(void* ctx, size_t task, int worker) {
+    const pairs_job* job = ctx;
+    const pairs_set* imp = job->imp;
+    const pairs_set* tgt = job->tgt;
+    double (*v_rel)[PAIRS_TILE_I] = (double (*)[PAIRS_TILE_I])(job->scratch +
+                                     (size_t)worker * 2 * PAIRS_TILE_J * PAIRS_TILE_I);
+    double (*v_class)[PAIRS_TILE_I] = v_rel + PAIRS_TILE_J;
+    size_t i0 = task * PAIRS_TILE_I;
+    size_t ni = imp->n - i0 < PAIRS_TILE_I ? imp->n - i0 : PAIRS_TILE_I;
+
+    unbind_soa_input in;
+    memset(&in, 0, sizeof(in));
+    in.mode = UNBIND_MODE_MASS;
+    in.material = job->material;
+    in.epsilon = job->epsilon;
+    in.value = imp->m + i0;
+    in.n = ni;
+    unbind_soa_result res;
+    memset(&res, 0, sizeof(res));
+
+    for (size_t j0 = 0; j0 < tgt->n; j0 += PAIRS_TILE_J) {
+        size_t nj = tgt->n - j0 < PAIRS_TILE_J ? tgt->n - j0 : PAIRS_TILE_J;
+        for (size_t jj = 0; jj < nj; jj++) {
+            in.planet = tgt->atmosphere[j0 + jj];
+            in.U = tgt->U[j0 + jj];
+            res.v_rel = v_rel[jj];
+            res.v_class = v_class[jj];
+            unbind_solve_soa(&in, &res);
+        }
+        for (size_t ii = 0; ii < ni; ii++) {
+            double* dst = job->matrix + (i0 + ii) * tgt->n + j0;
+            long row = imp->row[i0 + ii];
+            for (size_t jj = 0; jj < nj; jj++) {
+                double v = v_class[jj][ii] < PAIRS_CLASSICAL_BELOW ? v_class[jj][ii] : v_rel[jj][ii];
+                dst[jj] = row >= 0 && row == tgt->row[j0 + jj] ? NAN : v / 1000.0;
+            }
+        }
+    }
+}
+
+static char* put_quoted(char* p, const char* s) {
+    *p++ = '"';
+    for (; *s; s++) {
+        if (*s == '"') *p++ = '"';
+        *p++ = *s;
+    }
+    *p++ = '"';
+    return p;
+}
+
+static int print_matrix(const pairs_job* job) {
+    unbind_out* out = unbind_stdout();
+    char* p = unbind_out_reserve(out, 16);
+    unbind_out_advance(out, unbind_fmt_str(p, "impactor"));
+    for (size_t j = 0; j < job->tgt->n; j++) {
+        p = unbind_out_reserve(out, 2 * PAIRS_NAME + 4);
+        *p++ = ',';
+        unbind_out_advance(out, put_quoted(p, job->tgt->name[j]));
+    }
+    for (size_t i = 0; i < job->imp->n; i++) {
+        p = unbind_out_reserve(out, 2 * PAIRS_NAME + 4);
+        *p++ = '\n';
+        unbind_out_advance(out, put_quoted(p, job->imp->name[i]));
+        const double* v = job->matrix + i * job->tgt->n;
+        for (size_t j = 0; j < job->tgt->n; j++) {
+            p = unbind_out_reserve(out, UNBIND_FMT_MAX + 1);
+            *p++ = ',';
+            unbind_out_advance(out, isnan(v[j]) ? p : unbind_fmt_e(p, v[j], 6));
+        }
+    }
+    p = unbind_out_reserve(out, 1);
+    *p++ = '\n';
+    unbind_out_advance(out, p);
+    return unbind_out_flush(out);
+}
+
+// Size the output file, map it and fill in the header and names
+static unsigned char* map_output(const char* path, const pairs_job* job, size_t* size) {
+    pairs_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, PAIRS_MAGIC, sizeof(h.magic));
+    h.version = PAIRS_VERSION;
+    h.endian = PAIRS_ENDIAN;
+    h.n_impactors = job->imp->n;
+    h.n_targets = job->tgt->n;
+    h.material = (uint32_t)job->material;
+    h.name_bytes = PAIRS_NAME;
+    h.epsilon = job->epsilon;
+    h.names_offset = sizeof(h);
+    size_t names = (job->imp->n + job->tgt->n) * PAIRS_NAME;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    h.matrix_offset = (sizeof(h) + names + page - 1) / page * page;
+    *size = (size_t)h.matrix_offset + job->imp->n * job->tgt->n * sizeof(double);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return NULL;
+    void* map = MAP_FAILED;
+    if (ftruncate(fd, (off_t)*size) == 0)
+        map = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    unsigned char* base = map;
+    memcpy(base, &h, sizeof(h));
+    memcpy(base + h.names_offset, job->imp->name, job->imp->n * PAIRS_NAME);
+    memcpy(base + h.names_offset + job->imp->n * PAIRS_NAME, job->tgt->name, job->tgt->n * PAIRS_NAME);
+    return base;
+}
+
+static int pairs_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s pairs <catalog.csv> [targets=catalog|planets|<bodies file>] [material=stony] [eps=1.0]\n"
+        "          [out=<file>] [threads=0]\n", prog);
+    return 1;
+}
+
+int run_pairs(int argc, char** argv) {
+    const char* targets = "catalog";
+    const char* material_name = "stony";
+    const char* out_path = NULL;
+    double epsilon = 1.0;
+    int threads = 0;
+
+    if (argc < 3) return pairs_usage(argv[0]);
+    for (int i = 3; i < argc; i++) {
+        if (strncmp(argv[i], "targets=", 8) == 0) targets = argv[i] + 8;
+        else if (strncmp(argv[i], "material=", 9) == 0) material_name = argv[i] + 9;
+        else if (strncmp(argv[i], "eps=", 4) == 0) epsilon = atof(argv[i] + 4);
+        else if (strncmp(argv[i], "out=", 4) == 0) out_path = argv[i] + 4;
+        else if (strncmp(argv[i], "threads=", 8) == 0) threads = atoi(argv[i] + 8);
+        else {
+            fprintf(stderr, "Unknown pairs option: %s\n", argv[i]);
+            return pairs_usage(argv[0]);
+        }
+    }
+    int material = unbind_lookup_material(material_name);
+    if (material < 0 || !(epsilon > 0.0)) {
+        fprintf(stderr, "material must be stony, iron or cometary and eps positive.\n");
+        return 1;
+    }
+
+    int catalog_targets = strcasecmp(targets, "catalog") == 0;
+    unbind_registry* reg = unbind_registry_open(catalog_targets || strcasecmp(targets, "planets") == 0
+                                                ? NULL : targets);
+    if (!reg) return 1;
+    pairs_set imp, tgt;
+    memset(&imp, 0, sizeof(imp));
+    memset(&tgt, 0, sizeof(tgt));
+    int status = 1;
+    if (load_catalog(argv[2], &imp, &tgt, catalog_targets, reg) != 0) goto done;
+    if (!catalog_targets) {
+        for (size_t j = 0; j < unbind_registry_count(reg); j++) {
+            const unbind_body* b = unbind_registry_body(reg, j);
+            if (set_push(&tgt, b->name, -1, b->mass, b->U, b->atmosphere) != 0) {
+                fprintf(stderr, "Out of memory.\n");
+                goto done;
+            }
+        }
+    }
+    if (imp.n == 0 || tgt.n == 0) {
+        fprintf(stderr, "No impactors or no targets (targets need a mass and a diameter).\n");
+        goto done;
+    }
+
+    pairs_job job = { &imp, &tgt, material, epsilon, NULL, NULL };
+    unsigned char* map = NULL;
+    size_t map_size = 0;
+    if (out_path) {
+        map = map_output(out_path, &job, &map_size);
+        if (!map) {
+            fprintf(stderr, "Cannot write matrix file: %s\n", out_path);
+            goto done;
+        }
+        job.matrix = (double*)(map + ((const pairs_header*)map)->matrix_offset);
+    } else if (!(job.matrix = malloc(imp.n * tgt.n * sizeof(double)))) {
+        fprintf(stderr, "Out of memory (use out=<file> for large matrices).\n");
+        goto done;
+    }
+
+    unbind_pool* pool = unbind_pool_create(threads);
+    int n_threads = pool ? unbind_pool_threads(pool) : 0;
+    job.scratch = pool ? malloc((size_t)n_threads * 2 * PAIRS_TILE_J * PAIRS_TILE_I * sizeof(double)) : NULL;
+    if (!job.scratch) {
+        fprintf(stderr, pool ? "Out of memory.\n" : "Cannot start worker threads.\n");
+    } else {
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        unbind_pool_run(pool, (imp.n + PAIRS_TILE_I - 1) / PAIRS_TILE_I, pairs_task, &job);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+        double n_pairs = (double)imp.n * (double)tgt.n;
+        status = 0;
+        if (map) {
+            if (munmap(map, map_size) != 0) status = 1;
+            map = NULL;
+        } else if (print_matrix(&job) != 0) {
+            status = 1;
+        }
+        if (status != 0) fprintf(stderr, "Error writing pairs output.\n");
+        fprintf(stderr, "PAIRS  : %zu impactors x %zu targets = %.0f pairs on %d threads in %.3f s (%.3e pairs/s)\n",
+                imp.n, tgt.n, n_pairs, n_threads, secs, secs > 0.0 ? n_pairs / secs : 0.0);
+    }
+    free(job.scratch);
+    if (pool) unbind_pool_destroy(pool);
+    if (map) munmap(map, map_size);
+    else if (!out_path) free(job.matrix);
+
+done:
+    set_free(&imp);
+    set_free(&tgt);
+    unbind_registry_free(reg);
+    return status;
+}
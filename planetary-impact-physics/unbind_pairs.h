@@ -0,0 +1,44 @@
+/* unbind_pairs.h
+* (C) 2025 - George McGinn - MIT License
+* All-pairs mode for unbindEnergy: the required relativistic speed for every impactor
+* of a catalog hitting every target body.
+*
+* Matrix file (out=<file>; native little-endian):
+*   pairs_header                     64 bytes
+*   names                            (n_impactors + n_targets) x PAIRS_NAME bytes, NUL-padded,
+*                                    impactors first
+*   matrix at matrix_offset          n_impactors x n_targets doubles, one row per impactor:
+*                                    v_rel (km/s) needed to unbind the target, NaN for an
+*                                    impactor paired with itself
+* For example, in numpy:
+*   v = np.memmap(path, dtype='<f8', mode='r', offset=h.matrix_offset, shape=(n_imp, n_tgt))
+*/
+
+#ifndef UNBIND_PAIRS_H
+#define UNBIND_PAIRS_H
+
+#include <stdint.h>
+
+#define PAIRS_MAGIC "UNBPAIR"              // 8 bytes with the NUL
+#define PAIRS_VERSION 1
+#define PAIRS_ENDIAN 0x01020304u
+#define PAIRS_NAME 48
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;                       // PAIRS_ENDIAN as written
+    uint64_t n_impactors;
+    uint64_t n_targets;
+    uint32_t material;                     // MATERIAL_*
+    uint32_t name_bytes;                   // PAIRS_NAME
+    double   epsilon;
+    uint64_t names_offset;
+    uint64_t matrix_offset;                // page aligned
+} pairs_header;
+
+// pairs <catalog.csv> [targets=catalog|planets|<bodies file>] [material=stony] [eps=1.0]
+//       [out=<file>] [threads=0]
+int run_pairs(int argc, char** argv);
+
+#endif
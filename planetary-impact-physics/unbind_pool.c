@@ -0,0 +1,196 @@
+/* unbind_pool.c
+* (C) 2025 - George McGinn - MIT License
+* Work-stealing thread pool (see unbind_pool.h).
+* Build: gcc -O2 -pthread -c unbind_pool.c
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "unbind_pool.h"
+
+// One worker's slice of the current job: lo in the low 32 bits, hi in the high 32 bits.
+// Padded to a cache line so owners and thieves do not false-share neighbouring slices.
+typedef struct {
+    _Atomic uint64_t range;
+    char pad[64 - sizeof(uint64_t)];
+} worker_slice;
+
+typedef struct {
+    unbind_pool* pool;
+    int id;
+} worker_arg;
+
+struct unbind_pool {
+    int n_threads;
+    pthread_t* threads;
+    worker_arg* args;
+    worker_slice* slices;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;       // workers wait here for the next job
+    pthread_cond_t done_cv;       // unbind_pool_wait() waits here
+    unsigned long generation;     // bumped by every submit
+    int shutdown;
+    int active;                   // workers still inside the current job
+
+    unbind_task_fn fn;
+    void* ctx;
+};
+
+static inline uint64_t pack(uint32_t lo, uint32_t hi) { return ((uint64_t)hi << 32) | lo; }
+static inline uint32_t range_lo(uint64_t r) { return (uint32_t)r; }
+static inline uint32_t range_hi(uint64_t r) { return (uint32_t)(r >> 32); }
+
+// Take the next task from the front of our own slice; -1 when it is empty
+static int64_t pop_own(worker_slice* s) {
+    uint64_t r = atomic_load(&s->range);
+    for (;;) {
+        uint32_t lo = range_lo(r), hi = range_hi(r);
+        if (lo >= hi) return -1;
+        if (atomic_compare_exchange_weak(&s->range, &r, pack(lo + 1, hi))) return lo;
+    }
+}
+
+// Steal the back half of some other worker's slice. The first stolen task is
+// returned and the rest becomes our own slice. -1 when every slice is empty.
+static int64_t steal(unbind_pool* pool, int self) {
+    for (int k = 1; k < pool->n_threads; k++) {
+        worker_slice* victim = &pool->slices[(self + k) % pool->n_threads];
+        uint64_t r = atomic_load(&victim->range);
+        for (;;) {
+            uint32_t lo = range_lo(r), hi = range_hi(r);
+            if (lo >= hi) break;
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &r, pack(lo, mid))) {
+                atomic_store(&pool->slices[self].range, pack(mid + 1, hi));
+                return mid;
+            }
+        }
+    }
+    return -1;
+}
+
+static void* worker_main(void* p) {
+    worker_arg* arg = p;
+    unbind_pool* pool = arg->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->work_cv, &pool->lock);
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        unbind_task_fn fn = pool->fn;
+        void* ctx = pool->ctx;
+        pthread_mutex_unlock(&pool->lock);
+
+        int64_t task;
+        while ((task = pop_own(&pool->slices[arg->id])) >= 0 || (task = steal(pool, arg->id)) >= 0) {
+            fn(ctx, (size_t)task, arg->id);
+        }
+
+        // Out of work: report idle so wait() knows no worker still holds this job's fn/ctx
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0) pthread_cond_broadcast(&pool->done_cv);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+unbind_pool* unbind_pool_create(int n_threads) {
+    if (n_threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        n_threads = cpus > 0 ? (int)cpus : 1;
+    }
+    unbind_pool* pool = calloc(1, sizeof(*pool));
+    if (!pool) return NULL;
+    pool->n_threads = n_threads;
+    pool->threads = calloc((size_t)n_threads, sizeof(pthread_t));
+    pool->args = calloc((size_t)n_threads, sizeof(worker_arg));
+    if (posix_memalign((void**)&pool->slices, 64, (size_t)n_threads * sizeof(worker_slice)) != 0)
+        pool->slices = NULL;
+    if (!pool->threads || !pool->args || !pool->slices) {
+        free(pool->threads); free(pool->args); free(pool->slices); free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+
+    for (int i = 0; i < n_threads; i++) {
+        atomic_init(&pool->slices[i].range, 0);
+        pool->args[i].pool = pool;
+        pool->args[i].id = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->args[i]) != 0) {
+            pool->n_threads = i;     // destroy only the threads that started
+            unbind_pool_destroy(pool);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+int unbind_pool_threads(const unbind_pool* pool) {
+    return pool->n_threads;
+}
+
+// Start a job: task slices are dealt out contiguously, one per worker.
+// Returns 0, or -1 if the previous job has not been waited for or n_tasks is too large.
+int unbind_pool_submit(unbind_pool* pool, size_t n_tasks, unbind_task_fn fn, void* ctx) {
+    if (n_tasks > UINT32_MAX) return -1;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->active > 0) {
+        pthread_mutex_unlock(&pool->lock);
+        return -1;
+    }
+    for (int i = 0; i < pool->n_threads; i++) {
+        uint32_t lo = (uint32_t)(n_tasks * (size_t)i / (size_t)pool->n_threads);
+        uint32_t hi = (uint32_t)(n_tasks * (size_t)(i + 1) / (size_t)pool->n_threads);
+        atomic_store(&pool->slices[i].range, pack(lo, hi));
+    }
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->active = pool->n_threads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+// Block until every task of the current job has finished and all workers are idle
+void unbind_pool_wait(unbind_pool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active > 0)
+        pthread_cond_wait(&pool->done_cv, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int unbind_pool_run(unbind_pool* pool, size_t n_tasks, unbind_task_fn fn, void* ctx) {
+    if (unbind_pool_submit(pool, n_tasks, fn, ctx) != 0) return -1;
+    unbind_pool_wait(pool);
+    return 0;
+}
+
+void unbind_pool_destroy(unbind_pool* pool) {
+    if (!pool) return;
+    unbind_pool_wait(pool);
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 0; i < pool->n_threads; i++)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cv);
+    pthread_cond_destroy(&pool->done_cv);
+    free(pool->threads);
+    free(pool->args);
+    free(pool->slices);
+    free(pool);
+}
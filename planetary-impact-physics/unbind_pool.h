@@ -0,0 +1,35 @@
+/* unbind_pool.h
+* (C) 2025 - George McGinn - MIT License
+* Fixed-size work-stealing thread pool used by the sweep, Monte Carlo and grid modes.
+* Build: add unbind_pool.c to the program's gcc line and link with -pthread.
+*
+* Notes:
+*  - A job is n independent tasks numbered 0..n-1. Each worker starts with a contiguous
+*    slice of the task range and takes tasks from the front of it; a worker whose slice
+*    is empty steals the back half of another worker's slice. Slices are packed
+*    (lo, hi) pairs updated with compare-and-swap, so there are no locks on the task path.
+*  - Tasks finish in no particular order. Callers that need deterministic output write
+*    each task's result to its own slot and emit the slots in task order (see unbind_sweep.c).
+*  - unbind_pool_submit() returns at once so the caller can do other work (for example
+*    write out the previous job's results) before unbind_pool_wait().
+*  - A job may have at most UINT32_MAX tasks.
+*/
+
+#ifndef UNBIND_POOL_H
+#define UNBIND_POOL_H
+
+#include <stddef.h>
+
+// Task callback: ctx as passed to submit, the task number, and the worker (0..threads-1)
+typedef void (*unbind_task_fn)(void* ctx, size_t task, int worker);
+
+typedef struct unbind_pool unbind_pool;
+
+unbind_pool* unbind_pool_create(int n_threads);   // n_threads <= 0: one per online CPU
+int unbind_pool_threads(const unbind_pool* pool);
+int unbind_pool_submit(unbind_pool* pool, size_t n_tasks, unbind_task_fn fn, void* ctx);
+void unbind_pool_wait(unbind_pool* pool);
+int unbind_pool_run(unbind_pool* pool, size_t n_tasks, unbind_task_fn fn, void* ctx);
+void unbind_pool_destroy(unbind_pool* pool);
+
+#endif
@@ -0,0 +1,150 @@
+/* unbind_proto.c
+* (C) 2025 - George McGinn - MIT License
+* Request/response lines for the server and stream modes (see unbind_proto.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "libunbind.h"
+#include "unbind_fmt.h"
+#include "unbind_proto.h"
+
+int unbind_split_csv(char* line, char** fields, int max_fields) {
+    int n = 0;
+    char* p = line;
+    while (n < max_fields) {
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '"') {
+            char* out = ++p;
+            fields[n++] = out;
+            while (*p) {
+                if (*p == '"') {
+                    if (p[1] == '"') { *out++ = '"'; p += 2; continue; }
+                    p++;
+                    break;
+                }
+                *out++ = *p++;
+            }
+            while (*p && *p != ',') p++;   // skip trailing spaces after the quote
+            int more = (*p == ',');
+            *out = '\0';
+            if (!more) break;
+            p++;
+        } else {
+            fields[n++] = p;
+            char* comma = strchr(p, ',');
+            char* end = comma ? comma : p + strlen(p);
+            while (end > p && (end[-1] == ' ' || end[-1] == '\t')) end--;
+            if (!comma) { *end = '\0'; break; }
+            *end = '\0';
+            p = comma + 1;
+        }
+    }
+    return n;
+}
+
+static size_t put_error(char* out, int code, const char* message) {
+    char* p = unbind_fmt_str(out, "err,");
+    p = unbind_fmt_int(p, code);
+    *p++ = ',';
+    p = unbind_fmt_str(p, message);
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+// Optional numeric field: missing or empty keeps *value. Returns 0, or -1 if not a number.
+static int field_number(char** fields, int n, int i, double* value) {
+    if (i >= n || fields[i][0] == '\0') return 0;
+    char* end;
+    double x = strtod(fields[i], &end);
+    if (*end != '\0') return -1;
+    *value = x;
+    return 0;
+}
+
+static size_t handle_dose(char** fields, int n, char* out) {
+    unbind_dose_input in;
+    unbind_dose_result r;
+    unbind_dose_defaults(&in);
+    double* slots[] = { &in.E, &in.eta, &in.d, &in.A, &in.M, &in.f, &in.theta_deg, &in.atmos_trans };
+    for (int i = 0; i < (int)(sizeof(slots) / sizeof(slots[0])); i++)
+        if (field_number(fields, n, i + 1, slots[i]) != 0) return put_error(out, UNBIND_ERR_INPUT, "bad number");
+    unbind_dose(&in, &r);
+    char* p = unbind_fmt_str(out, "ok,dose,");
+    p = unbind_fmt_e(p, r.fluence, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r.dose_upper, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r.dose_lower, 6);
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+static size_t handle_energy(char** fields, int n, char* out) {
+    unbind_input in;
+    unbind_result r;
+    unbind_input_defaults(&in);
+    in.mode = fields[0][0];
+    if (fields[0][1] != '\0') return put_error(out, UNBIND_ERR_MODE, "unknown request");
+    in.value = 0.0;
+    if (field_number(fields, n, 1, &in.value) != 0 || field_number(fields, n, 2, &in.rho) != 0 ||
+        field_number(fields, n, 3, &in.epsilon) != 0)
+        return put_error(out, UNBIND_ERR_INPUT, "bad number");
+    const char* name = n > 4 ? fields[4] : "";
+    if (n > 5 && fields[5][0] && (in.planet = unbind_lookup_planet(fields[5])) < 0)
+        return put_error(out, UNBIND_ERR_INPUT, "unknown planet");
+    if (n > 6 && fields[6][0] && (in.material = unbind_lookup_material(fields[6])) < 0)
+        return put_error(out, UNBIND_ERR_INPUT, "unknown material");
+    if (in.mode == UNBIND_MODE_MASS) in.rho = UNBIND_DEFAULT_DENSITY;
+
+    int status = unbind_solve(&in, &r);
+    if (status == UNBIND_ERR_INPUT) return put_error(out, status, "inputs must be positive");
+    if (status == UNBIND_ERR_SPEED) return put_error(out, status, "speed must be < c");
+    if (status != UNBIND_OK) return put_error(out, status, "unknown request");
+
+    // ok,<mode>,"name" with the name quoted and bounded
+    char* p = unbind_fmt_str(out, "ok,");
+    *p++ = in.mode;
+    *p++ = ',';
+    *p++ = '"';
+    for (size_t i = 0; name[i] && i < PROTO_MAX_NAME; i++) {
+        if (name[i] == '"') *p++ = '"';
+        *p++ = name[i];
+    }
+    *p++ = '"';
+    *p++ = ',';
+    p = unbind_fmt_str(p, unbind_planet_name(in.planet));
+    *p++ = ',';
+    p = unbind_fmt_str(p, unbind_material_name(in.material));
+    *p++ = ',';
+    p = unbind_fmt_g(p, in.epsilon, 6);
+    *p++ = ',';
+    p = unbind_fmt_g(p, in.rho, 6);
+    *p++ = ',';
+    p = unbind_fmt_f(p, r.retention, 3);
+    *p++ = ',';
+    p = unbind_fmt_g(p, r.effective_eps, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r.m, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r.D/1000.0, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r.v_class/1000.0, 6);
+    *p++ = ',';
+    p = unbind_fmt_e(p, r.v_rel/1000.0, 6);
+    *p++ = ',';
+    *p++ = (char)('0' + (r.destroyed != 0));
+    *p++ = '\n';
+    return (size_t)(p - out);
+}
+
+size_t proto_handle_line(char* line, char* out) {
+    char* fields[PROTO_MAX_FIELDS];
+    size_t len = strlen(line);
+    if (len && line[len-1] == '\r') line[--len] = '\0';
+    int n = unbind_split_csv(line, fields, PROTO_MAX_FIELDS);
+    if (n == 0 || fields[0][0] == '\0') return put_error(out, UNBIND_ERR_MODE, "empty request");
+    if (strcmp(fields[0], "dose") == 0) return handle_dose(fields, n, out);
+    return handle_energy(fields, n, out);
+}
@@ -0,0 +1,32 @@
+/* unbind_proto.h
+* (C) 2025 - George McGinn - MIT License
+* One-line request/response protocol shared by the server and stream modes.
+*
+* Requests (CSV, one per line; empty or missing trailing fields take the CLI defaults):
+*   <m|d|v>,value,rho,epsilon,name,planet,material
+*   dose,E,eta,d,A,M,f,theta_deg,atmos_trans
+* Responses (one line per request, in request order):
+*   ok,<mode>,"name",planet,material,epsilon,rho_kg_m3,retention,eps_eff,mass_kg,diameter_km,
+*      v_class_km_s,v_rel_km_s,destroyed          (same columns as batch mode)
+*   ok,dose,fluence_J_m2,dose_upper_Gy,dose_lower_Gy
+*   err,<code>,<message>                           (code is an UNBIND_ERR_* status)
+*/
+
+#ifndef UNBIND_PROTO_H
+#define UNBIND_PROTO_H
+
+#include <stddef.h>
+
+#define PROTO_MAX_FIELDS 16
+#define PROTO_MAX_NAME 128         // longer names are truncated in the response
+#define PROTO_MAX_RESPONSE 512     // upper bound on one response line, newline included
+
+// Split one CSV line in place; handles quoted fields and "" escapes. Returns the field count.
+int unbind_split_csv(char* line, char** fields, int max_fields);
+
+// Evaluate one request (NUL-terminated, modified in place) and write the response line,
+// newline included, to out (at least PROTO_MAX_RESPONSE bytes). Returns its length.
+// Performs no allocation and no I/O.
+size_t proto_handle_line(char* line, char* out);
+
+#endif
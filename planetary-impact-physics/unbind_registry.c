@@ -0,0 +1,355 @@
+/* unbind_registry.c
+* (C) 2025 - George McGinn - MIT License
+* Target-body registry (see unbind_registry.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Notes:
+*  - Slots hold the 32-bit FNV-1a hash of the lower-cased name and the body index + 1
+*    (0 marks an empty slot). A probe compares hashes first, so a lookup normally does a
+*    single strcasecmp().
+*  - The table has at least twice as many slots as bodies (a power of two), which keeps
+*    probe sequences short for any registry size.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <stdint.h>
+#include "libunbind.h"
+#include "unbind_proto.h"
+#include "unbind_registry.h"
+
+#define REGISTRY_MAX_LINE 4096
+#define REGISTRY_MAX_FIELDS 16
+
+typedef struct {
+    uint32_t hash;
+    uint32_t index;        // body index + 1, 0 if empty
+} registry_slot;
+
+struct unbind_registry {
+    unbind_body* bodies;
+    size_t n, cap;
+    registry_slot* slots;
+    size_t mask;           // slot count - 1
+};
+
+// Mass (kg) and mean radius (km) of the built-in planets; vacuum uses Earth's
+static const double builtin_body[PLANET_COUNT][2] = {
+    { 5.972e24, 6371.0 },  { 6.417e23, 3389.5 },  { 4.867e24, 6051.8 },  { 1.898e27, 69911.0 },
+    { 5.683e26, 58232.0 }, { 8.681e25, 25362.0 }, { 1.024e26, 24622.0 }, { 1.303e22, 1188.3 },
+    { 7.342e22, 1737.4 },  { 5.972e24, 6371.0 }
+};
+
+static uint32_t name_hash(const char* s) {
+    uint32_t h = 2166136261u;
+    for (; *s; s++) {
+        h ^= (uint32_t)tolower((unsigned char)*s);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Slot holding name, or the empty slot where it would go
+static registry_slot* find_slot(const unbind_registry* r, const char* name, uint32_t h) {
+    for (size_t i = h & r->mask;; i = (i + 1) & r->mask) {
+        registry_slot* s = &r->slots[i];
+        if (s->index == 0) return s;
+        if (s->hash == h && strcasecmp(r->bodies[s->index - 1].name, name) == 0) return s;
+    }
+}
+
+static unbind_registry* registry_new(void) {
+    unbind_registry* r = calloc(1, sizeof(*r));
+    if (!r) return NULL;
+    r->cap = 16;
+    r->bodies = malloc(r->cap * sizeof(unbind_body));
+    if (!r->bodies) {
+        free(r);
+        return NULL;
+    }
+    return r;
+}
+
+// Append a body (duplicates are caught by build_index); returns -1 if out of memory
+static int registry_add(unbind_registry* r, const unbind_body* b) {
+    if (r->n == r->cap) {
+        unbind_body* grown = realloc(r->bodies, 2 * r->cap * sizeof(unbind_body));
+        if (!grown) return -1;
+        r->bodies = grown;
+        r->cap *= 2;
+    }
+    r->bodies[r->n++] = *b;
+    return 0;
+}
+
+// Build the hash table; returns -1 on a duplicate name or allocation failure
+static int build_index(unbind_registry* r, long* duplicate) {
+    size_t size = 16;
+    while (size < 2 * r->n) size *= 2;
+    r->slots = calloc(size, sizeof(registry_slot));
+    if (!r->slots) return -1;
+    r->mask = size - 1;
+    for (size_t i = 0; i < r->n; i++) {
+        uint32_t h = name_hash(r->bodies[i].name);
+        registry_slot* s = find_slot(r, r->bodies[i].name, h);
+        if (s->index != 0) {
+            *duplicate = (long)i;
+            return -1;
+        }
+        s->hash = h;
+        s->index = (uint32_t)i + 1;
+    }
+    return 0;
+}
+
+unbind_registry* unbind_registry_builtin(void) {
+    unbind_registry* r = registry_new();
+    if (!r) return NULL;
+    long dummy;
+    for (int i = 0; i < PLANET_COUNT; i++) {
+        unbind_body b;
+        memset(&b, 0, sizeof(b));
+        snprintf(b.name, sizeof(b.name), "%s", unbind_planet_name(i));
+        b.mass = builtin_body[i][0];
+        b.radius = builtin_body[i][1] * 1000.0;
+        b.U = get_planetary_binding_energy(i);
+        b.atmosphere = i;
+        if (registry_add(r, &b) != 0) {
+            unbind_registry_free(r);
+            return NULL;
+        }
+    }
+    if (build_index(r, &dummy) != 0) {
+        unbind_registry_free(r);
+        return NULL;
+    }
+    return r;
+}
+
+// Registry number: thousands separators dropped; placeholders ("—", "-", "") are missing.
+// Returns 1 with *value set for a positive number, 0 if missing, -1 if malformed.
+static int parse_number(const char* field, double* value) {
+    char buf[64];
+    size_t n = 0;
+    for (const char* p = field; *p; p++) {
+        if (*p == ',' || *p == ' ') continue;
+        if (n == sizeof(buf) - 1) return -1;
+        buf[n++] = *p;
+    }
+    buf[n] = '\0';
+    if (n == 0 || strcmp(buf, "-") == 0 || strcmp(buf, "—") == 0 || strcasecmp(buf, "n/a") == 0) return 0;
+    char* end;
+    double x = strtod(buf, &end);
+    if (*end != '\0' || !(x > 0.0)) return -1;
+    *value = x;
+    return 1;
+}
+
+typedef struct {
+    int name, mass, radius, U, atmosphere;     // field index, -1 if the file has no such column
+} registry_columns;
+
+// A line is a header when it names a column and holds no number. The header's columns
+// replace the positional ones; those it leaves out are absent. Returns 1 for a header,
+// 0 for a data line, -1 for a header without Name or without both U and Mass + Radius.
+static int read_header(char** fields, int n, registry_columns* col) {
+    registry_columns h = { -1, -1, -1, -1, -1 };
+    int named = 0;
+    for (int i = 0; i < n; i++) {
+        double x;
+        if (parse_number(fields[i], &x) > 0) return 0;
+        if (strncasecmp(fields[i], "name", 4) == 0) h.name = i;
+        else if (strncasecmp(fields[i], "mass", 4) == 0) h.mass = i;
+        else if (strncasecmp(fields[i], "radius", 6) == 0) h.radius = i;
+        else if (strncasecmp(fields[i], "binding", 7) == 0 || strcasecmp(fields[i], "U") == 0) h.U = i;
+        else if (strncasecmp(fields[i], "atmos", 5) == 0) h.atmosphere = i;
+        else continue;
+        named = 1;
+    }
+    if (!named) return 0;
+    if (h.name < 0 || (h.U < 0 && (h.mass < 0 || h.radius < 0))) return -1;
+    *col = h;
+    return 1;
+}
+
+// Field of a column, or NULL when the file or this line has none
+static const char* column_field(char** fields, int n, int column) {
+    return column >= 0 && column < n ? fields[column] : NULL;
+}
+
+// Parse one body line; returns 0, or -1 if it is malformed
+static int parse_body(char** fields, int n, const registry_columns* col, unbind_body* b) {
+    memset(b, 0, sizeof(*b));
+    if (col->name >= n || fields[col->name][0] == '\0' || strlen(fields[col->name]) >= sizeof(b->name))
+        return -1;
+    strcpy(b->name, fields[col->name]);
+
+    double mass = 0.0, radius_km = 0.0, U = 0.0;
+    const char* f_mass = column_field(fields, n, col->mass);
+    const char* f_radius = column_field(fields, n, col->radius);
+    const char* f_U = column_field(fields, n, col->U);
+    const char* f_atmosphere = column_field(fields, n, col->atmosphere);
+    int has_mass = f_mass ? parse_number(f_mass, &mass) : 0;
+    int has_radius = f_radius ? parse_number(f_radius, &radius_km) : 0;
+    int has_U = f_U ? parse_number(f_U, &U) : 0;
+    if (has_mass < 0 || has_radius < 0 || has_U < 0) return -1;
+    if (!has_U) {
+        if (!has_mass || !has_radius) return -1;
+        U = 0.6 * UNBIND_GRAVITATIONAL_CONSTANT * mass * mass / (radius_km * 1000.0);
+    }
+    b->mass = mass;
+    b->radius = radius_km * 1000.0;
+    b->U = U;
+
+    b->atmosphere = PLANET_VACUUM;
+    if (f_atmosphere && f_atmosphere[0] != '\0') {
+        b->atmosphere = unbind_lookup_planet(f_atmosphere);
+        if (b->atmosphere < 0) return -1;
+    }
+    return 0;
+}
+
+unbind_registry* unbind_registry_load(const char* path, long* bad_line) {
+    *bad_line = 0;
+    FILE* fp = fopen(path, "r");
+    if (!fp) return NULL;
+    unbind_registry* r = registry_new();
+    char* line = malloc(REGISTRY_MAX_LINE);
+    if (!r || !line) {
+        free(line);
+        unbind_registry_free(r);
+        fclose(fp);
+        return NULL;
+    }
+
+    registry_columns col = { 0, 1, 2, 3, 4 };
+    long* line_of = NULL;                  // line number of each body, for duplicate reports
+    size_t line_cap = 0;
+    long lineno = 0;
+    int ok = 1, have_header = 0;
+    while (ok && fgets(line, REGISTRY_MAX_LINE, fp)) {
+        lineno++;
+        size_t len = strlen(line);
+        if (len == REGISTRY_MAX_LINE - 1 && line[len-1] != '\n') { ok = 0; break; }
+        while (len && (line[len-1] == '\n' || line[len-1] == '\r')) line[--len] = '\0';
+        const char* s = line;
+        while (*s == ' ' || *s == '\t') s++;
+        if (*s == '\0' || *s == '#') continue;
+
+        char* fields[REGISTRY_MAX_FIELDS];
+        int n = unbind_split_csv(line, fields, REGISTRY_MAX_FIELDS);
+        if (r->n == 0 && !have_header) {
+            int header = read_header(fields, n, &col);
+            if (header < 0) { ok = 0; break; }
+            have_header = header;
+            if (header) continue;
+        }
+        unbind_body b;
+        if (parse_body(fields, n, &col, &b) != 0) { ok = 0; break; }
+        if (r->n == line_cap) {
+            line_cap = line_cap ? 2 * line_cap : 64;
+            long* grown = realloc(line_of, line_cap * sizeof(long));
+            if (!grown) { lineno = 0; ok = 0; break; }
+            line_of = grown;
+        }
+        line_of[r->n] = lineno;
+        if (registry_add(r, &b) != 0) { lineno = 0; ok = 0; break; }
+    }
+    if (ok && ferror(fp)) { lineno = 0; ok = 0; }
+    if (ok && r->n == 0) { lineno = 0; ok = 0; }
+    long duplicate = -1;
+    if (ok && build_index(r, &duplicate) != 0) {
+        lineno = duplicate >= 0 ? line_of[duplicate] : 0;
+        ok = 0;
+    }
+    free(line_of);
+    free(line);
+    fclose(fp);
+    if (!ok) {
+        *bad_line = lineno;
+        unbind_registry_free(r);
+        return NULL;
+    }
+    return r;
+}
+
+unbind_registry* unbind_registry_open(const char* path) {
+    if (!path) {
+        unbind_registry* r = unbind_registry_builtin();
+        if (!r) fprintf(stderr, "Out of memory.\n");
+        return r;
+    }
+    long bad_line;
+    unbind_registry* r = unbind_registry_load(path, &bad_line);
+    if (!r && bad_line > 0) fprintf(stderr, "Bad or duplicate body on line %ld of %s.\n", bad_line, path);
+    else if (!r) fprintf(stderr, "Cannot read bodies file: %s\n", path);
+    return r;
+}
+
+void unbind_registry_free(unbind_registry* r) {
+    if (!r) return;
+    free(r->bodies);
+    free(r->slots);
+    free(r);
+}
+
+size_t unbind_registry_count(const unbind_registry* r) {
+    return r->n;
+}
+
+const unbind_body* unbind_registry_body(const unbind_registry* r, size_t i) {
+    return i < r->n ? &r->bodies[i] : NULL;
+}
+
+const char* unbind_registry_name(const unbind_registry* r, size_t i) {
+    return i < r->n ? r->bodies[i].name : "unknown";
+}
+
+int unbind_registry_find(const unbind_registry* r, const char* name) {
+    if (!name) return -1;
+    const registry_slot* s = find_slot(r, name, name_hash(name));
+    return s->index ? (int)s->index - 1 : -1;
+}
+
+int unbind_registry_parse_list(const unbind_registry* r, const char* list, int** out) {
+    *out = NULL;
+    if (!list) return -1;
+    size_t cap = r->n;
+    if (strcasecmp(list, "all") != 0) {
+        cap = 1;
+        for (const char* p = list; *p; p++) cap += (*p == ',');
+    }
+    int* idx = malloc(cap * sizeof(int));
+    if (!idx) return -1;
+    int n = 0;
+    if (strcasecmp(list, "all") == 0) {
+        for (size_t i = 0; i < r->n; i++) idx[n++] = (int)i;
+    } else {
+        char name[UNBIND_BODY_NAME];
+        while (*list) {
+            size_t len = strcspn(list, ",");
+            int i = -1;
+            if (len > 0 && len < sizeof(name)) {
+                memcpy(name, list, len);
+                name[len] = '\0';
+                i = unbind_registry_find(r, name);
+            }
+            if (i < 0) {
+                free(idx);
+                return -1;
+            }
+            idx[n++] = i;
+            list += len;
+            if (*list == ',') list++;
+        }
+    }
+    if (n == 0) {
+        free(idx);
+        return -1;
+    }
+    *out = idx;
+    return n;
+}
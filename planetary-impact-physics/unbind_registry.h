@@ -0,0 +1,60 @@
+/* unbind_registry.h
+* (C) 2025 - George McGinn - MIT License
+* Target-body registry for unbindEnergy: the ten built-in planets, or any number of
+* bodies (moons, dwarf planets, exoplanets) loaded from a CSV data file.
+*
+* File format (one body per line, like "Target Bodies (unbindEnergy).csv"):
+*   "Name","Mass (kg)","Radius (km)","Binding Energy (J)","Atmosphere"
+*   - Columns are matched by header name when a header row is present, otherwise positional.
+*     A header must name Name and either the binding energy or both Mass and Radius; columns
+*     it leaves out are absent.
+*   - The binding energy may be left as a placeholder ("—", "-" or empty); it is then
+*     computed once at load time as U = (3/5) G M^2 / R (uniform sphere).
+*   - Atmosphere names the built-in planet whose retention profile applies (earth, mars,
+*     venus, jupiter, saturn, uranus, neptune, pluto, moon, vacuum); empty means vacuum.
+*   - Blank lines and lines starting with '#' are ignored. Names are unique, ignoring case.
+*
+* Notes:
+*  - Lookup is one hash of the case-folded name into an open-addressing table (linear
+*    probing, at most half full), so it costs the same for ten bodies or a million.
+*  - A registry is never modified after it is built; any number of threads may use one
+*    at the same time.
+*/
+
+#ifndef UNBIND_REGISTRY_H
+#define UNBIND_REGISTRY_H
+
+#include <stddef.h>
+
+#define UNBIND_BODY_NAME 48                // longest name, NUL included
+#define UNBIND_GRAVITATIONAL_CONSTANT 6.674e-11   // m^3 kg^-1 s^-2
+
+typedef struct {
+    char   name[UNBIND_BODY_NAME];
+    double mass;           // kg (0 if the file gave only U)
+    double radius;         // m  (0 if the file gave only U)
+    double U;              // gravitational binding energy (J)
+    int    atmosphere;     // PLANET_* retention profile
+} unbind_body;
+
+typedef struct unbind_registry unbind_registry;
+
+// Built-in planets; body i is PLANET_i with U = get_planetary_binding_energy(i)
+unbind_registry* unbind_registry_builtin(void);
+// Load a data file. On error returns NULL and sets *bad_line to the offending line
+// (0 if the file could not be read or memory ran out).
+unbind_registry* unbind_registry_load(const char* path, long* bad_line);
+// Command-line helper: the file given by bodies=, or the built-in planets when path is
+// NULL. Prints the reason to stderr and returns NULL on failure.
+unbind_registry* unbind_registry_open(const char* path);
+void unbind_registry_free(unbind_registry* r);
+
+size_t unbind_registry_count(const unbind_registry* r);
+const unbind_body* unbind_registry_body(const unbind_registry* r, size_t i);   // NULL if out of range
+const char* unbind_registry_name(const unbind_registry* r, size_t i);          // "unknown" if out of range
+int unbind_registry_find(const unbind_registry* r, const char* name);          // index, or -1
+// "all" or comma-separated names. Stores a malloc'd index array in *out and returns its
+// length, or returns -1 for an unknown name or an empty list.
+int unbind_registry_parse_list(const unbind_registry* r, const char* list, int** out);
+
+#endif
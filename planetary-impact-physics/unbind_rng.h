@@ -0,0 +1,87 @@
+/* unbind_rng.h
+* (C) 2025 - George McGinn - MIT License
+* Counter-based random numbers (Philox4x32-10, Salmon et al., SC'11) for the Monte Carlo modes.
+*
+* Notes:
+*  - A draw is a pure function of (key, counter): there is no generator state to seed,
+*    share or advance. Callers put the sample number and the input dimension in the
+*    counter, so every sample has its own independent stream and results do not depend
+*    on how samples are split across threads.
+*  - unbind_rng_stream walks one counter instead, for callers that draw an unknown number of
+*    uniforms per sample (photon histories): a stream per task, keyed by the task number,
+*    keeps the results independent of the thread count as long as the tasks are.
+*  - Header-only; every function is static inline.
+*/
+
+#ifndef UNBIND_RNG_H
+#define UNBIND_RNG_H
+
+#include <stdint.h>
+
+#define UNBIND_PHILOX_M0 0xD2511F53u
+#define UNBIND_PHILOX_M1 0xCD9E8D57u
+#define UNBIND_PHILOX_W0 0x9E3779B9u       // key schedule (golden ratio)
+#define UNBIND_PHILOX_W1 0xBB67AE85u       // key schedule (sqrt(3) - 1)
+
+// out = Philox4x32-10(ctr, key)
+static inline void unbind_philox(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)UNBIND_PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)UNBIND_PHILOX_M1 * c2;
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+        k0 += UNBIND_PHILOX_W0;
+        k1 += UNBIND_PHILOX_W1;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// Uniform double in the open interval (0, 1) from 64 random bits (53 used)
+static inline double unbind_u01(uint32_t hi, uint32_t lo) {
+    uint64_t bits = ((uint64_t)hi << 32 | lo) >> 11;
+    return ((double)bits + 0.5) * 0x1.0p-53;
+}
+
+// Two uniforms in (0, 1) for draw (index, stream) under a 64-bit seed
+static inline void unbind_rng_u01x2(uint64_t seed, uint64_t index, uint32_t stream, double* u1, double* u2) {
+    uint32_t ctr[4] = { (uint32_t)index, (uint32_t)(index >> 32), stream, 0 };
+    uint32_t key[2] = { (uint32_t)seed, (uint32_t)(seed >> 32) };
+    uint32_t r[4];
+    unbind_philox(ctr, key, r);
+    *u1 = unbind_u01(r[0], r[1]);
+    *u2 = unbind_u01(r[2], r[3]);
+}
+
+// Stream of uniforms Philox(seed; n, stream) for n = 0, 1, ..., two to a block
+typedef struct {
+    uint32_t key[2];
+    uint32_t ctr[4];
+    uint32_t block[4];
+    int left;                          // uniforms left in block
+} unbind_rng_stream;
+
+static inline void unbind_rng_stream_init(unbind_rng_stream* s, uint64_t seed, uint64_t stream) {
+    s->key[0] = (uint32_t)seed;
+    s->key[1] = (uint32_t)(seed >> 32);
+    s->ctr[0] = s->ctr[1] = 0;
+    s->ctr[2] = (uint32_t)stream;
+    s->ctr[3] = (uint32_t)(stream >> 32);
+    s->left = 0;
+}
+
+// Next uniform in (0, 1)
+static inline double unbind_rng_next(unbind_rng_stream* s) {
+    if (s->left == 0) {
+        unbind_philox(s->ctr, s->key, s->block);
+        if (++s->ctr[0] == 0) s->ctr[1]++;
+        s->left = 2;
+    }
+    s->left--;
+    return unbind_u01(s->block[2 * s->left], s->block[2 * s->left + 1]);
+}
+
+#endif
@@ -0,0 +1,416 @@
+/* unbind_server.c
+* (C) 2025 - George McGinn - MIT License
+* Query server mode for unbindEnergy (see unbind_server.h). Linux (epoll).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy serve unix:/tmp/unbind.sock [threads=0]
+*   ./unbindEnergy serve tcp:7878 [threads=0]          (binds 127.0.0.1 only)
+*
+* Example session (one request per line, see unbind_proto.h):
+*   $ printf 'd,0.375,2000,0.25,Apophis,earth,stony\ndose,,,,,,,,0.1\nstats\n' | nc -U /tmp/unbind.sock
+*   ok,d,"Apophis",earth,stony,0.25,2000,0.900,0.225,5.522331e+10,3.750000e-01,2.001991e+08,2.997925e+05,0
+*   ok,dose,4.022944e+10,4.022944e+08,1.041215e+08
+*   ok,stats,0,0.0,0.0,0.0,0.0,0.0,1
+*
+* Notes:
+*  - A fixed pool of worker threads each runs its own epoll loop. The listening socket is in
+*    every loop with EPOLLEXCLUSIVE, so a new connection wakes one worker, which keeps it for
+*    its lifetime; requests are never handed between threads.
+*  - Connections are edge-triggered and non-blocking, with fixed per-connection input and output
+*    buffers. All complete lines in a read are answered and written back with one send(), so
+*    pipelined clients get batched replies. When a client stops reading, its input is left
+*    unparsed until the output drains. A line longer than SERVER_BUF is answered with
+*    err,-1,request too long and its remainder is dropped up to the next newline.
+*  - Latency is measured per request from the read() that delivered it to the send() of its reply,
+*    into per-worker histograms (16 buckets per power of two of nanoseconds). "stats" returns
+*    ok,stats,requests,p50_us,p90_us,p99_us,p99.9_us,max_us,open_connections.
+*    A request is counted once its batch of replies is sent, so the example's stats line does
+*    not yet include the two requests before it.
+*  - SIGINT or SIGTERM stops the server, prints the latency summary to stderr and removes the
+*    socket file.
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "unbind_proto.h"
+#include "unbind_server.h"
+
+#define SERVER_BUF (1 << 16)          // per-connection input and output buffers
+#define SERVER_MAX_EVENTS 256
+#define SERVER_BACKLOG 1024
+#define SERVER_POLL_MS 250            // how often idle workers check for shutdown
+#define LAT_SUB_BITS 4
+#define LAT_BUCKETS (64 << LAT_SUB_BITS)
+
+typedef struct server_conn {
+    int fd;
+    size_t in_len;
+    size_t out_len, out_off;
+    int skipping;                     // discarding the rest of an over-long line
+    struct server_conn *prev, *next;
+    char in[SERVER_BUF];
+    char out[SERVER_BUF];
+} server_conn;
+
+typedef struct server_state server_state;
+
+typedef struct {
+    server_state* server;
+    int epfd;
+    pthread_t thread;
+    server_conn* conns;               // open connections, for cleanup
+    _Atomic uint64_t open;
+    _Atomic uint64_t latency[LAT_BUCKETS];   // written by this worker only
+} server_worker;
+
+struct server_state {
+    int listen_fd;
+    int n_workers;
+    server_worker* workers;
+    atomic_int stop;
+};
+
+/* ---------------------------------------------------------------------------
+ * Latency histogram
+ * ------------------------------------------------------------------------- */
+
+static inline uint64_t now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000u + (uint64_t)t.tv_nsec;
+}
+
+static inline int lat_bucket(uint64_t ns) {
+    if (ns < (1u << LAT_SUB_BITS)) return (int)ns;
+    int e = 63 - __builtin_clzll(ns);
+    return ((e - LAT_SUB_BITS + 1) << LAT_SUB_BITS) | (int)((ns >> (e - LAT_SUB_BITS)) & ((1u << LAT_SUB_BITS) - 1));
+}
+
+// Upper edge of a bucket, in nanoseconds
+static double lat_upper(int b) {
+    if (b < (1 << LAT_SUB_BITS)) return (double)b + 1.0;
+    int e = (b >> LAT_SUB_BITS) + LAT_SUB_BITS - 1;
+    uint64_t sub = (uint64_t)(b & ((1 << LAT_SUB_BITS) - 1));
+    return (double)(((1ull << LAT_SUB_BITS) + sub + 1) << (e - LAT_SUB_BITS));
+}
+
+static void lat_record(server_worker* w, uint64_t ns, uint64_t n) {
+    _Atomic uint64_t* slot = &w->latency[lat_bucket(ns)];
+    atomic_store_explicit(slot, atomic_load_explicit(slot, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+// Merge every worker's histogram: total count and quantiles in microseconds
+static uint64_t lat_summary(const server_state* s, const double* q, double* us, int nq, double* max_us) {
+    static const int n = LAT_BUCKETS;
+    uint64_t merged[LAT_BUCKETS] = { 0 };
+    uint64_t total = 0;
+    for (int w = 0; w < s->n_workers; w++)
+        for (int b = 0; b < n; b++) {
+            uint64_t c = atomic_load_explicit(&s->workers[w].latency[b], memory_order_relaxed);
+            merged[b] += c;
+            total += c;
+        }
+    *max_us = 0.0;
+    for (int k = 0; k < nq; k++) us[k] = 0.0;
+    if (total == 0) return 0;
+    uint64_t below = 0;
+    int k = 0;
+    for (int b = 0; b < n; b++) {
+        if (merged[b] == 0) continue;
+        below += merged[b];
+        while (k < nq && (double)below >= q[k] * (double)total) us[k++] = lat_upper(b) / 1000.0;
+        *max_us = lat_upper(b) / 1000.0;
+    }
+    return total;
+}
+
+static size_t put_stats(const server_state* s, char* out) {
+    static const double q[] = { 0.50, 0.90, 0.99, 0.999 };
+    double us[4], max_us;
+    uint64_t total = lat_summary(s, q, us, 4, &max_us);
+    uint64_t open = 0;
+    for (int w = 0; w < s->n_workers; w++) open += atomic_load(&s->workers[w].open);
+    return (size_t)snprintf(out, PROTO_MAX_RESPONSE, "ok,stats,%llu,%.1f,%.1f,%.1f,%.1f,%.1f,%llu\n",
+                            (unsigned long long)total, us[0], us[1], us[2], us[3], max_us,
+                            (unsigned long long)open);
+}
+
+/* ---------------------------------------------------------------------------
+ * Connections
+ * ------------------------------------------------------------------------- */
+
+static void conn_close(server_worker* w, server_conn* c) {
+    close(c->fd);
+    if (c->prev) c->prev->next = c->next; else w->conns = c->next;
+    if (c->next) c->next->prev = c->prev;
+    atomic_fetch_sub(&w->open, 1);
+    free(c);
+}
+
+// Write pending output. Returns 0 when drained, 1 if the socket is full, -1 on error.
+static int conn_flush(server_conn* c) {
+    while (c->out_off < c->out_len) {
+        ssize_t k = send(c->fd, c->out + c->out_off, c->out_len - c->out_off, MSG_NOSIGNAL);
+        if (k > 0) { c->out_off += (size_t)k; continue; }
+        if (k < 0 && errno == EINTR) continue;
+        return (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) ? 1 : -1;
+    }
+    c->out_len = c->out_off = 0;
+    return 0;
+}
+
+// Answer every complete line in the input buffer that fits in the output buffer.
+// Returns the number of requests answered.
+static uint64_t conn_answer(server_state* s, server_conn* c) {
+    uint64_t answered = 0;
+    size_t start = 0;
+    if (c->skipping) {
+        // Drop input up to and including the newline that ends the rejected line
+        char* nl = memchr(c->in, '\n', c->in_len);
+        if (!nl) {
+            c->in_len = 0;
+            return 0;
+        }
+        c->skipping = 0;
+        start = (size_t)(nl - c->in) + 1;
+    }
+    for (;;) {
+        char* nl = memchr(c->in + start, '\n', c->in_len - start);
+        if (!nl) break;
+        if (c->out_len + PROTO_MAX_RESPONSE > SERVER_BUF) break;
+        *nl = '\0';
+        char* line = c->in + start;
+        if (strcmp(line, "stats") == 0 || strcmp(line, "stats\r") == 0)
+            c->out_len += put_stats(s, c->out + c->out_len);
+        else
+            c->out_len += proto_handle_line(line, c->out + c->out_len);
+        start = (size_t)(nl - c->in) + 1;
+        answered++;
+    }
+    if (start == 0 && c->in_len == SERVER_BUF && c->out_len + PROTO_MAX_RESPONSE <= SERVER_BUF) {
+        // A full buffer without a newline: reject the line and drop it through its newline
+        c->out_len += (size_t)snprintf(c->out + c->out_len, PROTO_MAX_RESPONSE, "err,-1,request too long\n");
+        c->in_len = 0;
+        c->skipping = 1;
+        return answered + 1;
+    }
+    memmove(c->in, c->in + start, c->in_len - start);
+    c->in_len -= start;
+    return answered;
+}
+
+// Drain output, answer buffered requests, then read until the socket is empty
+static void conn_service(server_worker* w, server_conn* c) {
+    uint64_t t_read = now_ns();
+    for (;;) {
+        int f = conn_flush(c);
+        if (f != 0) {
+            if (f < 0) conn_close(w, c);
+            return;                               // wait for EPOLLOUT
+        }
+        uint64_t n = conn_answer(w->server, c);
+        if (n > 0) {
+            f = conn_flush(c);
+            lat_record(w, now_ns() - t_read, n);
+            if (f < 0) { conn_close(w, c); return; }
+            if (f > 0) return;
+            continue;                             // more buffered lines may now fit
+        }
+        if (c->in_len == SERVER_BUF) return;      // output blocked; resume on EPOLLOUT
+        ssize_t k = read(c->fd, c->in + c->in_len, SERVER_BUF - c->in_len);
+        if (k > 0) {
+            c->in_len += (size_t)k;
+            t_read = now_ns();
+            continue;
+        }
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        conn_close(w, c);                         // EOF or error
+        return;
+    }
+}
+
+static void accept_all(server_worker* w) {
+    for (;;) {
+        int fd = accept4(w->server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;                       // EAGAIN, or another worker took it
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // fails harmlessly on Unix sockets
+        server_conn* c = malloc(sizeof(*c));
+        if (!c) { close(fd); continue; }
+        c->fd = fd;
+        c->in_len = c->out_len = c->out_off = 0;
+        c->skipping = 0;
+        c->prev = NULL;
+        c->next = w->conns;
+        if (w->conns) w->conns->prev = c;
+        w->conns = c;
+        atomic_fetch_add(&w->open, 1);
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET, .data.ptr = c };
+        if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) conn_close(w, c);
+    }
+}
+
+static void* worker_main(void* arg) {
+    server_worker* w = arg;
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!atomic_load(&w->server->stop)) {
+        int n = epoll_wait(w->epfd, events, SERVER_MAX_EVENTS, SERVER_POLL_MS);
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.ptr == NULL) accept_all(w);
+            else conn_service(w, events[i].data.ptr);
+        }
+    }
+    while (w->conns) conn_close(w, w->conns);
+    return NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * Driver
+ * ------------------------------------------------------------------------- */
+
+// Bind and listen; returns the socket or -1. *unix_path is set for Unix sockets.
+static int open_listener(const char* address, const char** unix_path) {
+    *unix_path = NULL;
+    if (strncmp(address, "tcp:", 4) == 0) {
+        int port = atoi(address + 4);
+        if (port <= 0 || port > 65535) return -1;
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons((uint16_t)port);
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, SERVER_BACKLOG) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    const char* path = strncmp(address, "unix:", 5) == 0 ? address + 5 : address;
+    struct sockaddr_un sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sun_family = AF_UNIX;
+    if (path[0] == '\0' || strlen(path) >= sizeof(sa.sun_path)) return -1;
+    strcpy(sa.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    unlink(path);
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, SERVER_BACKLOG) != 0) {
+        close(fd);
+        return -1;
+    }
+    *unix_path = path;
+    return fd;
+}
+
+int run_server(int argc, char** argv) {
+    server_state s;
+    int threads = 0;
+    memset(&s, 0, sizeof(s));
+
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s serve <unix:/path | tcp:port> [threads=0]\n", argv[0]);
+        return 1;
+    }
+    for (int i = 3; i < argc; i++) {
+        if (strncmp(argv[i], "threads=", 8) == 0) threads = atoi(argv[i] + 8);
+        else {
+            fprintf(stderr, "Unknown serve option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    // Run each request type once so first clients do not pay for symbol binding and page faults
+    static const char* warmup[] = { "m,1e20", "d,1", "v,20", "dose" };
+    for (size_t i = 0; i < sizeof(warmup) / sizeof(warmup[0]); i++) {
+        char line[32], reply[PROTO_MAX_RESPONSE];
+        strcpy(line, warmup[i]);
+        proto_handle_line(line, reply);
+    }
+
+    const char* unix_path;
+    s.listen_fd = open_listener(argv[2], &unix_path);
+    if (s.listen_fd < 0) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", argv[2], strerror(errno));
+        return 1;
+    }
+
+    // Workers inherit a mask with the stop signals blocked; the main thread waits for them
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    s.workers = calloc((size_t)threads, sizeof(server_worker));
+    if (!s.workers) {
+        fprintf(stderr, "Out of memory.\n");
+        close(s.listen_fd);
+        return 1;
+    }
+    for (int i = 0; i < threads; i++) {
+        server_worker* w = &s.workers[i];
+        w->server = &s;
+        w->epfd = epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = NULL };
+        if (w->epfd < 0 || epoll_ctl(w->epfd, EPOLL_CTL_ADD, s.listen_fd, &ev) != 0 ||
+            pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            fprintf(stderr, "Cannot start worker %d: %s\n", i, strerror(errno));
+            atomic_store(&s.stop, 1);
+            for (int j = 0; j < i; j++) {
+                pthread_join(s.workers[j].thread, NULL);
+                close(s.workers[j].epfd);
+            }
+            if (w->epfd >= 0) close(w->epfd);
+            close(s.listen_fd);
+            if (unix_path) unlink(unix_path);
+            free(s.workers);
+            return 1;
+        }
+        s.n_workers = i + 1;
+    }
+    fprintf(stderr, "SERVE  : listening on %s with %d workers\n", argv[2], threads);
+
+    int sig;
+    sigwait(&stop_signals, &sig);
+    atomic_store(&s.stop, 1);
+    for (int i = 0; i < s.n_workers; i++) {
+        pthread_join(s.workers[i].thread, NULL);
+        close(s.workers[i].epfd);
+    }
+    close(s.listen_fd);
+    if (unix_path) unlink(unix_path);
+
+    static const double q[] = { 0.50, 0.99, 0.999 };
+    double us[3], max_us;
+    uint64_t total = lat_summary(&s, q, us, 3, &max_us);
+    fprintf(stderr, "SERVE  : %llu requests, latency p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+            (unsigned long long)total, us[0], us[1], us[2], max_us);
+    free(s.workers);
+    return 0;
+}
@@ -0,0 +1,12 @@
+/* unbind_server.h
+* (C) 2025 - George McGinn - MIT License
+* Long-lived query server for unbindEnergy and unbindDose scenarios (protocol: unbind_proto.h).
+*/
+
+#ifndef UNBIND_SERVER_H
+#define UNBIND_SERVER_H
+
+// serve <unix:/path | /path | tcp:port> [threads=0]
+int run_server(int argc, char** argv);
+
+#endif
@@ -0,0 +1,388 @@
+/* unbind_shard.c
+* (C) 2025 - George McGinn - MIT License
+* Sharded and resumable runs, and the merge mode (see unbind_shard.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy <batch|sweep|mc> ... shard=<i>/<N> [out=<file>] [checkpoint=<file>] [every=30]
+*   ./unbindEnergy merge <shard> <shard> ... > merged
+*
+* Examples:
+*   for i in 0 1 2 3; do ./unbindEnergy sweep d log:1e-4:1e4:1000000 shard=$i/4 out=s$i.csv checkpoint=s$i.ckpt & done
+*   ./unbindEnergy merge s0.csv s1.csv s2.csv s3.csv > sweep.csv
+*   ./unbindEnergy mc d loguniform:0.1:10 samples=1e10 shard=2/8 out=mc2.part checkpoint=mc2.ckpt
+*   ./unbindEnergy merge mc*.part
+*
+* Notes:
+*  - Shard i of N owns units floor(n i / N) to floor(n (i + 1) / N) - 1 of the run's n work
+*    units. Units are the same pieces the unsharded run works through in order, and every
+*    result depends only on its own unit, so the merged shards are byte-for-byte the output
+*    of one unsharded run for any N (the mc report's timing line aside).
+*  - A CSV run saves the output position: on resume out= is cut back to it, so rows written
+*    after the last checkpoint are computed again rather than duplicated. The output is
+*    synced before the checkpoint that covers it is renamed into place, so a checkpoint
+*    never points past what is on disk.
+*  - merge checks that the files are all N shards of the same run (mode, N and
+*    fingerprint), each complete, then writes them in shard order: CSV shards without
+*    their frame lines and with the column header once, mc shards as the full report.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "unbind_fmt.h"
+#include "unbind_mc.h"
+#include "unbind_shard.h"
+
+#define SHARD_COPY_BUF (1 << 20)
+#define SHARD_LINE_MAX 256            // longest frame line
+
+static double now_seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+void unbind_shard_init(unbind_shard* s) {
+    memset(s, 0, sizeof(*s));
+    s->count = 1;
+    s->every = UNBIND_CHECKPOINT_EVERY;
+    s->out_fd = -1;
+}
+
+int unbind_shard_option(const char* arg, unbind_shard* s) {
+    if (strncmp(arg, "shard=", 6) == 0) {
+        unsigned i, n;
+        char tail;
+        if (sscanf(arg + 6, "%u/%u%c", &i, &n, &tail) != 2 || n == 0 || i >= n) return -1;
+        s->index = i;
+        s->count = n;
+        s->sharded = 1;
+    } else if (strncmp(arg, "out=", 4) == 0) {
+        s->out_path = arg + 4;
+    } else if (strncmp(arg, "checkpoint=", 11) == 0) {
+        s->checkpoint_path = arg + 11;
+    } else if (strncmp(arg, "every=", 6) == 0) {
+        s->every = strtod(arg + 6, NULL);
+        if (!(s->every >= 0.0)) return -1;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+uint64_t unbind_shard_fingerprint(int argc, char** argv) {
+    unbind_shard ignored;
+    uint64_t h = 14695981039346656037ull;
+    unbind_shard_init(&ignored);
+    for (int i = 1; i < argc; i++) {
+        if (unbind_shard_option(argv[i], &ignored) != 0 || strncmp(argv[i], "threads=", 8) == 0) continue;
+        for (const char* p = argv[i]; ; p++) {            // the NUL separates arguments
+            h = (h ^ (unsigned char)*p) * 1099511628211ull;
+            if (*p == '\0') break;
+        }
+    }
+    return h;
+}
+
+/* ---------------------------------------------------------------------------
+ * Checkpoint files
+ * ------------------------------------------------------------------------- */
+
+static int write_all(int fd, const void* data, size_t n) {
+    const char* p = data;
+    while (n > 0) {
+        ssize_t k = write(fd, p, n);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return -1;
+        p += k;
+        n -= (size_t)k;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void* data, size_t n) {
+    char* p = data;
+    while (n > 0) {
+        ssize_t k = read(fd, p, n);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return -1;
+        p += k;
+        n -= (size_t)k;
+    }
+    return 0;
+}
+
+int unbind_checkpoint_write(const char* path, const unbind_checkpoint* c, const void* payload) {
+    size_t len = strlen(path);
+    char* tmp = malloc(len + 5);
+    if (!tmp) return -1;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int ok = fd >= 0 && write_all(fd, c, sizeof(*c)) == 0 &&
+             (c->payload_bytes == 0 || write_all(fd, payload, (size_t)c->payload_bytes) == 0) && fsync(fd) == 0;
+    if (fd >= 0 && close(fd) != 0) ok = 0;
+    if (ok && rename(tmp, path) != 0) ok = 0;
+    if (!ok && fd >= 0) unlink(tmp);
+    free(tmp);
+    return ok ? 0 : -1;
+}
+
+int unbind_checkpoint_read(const char* path, unbind_checkpoint* c, void** payload) {
+    *payload = NULL;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return errno == ENOENT ? 0 : -1;
+    int status = -1;
+    if (read_all(fd, c, sizeof(*c)) == 0 && memcmp(c->magic, UNBIND_CHECKPOINT_MAGIC, 8) == 0 &&
+        c->begin <= c->next && c->next <= c->end && c->payload_bytes < ((uint64_t)1 << 40)) {
+        *payload = malloc(c->payload_bytes ? (size_t)c->payload_bytes : 1);
+        if (*payload && read_all(fd, *payload, (size_t)c->payload_bytes) == 0) status = 1;
+        else {
+            free(*payload);
+            *payload = NULL;
+        }
+    }
+    close(fd);
+    return status;
+}
+
+/* ---------------------------------------------------------------------------
+ * Runs
+ * ------------------------------------------------------------------------- */
+
+int unbind_shard_start(unbind_shard* s, uint64_t n_units, void** payload, uint64_t* payload_bytes) {
+    // floor(n i / N) without overflowing n i
+    uint64_t q = n_units / s->count, r = n_units % s->count;
+    s->begin = q * s->index + r * s->index / s->count;
+    s->end = q * (s->index + 1) + r * (s->index + 1) / s->count;
+    s->next = s->begin;
+    s->out_bytes = 0;
+    s->last_save = now_seconds();
+    *payload = NULL;
+    *payload_bytes = 0;
+    if (!s->checkpoint_path) return 0;
+
+    unbind_checkpoint c;
+    int got = unbind_checkpoint_read(s->checkpoint_path, &c, payload);
+    if (got <= 0) {
+        if (got < 0) fprintf(stderr, "Cannot read checkpoint: %s\n", s->checkpoint_path);
+        return got;
+    }
+    if (c.fingerprint != s->fingerprint || c.shard != s->index || c.n_shards != s->count ||
+        c.begin != s->begin || c.end != s->end) {
+        fprintf(stderr, "Checkpoint %s is from a different run or shard.\n", s->checkpoint_path);
+        free(*payload);
+        *payload = NULL;
+        return -1;
+    }
+    s->next = c.next;
+    s->out_bytes = c.out_bytes;
+    *payload_bytes = c.payload_bytes;
+    return 1;
+}
+
+int unbind_shard_open_output(unbind_shard* s, int resumed) {
+    if (!s->out_path) {
+        if (!s->checkpoint_path) return 0;
+        fprintf(stderr, "checkpoint= needs out= so the output can be resumed.\n");
+        return -1;
+    }
+    int fd = open(s->out_path, O_WRONLY | O_CREAT | (resumed ? 0 : O_TRUNC), 0644);
+    struct stat st;
+    if (fd >= 0 && resumed && (fstat(fd, &st) != 0 || (uint64_t)st.st_size < s->out_bytes ||
+                               ftruncate(fd, (off_t)s->out_bytes) != 0 || lseek(fd, 0, SEEK_END) < 0)) {
+        fprintf(stderr, "%s is shorter than its checkpoint says.\n", s->out_path);
+        close(fd);
+        return -1;
+    }
+    if (fd < 0) {
+        fprintf(stderr, "Cannot write output: %s\n", s->out_path);
+        return -1;
+    }
+    s->out_fd = fd;
+    unbind_stdout()->fd = fd;
+    return 0;
+}
+
+void unbind_shard_close_output(unbind_shard* s) {
+    if (s->out_fd < 0) return;
+    close(s->out_fd);
+    s->out_fd = -1;
+    unbind_stdout()->fd = STDOUT_FILENO;
+}
+
+void unbind_shard_header(const unbind_shard* s, const char* mode) {
+    char line[SHARD_LINE_MAX];
+    if (!s->sharded) return;
+    int n = snprintf(line, sizeof(line), "#shard,%u,%u,%s,%016llx\n", s->index, s->count, mode,
+                     (unsigned long long)s->fingerprint);
+    unbind_out_write(unbind_stdout(), line, (size_t)n);
+}
+
+void unbind_shard_trailer(const unbind_shard* s) {
+    if (s->sharded) unbind_out_printf(unbind_stdout(), "#end,%u,%u\n", s->index, s->count);
+}
+
+int unbind_shard_due(const unbind_shard* s) {
+    return s->checkpoint_path && now_seconds() - s->last_save >= s->every;
+}
+
+int unbind_shard_save(unbind_shard* s, uint64_t next, const void* payload, uint64_t payload_bytes) {
+    unbind_checkpoint c;
+    memset(&c, 0, sizeof(c));
+    memcpy(c.magic, UNBIND_CHECKPOINT_MAGIC, 8);
+    c.fingerprint = s->fingerprint;
+    c.shard = s->index;
+    c.n_shards = s->count;
+    c.begin = s->begin;
+    c.end = s->end;
+    c.next = next;
+    c.payload_bytes = payload_bytes;
+    if (s->out_fd >= 0) {
+        off_t at;
+        if (unbind_out_flush(unbind_stdout()) != 0 || fdatasync(s->out_fd) != 0 ||
+            (at = lseek(s->out_fd, 0, SEEK_CUR)) < 0) {
+            fprintf(stderr, "Error writing output: %s\n", s->out_path);
+            return -1;
+        }
+        c.out_bytes = (uint64_t)at;
+    }
+    if (unbind_checkpoint_write(s->checkpoint_path, &c, payload) != 0) {
+        fprintf(stderr, "Cannot write checkpoint: %s\n", s->checkpoint_path);
+        return -1;
+    }
+    s->next = next;
+    s->last_save = now_seconds();
+    return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Merge
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    const char* path;
+    unsigned index, count;
+    char mode[32];
+    char fingerprint[17];
+    long long body;                   // first byte after the frame line
+    long long size;
+} merge_shard;
+
+// Read the #shard line and check for the #end line
+static int merge_open(merge_shard* m) {
+    char line[SHARD_LINE_MAX], tail[SHARD_LINE_MAX], expect[SHARD_LINE_MAX];
+    FILE* fp = fopen(m->path, "rb");
+    int ok = 0;
+    if (fp && fgets(line, sizeof(line), fp) &&
+        sscanf(line, "#shard,%u,%u,%31[^,],%16[0-9a-f]", &m->index, &m->count, m->mode, m->fingerprint) == 4 &&
+        m->count > 0 && m->index < m->count) {
+        int n = snprintf(expect, sizeof(expect), "#end,%u,%u\n", m->index, m->count);
+        m->body = (long long)strlen(line);
+        if (fseek(fp, 0, SEEK_END) == 0 && (m->size = ftell(fp)) >= m->body + n &&
+            fseek(fp, (long)(m->size - n), SEEK_SET) == 0 && fread(tail, 1, (size_t)n, fp) == (size_t)n)
+            ok = memcmp(tail, expect, (size_t)n) == 0 ? 1 : -1;
+    }
+    if (fp) fclose(fp);
+    if (ok == 0) fprintf(stderr, "%s is not a sharded CSV output.\n", m->path);
+    if (ok < 0) fprintf(stderr, "%s (shard %u/%u) is incomplete; resume it from its checkpoint.\n",
+                        m->path, m->index, m->count);
+    if (ok > 0) m->size -= (long long)strlen(expect);
+    return ok > 0 ? 0 : -1;
+}
+
+// Copy the shard's rows; the column header line is kept only for the first shard
+static int merge_copy(const merge_shard* m, int keep_header, char* buf, unbind_out* out) {
+    FILE* fp = fopen(m->path, "rb");
+    if (!fp || fseek(fp, (long)m->body, SEEK_SET) != 0) {
+        if (fp) fclose(fp);
+        return -1;
+    }
+    long long left = m->size - m->body;
+    int header = 1;
+    while (left > 0) {
+        size_t want = left < SHARD_COPY_BUF ? (size_t)left : SHARD_COPY_BUF;
+        size_t got = fread(buf, 1, want, fp);
+        if (got == 0) break;
+        left -= (long long)got;
+        char* p = buf;
+        if (header) {                                     // the header is shorter than any buffer
+            char* nl = memchr(buf, '\n', got);
+            header = 0;
+            if (!keep_header && nl) p = nl + 1;
+        }
+        unbind_out_write(out, p, got - (size_t)(p - buf));
+    }
+    fclose(fp);
+    return left == 0 ? 0 : -1;
+}
+
+int run_merge(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s merge <shard> <shard> ...   (all shards of one batch, sweep or mc run)\n", argv[0]);
+        return 1;
+    }
+    char magic[8] = { 0 };
+    FILE* fp = fopen(argv[2], "rb");
+    if (!fp) {
+        fprintf(stderr, "Cannot open shard: %s\n", argv[2]);
+        return 1;
+    }
+    size_t got = fread(magic, 1, sizeof(magic), fp);
+    fclose(fp);
+    if (got == sizeof(magic) && memcmp(magic, UNBIND_CHECKPOINT_MAGIC, 8) == 0)
+        return mc_merge(argc - 2, argv + 2);
+
+    int n = argc - 2, status = 1;
+    merge_shard* shards = calloc((size_t)n, sizeof(merge_shard));
+    merge_shard** order = calloc((size_t)n, sizeof(merge_shard*));
+    char* buf = malloc(SHARD_COPY_BUF);
+    if (!shards || !order || !buf) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+    for (int i = 0; i < n; i++) {
+        shards[i].path = argv[i + 2];
+        if (merge_open(&shards[i]) != 0) goto done;
+        if (shards[i].count != (unsigned)n) {
+            fprintf(stderr, "%s is shard %u of %u, but %d files were given.\n", shards[i].path, shards[i].index,
+                    shards[i].count, n);
+            goto done;
+        }
+        if (strcmp(shards[i].mode, shards[0].mode) != 0 || strcmp(shards[i].fingerprint, shards[0].fingerprint) != 0) {
+            fprintf(stderr, "%s is not a shard of the same run as %s.\n", shards[i].path, shards[0].path);
+            goto done;
+        }
+        if (order[shards[i].index]) {
+            fprintf(stderr, "%s and %s are both shard %u.\n", order[shards[i].index]->path, shards[i].path,
+                    shards[i].index);
+            goto done;
+        }
+        order[shards[i].index] = &shards[i];
+    }
+
+    unbind_out* out = unbind_stdout();
+    status = 0;
+    for (int i = 0; i < n && status == 0; i++) {
+        if (merge_copy(order[i], i == 0, buf, out) != 0) {
+            fprintf(stderr, "Error reading shard: %s\n", order[i]->path);
+            status = 1;
+        }
+    }
+    if (unbind_out_flush(out) != 0) {
+        fprintf(stderr, "Error writing output.\n");
+        status = 1;
+    }
+
+done:
+    free(shards);
+    free(order);
+    free(buf);
+    return status;
+}
@@ -0,0 +1,91 @@
+/* unbind_shard.h
+* (C) 2025 - George McGinn - MIT License
+* Sharded and resumable runs for batch, sweep and mc, and the merge mode that joins shards.
+*
+* Options (accepted by batch, sweep and mc):
+*   shard=i/N           run only shard i (0-based) of N; each shard owns a contiguous range of
+*                       the run's work units (sweep: SWEEP_CHUNK tasks, batch: catalog bytes,
+*                       mc: MC_TASK sample tasks), fixed by the run's options alone
+*   out=<file>          write to a file instead of stdout
+*   checkpoint=<file>   save progress at most every every= seconds (default 30) and at the
+*                       end; a run started again with the same options resumes from it
+*   every=<seconds>
+*
+* Sharded CSV output is framed by two comment lines that merge removes:
+*   #shard,<i>,<N>,<mode>,<fingerprint>     first line
+*   #end,<i>,<N>                            last line, written when the shard is complete
+* The fingerprint is a hash of the options that decide the results (everything but the
+* options above and threads=), so shards and checkpoints of a different run are refused.
+* An mc shard writes no report: out= gets its partial aggregates in the checkpoint format.
+*
+* Checkpoint file layout (native byte order): unbind_checkpoint, then payload_bytes of
+* mode data (none for CSV runs, whose state is the output file itself, cut back to
+* out_bytes on resume). Checkpoints are written to <file>.tmp, synced and renamed over
+* <file>, after the output up to out_bytes has been synced.
+*/
+
+#ifndef UNBIND_SHARD_H
+#define UNBIND_SHARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UNBIND_CHECKPOINT_MAGIC "UNBCKP1"  // 8 bytes with the NUL
+#define UNBIND_CHECKPOINT_EVERY 30.0       // seconds
+
+typedef struct {
+    char     magic[8];
+    uint64_t fingerprint;
+    uint32_t shard, n_shards;
+    uint64_t begin, end;                   // this shard's work units
+    uint64_t next;                         // first unit not yet done; end when complete
+    uint64_t out_bytes;                    // CSV output written for units begin..next-1
+    uint64_t payload_bytes;
+} unbind_checkpoint;
+
+typedef struct {
+    uint32_t index, count;                 // shard=i/N; 0/1 without it
+    int sharded;
+    const char* out_path;
+    const char* checkpoint_path;
+    double every;
+    uint64_t fingerprint;                  // set by the caller, see unbind_shard_fingerprint()
+    uint64_t begin, end, next;             // set by unbind_shard_start()
+    uint64_t out_bytes;                    // CSV output kept on resume
+    int out_fd;                            // out= once opened, -1 before
+    double last_save;                      // monotonic seconds of the last checkpoint
+} unbind_shard;
+
+void unbind_shard_init(unbind_shard* s);
+// 1 if arg is one of the options above (stored in s), 0 if it is not, -1 if it is malformed
+int unbind_shard_option(const char* arg, unbind_shard* s);
+// FNV-1a of argv[1..argc-1], skipping the shard options and threads=
+uint64_t unbind_shard_fingerprint(int argc, char** argv);
+
+/* Fix this shard's range of n_units and load checkpoint= if it exists: s->next is where
+ * it stopped (s->begin on a fresh start) and its payload, if any, is returned in *payload
+ * (malloc'd). Returns 1 resumed, 0 fresh, -1 on an error (printed). */
+int unbind_shard_start(unbind_shard* s, uint64_t n_units, void** payload, uint64_t* payload_bytes);
+/* CSV runs: point unbind_stdout() at out= (created, or cut back to the checkpoint when
+ * resumed). Without out= the output stays on stdout, which checkpoint= does not allow.
+ * 0 or -1 (printed). */
+int unbind_shard_open_output(unbind_shard* s, int resumed);
+void unbind_shard_close_output(unbind_shard* s);
+// Write the #shard line (sharded CSV runs only, fresh starts)
+void unbind_shard_header(const unbind_shard* s, const char* mode);
+// Write the #end line (sharded CSV runs only)
+void unbind_shard_trailer(const unbind_shard* s);
+// 1 when checkpoint= is set and every= seconds have passed since the last save
+int unbind_shard_due(const unbind_shard* s);
+/* Record that units up to next-1 are done: flush and sync the output, then save the
+ * checkpoint with the given payload. 0 on success, -1 on an error (printed). */
+int unbind_shard_save(unbind_shard* s, uint64_t next, const void* payload, uint64_t payload_bytes);
+// Write a checkpoint-format file (mc shard results); 0 or -1
+int unbind_checkpoint_write(const char* path, const unbind_checkpoint* c, const void* payload);
+// Read one; 1 read, 0 no such file, -1 unreadable or not a checkpoint. *payload is malloc'd.
+int unbind_checkpoint_read(const char* path, unbind_checkpoint* c, void** payload);
+
+// merge <shard> <shard> ...: the shards of one run, in any order, to stdout
+int run_merge(int argc, char** argv);
+
+#endif
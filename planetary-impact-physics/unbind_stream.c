@@ -0,0 +1,97 @@
+/* unbind_stream.c
+* (C) 2025 - George McGinn - MIT License
+* Stream mode for unbindEnergy (see unbind_stream.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   cat scenarios.csv | ./unbindEnergy --stream [--flush] > results.csv
+*
+* Example:
+*   $ printf 'd,0.375,2000,0.25,Apophis,earth,stony\nm,1e20,,0.5,,pluto\n' | ./unbindEnergy --stream
+*   ok,d,"Apophis",earth,stony,0.25,2000,0.900,0.225,5.522331e+10,3.750000e-01,2.001991e+08,2.997925e+05,0
+*   ok,m,"",pluto,stony,0.5,3000,0.980,0.49,1.000000e+20,3.992945e+02,1.078548e+01,1.078548e+01,1
+*
+* Notes:
+*  - Requests and replies are the server's (unbind_proto.h): one request per line,
+*    mode,value,rho,epsilon,name,planet,material (or dose,...), one reply line each, in order.
+*    Empty lines are skipped.
+*  - stdin is read with read() in STREAM_BUF chunks and lines are parsed in place; replies are
+*    formatted straight into the unbind_stdout() buffer (unbind_fmt.h), which is written with
+*    write() when it fills, so a long pipeline costs two system calls per megabyte and no
+*    allocation per line.
+*  - --flush writes each reply as soon as it is ready, for interactive use.
+*  - A line longer than STREAM_BUF is answered with err,-1,request too long and skipped.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "unbind_fmt.h"
+#include "unbind_proto.h"
+#include "unbind_stream.h"
+
+#define STREAM_BUF (1 << 20)
+
+static char stream_in[STREAM_BUF];
+
+int run_stream(int argc, char** argv) {
+    int flush_each = 0;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--flush") == 0) flush_each = 1;
+        else {
+            fprintf(stderr, "Usage: %s --stream [--flush]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    unbind_out* out = unbind_stdout();
+    size_t in_len = 0;
+    int skipping = 0;                 // discarding the rest of an over-long line
+    int eof = 0;
+    while (!eof) {
+        ssize_t k = read(STDIN_FILENO, stream_in + in_len, STREAM_BUF - in_len);
+        if (k < 0 && errno == EINTR) continue;
+        if (k < 0) {
+            fprintf(stderr, "Error reading stdin: %s\n", strerror(errno));
+            return 1;
+        }
+        if (k == 0) {
+            eof = 1;
+            if (in_len > 0 && stream_in[in_len-1] != '\n') {
+                if (in_len == STREAM_BUF) in_len--;     // make room for the final newline
+                stream_in[in_len++] = '\n';
+            }
+        }
+        in_len += (size_t)(k > 0 ? k : 0);
+
+        size_t start = 0;
+        char* nl;
+        while ((nl = memchr(stream_in + start, '\n', in_len - start)) != NULL) {
+            char* line = stream_in + start;
+            *nl = '\0';
+            start = (size_t)(nl - stream_in) + 1;
+            if (skipping) { skipping = 0; continue; }
+            if (line[0] == '\0' || (line[0] == '\r' && line[1] == '\0')) continue;
+
+            char* p = unbind_out_reserve(out, PROTO_MAX_RESPONSE);
+            unbind_out_advance(out, p + proto_handle_line(line, p));
+            if (flush_each) unbind_out_flush(out);
+            if (out->error) goto write_error;
+        }
+        if (start == 0 && in_len == STREAM_BUF) {
+            // No newline in a full buffer: reject this line and drop input up to its end
+            if (!skipping) unbind_out_write(out, "err,-1,request too long\n", 24);
+            skipping = 1;
+            in_len = 0;
+            continue;
+        }
+        memmove(stream_in, stream_in + start, in_len - start);
+        in_len -= start;
+    }
+    if (unbind_out_flush(out) == 0) return 0;
+
+write_error:
+    fprintf(stderr, "Error writing stdout: %s\n", strerror(out->error));
+    return 1;
+}
@@ -0,0 +1,12 @@
+/* unbind_stream.h
+* (C) 2025 - George McGinn - MIT License
+* Pipelined stdin/stdout mode for unbindEnergy (protocol: unbind_proto.h).
+*/
+
+#ifndef UNBIND_STREAM_H
+#define UNBIND_STREAM_H
+
+// --stream [--flush]
+int run_stream(int argc, char** argv);
+
+#endif
@@ -0,0 +1,386 @@
+/* unbind_surface.c
+* (C) 2025 - George McGinn - MIT License
+* Retention-surface mode and file loader for unbindEnergy (see unbind_surface.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy surface <file> [planets=all] [materials=all] [D=1e-5:1e3:65] [speed=2:100:49]
+*                          [angle=15:90:16] [threads=0]
+*
+* Examples:
+*   ./unbindEnergy surface entry.urs
+*   ./unbindEnergy surface earth.urs planets=earth materials=stony,iron angle=5:90:18 threads=8
+*   ./unbindEnergy mc d lognormal:0.05:1 speed=lognormal:20:0.3 angle=uniform:15:90 surface=entry.urs
+*
+* Notes:
+*  - Axes are lo:hi:n. Diameter (km) and entry speed (km/s) are log-spaced, angle (degrees
+*    above the horizon) evenly spaced. There is no density axis: the entry model depends on
+*    D rho only, so the diameter axis is the size at 3000 kg/m^3 and a lookup at density rho
+*    reads it at D rho / 3000. The D range therefore has to cover the densities in use too.
+*  - The defaults take about 1.5M trajectories (about 8 s on one core for all planets and
+*    materials) and make a 6 MB file. Lookups outside the axes use the nearest edge.
+*  - Each task integrates one (planet, material, angle) slice of n_D x n_speed trajectories
+*    with unbind_entry_array() on the thread pool; the file is the same for any thread count.
+*  - After the build, SURFACE_CHECK random points per table, at random densities, are
+*    integrated directly and compared with the lookup; the largest difference is reported
+*    on stderr. With the defaults it is about 0.015 (as a delivered fraction), on the giant
+*    planets; the speed and angle axes matter more for it than the diameter axis.
+*  - The loader maps the file read-only and points unbind_retention_surface values into
+*    the mapping, so a large table costs nothing until it is touched and is shared by
+*    every process that maps it.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_rng.h"
+#include "unbind_surface.h"
+
+#define SURFACE_MAX_POINTS 4096       // per axis
+#define SURFACE_CHECK 256             // random check points per table
+#define SURFACE_CHECK_ANGLES 8        // entry angles they are spread over
+#define SURFACE_CHECK_RHO_LO 500.0    // and their densities (kg/m^3)
+#define SURFACE_CHECK_RHO_HI 8000.0
+#define SURFACE_CHECK_SEED 0x5eedULL
+
+static size_t align_up(size_t n) {
+    return (n + UNBIND_SURFACE_ALIGN - 1) & ~(size_t)(UNBIND_SURFACE_ALIGN - 1);
+}
+
+/* ---------------------------------------------------------------------------
+ * Loader
+ * ------------------------------------------------------------------------- */
+
+static int bad_file(unbind_surface_file* f) {
+    unbind_surface_close(f);
+    errno = EINVAL;
+    return -1;
+}
+
+int unbind_surface_open(const char* path, unbind_surface_file* f) {
+    memset(f, 0, sizeof(*f));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return -1;
+    }
+    f->size = (size_t)st.st_size;
+    if (f->size < sizeof(unbind_surface_header)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void* map = mmap(NULL, f->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return -1;
+    f->base = map;
+
+    const unbind_surface_header* h = (const unbind_surface_header*)f->base;
+    f->header = h;
+    if (memcmp(h->magic, UNBIND_SURFACE_MAGIC, sizeof(h->magic)) != 0 || h->version != UNBIND_SURFACE_VERSION ||
+        h->endian != UNBIND_SURFACE_ENDIAN || h->n_surfaces == 0 ||
+        h->n_surfaces > (f->size - sizeof(*h)) / sizeof(unbind_surface_entry))
+        return bad_file(f);
+    int n[UNBIND_SURFACE_AXES];
+    for (int a = 0; a < UNBIND_SURFACE_AXES; a++) {
+        if (h->n[a] < 2 || h->n[a] > SURFACE_MAX_POINTS) return bad_file(f);
+        n[a] = (int)h->n[a];
+    }
+    unbind_retention_surface grid;
+    if (unbind_surface_init(&grid, n, h->lo, h->hi, NULL) != UNBIND_OK) return bad_file(f);
+    size_t bytes = unbind_surface_size(&grid) * sizeof(float);
+
+    const unbind_surface_entry* dir = (const unbind_surface_entry*)(f->base + sizeof(*h));
+    for (uint32_t k = 0; k < h->n_surfaces; k++) {
+        const unbind_surface_entry* e = &dir[k];
+        if (e->planet >= PLANET_COUNT || e->material >= MATERIAL_COUNT || e->offset % UNBIND_SURFACE_ALIGN != 0 ||
+            e->offset > f->size || bytes > f->size - e->offset)
+            return bad_file(f);
+        unbind_retention_surface* s = &f->surface[e->planet][e->material];
+        *s = grid;
+        s->value = (const float*)(f->base + e->offset);
+    }
+    return 0;
+}
+
+void unbind_surface_close(unbind_surface_file* f) {
+    if (f->base) munmap((void*)f->base, f->size);
+    memset(f, 0, sizeof(*f));
+}
+
+const unbind_retention_surface* unbind_surface_find(const unbind_surface_file* f, int planet, int material) {
+    if (planet < 0 || planet >= PLANET_COUNT || material < 0 || material >= MATERIAL_COUNT) return NULL;
+    const unbind_retention_surface* s = &f->surface[planet][material];
+    return s->value ? s : NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * Build
+ * ------------------------------------------------------------------------- */
+
+typedef struct {
+    unbind_retention_surface grid;    // axes only
+    const int* planets;
+    const int* materials;
+    int n_materials;
+    size_t points;                    // per table
+    size_t slice;                     // n_D * n_speed
+    float* values;                    // all tables, back to back
+    double* scratch;                  // per worker: D, speed and fraction, slice each
+} surface_build;
+
+// One (table, angle) slice
+static void surface_task(void* ctx, size_t task, int worker) {
+    const surface_build* b = ctx;
+    const unbind_retention_surface* g = &b->grid;
+    size_t n_angle = (size_t)g->n[UNBIND_SURFACE_ANGLE];
+    size_t table = task / n_angle;
+    int ia = (int)(task % n_angle);
+
+    double* D = b->scratch + (size_t)worker * 3 * b->slice;
+    double* v = D + b->slice;
+    double* f = v + b->slice;
+    int n_D = g->n[UNBIND_SURFACE_DIAMETER];
+    for (int iv = 0; iv < g->n[UNBIND_SURFACE_SPEED]; iv++) {
+        double speed = unbind_surface_axis(g, UNBIND_SURFACE_SPEED, iv);
+        for (int id = 0; id < n_D; id++) {
+            D[(size_t)iv * n_D + id] = unbind_surface_axis(g, UNBIND_SURFACE_DIAMETER, id);
+            v[(size_t)iv * n_D + id] = speed;
+        }
+    }
+
+    unbind_entry_input in;
+    unbind_entry_result out;
+    memset(&in, 0, sizeof(in));
+    memset(&out, 0, sizeof(out));
+    in.planet = b->planets[table / (size_t)b->n_materials];
+    in.material = b->materials[table % (size_t)b->n_materials];
+    in.rho = UNBIND_DEFAULT_DENSITY;
+    in.angle_deg = unbind_surface_axis(g, UNBIND_SURFACE_ANGLE, ia);
+    in.D_km = D;
+    in.speed_v = v;
+    in.n = b->slice;
+    out.fraction = f;
+    unbind_entry_array(&in, &out);
+
+    float* dst = b->values + table * b->points + (size_t)ia * b->slice;
+    for (size_t i = 0; i < b->slice; i++) dst[i] = (float)f[i];
+}
+
+// Largest |lookup - entry model| over SURFACE_CHECK random points of one table, at
+// densities between SURFACE_CHECK_RHO_LO and SURFACE_CHECK_RHO_HI
+static double surface_check(const surface_build* b, size_t table, const unbind_retention_surface* s) {
+    double D[SURFACE_CHECK], v[SURFACE_CHECK], rho[SURFACE_CHECK], f[SURFACE_CHECK], worst = 0.0;
+    const unbind_retention_surface* g = &b->grid;
+    unbind_entry_input in;
+    unbind_entry_result out;
+    memset(&in, 0, sizeof(in));
+    memset(&out, 0, sizeof(out));
+    in.planet = b->planets[table / (size_t)b->n_materials];
+    in.material = b->materials[table % (size_t)b->n_materials];
+    in.speed_v = v;
+    in.rho_v = rho;
+    in.n = SURFACE_CHECK / SURFACE_CHECK_ANGLES;
+    out.fraction = f;
+    double u1, u2;
+    for (size_t i = 0; i < SURFACE_CHECK; i++) {
+        unbind_rng_u01x2(SURFACE_CHECK_SEED, i, 2 * (uint32_t)table, &u1, &u2);
+        rho[i] = SURFACE_CHECK_RHO_LO + u1 * (SURFACE_CHECK_RHO_HI - SURFACE_CHECK_RHO_LO);
+        v[i] = pow(10.0, g->lo[UNBIND_SURFACE_SPEED] + u2 * (g->hi[UNBIND_SURFACE_SPEED] - g->lo[UNBIND_SURFACE_SPEED]));
+        unbind_rng_u01x2(SURFACE_CHECK_SEED, i, 2 * (uint32_t)table + 1, &u1, &u2);
+        double x = g->lo[UNBIND_SURFACE_DIAMETER] + u1 * (g->hi[UNBIND_SURFACE_DIAMETER] - g->lo[UNBIND_SURFACE_DIAMETER]);
+        D[i] = pow(10.0, x) * UNBIND_DEFAULT_DENSITY / rho[i];
+    }
+    // The model takes one angle per call
+    for (size_t k = 0; k < SURFACE_CHECK_ANGLES; k++) {
+        size_t at = k * in.n;
+        unbind_rng_u01x2(SURFACE_CHECK_SEED, table, 0xffffffffu, &u1, &u2);
+        in.angle_deg = g->lo[UNBIND_SURFACE_ANGLE] + (k + u1) / SURFACE_CHECK_ANGLES *
+                       (g->hi[UNBIND_SURFACE_ANGLE] - g->lo[UNBIND_SURFACE_ANGLE]);
+        in.D_km = D + at;
+        in.speed_v = v + at;
+        in.rho_v = rho + at;
+        out.fraction = f + at;
+        unbind_entry_array(&in, &out);
+        for (size_t i = at; i < at + in.n; i++) {
+            double d = fabs(unbind_surface_lookup(s, D[i], v[i], rho[i], in.angle_deg) - f[i]);
+            if (d > worst) worst = d;
+        }
+    }
+    return worst;
+}
+
+// "lo:hi:n" with n >= 2 and 0 < lo < hi
+static int parse_grid_axis(const char* spec, double* lo, double* hi, int* n) {
+    char tail;
+    return sscanf(spec, "%lf:%lf:%d%c", lo, hi, n, &tail) == 3 && *lo > 0.0 && *hi > *lo &&
+           *n >= 2 && *n <= SURFACE_MAX_POINTS ? 0 : -1;
+}
+
+static int surface_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s surface <file> [planets=all] [materials=all] [D=1e-5:1e3:65] [speed=2:100:49]\n"
+        "          [angle=15:90:16] [threads=0]\n"
+        "  axes: lo:hi:n (D in km at 3000 kg/m^3 and speed in km/s log-spaced, angle in degrees linear)\n",
+        prog);
+    return 1;
+}
+
+static int write_all(FILE* fp, const void* p, size_t n) {
+    return fwrite(p, 1, n, fp) == n ? 0 : -1;
+}
+
+int run_surface(int argc, char** argv) {
+    if (argc < 3 || strchr(argv[2], '=')) return surface_usage(argv[0]);
+    const char* path = argv[2];
+    const char* planet_spec = "all";
+    const char* material_spec = "all";
+    double lo[UNBIND_SURFACE_AXES] = { 1e-5, 2.0, 15.0 };
+    double hi[UNBIND_SURFACE_AXES] = { 1e3, 100.0, 90.0 };
+    int n[UNBIND_SURFACE_AXES] = { 65, 49, 16 };
+    int threads = 0;
+    static const char* axis_opt[UNBIND_SURFACE_AXES] = { "D=", "speed=", "angle=" };
+
+    for (int i = 3; i < argc; i++) {
+        int axis = -1;
+        for (int a = 0; a < UNBIND_SURFACE_AXES; a++)
+            if (strncmp(argv[i], axis_opt[a], strlen(axis_opt[a])) == 0) axis = a;
+        if (axis >= 0 && parse_grid_axis(argv[i] + strlen(axis_opt[axis]), &lo[axis], &hi[axis], &n[axis]) == 0)
+            continue;
+        if (strncmp(argv[i], "planets=", 8) == 0) planet_spec = argv[i] + 8;
+        else if (strncmp(argv[i], "materials=", 10) == 0) material_spec = argv[i] + 10;
+        else if (strncmp(argv[i], "threads=", 8) == 0) threads = atoi(argv[i] + 8);
+        else {
+            fprintf(stderr, "Bad surface option: %s\n", argv[i]);
+            return surface_usage(argv[0]);
+        }
+    }
+    if (hi[UNBIND_SURFACE_ANGLE] > 90.0) {
+        fprintf(stderr, "Entry angles must be in (0, 90] degrees.\n");
+        return 1;
+    }
+
+    int planets[PLANET_COUNT], materials[MATERIAL_COUNT];
+    int n_planets = unbind_parse_planet_list(planet_spec, planets, PLANET_COUNT);
+    int n_materials = unbind_parse_material_list(material_spec, materials, MATERIAL_COUNT);
+    if (n_planets <= 0 || n_materials <= 0) {
+        fprintf(stderr, "Planets/materials must be comma-separated names or 'all'.\n");
+        return 1;
+    }
+
+    surface_build b;
+    memset(&b, 0, sizeof(b));
+    double axis_lo[UNBIND_SURFACE_AXES], axis_hi[UNBIND_SURFACE_AXES];
+    for (int a = 0; a < UNBIND_SURFACE_AXES; a++) {
+        int log_axis = a != UNBIND_SURFACE_ANGLE;
+        axis_lo[a] = log_axis ? log10(lo[a]) : lo[a];
+        axis_hi[a] = log_axis ? log10(hi[a]) : hi[a];
+    }
+    unbind_surface_init(&b.grid, n, axis_lo, axis_hi, NULL);
+    b.planets = planets;
+    b.materials = materials;
+    b.n_materials = n_materials;
+    b.points = unbind_surface_size(&b.grid);
+    b.slice = (size_t)n[UNBIND_SURFACE_DIAMETER] * (size_t)n[UNBIND_SURFACE_SPEED];
+    size_t n_tables = (size_t)n_planets * (size_t)n_materials;
+    size_t table_bytes = align_up(b.points * sizeof(float));
+
+    int status = 1;
+    FILE* fp = NULL;
+    unbind_pool* pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        return 1;
+    }
+    int n_threads = unbind_pool_threads(pool);
+    b.values = malloc(n_tables * b.points * sizeof(float));
+    b.scratch = malloc((size_t)n_threads * 3 * b.slice * sizeof(double));
+    if (!b.values || !b.scratch) {
+        fprintf(stderr, "Out of memory.\n");
+        goto done;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    unbind_pool_run(pool, n_tables * (size_t)n[UNBIND_SURFACE_ANGLE], surface_task, &b);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+
+    double worst = 0.0;
+    size_t worst_table = 0;
+    for (size_t k = 0; k < n_tables; k++) {
+        unbind_retention_surface s = b.grid;
+        s.value = b.values + k * b.points;
+        double d = surface_check(&b, k, &s);
+        if (d > worst) {
+            worst = d;
+            worst_table = k;
+        }
+    }
+
+    fp = fopen(path, "wb");
+    if (!fp) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        goto done;
+    }
+    unbind_surface_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, UNBIND_SURFACE_MAGIC, sizeof(h.magic));
+    h.version = UNBIND_SURFACE_VERSION;
+    h.endian = UNBIND_SURFACE_ENDIAN;
+    h.n_surfaces = (uint32_t)n_tables;
+    for (int a = 0; a < UNBIND_SURFACE_AXES; a++) {
+        h.n[a] = (uint32_t)n[a];
+        h.lo[a] = axis_lo[a];
+        h.hi[a] = axis_hi[a];
+    }
+    size_t data_offset = align_up(sizeof(h) + n_tables * sizeof(unbind_surface_entry));
+    int err = write_all(fp, &h, sizeof(h));
+    for (size_t k = 0; k < n_tables; k++) {
+        unbind_surface_entry e;
+        e.planet = (uint32_t)planets[k / (size_t)n_materials];
+        e.material = (uint32_t)materials[k % (size_t)n_materials];
+        e.offset = data_offset + k * table_bytes;
+        err |= write_all(fp, &e, sizeof(e));
+    }
+    static const char zero[UNBIND_SURFACE_ALIGN];
+    size_t at = sizeof(h) + n_tables * sizeof(unbind_surface_entry);
+    err |= write_all(fp, zero, data_offset - at);
+    for (size_t k = 0; k < n_tables; k++) {
+        err |= write_all(fp, b.values + k * b.points, b.points * sizeof(float));
+        err |= write_all(fp, zero, table_bytes - b.points * sizeof(float));
+    }
+    if (fclose(fp) != 0) err = -1;
+    fp = NULL;
+    if (err) {
+        fprintf(stderr, "Error writing %s.\n", path);
+        goto done;
+    }
+    status = 0;
+
+    double trajectories = (double)n_tables * (double)b.points;
+    fprintf(stderr, "SURFACE: %zu tables of %d x %d x %d points, %.0f trajectories on %d threads in %.3f s\n",
+            n_tables, n[0], n[1], n[2], trajectories, n_threads, secs);
+    fprintf(stderr, "SURFACE: %.1f MB, largest lookup error %.3g (%s, %s) at %d random points per table\n",
+            (double)(data_offset + n_tables * table_bytes) / 1e6, worst,
+            unbind_planet_name(planets[worst_table / (size_t)n_materials]),
+            unbind_material_name(materials[worst_table % (size_t)n_materials]), SURFACE_CHECK);
+
+done:
+    if (fp) fclose(fp);
+    free(b.values);
+    free(b.scratch);
+    unbind_pool_destroy(pool);
+    return status;
+}
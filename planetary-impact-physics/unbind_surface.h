@@ -0,0 +1,67 @@
+/* unbind_surface.h
+* (C) 2025 - George McGinn - MIT License
+* Retention-surface files for unbindEnergy: the atmospheric entry model tabulated once per
+* planet and material (the surface mode), and a read-only mmap loader for the sweep and
+* Monte Carlo modes.
+*
+* File layout (native little-endian):
+*   header      unbind_surface_header
+*   directory   n_surfaces unbind_surface_entry records
+*   tables      n[0] * n[1] * n[2] floats each, at the entry's offset (64-byte aligned),
+*               diameter varying fastest, then speed and angle
+*
+* Reader use:
+*   unbind_surface_file f;
+*   if (unbind_surface_open("entry.urs", &f) == 0) {
+*       const unbind_retention_surface* s = unbind_surface_find(&f, PLANET_EARTH, MATERIAL_STONY);
+*       if (s) ret = unbind_surface_lookup(s, D_km, 20.0, 3000.0, 45.0);
+*       unbind_surface_close(&f);
+*   }
+*/
+
+#ifndef UNBIND_SURFACE_H
+#define UNBIND_SURFACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "libunbind.h"
+
+#define UNBIND_SURFACE_MAGIC "UNBSRF1"     // 8 bytes with the NUL
+#define UNBIND_SURFACE_VERSION 1
+#define UNBIND_SURFACE_ENDIAN 0x01020304u
+#define UNBIND_SURFACE_ALIGN 64
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t endian;                       // UNBIND_SURFACE_ENDIAN as written
+    uint32_t n_surfaces;
+    uint32_t n[UNBIND_SURFACE_AXES];       // grid points per axis
+    uint32_t reserved0;
+    double   lo[UNBIND_SURFACE_AXES];      // axis ranges (log10 for diameter and speed)
+    double   hi[UNBIND_SURFACE_AXES];
+    uint64_t reserved[4];
+} unbind_surface_header;
+
+typedef struct {
+    uint32_t planet;                       // PLANET_*
+    uint32_t material;                     // MATERIAL_*
+    uint64_t offset;                       // first value, from the start of the file
+} unbind_surface_entry;
+
+typedef struct {
+    const unsigned char* base;
+    size_t size;
+    const unbind_surface_header* header;
+    unbind_retention_surface surface[PLANET_COUNT][MATERIAL_COUNT];   // value NULL if absent
+} unbind_surface_file;
+
+int unbind_surface_open(const char* path, unbind_surface_file* f);    // 0, or -1 with errno set
+void unbind_surface_close(unbind_surface_file* f);
+const unbind_retention_surface* unbind_surface_find(const unbind_surface_file* f, int planet, int material);
+
+// surface <file> [planets=all] [materials=all] [D=1e-5:1e3:65] [speed=2:100:49] [angle=15:90:16]
+//         [threads=0]
+int run_surface(int argc, char** argv);
+
+#endif
@@ -0,0 +1,501 @@
+/* unbind_sweep.c
+* (C) 2025 - George McGinn - MIT License
+* Parameter-sweep mode for unbindEnergy (see unbind_sweep.h).
+* Build: part of unbindEnergy, see unbindEnergy.c
+*
+* Usage:
+*   ./unbindEnergy sweep <m|d|v> <value-axis> [rho=<axis>] [eps=<axis>] [planets=all] [materials=all] [threads=0]
+*                        [bin=<file|->] [bodies=<file>] [retention=table|entry[:<speed_km_s>[:<angle_deg>]]]
+*                        [surface=<file.urs>] [shard=i/N] [out=<file>] [checkpoint=<file>] [every=30]
+*
+* Examples:
+*   ./unbindEnergy sweep d log:0.001:1000:601 rho=lin:1000:8000:8 eps=log:0.01:1:20
+*   ./unbindEnergy sweep v 10,20,50,100 rho=3000 eps=0.25 planets=earth,mars materials=iron
+*   ./unbindEnergy sweep d log:0.01:100:200 bodies="Target Bodies (unbindEnergy).csv" planets=titan,ceres
+*   ./unbindEnergy sweep d log:0.001:10:400 planets=earth,venus retention=entry:20:45
+*
+* Notes:
+*  - The value axis is the mass (kg) for 'm', the diameter (km) for 'd' and the speed (km/s)
+*    for 'v'. rho does not apply to 'm' (the solver estimates size at 3000 kg/m^3).
+*  - Output is the same CSV as batch mode (without the name column), in a fixed order:
+*    planet, then material, epsilon, rho, and the value axis innermost. The order does not
+*    depend on the thread count.
+*  - planets= names come from the bodies= file when one is given (see unbind_registry.h),
+*    otherwise from the built-in planets.
+*  - Each row of the value axis is cut into tasks of SWEEP_CHUNK points, which run through
+*    the SIMD kernels (unbind_solve_soa) and are formatted (unbind_fmt.h) into a per-task
+*    buffer on a work-stealing pool. Tasks are issued in windows; while one window computes,
+*    the previous window's buffers are written in task order, so memory stays bounded and
+*    the output is deterministic.
+*  - retention=entry replaces the step tables with the atmospheric entry model
+*    (libunbind_entry.c): each impactor's retention is the energy fraction it delivers
+*    entering at the given speed (default 20 km/s) and angle above the horizon (default 45).
+*    It integrates one trajectory per point ('v' needs several), so expect microseconds
+*    per point instead of nanoseconds.
+*  - surface= takes the same entry-model retention from a table built by the surface mode
+*    (unbind_surface.c) instead, interpolated in nanoseconds. It implies retention=entry;
+*    the file needs a table for every planet (atmosphere) and material in the sweep.
+*  - shard= runs a contiguous range of the SWEEP_CHUNK tasks, and checkpoint= saves after a
+*    window has been written (unbind_shard.h); concatenating the shards' rows gives the
+*    unsharded output exactly, since a task's rows depend only on its chunk.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "libunbind.h"
+#include "unbind_pool.h"
+#include "unbind_fmt.h"
+#include "unbind_bin.h"
+#include "unbind_registry.h"
+#include "unbind_surface.h"
+#include "unbind_shard.h"
+#include "unbind_sweep.h"
+
+#define SWEEP_CHUNK 2048              // points per task
+#define SWEEP_LINE_MAX 192            // upper bound on one formatted result line
+#define SWEEP_WINDOW_PER_THREAD 16    // tasks per window, per worker
+
+typedef struct {
+    char mode;
+    sweep_axis value, rho, eps;
+    const unbind_registry* reg;       // target bodies (built-in or bodies=)
+    int* planets;                     // registry indices
+    int n_planets;
+    int materials[MATERIAL_COUNT];
+    int n_materials;
+    size_t chunks_per_row;
+    size_t n_rows;                    // planets * materials * eps * rho
+    size_t n_chunks;                  // n_rows * chunks_per_row
+    int binary;                       // bin=: slots hold unbind_bin_row records instead of CSV
+    int entry;                        // retention=entry: entry model instead of the tables
+    double entry_speed, entry_angle;  // km/s, degrees above the horizon
+    const unbind_surface_file* surface;   // surface=: entry retention from tables, or NULL
+} sweep_plan;
+
+typedef struct {
+    char* data;
+    size_t len, cap;
+} sweep_buffer;
+
+// Per-worker output columns for one chunk
+typedef struct {
+    double ret[SWEEP_CHUNK], m[SWEEP_CHUNK], D_km[SWEEP_CHUNK];
+    double v_class[SWEEP_CHUNK], v_rel[SWEEP_CHUNK];
+    unsigned char destroyed[SWEEP_CHUNK];
+} sweep_scratch;
+
+typedef struct {
+    const sweep_plan* plan;
+    size_t base;                      // first chunk of this window
+    size_t count;                     // chunks in this window
+    sweep_buffer* slots;              // one per chunk of the window
+    sweep_scratch* scratch;           // one per worker
+} sweep_window;
+
+/* ---------------------------------------------------------------------------
+ * Axis parsing
+ * ------------------------------------------------------------------------- */
+
+int sweep_parse_axis(const char* spec, sweep_axis* axis) {
+    axis->values = NULL;
+    axis->n = 0;
+
+    int is_lin = strncmp(spec, "lin:", 4) == 0;
+    int is_log = strncmp(spec, "log:", 4) == 0;
+    if (is_lin || is_log) {
+        double a, b;
+        long n;
+        char tail;
+        if (sscanf(spec + 4, "%lf:%lf:%ld%c", &a, &b, &n, &tail) != 3 || n < 1) return -1;
+        if (is_log && (a <= 0.0 || b <= 0.0)) return -1;
+        axis->values = malloc((size_t)n * sizeof(double));
+        if (!axis->values) return -1;
+        axis->n = (size_t)n;
+        for (long i = 0; i < n; i++) {
+            double t = n > 1 ? (double)i / (double)(n - 1) : 0.0;
+            axis->values[i] = is_lin ? a + (b - a) * t : exp(log(a) + (log(b) - log(a)) * t);
+        }
+        if (n > 1) axis->values[n-1] = b;   // exact end point
+        return 0;
+    }
+
+    // Explicit list
+    size_t cap = 1;
+    for (const char* p = spec; *p; p++) cap += (*p == ',');
+    axis->values = malloc(cap * sizeof(double));
+    if (!axis->values) return -1;
+    const char* p = spec;
+    while (*p) {
+        char* end;
+        double x = strtod(p, &end);
+        if (end == p || (*end != ',' && *end != '\0')) {
+            sweep_free_axis(axis);
+            return -1;
+        }
+        axis->values[axis->n++] = x;
+        p = *end == ',' ? end + 1 : end;
+    }
+    if (axis->n == 0) {
+        sweep_free_axis(axis);
+        return -1;
+    }
+    return 0;
+}
+
+void sweep_free_axis(sweep_axis* axis) {
+    free(axis->values);
+    axis->values = NULL;
+    axis->n = 0;
+}
+
+static int axis_positive(const sweep_axis* axis) {
+    for (size_t i = 0; i < axis->n; i++)
+        if (!(axis->values[i] > 0.0)) return 0;
+    return 1;
+}
+
+/* ---------------------------------------------------------------------------
+ * Tasks
+ * ------------------------------------------------------------------------- */
+
+static int buffer_reserve(sweep_buffer* b, size_t need) {
+    if (b->cap >= need) return 0;
+    char* p = realloc(b->data, need);
+    if (!p) return -1;
+    b->data = p;
+    b->cap = need;
+    return 0;
+}
+
+// Format and append one chunk's rows to its slot
+static void sweep_format_chunk(const sweep_plan* plan, sweep_buffer* out, const char* prefix, double eps,
+                               const double* value, const sweep_scratch* s, size_t n) {
+    size_t prefix_len = strlen(prefix);
+    char* p = out->data;
+    for (size_t i = 0; i < n; i++) {
+        double v_class = plan->mode == 'v' ? value[i] : s->v_class[i] / 1000.0;
+        double v_rel = plan->mode == 'v' ? value[i] : s->v_rel[i] / 1000.0;
+        memcpy(p, prefix, prefix_len);
+        p += prefix_len;
+        p = unbind_fmt_f(p, s->ret[i], 3);
+        *p++ = ',';
+        p = unbind_fmt_g(p, eps * s->ret[i], 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, s->m[i], 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, s->D_km[i], 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, v_class, 6);
+        *p++ = ',';
+        p = unbind_fmt_e(p, v_rel, 6);
+        *p++ = ',';
+        *p++ = (char)('0' + (s->destroyed[i] != 0));
+        *p++ = '\n';
+    }
+    out->len = (size_t)(p - out->data);
+}
+
+static void sweep_task(void* ctx, size_t task, int worker) {
+    sweep_window* w = ctx;
+    const sweep_plan* plan = w->plan;
+    sweep_scratch* s = &w->scratch[worker];
+    sweep_buffer* out = &w->slots[task];
+    size_t chunk = w->base + task;
+
+    // Decode (planet, material, eps, rho, value chunk) from the chunk number
+    size_t row = chunk / plan->chunks_per_row;
+    size_t off = (chunk % plan->chunks_per_row) * SWEEP_CHUNK;
+    size_t i_rho = row % plan->rho.n;  row /= plan->rho.n;
+    size_t i_eps = row % plan->eps.n;  row /= plan->eps.n;
+    size_t i_mat = row % (size_t)plan->n_materials;
+    size_t i_planet = row / (size_t)plan->n_materials;
+    size_t n = plan->value.n - off < SWEEP_CHUNK ? plan->value.n - off : SWEEP_CHUNK;
+
+    unbind_soa_input in;
+    memset(&in, 0, sizeof(in));
+    in.mode = plan->mode;
+    const unbind_body* body = unbind_registry_body(plan->reg, (size_t)plan->planets[i_planet]);
+    in.planet = body->atmosphere;
+    in.U = body->U;
+    in.material = plan->materials[i_mat];
+    in.rho = plan->rho.values[i_rho];
+    in.epsilon = plan->eps.values[i_eps];
+    in.value = plan->value.values + off;
+    in.n = n;
+    unbind_soa_result res = { s->ret, s->m, s->D_km, s->v_class, s->v_rel, NULL, s->destroyed, NULL };
+    if (plan->surface)
+        unbind_surface_solve_soa(&in, unbind_surface_find(plan->surface, in.planet, in.material), NULL,
+                                 plan->entry_speed, NULL, plan->entry_angle, &res);
+    else if (plan->entry) unbind_entry_solve_soa(&in, plan->entry_speed, plan->entry_angle, &res);
+    else unbind_solve_soa(&in, &res);
+
+    out->len = 0;
+    if (plan->binary) {
+        if (buffer_reserve(out, n * sizeof(unbind_bin_row)) != 0) return;          // reported by the writer
+        unbind_bin_row* rec = (unbind_bin_row*)out->data;
+        for (size_t i = 0; i < n; i++) {
+            rec[i].value = in.value[i];
+            rec[i].rho = in.rho;
+            rec[i].epsilon = in.epsilon;
+            rec[i].retention = s->ret[i];
+            rec[i].eps_eff = in.epsilon * s->ret[i];
+            rec[i].m = s->m[i];
+            rec[i].D_km = s->D_km[i];
+            rec[i].v_class = plan->mode == 'v' ? in.value[i] : s->v_class[i] / 1000.0;
+            rec[i].v_rel = plan->mode == 'v' ? in.value[i] : s->v_rel[i] / 1000.0;
+            rec[i].source = (uint32_t)(off + i);
+            rec[i].mode = plan->mode;
+            rec[i].planet = (uint32_t)plan->planets[i_planet];
+            rec[i].material = (unsigned char)in.material;
+            rec[i].destroyed = s->destroyed[i] != 0;
+        }
+        out->len = n * sizeof(unbind_bin_row);
+        return;
+    }
+
+    char prefix[96 + UNBIND_BODY_NAME], *p = prefix;
+    *p++ = plan->mode;
+    *p++ = ',';
+    p = unbind_fmt_str(p, body->name);
+    *p++ = ',';
+    p = unbind_fmt_str(p, unbind_material_name(in.material));
+    *p++ = ',';
+    p = unbind_fmt_g(p, in.epsilon, 6);
+    *p++ = ',';
+    p = unbind_fmt_g(p, in.rho, 6);
+    *p++ = ',';
+    *p = '\0';
+    if (buffer_reserve(out, n * (SWEEP_LINE_MAX + strlen(prefix))) != 0) return;   // reported by the writer
+    sweep_format_chunk(plan, out, prefix, in.epsilon, in.value, s, n);
+}
+
+// Write a finished window in chunk order. Returns -1 on a write or allocation failure.
+static int sweep_write_window(const sweep_window* w, unbind_out* out, unbind_bin_writer* bin) {
+    for (size_t i = 0; i < w->count; i++) {
+        if (w->slots[i].len == 0) return -1;
+        if (bin) {
+            size_t n = w->slots[i].len / sizeof(unbind_bin_row);
+            if (unbind_bin_append(bin, (const unbind_bin_row*)w->slots[i].data, n) != 0) return -1;
+        } else {
+            unbind_out_write(out, w->slots[i].data, w->slots[i].len);
+        }
+    }
+    return out->error ? -1 : 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Driver
+ * ------------------------------------------------------------------------- */
+
+// ":<speed_km_s>[:<angle_deg>]" after retention=entry, or nothing for the defaults
+static int parse_entry(const char* spec, sweep_plan* plan) {
+    char* end;
+    plan->entry_speed = 20.0;
+    plan->entry_angle = 45.0;
+    if (*spec == ':') {
+        plan->entry_speed = strtod(spec + 1, &end);
+        spec = end;
+        if (*spec == ':') {
+            plan->entry_angle = strtod(spec + 1, &end);
+            spec = end;
+        }
+    }
+    return *spec == '\0' && plan->entry_speed > 0.0 && plan->entry_angle > 0.0 && plan->entry_angle <= 90.0 ? 0 : -1;
+}
+
+static int sweep_usage(const char* prog) {
+    fprintf(stderr,
+        "Usage: %s sweep <m|d|v> <value-axis> [rho=<axis>] [eps=<axis>] [planets=all] [materials=all] [threads=0]\n"
+        "          [bin=<file|->] [bodies=<file>] [retention=table|entry[:<speed_km_s>[:<angle_deg>]]]\n"
+        "          [surface=<file.urs>] [shard=i/N] [out=<file>] [checkpoint=<file>] [every=30]\n"
+        "  axis: lin:a:b:n | log:a:b:n | x1,x2,...\n", prog);
+    return 1;
+}
+
+int run_sweep(int argc, char** argv) {
+    sweep_plan plan;
+    const char* rho_spec = NULL;
+    const char* eps_spec = "1.0";
+    const char* planet_spec = "all";
+    const char* material_spec = "all";
+    const char* bin_path = NULL;
+    const char* bodies_path = NULL;
+    const char* surface_path = NULL;
+    unbind_surface_file surface;
+    unbind_bin_writer* bin = NULL;
+    unbind_registry* reg = NULL;
+    unbind_shard shard;
+    int threads = 0;
+    int status = 1;
+
+    memset(&plan, 0, sizeof(plan));
+    unbind_shard_init(&shard);
+    memset(&surface, 0, sizeof(surface));
+    if (argc < 4) return sweep_usage(argv[0]);
+    plan.mode = argv[2][0];
+    if (argv[2][1] != '\0' || (plan.mode != 'm' && plan.mode != 'd' && plan.mode != 'v')) {
+        fprintf(stderr, "Sweep mode must be 'm', 'd', or 'v'.\n");
+        return 1;
+    }
+    for (int i = 4; i < argc; i++) {
+        int opt = 0;
+        if (strncmp(argv[i], "rho=", 4) == 0) rho_spec = argv[i] + 4;
+        else if (strncmp(argv[i], "eps=", 4) == 0) eps_spec = argv[i] + 4;
+        else if (strncmp(argv[i], "planets=", 8) == 0) planet_spec = argv[i] + 8;
+        else if (strncmp(argv[i], "materials=", 10) == 0) material_spec = argv[i] + 10;
+        else if (strncmp(argv[i], "threads=", 8) == 0) threads = atoi(argv[i] + 8);
+        else if (strncmp(argv[i], "bin=", 4) == 0) bin_path = argv[i] + 4;
+        else if (strncmp(argv[i], "bodies=", 7) == 0) bodies_path = argv[i] + 7;
+        else if (strcmp(argv[i], "retention=table") == 0) plan.entry = 0;
+        else if (strncmp(argv[i], "retention=entry", 15) == 0 && parse_entry(argv[i] + 15, &plan) == 0) plan.entry = 1;
+        else if (strncmp(argv[i], "surface=", 8) == 0) surface_path = argv[i] + 8;
+        else if ((opt = unbind_shard_option(argv[i], &shard)) > 0) continue;
+        else {
+            fprintf(stderr, opt < 0 ? "Bad sweep option: %s\n" : "Unknown sweep option: %s\n", argv[i]);
+            return sweep_usage(argv[0]);
+        }
+    }
+    if (plan.mode == 'm' && rho_spec) {
+        fprintf(stderr, "rho does not apply to mode 'm'.\n");
+        return 1;
+    }
+    if (bin_path && (shard.sharded || shard.out_path || shard.checkpoint_path)) {
+        fprintf(stderr, "shard=, out= and checkpoint= apply to CSV output, not bin=.\n");
+        return 1;
+    }
+    shard.fingerprint = unbind_shard_fingerprint(argc, argv);
+
+    if (sweep_parse_axis(argv[3], &plan.value) != 0 || !axis_positive(&plan.value) ||
+        sweep_parse_axis(rho_spec ? rho_spec : "3000", &plan.rho) != 0 || !axis_positive(&plan.rho) ||
+        sweep_parse_axis(eps_spec, &plan.eps) != 0 || !axis_positive(&plan.eps)) {
+        fprintf(stderr, "Axes must be lin:a:b:n, log:a:b:n or a list, with positive values.\n");
+        goto done;
+    }
+    if (!(reg = unbind_registry_open(bodies_path))) goto done;
+    plan.reg = reg;
+    plan.n_planets = unbind_registry_parse_list(reg, planet_spec, &plan.planets);
+    plan.n_materials = unbind_parse_material_list(material_spec, plan.materials, MATERIAL_COUNT);
+    if (plan.n_planets < 0 || plan.n_materials < 0) {
+        fprintf(stderr, "Planets/materials must be comma-separated names or 'all'.\n");
+        goto done;
+    }
+    if (surface_path) {
+        if (unbind_surface_open(surface_path, &surface) != 0) {
+            fprintf(stderr, "Cannot read retention surfaces: %s\n", surface_path);
+            goto done;
+        }
+        for (int ip = 0; ip < plan.n_planets; ip++) {
+            for (int im = 0; im < plan.n_materials; im++) {
+                const unbind_body* body = unbind_registry_body(reg, (size_t)plan.planets[ip]);
+                if (!unbind_surface_find(&surface, body->atmosphere, plan.materials[im])) {
+                    fprintf(stderr, "%s has no %s/%s table.\n", surface_path,
+                            unbind_planet_name(body->atmosphere), unbind_material_name(plan.materials[im]));
+                    goto done;
+                }
+            }
+        }
+        if (!plan.entry) parse_entry("", &plan);
+        plan.entry = 1;
+        plan.surface = &surface;
+    }
+    plan.chunks_per_row = (plan.value.n + SWEEP_CHUNK - 1) / SWEEP_CHUNK;
+    plan.n_rows = (size_t)plan.n_planets * (size_t)plan.n_materials * plan.eps.n * plan.rho.n;
+    plan.n_chunks = plan.n_rows * plan.chunks_per_row;
+    plan.binary = bin_path != NULL;
+    if (bin_path) {
+        int fd = unbind_bin_open_output(bin_path);
+        if (fd < 0 || !(bin = unbind_bin_create(fd))) {
+            fprintf(stderr, "Cannot write binary output: %s\n", bin_path);
+            goto done;
+        }
+    }
+    void* payload;
+    uint64_t payload_bytes;
+    int resumed = unbind_shard_start(&shard, plan.n_chunks, &payload, &payload_bytes);
+    free(payload);
+    if (resumed < 0 || (!bin && unbind_shard_open_output(&shard, resumed) != 0)) goto done;
+
+    unbind_pool* pool = unbind_pool_create(threads);
+    if (!pool) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        goto done;
+    }
+    int n_threads = unbind_pool_threads(pool);
+    size_t window_size = (size_t)n_threads * SWEEP_WINDOW_PER_THREAD;
+    sweep_window windows[2];
+    sweep_scratch* scratch = malloc((size_t)n_threads * sizeof(sweep_scratch));
+    sweep_buffer* slots = calloc(2 * window_size, sizeof(sweep_buffer));
+    if (!scratch || !slots) {
+        fprintf(stderr, "Out of memory.\n");
+        free(scratch); free(slots);
+        unbind_pool_destroy(pool);
+        goto done;
+    }
+    for (int k = 0; k < 2; k++) {
+        windows[k].plan = &plan;
+        windows[k].slots = slots + (size_t)k * window_size;
+        windows[k].scratch = scratch;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    static const char header[] =
+        "mode,planet,material,epsilon,rho_kg_m3,retention,eps_eff,mass_kg,diameter_km,v_class_km_s,v_rel_km_s,destroyed\n";
+    unbind_out* out = unbind_stdout();
+    if (!bin && !resumed) {
+        unbind_shard_header(&shard, "sweep");
+        unbind_out_write(out, header, sizeof(header) - 1);
+    }
+
+    // Compute window k while window k-1 is written; the shard's chunks start at shard.next
+    size_t first = (size_t)shard.next, todo = (size_t)(shard.end - shard.next);
+    size_t n_windows = (todo + window_size - 1) / window_size;
+    status = 0;
+    for (size_t k = 0; k < n_windows && status == 0; k++) {
+        sweep_window* w = &windows[k % 2];
+        w->base = first + k * window_size;
+        w->count = (size_t)shard.end - w->base < window_size ? (size_t)shard.end - w->base : window_size;
+        unbind_pool_submit(pool, w->count, sweep_task, w);
+        if (k > 0 && sweep_write_window(&windows[(k - 1) % 2], out, bin) != 0) status = 1;
+        if (k > 0 && status == 0 && unbind_shard_due(&shard) && unbind_shard_save(&shard, w->base, NULL, 0) != 0)
+            status = 2;
+        unbind_pool_wait(pool);
+    }
+    if (status == 0 && n_windows > 0 && sweep_write_window(&windows[(n_windows - 1) % 2], out, bin) != 0) status = 1;
+    if (status == 0 && (!resumed || todo > 0)) unbind_shard_trailer(&shard);
+    if (unbind_out_flush(out) != 0 && status == 0) status = 1;
+    if (bin && unbind_bin_finish(bin) != 0) status = 1;
+    bin = NULL;
+    if (status == 1) fprintf(stderr, "Error writing sweep output.\n");
+    if (status == 0 && shard.checkpoint_path && unbind_shard_save(&shard, shard.end, NULL, 0) != 0) status = 2;
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double secs = (double)(t1.tv_sec - t0.tv_sec) + 1e-9 * (double)(t1.tv_nsec - t0.tv_nsec);
+    double points = 0.0;
+    for (size_t c = first; c < (size_t)shard.end; c++) {
+        size_t off = (c % plan.chunks_per_row) * SWEEP_CHUNK;
+        points += (double)(plan.value.n - off < SWEEP_CHUNK ? plan.value.n - off : SWEEP_CHUNK);
+    }
+    fprintf(stderr, "SWEEP  : %.0f points on %d threads in %.3f s (%.3e points/s)\n",
+            points, n_threads, secs, secs > 0.0 ? points / secs : 0.0);
+
+    unbind_pool_destroy(pool);
+    for (size_t i = 0; i < 2 * window_size; i++) free(slots[i].data);
+    free(slots);
+    free(scratch);
+    if (status != 0) status = 1;
+
+done:
+    unbind_shard_close_output(&shard);
+    if (bin) unbind_bin_finish(bin);
+    unbind_surface_close(&surface);
+    free(plan.planets);
+    unbind_registry_free(reg);
+    sweep_free_axis(&plan.value);
+    sweep_free_axis(&plan.rho);
+    sweep_free_axis(&plan.eps);
+    return status;
+}
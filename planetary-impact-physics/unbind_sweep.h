@@ -0,0 +1,28 @@
+/* unbind_sweep.h
+* (C) 2025 - George McGinn - MIT License
+* Parameter-sweep mode for unbindEnergy: the Cartesian product of
+* (planet, material, epsilon, density, value) evaluated on a thread pool.
+*
+* Axis specifications (used for the value, rho and eps axes):
+*   lin:a:b:n     n points evenly spaced from a to b
+*   log:a:b:n     n points log-spaced from a to b
+*   x1,x2,...     explicit list (a single number is a one-point axis)
+*/
+
+#ifndef UNBIND_SWEEP_H
+#define UNBIND_SWEEP_H
+
+#include <stddef.h>
+
+typedef struct {
+    double* values;
+    size_t n;
+} sweep_axis;
+
+int sweep_parse_axis(const char* spec, sweep_axis* axis);   // 0 on success, -1 on bad spec
+void sweep_free_axis(sweep_axis* axis);
+
+// sweep <m|d|v> <value-axis> [rho=<axis>] [eps=<axis>] [planets=all] [materials=all] [threads=0]
+int run_sweep(int argc, char** argv);
+
+#endif